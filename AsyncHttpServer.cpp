@@ -0,0 +1,533 @@
+// AsyncHttpServer.cpp
+#include "AsyncHttpServer.h"
+#include <string.h>
+#include <strings.h>
+
+// لم يستدعِ المعالج setContentLength (الطول = طول المحتوى المرسل مع send)؛ معرّف أيضاً في WebServer.h لـ ESP32
+#ifndef CONTENT_LENGTH_NOT_SET
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+#endif
+// طريقة إرسال الرد الحالي بعد setContentLength(CONTENT_LENGTH_UNKNOWN)
+#define HTTP_STREAM_NONE 0
+#define HTTP_STREAM_CHUNKED 1 // HTTP/1.1: Transfer-Encoding: chunked
+#define HTTP_STREAM_RAW 2     // HTTP/1.0: المحتوى كما هو حتى إغلاق الاتصال
+
+AsyncHttpServer::AsyncHttpServer(HttpSocketBackend& backend, uint16_t port)
+    : _backend(backend), _port(port), _started(false), _routes(nullptr), _lastRoute(nullptr),
+      _stats(), _current(nullptr), _method(HTTP_GET), _argCount(0),
+      _contentLength(CONTENT_LENGTH_NOT_SET), _responded(false), _stream(HTTP_STREAM_NONE), _http10(false) {
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+        _connections[i].handle = -1;
+        _connections[i].state = HTTP_CONNECTION_FREE;
+        _connections[i].keepAlive = false;
+        _connections[i].failed = false;
+        _connections[i].outputSent = 0;
+        _connections[i].lastActivity = 0;
+    }
+}
+
+// تسجيل مسار (بترتيب التسجيل: أول مسار مطابق يُنفذ كما في WebServer)
+void AsyncHttpServer::on(const String& uri, HTTPMethod method, HttpHandler handler) {
+    Route* route = new Route();
+    route->uri = uri;
+    route->method = method;
+    route->handler = handler;
+    route->next = nullptr;
+    if (_lastRoute == nullptr) {
+        _routes = route;
+    } else {
+        _lastRoute->next = route;
+    }
+    _lastRoute = route;
+}
+
+void AsyncHttpServer::onNotFound(HttpHandler handler) {
+    _notFound = handler;
+}
+
+// بدء الاستماع (كل مدير يستدعي begin من beginAPAndWebServer، فالاستدعاءات التالية لا تفعل شيئاً)
+void AsyncHttpServer::begin() {
+    if (_started) {
+        return;
+    }
+    _started = _backend.listen(_port);
+    if (!_started) {
+        Serial.println("فشل بدء الاستماع لخادم HTTP");
+    }
+}
+
+// مرور واحد على جميع الاتصالات: قبول، قراءة، تنفيذ طلب مكتمل، إرسال، وإغلاق المنتهية
+void AsyncHttpServer::handleClient() {
+    if (!_started) {
+        return;
+    }
+    acceptConnections();
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+        HttpConnection& connection = _connections[i];
+        if (connection.state == HTTP_CONNECTION_FREE) {
+            continue;
+        }
+        if (connection.state == HTTP_CONNECTION_OPEN) {
+            if (!receive(connection)) {
+                closeConnection(connection);
+                continue;
+            }
+            // طلب جديد فقط بعد إرسال الرد السابق (الطلبات المتتالية على نفس الاتصال تنتظر في input)
+            if (connection.output.length() == 0) {
+                processRequest(connection);
+            }
+        }
+        if (!transmit(connection)) {
+            closeConnection(connection);
+            continue;
+        }
+        if (connection.state == HTTP_CONNECTION_CLOSING && connection.output.length() == 0) {
+            closeConnection(connection);
+            continue;
+        }
+        if (millis() - connection.lastActivity > HTTP_IDLE_TIMEOUT_MS) {
+            _stats.timeouts++;
+            closeConnection(connection);
+        }
+    }
+}
+
+// انتظار نشاط على المقابس (انتظار قصير إذا بقي رد لم يُرسل أو طلب لم يُعالج)
+void AsyncHttpServer::waitForActivity(uint32_t timeoutMs) {
+    bool busy = false;
+    bool accepting = false;
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+        const HttpConnection& connection = _connections[i];
+        if (connection.state == HTTP_CONNECTION_FREE) {
+            accepting = true;
+        } else if (connection.output.length() > 0 || connection.input.length() > 0) {
+            busy = true;
+        }
+    }
+    _backend.wait(busy ? 1 : timeoutMs, accepting);
+}
+
+// قبول الاتصالات المنتظرة ما دامت توجد خانات فارغة (وإلا تبقى في طابور الاستماع)
+void AsyncHttpServer::acceptConnections() {
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+        HttpConnection& connection = _connections[i];
+        if (connection.state != HTTP_CONNECTION_FREE) {
+            continue;
+        }
+        int handle = _backend.accept();
+        if (handle < 0) {
+            return;
+        }
+        connection.handle = handle;
+        connection.state = HTTP_CONNECTION_OPEN;
+        connection.keepAlive = true;
+        connection.failed = false;
+        connection.outputSent = 0;
+        connection.lastActivity = millis();
+        _stats.accepted++;
+        _stats.active++;
+        if (_stats.active > _stats.maxActive) {
+            _stats.maxActive = _stats.active;
+        }
+    }
+}
+
+// قراءة ما وصل حتى حد الطلب (ما بعده يبقى في المقبس حتى يُعالج الطلب الحالي)
+bool AsyncHttpServer::receive(HttpConnection& connection) {
+    uint8_t buffer[256];
+    while (connection.input.length() < HTTP_MAX_HEADER_SIZE + HTTP_MAX_BODY_SIZE) {
+        int received = _backend.read(connection.handle, buffer, sizeof(buffer));
+        if (received < 0) {
+            return false;
+        }
+        if (received == 0) {
+            break;
+        }
+        connection.input.concat((const char*)buffer, received);
+        connection.lastActivity = millis();
+    }
+    return true;
+}
+
+// مطابقة سطر ترويسة باسمها وإرجاع بداية قيمتها
+static const char* headerValue(const char* line, size_t length, const char* name) {
+    size_t nameLength = strlen(name);
+    if (length <= nameLength || line[nameLength] != ':' || strncasecmp(line, name, nameLength) != 0) {
+        return nullptr;
+    }
+    const char* value = line + nameLength + 1;
+    while (*value == ' ' || *value == '\t') {
+        value++;
+    }
+    return value;
+}
+
+// تحليل طلب مكتمل: سطر الطلب، الترويسات المستخدمة، الوسائط، ثم المعالج
+void AsyncHttpServer::processRequest(HttpConnection& connection) {
+    const char* data = connection.input.c_str();
+    const char* headerEnd = strstr(data, "\r\n\r\n");
+    if (headerEnd == nullptr) {
+        if (connection.input.length() > HTTP_MAX_HEADER_SIZE) {
+            reject(connection, 431);
+        }
+        return; // الترويسات لم تكتمل بعد
+    }
+    size_t headerLength = headerEnd - data + 4;
+    if (headerLength > HTTP_MAX_HEADER_SIZE) {
+        reject(connection, 431);
+        return;
+    }
+
+    // سطر الطلب: الطريقة، المسار، الإصدار
+    const char* lineEnd = strstr(data, "\r\n");
+    const char* target = (const char*)memchr(data, ' ', lineEnd - data);
+    const char* version = target ? (const char*)memchr(target + 1, ' ', lineEnd - target - 1) : nullptr;
+    if (version == nullptr) {
+        reject(connection, 400);
+        return;
+    }
+    target++;
+    size_t targetLength = version - target;
+    version++;
+    bool http10 = lineEnd - version == 8 && strncmp(version, "HTTP/1.0", 8) == 0;
+
+    HTTPMethod method = HTTP_ANY; // طرق أخرى لا تطابق إلا المسارات المسجلة بـ HTTP_ANY
+    size_t methodLength = target - 1 - data;
+    if (methodLength == 3 && strncmp(data, "GET", 3) == 0) {
+        method = HTTP_GET;
+    } else if (methodLength == 4 && strncmp(data, "POST", 4) == 0) {
+        method = HTTP_POST;
+    } else if (methodLength == 3 && strncmp(data, "PUT", 3) == 0) {
+        method = HTTP_PUT;
+    } else if (methodLength == 6 && strncmp(data, "DELETE", 6) == 0) {
+        method = HTTP_DELETE;
+    }
+
+    // الترويسات
+    long contentLength = 0;
+    bool keepAlive = !http10;
+    bool form = false;
+    for (const char* line = lineEnd + 2; line < headerEnd + 2; ) {
+        const char* next = strstr(line, "\r\n");
+        size_t length = next - line;
+        const char* value;
+        if ((value = headerValue(line, length, "Content-Length")) != nullptr) {
+            contentLength = atol(value);
+        } else if ((value = headerValue(line, length, "Connection")) != nullptr) {
+            if (strncasecmp(value, "close", 5) == 0) {
+                keepAlive = false;
+            } else if (strncasecmp(value, "keep-alive", 10) == 0) {
+                keepAlive = true;
+            }
+        } else if ((value = headerValue(line, length, "Content-Type")) != nullptr) {
+            form = strncasecmp(value, "application/x-www-form-urlencoded", 33) == 0;
+        }
+        line = next + 2;
+    }
+    if (contentLength < 0) {
+        reject(connection, 400);
+        return;
+    }
+    if (contentLength > HTTP_MAX_BODY_SIZE) {
+        reject(connection, 413);
+        return;
+    }
+    if (connection.input.length() < headerLength + (size_t)contentLength) {
+        return; // الجسم لم يكتمل بعد
+    }
+
+    // الطلب الحالي: المسار والوسائط (من الاستعلام، ثم من الجسم أو "plain" كما في WebServer)
+    _current = &connection;
+    _method = method;
+    _http10 = http10;
+    _argCount = 0;
+    const char* query = (const char*)memchr(target, '?', targetLength);
+    size_t pathLength = query ? (size_t)(query - target) : targetLength;
+    _uri = urlDecode(target, pathLength);
+    if (query != nullptr) {
+        parseArgs(query + 1, targetLength - pathLength - 1);
+    }
+    if (contentLength > 0) {
+        const char* body = data + headerLength;
+        if (form) {
+            parseArgs(body, contentLength);
+        } else {
+            addArg("plain", 5, nullptr, 0);
+            _argValues[_argCount - 1].concat(body, contentLength);
+        }
+    }
+    connection.keepAlive = keepAlive;
+    connection.input = connection.input.substring(headerLength + contentLength);
+
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    _responded = false;
+    _stream = HTTP_STREAM_NONE;
+    dispatch();
+    _stats.requests++;
+    if (!_responded) {
+        send(500, "application/json", "{\"status\":\"error\",\"message\":\"لم يُرسل المعالج رداً\"}");
+    } else if (_stream == HTTP_STREAM_CHUNKED) {
+        sendContent(""); // المعالج لم ينهِ الرد المجزأ
+    }
+    if (!connection.keepAlive) {
+        connection.state = HTTP_CONNECTION_CLOSING;
+    }
+    _current = nullptr;
+    _argCount = 0;
+}
+
+// تنفيذ أول مسار مطابق، أو معالج المسار غير الموجود
+void AsyncHttpServer::dispatch() {
+    for (Route* route = _routes; route != nullptr; route = route->next) {
+        if ((route->method == HTTP_ANY || route->method == _method) && route->uri == _uri) {
+            route->handler();
+            return;
+        }
+    }
+    if (_notFound) {
+        _notFound();
+    } else {
+        send(404, "text/plain", "Not found");
+    }
+}
+
+// إرسال ما يسمح به المقبس على دفعات HTTP_WRITE_SLICE
+bool AsyncHttpServer::transmit(HttpConnection& connection) {
+    while (connection.outputSent < connection.output.length()) {
+        size_t size = connection.output.length() - connection.outputSent;
+        if (size > HTTP_WRITE_SLICE) {
+            size = HTTP_WRITE_SLICE;
+        }
+        int sent = _backend.write(connection.handle,
+                                  (const uint8_t*)connection.output.c_str() + connection.outputSent, size);
+        if (sent < 0) {
+            return false;
+        }
+        if (sent == 0) {
+            break; // مخزن الإرسال ممتلئ: المتبقي في المرور التالي
+        }
+        connection.outputSent += sent;
+        connection.lastActivity = millis();
+    }
+    if (connection.outputSent > 0 && connection.outputSent == connection.output.length()) {
+        connection.output = "";
+        connection.outputSent = 0;
+    }
+    return true;
+}
+
+// دفع ما يقبله المقبس الآن من رد مجزأ تجاوز HTTP_OUTPUT_HIGH_WATER دون انتظار (الباقي يُرسل في مرور
+// handleClient التالي)؛ إذا بقي أكثر من HTTP_OUTPUT_MAX_PENDING لأن العميل لا يستلم يُلغى الرد ويُغلق الاتصال
+void AsyncHttpServer::drain(HttpConnection& connection) {
+    bool open = transmit(connection);
+    if (open && connection.outputSent > 0) {
+        // حذف المرسل حتى لا يتضخم المخزن بطول الرد كله
+        connection.output.remove(0, connection.outputSent);
+        connection.outputSent = 0;
+    }
+    if (open && connection.output.length() <= HTTP_OUTPUT_MAX_PENDING) {
+        return;
+    }
+    if (open) {
+        _stats.timeouts++;
+    }
+    connection.failed = true;
+    connection.keepAlive = false;
+    connection.output = "";
+    connection.outputSent = 0;
+}
+
+void AsyncHttpServer::closeConnection(HttpConnection& connection) {
+    _backend.close(connection.handle);
+    connection.handle = -1;
+    connection.state = HTTP_CONNECTION_FREE;
+    connection.input = "";
+    connection.output = "";
+    connection.outputSent = 0;
+    _stats.active--;
+}
+
+// رد خطأ قبل المعالج ثم إغلاق الاتصال (باقي الطلب لا يُقرأ)
+void AsyncHttpServer::reject(HttpConnection& connection, int code) {
+    _stats.rejected++;
+    _current = &connection;
+    _http10 = false;
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    _responded = false;
+    _stream = HTTP_STREAM_NONE;
+    connection.keepAlive = false;
+    connection.input = "";
+    String message = code == 413 ? "جسم الطلب كبير جداً" : code == 431 ? "ترويسات الطلب كبيرة جداً" : "طلب غير صالح";
+    send(code, "application/json", "{\"status\":\"error\",\"message\":\"" + message + "\"}");
+    connection.state = HTTP_CONNECTION_CLOSING;
+    _current = nullptr;
+}
+
+// --- الطلب الحالي ---
+
+bool AsyncHttpServer::hasArg(const String& name) {
+    for (uint8_t i = 0; i < _argCount; i++) {
+        if (_argNames[i] == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+String AsyncHttpServer::arg(const String& name) {
+    for (uint8_t i = 0; i < _argCount; i++) {
+        if (_argNames[i] == name) {
+            return _argValues[i];
+        }
+    }
+    return "";
+}
+
+String AsyncHttpServer::arg(int index) {
+    return index >= 0 && index < _argCount ? _argValues[index] : String("");
+}
+
+String AsyncHttpServer::argName(int index) {
+    return index >= 0 && index < _argCount ? _argNames[index] : String("");
+}
+
+// إضافة وسيط بعد فك ترميز الاسم والقيمة (الوسائط بعد HTTP_MAX_ARGS تُهمل)
+void AsyncHttpServer::addArg(const char* name, size_t nameLength, const char* value, size_t valueLength) {
+    if (_argCount >= HTTP_MAX_ARGS) {
+        return;
+    }
+    _argNames[_argCount] = urlDecode(name, nameLength);
+    _argValues[_argCount] = urlDecode(value, valueLength);
+    _argCount++;
+}
+
+// تحليل name=value&name=value
+void AsyncHttpServer::parseArgs(const char* query, size_t length) {
+    const char* end = query + length;
+    while (query < end) {
+        const char* next = (const char*)memchr(query, '&', end - query);
+        if (next == nullptr) {
+            next = end;
+        }
+        const char* equals = (const char*)memchr(query, '=', next - query);
+        if (equals == nullptr) {
+            addArg(query, next - query, nullptr, 0);
+        } else {
+            addArg(query, equals - query, equals + 1, next - equals - 1);
+        }
+        query = next + 1;
+    }
+}
+
+// --- الرد ---
+
+// رد كامل بطول معروف، أو بداية رد مجزأ بعد setContentLength(CONTENT_LENGTH_UNKNOWN)
+void AsyncHttpServer::send(int code, const char* contentType, const String& content) {
+    if (_current == nullptr || _responded) {
+        return;
+    }
+    _responded = true;
+    if (_contentLength == CONTENT_LENGTH_UNKNOWN) {
+        if (_http10) {
+            // HTTP/1.0 لا يدعم الرد المجزأ: المحتوى كما هو وينتهي بإغلاق الاتصال
+            _current->keepAlive = false;
+            _stream = HTTP_STREAM_RAW;
+            writeHeaders(code, contentType, nullptr);
+        } else {
+            _stream = HTTP_STREAM_CHUNKED;
+            writeHeaders(code, contentType, "Transfer-Encoding: chunked");
+        }
+        if (content.length() > 0) {
+            sendContent(content);
+        }
+        return;
+    }
+    size_t length = _contentLength == CONTENT_LENGTH_NOT_SET ? content.length() : _contentLength;
+    char lengthHeader[40]; // "Content-Length: " وحتى 20 رقماً
+    snprintf(lengthHeader, sizeof(lengthHeader), "Content-Length: %lu", (unsigned long)length);
+    writeHeaders(code, contentType, lengthHeader);
+    sendContent(content);
+}
+
+// جزء من الرد (sendContent("") ينهي الرد المجزأ)
+void AsyncHttpServer::sendContent(const String& content) {
+    if (_current == nullptr) {
+        return;
+    }
+    HttpConnection& connection = *_current;
+    if (connection.failed) {
+        return; // الاتصال انقطع أثناء الرد: يكمل المعالج دون إرسال
+    }
+    if (_stream == HTTP_STREAM_CHUNKED) {
+        if (content.length() == 0) {
+            connection.output += "0\r\n\r\n";
+            _stream = HTTP_STREAM_NONE;
+        } else {
+            char size[12];
+            snprintf(size, sizeof(size), "%X\r\n", (unsigned)content.length());
+            connection.output += size;
+            connection.output += content;
+            connection.output += "\r\n";
+        }
+    } else {
+        connection.output += content;
+    }
+    if (connection.output.length() - connection.outputSent > HTTP_OUTPUT_HIGH_WATER) {
+        drain(connection);
+    }
+}
+
+// سطر الحالة والترويسات
+void AsyncHttpServer::writeHeaders(int code, const char* contentType, const char* lengthHeader) {
+    HttpConnection& connection = *_current;
+    char statusLine[48];
+    snprintf(statusLine, sizeof(statusLine), "HTTP/1.1 %d %s\r\n", code, reason(code));
+    connection.output += statusLine;
+    connection.output += "Content-Type: ";
+    connection.output += contentType;
+    connection.output += "\r\n";
+    if (lengthHeader != nullptr) {
+        connection.output += lengthHeader;
+        connection.output += "\r\n";
+    }
+    connection.output += connection.keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+}
+
+// فك ترميز %XX و + في المسار والوسائط
+String AsyncHttpServer::urlDecode(const char* text, size_t length) {
+    String decoded;
+    decoded.reserve(length);
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        if (c == '+') {
+            c = ' ';
+        } else if (c == '%' && i + 2 < length && isxdigit((unsigned char)text[i + 1]) && isxdigit((unsigned char)text[i + 2])) {
+            char hex[3] = { text[i + 1], text[i + 2], 0 };
+            c = (char)strtol(hex, nullptr, 16);
+            i += 2;
+        }
+        decoded += c;
+    }
+    return decoded;
+}
+
+// نص الحالة للرموز المستخدمة في المكتبة
+const char* AsyncHttpServer::reason(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 204: return "No Content";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 429: return "Too Many Requests";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "";
+    }
+}
@@ -0,0 +1,119 @@
+// AsyncHttpServer.h
+#ifndef ASYNC_HTTP_SERVER_H
+#define ASYNC_HTTP_SERVER_H
+
+#include "HttpTransport.h"
+#include "HttpSocketBackend.h"
+
+// حالة اتصال
+#define HTTP_CONNECTION_FREE 0
+#define HTTP_CONNECTION_OPEN 1    // يقرأ الطلبات (keep-alive)
+#define HTTP_CONNECTION_CLOSING 2 // يُغلق بعد إرسال الرد
+
+// اتصال في خانة ثابتة
+struct HttpConnection {
+    int handle;                // رقم الاتصال عند الواجهة الخلفية
+    uint8_t state;             // HTTP_CONNECTION_*
+    bool keepAlive;            // هل يبقى الاتصال بعد الرد الحالي؟
+    bool failed;               // انقطع الاتصال أثناء رد مجزأ (يُهمل باقي الرد)
+    String input;              // بيانات الطلب المستلمة ولم تُعالج بعد
+    String output;             // الرد الذي لم يُرسل بعد
+    size_t outputSent;         // ما أُرسل من output
+    unsigned long lastActivity; // آخر قراءة أو كتابة (millis)
+};
+
+// عدادات الخادم
+struct AsyncHttpStats {
+    uint32_t requests;   // الطلبات المنفذة
+    uint32_t accepted;   // الاتصالات المقبولة
+    uint32_t rejected;   // طلبات رُفضت قبل المعالج (400، 413، 431)
+    uint32_t timeouts;   // اتصالات أُغلقت لانتهاء المهلة أو لعميل توقف عن استلام رد كبير
+    uint16_t active;     // الاتصالات المفتوحة حالياً
+    uint16_t maxActive;  // أعلى عدد اتصالات متزامنة
+};
+
+// خادم HTTP/1.1 دون حجب فوق HttpSocketBackend: عدة اتصالات في خانات ثابتة، كل منها يُقرأ
+// ويُرسل بقدر ما تسمح المقابس في كل مرور لـ handleClient()، فلا يحجز عميل بطيء أو طلب ناقص بقية العملاء.
+// المعالجات تُنفذ في نفس مهمة loop() (طلب واحد لكل اتصال في كل مرور)، فلا تحتاج المديرات إلى أقفال.
+// الردود تُجمع في مخزن الاتصال وتُرسل على دفعات HTTP_WRITE_SLICE؛ والرد المجزأ يُدفع للمقبس دون انتظار
+// إذا تجاوز المخزن HTTP_OUTPUT_HIGH_WATER، ويُلغى إذا تجاوز HTTP_OUTPUT_MAX_PENDING لعميل لا يستلم.
+class AsyncHttpServer : public HttpTransport {
+public:
+    AsyncHttpServer(HttpSocketBackend& backend, uint16_t port = 80);
+
+    void on(const String& uri, HTTPMethod method, HttpHandler handler) override;
+    void onNotFound(HttpHandler handler) override;
+    void begin() override;
+    void handleClient() override;
+
+    bool hasArg(const String& name) override;
+    String arg(const String& name) override;
+    String arg(int index) override;
+    String argName(int index) override;
+    int args() override { return _argCount; }
+    String uri() override { return _uri; }
+    HTTPMethod method() override { return _method; }
+
+    void send(int code, const char* contentType, const String& content) override;
+    void setContentLength(size_t length) override { _contentLength = length; }
+    void sendContent(const String& content) override;
+
+    // انتظار نشاط على المقابس حتى timeoutMs (للحلقات على الحاسوب؛ على الجهاز تكفي loop())
+    void waitForActivity(uint32_t timeoutMs);
+    // العدادات
+    const AsyncHttpStats& stats() const { return _stats; }
+
+private:
+    // مسار مسجل (قائمة مترابطة مثل معالجات WebServer)
+    struct Route {
+        String uri;
+        HTTPMethod method;
+        HttpHandler handler;
+        Route* next;
+    };
+
+    HttpSocketBackend& _backend;
+    uint16_t _port;
+    bool _started;
+    Route* _routes;
+    Route* _lastRoute;
+    HttpHandler _notFound;
+    HttpConnection _connections[HTTP_MAX_CONNECTIONS];
+    AsyncHttpStats _stats;
+
+    // الطلب الحالي
+    HttpConnection* _current;
+    HTTPMethod _method;
+    String _uri;
+    String _argNames[HTTP_MAX_ARGS];
+    String _argValues[HTTP_MAX_ARGS];
+    uint8_t _argCount;
+    // الرد الحالي
+    size_t _contentLength;
+    bool _responded;
+    uint8_t _stream;      // طريقة إرسال الرد غير معروف الطول
+    bool _http10;         // الطلب الحالي HTTP/1.0
+
+    // قبول الاتصالات المنتظرة في الخانات الفارغة
+    void acceptConnections();
+    // قراءة ما وصل على الاتصال (false إذا أُغلق)
+    bool receive(HttpConnection& connection);
+    // تحليل طلب مكتمل من مخزن الاتصال وتنفيذ معالجه
+    void processRequest(HttpConnection& connection);
+    // إرسال ما يسمح به المقبس من مخزن الرد (false إذا أُغلق)
+    bool transmit(HttpConnection& connection);
+    // دفع ما يقبله المقبس من رد مجزأ كبير دون انتظار، وإلغاء الرد إذا تجاوز المتبقي HTTP_OUTPUT_MAX_PENDING
+    void drain(HttpConnection& connection);
+    void closeConnection(HttpConnection& connection);
+    // رد خطأ من المحرك نفسه ثم الإغلاق
+    void reject(HttpConnection& connection, int code);
+
+    void dispatch();
+    void addArg(const char* name, size_t nameLength, const char* value, size_t valueLength);
+    void parseArgs(const char* query, size_t length);
+    void writeHeaders(int code, const char* contentType, const char* lengthHeader);
+    static String urlDecode(const char* text, size_t length);
+    static const char* reason(int code);
+};
+
+#endif // ASYNC_HTTP_SERVER_H
@@ -7,7 +7,6 @@
 #include <EEPROM.h>
 #include "RTClib.h" 
 #include <ArduinoJson.h> 
-#include "PrayerTimes.h" 
 
 #ifdef ESP32
 #include <WiFi.h>
@@ -16,6 +15,10 @@
 #include <ESP8266WiFi.h>
 #include <ESP8266WebServer.h>
 #define WebServer ESP8266WebServer 
+#else
+// البناء على الحاسوب (extras/host): نفس الواجهات من الطبقة البديلة
+#include <WiFi.h>
+#include <WebServer.h>
 #endif
 
 // تضمين مكتبة Wire للتعامل مع EEPROM الخارجية
@@ -25,13 +28,179 @@
 // تعريف هذا لاستخدام EEPROM خارجية بشكل مشروط
 #define USE_EXTERNAL_EEPROM 
 
-// تعريف دبابيس I2C (SDA, SCL) لـ EEPROM
+// حجم صفحة الكتابة في EEPROM 24C256 (لا يجوز أن تعبر الكتابة المتتالية حدود الصفحة)
+#define EXTERNAL_EEPROM_PAGE_SIZE 64
+// أقصى عدد بايتات بيانات في معاملة I2C واحدة (مخزن Wire المؤقت ناقص بايتي العنوان)
+// مخزن Wire في ESP32/ESP8266 يتسع 128 بايتاً (وفي الطبقة البديلة على الحاسوب 256)، فتُكتب الصفحة كاملة بمعاملة ودورة كتابة واحدة
+#if defined(ESP32) || defined(ESP8266) || !defined(ARDUINO)
+#define I2C_TRANSFER_CHUNK EXTERNAL_EEPROM_PAGE_SIZE
+#else
+#define I2C_TRANSFER_CHUNK 30
+#endif
+
+// تعريف دبابيس I2C (SDA, SCL) لـ EEPROM و RTC (الناقل المشترك، يُهيأ في I2CBus::begin())
+#ifndef EEPROM_SDA_PIN
 #define EEPROM_SDA_PIN 0
+#endif
+#ifndef EEPROM_SCL_PIN
 #define EEPROM_SCL_PIN 2
+#endif
+
+// --- مدير ناقل I2C ---
+// عنوان I2C لساعة DS3231
+#define DS3231_I2C_ADDR 0x68
+// أجهزة الناقل (فهارس السرعات والعدادات)
+#define I2C_DEVICE_EEPROM 0
+#define I2C_DEVICE_RTC 1
+#define I2C_DEVICE_COUNT 2
+// سرعة الناقل لكل جهاز: DS3231 حتى 400 kHz، و 24C256 حتى 400 kHz (1 MHz لـ 24FC256 عند 5V)
+#ifndef I2C_RTC_CLOCK_HZ
+#define I2C_RTC_CLOCK_HZ 400000UL
+#endif
+#ifndef I2C_EEPROM_CLOCK_HZ
+#define I2C_EEPROM_CLOCK_HZ 400000UL
+#endif
+// إعادة المحاولة عند NACK: أقصى عدد محاولات، وانتظار يتضاعف من البداية حتى الحد الأعلى (ميكروثانية)
+// (المجموع حوالي 7ms، أي أطول من دورة كتابة EEPROM التي لا يستجيب الجهاز خلالها)
+#define I2C_MAX_ATTEMPTS 8
+#define I2C_BACKOFF_START_US 100
+#define I2C_BACKOFF_MAX_US 2000
 
 // --- تعريفات الأجهزة ---
 // دبوس المرحل (Relay)
 #define RELAY_PIN 16
+// عدد قنوات المرحل (1-8). حالة جميع القنوات تُحفظ كقناع بتات واحد في RELAY_STATE_ADDR
+#ifndef RELAY_CHANNEL_COUNT
+#define RELAY_CHANNEL_COUNT 1
+#endif
+// دبابيس القنوات بترتيب الفهرس (القناة 0 تستخدم دائماً الدبوس الممرر للمُنشئ)
+#ifndef RELAY_CHANNEL_PINS
+#define RELAY_CHANNEL_PINS { RELAY_PIN }
+#endif
+// إخراج القنوات عبر مسجل إزاحة 74HC595 بدلاً من الدبابيس المباشرة (تعريف الدبابيس الثلاثة يفعّله)
+// #define RELAY_SHIFT_DATA_PIN 13
+// #define RELAY_SHIFT_CLOCK_PIN 14
+// #define RELAY_SHIFT_LATCH_PIN 15
+// قناع جميع القنوات
+#define RELAY_CHANNEL_ALL ((uint8_t)((1u << RELAY_CHANNEL_COUNT) - 1))
+static_assert(RELAY_CHANNEL_COUNT >= 1 && RELAY_CHANNEL_COUNT <= 8, "عدد قنوات المرحل يجب أن يكون بين 1 و 8");
+// الحد الأقصى لعدد مصادر حالة المرحل المسجلة (الجداول، أوقات الصلاة، ...)
+#define MAX_RELAY_SOURCES 4
+// مصادر طلبات المرحل في الحَكَم (MainControlClass)
+#define RELAY_SOURCE_MANUAL 0    // طلبات API اليدوية
+#define RELAY_SOURCE_CARD 1      // بطاقات المستخدمين
+#define RELAY_SOURCE_SCHEDULE 2  // الجداول الزمنية وأيام الاستثناء
+#define RELAY_SOURCE_PRAYER 3    // المرحل التلقائي لأوقات الصلاة
+#define RELAY_SOURCE_COUNT 4
+#define RELAY_SOURCE_NONE 0xFF
+// قيمة المهلة التي تعني "مهلة المصدر المحفوظة"
+#define RELAY_TIMEOUT_DEFAULT 0xFFFFFFFFUL
+// الحد الأقصى لعدد المشتركين في إشعارات تغير الساعة
+#define MAX_TIME_LISTENERS 4
+// أقصى مدة بين قراءتين لـ RTC في خدمة الوقت المشتركة (الوقت بينهما يُقدر من millis())
+#define TIME_RESYNC_MS 3600000UL
+// فرق (بالثواني) بين RTC والتقدير يُعتبر تغيراً للساعة وليس انحرافاً
+#define TIME_JUMP_SECONDS 2
+// طول فترة قياس انحراف millis() عن RTC، وأقصى انحراف مقبول لبلورة (جزء من المليون)
+#define TIME_DRIFT_WINDOW_MS 86400000UL
+#define TIME_MAX_DRIFT_PPM 500
+// وضع دبوس INT/SQW في DS3231 (الدبوس نفسه يخرج إما مقاطعة التنبيه أو الموجة المربعة)
+#define RTC_PIN_MODE_ALARM 0 // مقاطعة عند تطابق Alarm1/Alarm2
+#define RTC_PIN_MODE_SQW 1   // نبضة كل ثانية (1 Hz) لضبط طور التقدير، والمواعيد تُفحص عند كل نبضة
+// منافذ الاستيقاظ في خدمة الوقت (في وضع التنبيه: المنفذ 0 = Alarm1، المنفذ 1 = Alarm2 بدقة الدقيقة)
+#define TIME_WAKE_SCHEDULE 0
+#define TIME_WAKE_PRAYER 1
+#define TIME_WAKE_SLOTS 2
+// مهلة احتياطية بعد موعد التنبيه قبل الفحص بـ millis() إذا لم تصل المقاطعة
+#define RTC_ALARM_GRACE_MS 2000
+// تعريف هذا لاستخدام النوم الخفيف لـ ESP32 في TimeService::idle() حتى مقاطعة التنبيه
+// (يتوقف Wi-Fi عن الاستجابة أثناء النوم، لذا هو معطل افتراضياً)
+// #define USE_RTC_LIGHT_SLEEP
+
+// --- جدول المهام المشترك (عجلة مؤقتات هرمية) ---
+// الحد الأقصى لعدد المهام المسجلة (قابل للتجاوز قبل تضمين المكتبة)
+#ifndef MAX_SCHEDULED_TASKS
+#define MAX_SCHEDULED_TASKS 16
+#endif
+// مدة النبضة الواحدة للعجلة بالمللي ثانية
+#define TASK_TICK_MS 1
+// مستويات العجلة وعدد بتات الخانة في كل مستوى (4 × 64 خانة = 2^24 نبضة ≈ 4.6 ساعات بنبضة 1ms،
+// والمواعيد الأبعد تُعاد جدولتها تلقائياً)
+#define TASK_WHEEL_LEVELS 4
+#define TASK_WHEEL_BITS 6
+#define TASK_WHEEL_SLOTS (1 << TASK_WHEEL_BITS)
+// ميزانية تنفيذ المهام المستحقة في دورة واحدة (ميكروثانية)، والباقي يُؤجل للدورة التالية
+#define TASK_SERVICE_BUDGET_US 20000UL
+// معرف مهمة غير صالح
+#define TASK_NONE 0xFF
+// مدة تعني "بلا موعد"
+#define TASK_NO_DEADLINE 0xFFFFFFFFUL
+
+// --- عامل التخزين (ESP32 ثنائي النواة) ---
+// تعريف هذا لتنفيذ جميع عمليات I2C و EEPROM في مهمة FreeRTOS مثبتة على النواة الأخرى،
+// فلا تنتظر handleClient() دورات كتابة EEPROM (بدونه تُنفذ العمليات مباشرة كما سابقاً)
+// #define USE_STORAGE_WORKER
+// سعة طابور الطلبات وطابور الإكمال (قوة للعدد 2، والسعة الفعلية أقل بواحد)
+#ifndef STORAGE_QUEUE_DEPTH
+#define STORAGE_QUEUE_DEPTH 16
+#endif
+// أقصى بيانات تُنسخ داخل طلب واحد: صفحة EEPROM كاملة، فتُقسم الكتابات الأكبر عند حدود الصفحات
+// ويبقى كل طلب كتابة دورة كتابة واحدة كالكتابة المباشرة
+#define STORAGE_PAYLOAD_SIZE EXTERNAL_EEPROM_PAGE_SIZE
+// النواة والمكدس والأولوية لمهمة العامل (loop() تعمل على النواة 1)
+#define STORAGE_WORKER_CORE 0
+#define STORAGE_WORKER_STACK 4096
+#define STORAGE_WORKER_PRIORITY 2
+
+// --- خادم HTTP غير المتزامن (AsyncHttpServer) ---
+// عدد الاتصالات المتزامنة (خانات ثابتة؛ الاتصالات الزائدة تنتظر في طابور الاستماع)
+#ifndef HTTP_MAX_CONNECTIONS
+#define HTTP_MAX_CONNECTIONS 4
+#endif
+// حدود الطلب: الترويسات (431 إذا تجاوزها)، الجسم (413 إذا تجاوزه)، وعدد الوسائط
+#define HTTP_MAX_HEADER_SIZE 1024
+#define HTTP_MAX_BODY_SIZE 4096
+#define HTTP_MAX_ARGS 16
+// مهلة الاتصال الخامل أو العميل الذي توقف عن الاستلام (مللي ثانية)
+#define HTTP_IDLE_TIMEOUT_MS 5000UL
+// أقصى كتابة واحدة على المقبس (مقطع TCP واحد)
+#define HTTP_WRITE_SLICE 1460
+// حجم مخزن الرد الذي يُدفع بعده الرد المجزأ للمقبس من داخل المعالج
+#define HTTP_OUTPUT_HIGH_WATER 4096
+// أقصى ما يبقى في مخزن الرد المجزأ دون إرسال؛ بعده يُلغى الرد (العميل لا يستلم) بدل انتظاره داخل المعالج
+#ifndef HTTP_OUTPUT_MAX_PENDING
+#define HTTP_OUTPUT_MAX_PENDING 16384
+#endif
+
+// --- مقاييس التشغيل (/api/metrics) ---
+// الحد الأقصى لعدد المسارات المقاسة (المسارات الزائدة تعمل دون قياس)
+#ifndef METRICS_MAX_ROUTES
+#define METRICS_MAX_ROUTES 48
+#endif
+// خانات مدرج الزمن: الأولى أقل من 2^METRICS_BUCKET_SHIFT ميكروثانية (128)، وكل خانة ضعف سابقتها
+// (12 خانة: حتى 131 ms، والأخيرة لكل ما يتجاوزها)
+#define METRICS_LATENCY_BUCKETS 12
+#define METRICS_BUCKET_SHIFT 7
+// رقم مسار غير مقاس
+#define METRICS_NO_ROUTE 0xFF
+// كاشف التوقف: دورة handleClient() أو معالج يتجاوز هذه المدة يُسجل في حلقة آخر التوقفات
+#ifndef METRICS_STALL_THRESHOLD_US
+#define METRICS_STALL_THRESHOLD_US 50000UL
+#endif
+#define METRICS_STALL_SLOTS 8
+// تعريف هذا لأخذ عينة من موضع التنفيذ (المسار أو مرحلة الدورة) على مؤقت عتادي
+// كل METRICS_SAMPLE_PERIOD_US أثناء دورة تجاوزت حد التوقف (ESP32 و ESP8266)
+// #define USE_STALL_SAMPLER
+#define METRICS_SAMPLE_PERIOD_US 10000UL
+// رسم المكدس قبل كل معالج لقياس أقصى عمق يستخدمه: أقصى ما يُرسم تحت موضع الدخول (ضمن حد مكدس المهمة)،
+// وهامش تحت الموضع الحالي لإطار دالة الرسم، وحارس فوق حد المكدس (نقطة مراقبة نهاية المكدس في ESP32)
+// (عمق stack في /api/metrics قرب PAINT_BYTES + MARGIN يعني أن المعالج تجاوز المنطقة المرسومة)
+#ifndef METRICS_STACK_PAINT_BYTES
+#define METRICS_STACK_PAINT_BYTES 6144
+#endif
+#define METRICS_STACK_MARGIN 256
+#define METRICS_STACK_GUARD 64
+#define METRICS_STACK_PATTERN 0x5AC3E11DUL
 // حجم EEPROM الداخلية (إذا لم يتم استخدام الخارجية)
 #define EEPROM_SIZE 1024 
 // حجم EEPROM الخارجية (لضمان مساحة كافية)
@@ -46,7 +215,7 @@
 #define MAX_USER_TAGS 300
 
 // --- تعيينات عناوين EEPROM (تم تعديلها لتجنب التداخل) ---
-// عنوان حالة المرحل (Relay) - 1 بايت (true/false)
+// عنوان حالة المرحل (Relay) - 1 بايت (قناع القنوات: البت i = القناة i، والقيمة القديمة 1 = القناة 0)
 #define RELAY_STATE_ADDR 0 
 // عنوان طريقة التشغيل (0: يدوي, 1: تلقائي) - 1 بايت
 #define OP_METHOD_ADDR 1 // تم الإبقاء عليه لعدم كسر تسلسل العناوين القديم، لكنه غير مستخدم الآن
@@ -91,34 +260,219 @@
 #endif
 
 
-// الحد الأقصى لعدد الجداول الزمنية
-#define MAX_SCHEDULES 10
+// الحد الأقصى لعدد الجداول الزمنية (قابل للتجاوز قبل تضمين المكتبة)
+#ifndef MAX_SCHEDULES
+#define MAX_SCHEDULES 256
+#endif
 // حجم هيكل الجدول الزمني بالبايت
-#define SCHEDULE_SIZE 13 
-// عنوان بداية تخزين الجداول الزمنية - (MAX_SCHEDULES * SCHEDULE_SIZE) بايت
+#define SCHEDULE_SIZE 23 
+// عدد الجداول المعروضة في الصفحة الواحدة افتراضياً عند طلب الترقيم
+#define SCHEDULE_PAGE_DEFAULT_LIMIT 20
+// فترة الفحص السريع لـ RTC خلال الثانية الأخيرة قبل حدث الجدول (لدقة التبديل عند بداية الدقيقة)
+#define SCHEDULE_EDGE_POLL_MS 5
+// أقصى مدة نوم بين قراءتين لـ RTC، لتصحيح انحراف millis() عن ساعة RTC
+#define SCHEDULE_RESYNC_MS 3600000UL
+
+// --- منطقة الجداول الزمنية المخصصة (في EEPROM الخارجية بعد منطقة المستخدمين والإحصائيات) ---
+// الرأس ثم خريطة إشغال الخانات (بت لكل خانة) مقربة لصفحة كاملة، ثم سجلات الجداول - (MAX_SCHEDULES * SCHEDULE_SIZE) بايت
+#define SCHEDULE_REGION_ADDR 0x1400
+// قيمة التحقق من تهيئة المنطقة (خانات ثابتة مع خريطة إشغال، سجلات بحجم SCHEDULE_SIZE)
+#define SCHEDULE_REGION_MAGIC 0x5345
+// حجم خريطة إشغال الخانات بالبايت
+#define SCHEDULE_BITMAP_SIZE ((MAX_SCHEDULES + 7) / 8)
+// عنوان خريطة إشغال الخانات (مباشرة بعد الرأس)
+#define SCHEDULE_BITMAP_ADDR (SCHEDULE_REGION_ADDR + sizeof(ScheduleRegionHeader))
+// عنوان بداية سجلات الجداول الزمنية (بداية أول صفحة بعد الرأس والخريطة)
+#define SCHEDULE_RECORDS_ADDR (SCHEDULE_REGION_ADDR + \
+    ((sizeof(ScheduleRegionHeader) + SCHEDULE_BITMAP_SIZE + EXTERNAL_EEPROM_PAGE_SIZE - 1) / EXTERNAL_EEPROM_PAGE_SIZE) * EXTERNAL_EEPROM_PAGE_SIZE)
+
+// المنطقة القديمة للجداول (10 سجلات بحجم 13 بايت ومعرف 8 بت) - تُقرأ مرة واحدة للترحيل فقط
+#define LEGACY_MAX_SCHEDULES 10
+#define LEGACY_SCHEDULE_SIZE 13
 #ifdef ENABLE_USER_STATISTICS
 #define SCHEDULE_START_ADDR (STATISTICS_START_ADDR + (MAX_USER_TAGS * sizeof(int))) 
 #else
 #define SCHEDULE_START_ADDR (USER_TAGS_START_ADDR + (MAX_USER_TAGS * USER_TAG_LEN)) 
 #endif
 
-// هيكل إعدادات المرحل التلقائي لأوقات الصلاة
+// هيكل إعدادات المرحل التلقائي لأوقات الصلاة (التخطيط القديم لثلاث صلوات)
+// يبقى في مكانه للحفاظ على العناوين التالية، ويُقرأ فقط للترحيل إلى PrayerRelayConfig
 struct AutoRelayPrayerConfig {
     bool enabled;           // هل المرحل التلقائي مفعل؟
     int minutesBefore[3];   // دقائق قبل (للفجر، المغرب، العشاء)
     int minutesAfter[3];    // دقائق بعد (للفجر، المغرب، العشاء)
 };
 
-// هيكل الجدول الزمني
-struct Schedule {
-    uint8_t id;             // معرف فريد للجدول الزمني
+// نوع الجدول الزمني
+#define SCHEDULE_KIND_POINT 0     // حدث واحد: تعيين المرحل إلى turnOn عند الوقت المحدد
+#define SCHEDULE_KIND_INTERVAL 1  // فترة: تشغيل عند البداية وإيقاف عند النهاية (قد تمتد بعد منتصف الليل)
+
+// مرجع وقت الجدول: ساعة ثابتة، أو وقت شمسي/صلاة اليوم مع إزاحة بالدقائق
+#define SCHEDULE_ANCHOR_CLOCK 0
+#define SCHEDULE_ANCHOR_FAJR 1
+#define SCHEDULE_ANCHOR_SUNRISE 2
+#define SCHEDULE_ANCHOR_DHUHR 3
+#define SCHEDULE_ANCHOR_ASR 4
+#define SCHEDULE_ANCHOR_SUNSET 5   // الغروب = المغرب
+#define SCHEDULE_ANCHOR_ISHA 6
+#define SCHEDULE_ANCHOR_COUNT 7
+
+// هيكل الجدول الزمني (مضغوط ليطابق تخطيط EEPROM بايت ببايت، ويُقرأ ويُكتب ككتلة واحدة)
+struct __attribute__((packed)) Schedule {
+    uint16_t id;            // معرف فريد وثابت للجدول الزمني (لا يتغير عند حذف جداول أخرى)
     uint8_t hour;           // الساعة (0-23)
     uint8_t minute;         // الدقيقة (0-59)
     bool turnOn;            // True لتشغيل المرحل، False لإيقافه
     bool repeatEveryDay;    // True إذا كان الجدول يتكرر يومياً
     bool days[7];           // مصفوفة لأيام الأسبوع المحددة (الأحد=0، الإثنين=1، ...، السبت=6)
     bool active;            // True إذا كان الجدول نشطاً، False إذا تم حذفه/إلغاء تنشيطه
+    // --- الحقول التالية تساوي 0 في السجلات المرحلة من المنطقة القديمة (جدول نقطي بساعة ثابتة) ---
+    uint8_t kind : 4;       // SCHEDULE_KIND_POINT أو SCHEDULE_KIND_INTERVAL (النصف الأدنى من البايت)
+    uint8_t channel : 4;    // قناة المرحل (النصف الأعلى من البايت)
+    uint8_t anchor;         // مرجع وقت البداية (SCHEDULE_ANCHOR_*). مع CLOCK تُستخدم hour/minute
+    int16_t offset;         // إزاحة البداية بالدقائق عن المرجع (عند عدم استخدام CLOCK)
+    uint8_t endHour;        // ساعة نهاية الفترة (0-23)
+    uint8_t endMinute;      // دقيقة نهاية الفترة (0-59)
+    uint8_t endAnchor;      // مرجع وقت النهاية (SCHEDULE_ANCHOR_*)
+    int16_t endOffset;      // إزاحة النهاية بالدقائق عن المرجع
+};
+static_assert(sizeof(Schedule) == SCHEDULE_SIZE, "يجب أن يطابق حجم هيكل Schedule قيمة SCHEDULE_SIZE");
+
+// رأس منطقة الجداول الزمنية في EEPROM
+struct __attribute__((packed)) ScheduleRegionHeader {
+    uint16_t magic;         // SCHEDULE_REGION_MAGIC إذا كانت المنطقة مهيأة
+    uint16_t nextId;        // المعرف التالي الذي سيُعطى لجدول جديد
+    uint16_t count;         // عدد الخانات المشغولة
+};
+
+// --- تقويم الاستثناءات (العطل والإغلاقات) للجداول الزمنية ---
+// الحد الأقصى لعدد فترات الاستثناء المحفوظة
+#define MAX_SCHEDULE_EXCEPTIONS 64
+// نوع الاستثناء (عند تداخل الفترات يُطبق النوع ذو القيمة الأعلى)
+#define EXCEPTION_KIND_NONE 0       // يوم عادي
+#define EXCEPTION_KIND_SUPPRESS 1   // تجاهل الجداول دون تغيير المرحل
+#define EXCEPTION_KIND_FORCE_ON 2   // تجاهل الجداول وتشغيل المرحل طوال اليوم
+#define EXCEPTION_KIND_FORCE_OFF 3  // تجاهل الجداول وإيقاف المرحل طوال اليوم
+// منطقة الاستثناءات: الرأس ثم سجلات الفترات (بعد سجلات الجداول الزمنية)
+#define EXCEPTION_REGION_ADDR 0x2C00
+// قيمة التحقق من تهيئة منطقة الاستثناءات
+#define EXCEPTION_REGION_MAGIC 0x4558
+
+// فترة استثناء (التواريخ بعدد الأيام منذ 1970-01-01، شاملة للطرفين)
+struct __attribute__((packed)) ExceptionRange {
+    uint16_t id;            // معرف فريد للفترة
+    uint16_t firstDay;      // أول يوم في الفترة
+    uint16_t lastDay;       // آخر يوم في الفترة
+    uint8_t kind;           // EXCEPTION_KIND_*
+};
+
+// رأس منطقة الاستثناءات في EEPROM
+struct __attribute__((packed)) ExceptionRegionHeader {
+    uint16_t magic;         // EXCEPTION_REGION_MAGIC إذا كانت المنطقة مهيأة
+    uint16_t nextId;        // المعرف التالي لفترة جديدة
+    uint8_t count;          // عدد الفترات المحفوظة (متتالية بعد الرأس)
+};
+// عنوان بداية سجلات الفترات
+#define EXCEPTION_RECORDS_ADDR (EXCEPTION_REGION_ADDR + sizeof(ExceptionRegionHeader))
+static_assert(SCHEDULE_RECORDS_ADDR + MAX_SCHEDULES * SCHEDULE_SIZE <= EXCEPTION_REGION_ADDR,
+              "منطقة الاستثناءات تتداخل مع سجلات الجداول الزمنية");
+
+// --- جدول أوقات الصلاة السنوي المحسوب مسبقاً (في EEPROM الخارجية بعد منطقة الاستثناءات) ---
+// الرأس، ثم قيمة مرجعية لأول يوم في كل شهر (12 × 6 دقائق)، ثم فروق يومية بحجم 4 بت (3 بايت لكل يوم)
+#define PRAYER_TABLE_ADDR 0x2E00
+// قيمة التحقق من صلاحية الجدول
+#define PRAYER_TABLE_MAGIC 0x5055
+// الجدول حُسب لهذه الإعدادات لكن تعذر ترميزه (يُستخدم الحساب المباشر دون إعادة المحاولة)
+#define PRAYER_TABLE_MAGIC_UNENCODABLE 0x5046
+// عدد الأوقات المحفوظة لكل يوم (الفجر، الشروق، الظهر، العصر، المغرب، العشاء)
+#define PRAYER_TABLE_TIMES 6
+// حجم فروق اليوم الواحد بالبايت (6 قيم × 4 بت)
+#define PRAYER_TABLE_DAY_BYTES (PRAYER_TABLE_TIMES / 2)
+
+// رأس الجدول السنوي: السنة والإعدادات التي حُسب بها (يُعاد توليده عند اختلاف أي منها)
+struct __attribute__((packed)) PrayerTableHeader {
+    uint16_t magic;         // PRAYER_TABLE_MAGIC إذا كان الجدول مكتملاً
+    uint16_t year;          // السنة المحسوبة
+    int32_t latitudeE4;     // خط العرض × 10000
+    int32_t longitudeE4;    // خط الطول × 10000
+    int8_t timezone;        // المنطقة الزمنية
+    uint8_t method;         // طريقة الحساب (PRAYER_METHOD_*)
+    uint8_t asrFactor;      // معامل ظل العصر (1 شافعي، 2 حنفي)
 };
+// عنوان القيم المرجعية الشهرية (uint16_t لكل وقت)
+#define PRAYER_TABLE_KEYFRAMES_ADDR (PRAYER_TABLE_ADDR + sizeof(PrayerTableHeader))
+// عنوان الفروق اليومية
+#define PRAYER_TABLE_DELTAS_ADDR (PRAYER_TABLE_KEYFRAMES_ADDR + 12 * PRAYER_TABLE_TIMES * sizeof(uint16_t))
+static_assert(EXCEPTION_RECORDS_ADDR + MAX_SCHEDULE_EXCEPTIONS * sizeof(ExceptionRange) <= PRAYER_TABLE_ADDR,
+              "جدول أوقات الصلاة يتداخل مع منطقة الاستثناءات");
+static_assert(PRAYER_TABLE_DELTAS_ADDR + 366 * PRAYER_TABLE_DAY_BYTES <= EX_EEPROM_SIZE,
+              "جدول أوقات الصلاة يتجاوز حجم EEPROM الخارجية");
+
+// --- طريقة حساب أوقات الصلاة (خارج كتلة PRAYER_CONFIG_ADDR للحفاظ على العناوين القديمة) ---
+#define PRAYER_METHOD_ADDR 0x3300
+// طرق الحساب المدعومة (القيمة 0 = المصرية، وهي الطريقة المستخدمة سابقاً)
+#define PRAYER_METHOD_EGYPTIAN 0
+#define PRAYER_METHOD_MWL 1       // رابطة العالم الإسلامي
+#define PRAYER_METHOD_ISNA 2      // أمريكا الشمالية
+#define PRAYER_METHOD_MAKKAH 3    // أم القرى
+#define PRAYER_METHOD_KARACHI 4   // جامعة العلوم الإسلامية، كراتشي
+#define PRAYER_METHOD_COUNT 5
+// معامل ظل العصر
+#define PRAYER_ASR_SHAFII 1
+#define PRAYER_ASR_HANAFI 2
+
+// طريقة الحساب المحفوظة
+struct __attribute__((packed)) PrayerMethodConfig {
+    uint8_t method;         // PRAYER_METHOD_*
+    uint8_t asrFactor;      // PRAYER_ASR_SHAFII أو PRAYER_ASR_HANAFI
+};
+static_assert(PRAYER_TABLE_DELTAS_ADDR + 366 * PRAYER_TABLE_DAY_BYTES <= PRAYER_METHOD_ADDR,
+              "طريقة حساب الصلاة تتداخل مع الجدول السنوي");
+
+// --- نوافذ المرحل التلقائي لجميع أوقات اليوم (منطقة جديدة حتى لا تُزاح عناوين المستخدمين) ---
+#define PRAYER_RELAY_ADDR (PRAYER_METHOD_ADDR + sizeof(PrayerMethodConfig))
+#define PRAYER_RELAY_MAGIC 0x5052
+
+// نافذة تشغيل لكل وقت من أوقات اليوم الستة (بترتيب PrayerIndex: الفجر، الشروق، الظهر، العصر، المغرب، العشاء)
+struct __attribute__((packed)) PrayerRelayConfig {
+    uint16_t magic;            // PRAYER_RELAY_MAGIC إذا كانت المنطقة مهيأة
+    bool enabled;              // هل المرحل التلقائي مفعل؟
+    uint8_t prayerMask;        // البت i = نافذة الوقت i مفعلة
+    int16_t minutesBefore[6];  // دقائق قبل كل وقت
+    int16_t minutesAfter[6];   // دقائق بعد كل وقت
+};
+static_assert(PRAYER_RELAY_ADDR + sizeof(PrayerRelayConfig) <= EX_EEPROM_SIZE,
+              "نوافذ المرحل التلقائي تتجاوز حجم EEPROM الخارجية");
+
+// --- إعدادات حَكَم المرحل (أولوية ومهلة كل مصدر) ---
+#define RELAY_ARBITER_ADDR (PRAYER_RELAY_ADDR + sizeof(PrayerRelayConfig))
+#define RELAY_ARBITER_MAGIC 0x5241
+
+// الطلب الفعّال هو صاحب أعلى أولوية، وعند التساوي الأحدث (فالأولويات المتساوية = آخر طلب يفوز كما سابقاً)
+struct __attribute__((packed)) RelayArbiterConfig {
+    uint16_t magic;                               // RELAY_ARBITER_MAGIC إذا كانت المنطقة مهيأة
+    uint8_t priority[RELAY_SOURCE_COUNT];         // أولوية كل مصدر (الأعلى يغلب)
+    uint16_t timeoutSeconds[RELAY_SOURCE_COUNT];  // مدة صلاحية طلب المصدر بالثواني (0 = بلا انتهاء)
+};
+static_assert(RELAY_ARBITER_ADDR + sizeof(RelayArbiterConfig) <= EX_EEPROM_SIZE,
+              "إعدادات حَكَم المرحل تتجاوز حجم EEPROM الخارجية");
+
+// --- القنوات الافتراضية لكل مصدر (الطلبات التي لا تحدد قناة: اليدوي، البطاقة، أوقات الصلاة) ---
+#define RELAY_CHANNEL_CONFIG_ADDR (RELAY_ARBITER_ADDR + sizeof(RelayArbiterConfig))
+#define RELAY_CHANNEL_CONFIG_MAGIC 0x5243
+
+// الجداول الزمنية تحمل قناتها في كل جدول، فلا تُستخدم خانة RELAY_SOURCE_SCHEDULE
+struct __attribute__((packed)) RelayChannelConfig {
+    uint16_t magic;                            // RELAY_CHANNEL_CONFIG_MAGIC إذا كانت المنطقة مهيأة
+    uint8_t sourceChannels[RELAY_SOURCE_COUNT]; // قناع القنوات لكل مصدر (الافتراضي: القناة 0)
+};
+static_assert(RELAY_CHANNEL_CONFIG_ADDR + sizeof(RelayChannelConfig) <= EX_EEPROM_SIZE,
+              "قنوات المصادر تتجاوز حجم EEPROM الخارجية");
+
+// الحد الأقصى لعدد الأيام في طلب واحد لتقويم أوقات الصلاة (?from=&days=)
+#define PRAYER_CALENDAR_MAX_DAYS 366
+// عدد الأيام الافتراضي إذا لم يُحدد days
+#define PRAYER_CALENDAR_DEFAULT_DAYS 30
 
 // تعريف كائن الخادم الويب كخارجي ليتم الوصول إليه من جميع الفئات
 extern WebServer server; 
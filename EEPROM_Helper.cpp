@@ -1,154 +1,159 @@
 // EEPROM_Helper.cpp
 #include "EEPROM_Helper.h"
+#include "StorageWorker.h"
+#include "I2CBus.h"
 
-// قسم الكود الخاص بـ EEPROM الخارجية (باستخدام Wire)
-#ifdef USE_EXTERNAL_EEPROM
-
-// قراءة بايت واحد من EEPROM الخارجية
-uint8_t EEPROMHelper::readByte(unsigned int address) {
-    Wire.beginTransmission(EXTERNAL_EEPROM_ADDR);
-    Wire.write((int)(address >> 8));   // الجزء العلوي من العنوان (MSB)
-    Wire.write((int)(address & 0xFF)); // الجزء السفلي من العنوان (LSB)
-    Wire.endTransmission();
-    Wire.requestFrom(EXTERNAL_EEPROM_ADDR, 1); // طلب بايت واحد
-    return Wire.read(); // قراءة البايت
-}
+uint32_t EEPROMHelper::_reads = 0;
+uint32_t EEPROMHelper::_writes = 0;
+uint32_t EEPROMHelper::_commits = 0;
 
-// كتابة بايت واحد في EEPROM الخارجية
-void EEPROMHelper::writeByte(unsigned int address, uint8_t data) {
-    Wire.beginTransmission(EXTERNAL_EEPROM_ADDR);
-    Wire.write((int)(address >> 8));   // الجزء العلوي من العنوان (MSB)
-    Wire.write((int)(address & 0xFF)); // الجزء السفلي من العنوان (LSB)
-    Wire.write(data); // كتابة البيانات
-    Wire.endTransmission();
-    delay(5); // تأخير قصير للسماح لـ EEPROM بإكمال دورة الكتابة
-}
+// قسم الكود الخاص بـ EEPROM الخارجية (عبر مدير ناقل I2C)
+#ifdef USE_EXTERNAL_EEPROM
 
-// قراءة بايتات متعددة من EEPROM الخارجية
-void EEPROMHelper::readBytes(unsigned int address, byte* buffer, int length) {
-    Wire.beginTransmission(EXTERNAL_EEPROM_ADDR);
-    Wire.write((int)(address >> 8));   // الجزء العلوي من العنوان (MSB)
-    Wire.write((int)(address & 0xFF)); // الجزء السفلي من العنوان (LSB)
-    Wire.endTransmission();
-    Wire.requestFrom(EXTERNAL_EEPROM_ADDR, length); // طلب عدد معين من البايتات
-    for (int i = 0; i < length; i++) {
-        if (Wire.available()) {
-            buffer[i] = Wire.read(); // قراءة البايتات في المخزن المؤقت
+// قراءة بايتات متعددة من EEPROM الخارجية مباشرة عبر مدير الناقل
+// تُقسم القراءة إلى أجزاء لا تتجاوز مخزن Wire المؤقت، فتُقرأ الكتل الكبيرة (مثل جدول كامل) باستدعاء واحد
+void EEPROMHelper::deviceRead(unsigned int address, byte* buffer, int length) {
+    _reads++;
+    I2CBus::lock(I2C_DEVICE_EEPROM); // الأجزاء متتالية دون تداخل من مهمة أخرى
+    int offset = 0;
+    while (offset < length) {
+        int chunk = length - offset;
+        if (chunk > I2C_TRANSFER_CHUNK) {
+            chunk = I2C_TRANSFER_CHUNK;
         }
+        unsigned int chunkAddr = address + offset;
+        uint8_t reg[2] = { (uint8_t)(chunkAddr >> 8), (uint8_t)(chunkAddr & 0xFF) }; // MSB ثم LSB
+        I2CBus::read(I2C_DEVICE_EEPROM, reg, sizeof(reg), buffer + offset, chunk);
+        offset += chunk;
     }
-}
-
-// كتابة بايتات متعددة في EEPROM الخارجية
-void EEPROMHelper::writeBytes(unsigned int address, const byte* buffer, int length) {
-    Wire.beginTransmission(EXTERNAL_EEPROM_ADDR);
-    Wire.write((int)(address >> 8));   // الجزء العلوي من العنوان (MSB)
-    Wire.write((int)(address & 0xFF)); // الجزء السفلي من العنوان (LSB)
-    for (int i = 0; i < length; i++) {
-        Wire.write(buffer[i]); // كتابة البايتات من المخزن المؤقت
+    I2CBus::unlock();
+}
+
+// كتابة بايتات متعددة في EEPROM الخارجية مباشرة عبر مدير الناقل
+// تُقسم الكتابة عند حدود صفحات EEPROM وحجم مخزن Wire، مع دورة كتابة واحدة لكل جزء
+// ينتهي انتظار الدورة عند أول استجابة للجهاز بدلاً من delay(5) ثابت
+void EEPROMHelper::deviceWrite(unsigned int address, const byte* buffer, int length) {
+    _writes++;
+    I2CBus::lock(I2C_DEVICE_EEPROM);
+    int offset = 0;
+    while (offset < length) {
+        unsigned int chunkAddr = address + offset;
+        int chunk = EXTERNAL_EEPROM_PAGE_SIZE - (chunkAddr % EXTERNAL_EEPROM_PAGE_SIZE); // المتبقي حتى نهاية الصفحة
+        if (chunk > I2C_TRANSFER_CHUNK) {
+            chunk = I2C_TRANSFER_CHUNK;
+        }
+        if (chunk > length - offset) {
+            chunk = length - offset;
+        }
+        uint8_t reg[2] = { (uint8_t)(chunkAddr >> 8), (uint8_t)(chunkAddr & 0xFF) }; // MSB ثم LSB
+        I2CBus::write(I2C_DEVICE_EEPROM, reg, sizeof(reg), buffer + offset, chunk);
+        I2CBus::waitReady(I2C_DEVICE_EEPROM); // دورة الكتابة الداخلية
+        _commits++;
+        offset += chunk;
     }
-    Wire.endTransmission();
-    delay(5); // تأخير قصير للسماح لـ EEPROM بإكمال دورة الكتابة
+    I2CBus::unlock();
 }
 
-// قراءة قيمة عدد صحيح (int) من EEPROM الخارجية
-int EEPROMHelper::readInt(unsigned int address) {
-    int value;
-    readBytes(address, (byte*)&value, sizeof(int)); // قراءة البايتات وتحويلها إلى int
-    return value;
+// قسم الكود الخاص بـ EEPROM الداخلية (باستخدام مكتبة EEPROM)
+#else 
+
+// قراءة بايتات متعددة من EEPROM الداخلية مباشرة
+void EEPROMHelper::deviceRead(unsigned int address, byte* buffer, int length) {
+    _reads++;
+    EEPROM.readBytes(address, buffer, length);
 }
 
-// كتابة قيمة عدد صحيح (int) في EEPROM الخارجية
-void EEPROMHelper::writeInt(unsigned int address, int value) {
-    writeBytes(address, (const byte*)&value, sizeof(int)); // كتابة البايتات من int
+// كتابة بايتات متعددة في EEPROM الداخلية مباشرة
+void EEPROMHelper::deviceWrite(unsigned int address, const byte* buffer, int length) {
+    _writes++;
+    EEPROM.writeBytes(address, buffer, length);
+    EEPROM.commit(); // حفظ التغييرات
+    _commits++;
 }
 
-// قراءة سلسلة نصية (String) من EEPROM الخارجية
-String EEPROMHelper::readString(uint16_t address, uint16_t length) {
-    String result = "";
-    Wire.beginTransmission(EXTERNAL_EEPROM_ADDR);
-    Wire.write((address >> 8) & 0xFF); // الجزء العلوي من العنوان (MSB)
-    Wire.write(address & 0xFF);        // الجزء السفلي من العنوان (LSB)
-    Wire.endTransmission();
+#endif // USE_EXTERNAL_EEPROM
+
+// --- العمليات المشتركة (عبر عامل التخزين إذا كان يعمل) ---
 
-    Wire.requestFrom(EXTERNAL_EEPROM_ADDR, length); // طلب السلسلة بطولها المحدد
+// معاملات قراءة تُنفذ في عامل التخزين
+struct EEPROMReadArgs {
+    unsigned int address;
+    byte* buffer;
+    int length;
+};
 
-    while (Wire.available()) {
-        char c = Wire.read();
-        result += c; // إضافة الحرف إلى السلسلة
+// قراءة بايتات متعددة: في عامل التخزين إذا كان يعمل (بالترتيب بعد الكتابات المنتظرة)، وإلا مباشرة
+void EEPROMHelper::readBytes(unsigned int address, byte* buffer, int length) {
+    if (StorageWorker::offload()) {
+        EEPROMReadArgs args = { address, buffer, length };
+        StorageWorker::call([](void* context) {
+            EEPROMReadArgs* args = static_cast<EEPROMReadArgs*>(context);
+            deviceRead(args->address, args->buffer, args->length);
+        }, &args);
+        return;
     }
-    return result;
+    deviceRead(address, buffer, length);
 }
 
-// كتابة سلسلة نصية (String) في EEPROM الخارجية
-void EEPROMHelper::writeString(uint16_t address, String data) {
-    Wire.beginTransmission(EXTERNAL_EEPROM_ADDR);
-    Wire.write((address >> 8) & 0xFF); // الجزء العلوي من العنوان (MSB)
-    Wire.write(address & 0xFF);        // الجزء السفلي من العنوان (LSB)
-
-    for (uint16_t i = 0; i < data.length(); i++) {
-        Wire.write(data[i]); // كتابة كل حرف من السلسلة
+// كتابة بايتات متعددة: تُنسخ إلى طابور عامل التخزين وتعود فوراً إذا كان يعمل، وإلا مباشرة
+void EEPROMHelper::writeBytes(unsigned int address, const byte* buffer, int length) {
+    if (StorageWorker::offload()) {
+        StorageWorker::write(address, buffer, length);
+        return;
     }
-    Wire.endTransmission();
-    delay(5);  // تأخير قصير لدورة كتابة EEPROM
+    deviceWrite(address, buffer, length);
 }
 
-// قسم الكود الخاص بـ EEPROM الداخلية (باستخدام مكتبة EEPROM)
-#else 
-
-// قراءة بايت واحد من EEPROM الداخلية
+// قراءة بايت واحد (0xFF إذا فشلت القراءة، كقيمة EEPROM الممسوحة)
 uint8_t EEPROMHelper::readByte(unsigned int address) {
-    return EEPROM.read(address);
+    uint8_t value = 0xFF;
+    readBytes(address, &value, 1);
+    return value;
 }
 
-// كتابة بايت واحد في EEPROM الداخلية
+// كتابة بايت واحد
 void EEPROMHelper::writeByte(unsigned int address, uint8_t data) {
-    EEPROM.write(address, data);
-    EEPROM.commit(); // حفظ التغييرات
+    writeBytes(address, &data, 1);
 }
 
-// قراءة بايتات متعددة من EEPROM الداخلية
-void EEPROMHelper::readBytes(unsigned int address, byte* buffer, int length) {
-    EEPROM.readBytes(address, buffer, length);
-}
-
-// كتابة بايتات متعددة في EEPROM الداخلية
-void EEPROMHelper::writeBytes(unsigned int address, const byte* buffer, int length) {
-    EEPROM.writeBytes(address, buffer, length);
-    EEPROM.commit(); // حفظ التغييرات
-}
-
-// قراءة قيمة عدد صحيح (int) من EEPROM الداخلية
+// قراءة قيمة عدد صحيح (int)
 int EEPROMHelper::readInt(unsigned int address) {
-    return EEPROM.readInt(address);
+    int value = 0;
+    readBytes(address, (byte*)&value, sizeof(int)); // قراءة البايتات وتحويلها إلى int
+    return value;
 }
 
-// كتابة قيمة عدد صحيح (int) في EEPROM الداخلية
+// كتابة قيمة عدد صحيح (int)
 void EEPROMHelper::writeInt(unsigned int address, int value) {
-    EEPROM.writeInt(address, value);
-    EEPROM.commit(); // حفظ التغييرات
+    writeBytes(address, (const byte*)&value, sizeof(int)); // كتابة البايتات من int
 }
 
-// قراءة سلسلة نصية (String) من EEPROM الداخلية
+// قراءة سلسلة نصية (String) بطول معين، بقراءة كتلة واحدة لكل I2C_TRANSFER_CHUNK بايت
+// في EEPROM الداخلية تتوقف القراءة عند حرف النهاية، والخارجية تُقرأ بطولها كاملاً كما سابقاً
 String EEPROMHelper::readString(uint16_t address, uint16_t length) {
-    String data = "";
-    for (int i = 0; i < length; ++i) {
-        char c = EEPROM.read(address + i);
-        if (c == 0) { // عند الوصول إلى حرف النهاية (Null terminator)
-            break;
+    String result = "";
+    byte chunk[I2C_TRANSFER_CHUNK];
+    for (uint16_t offset = 0; offset < length; offset += sizeof(chunk)) {
+        uint16_t count = length - offset < (int)sizeof(chunk) ? length - offset : (uint16_t)sizeof(chunk);
+        readBytes(address + offset, chunk, count);
+        for (uint16_t i = 0; i < count; i++) {
+#ifndef USE_EXTERNAL_EEPROM
+            if (chunk[i] == 0) { // عند الوصول إلى حرف النهاية (Null terminator)
+                return result;
+            }
+#endif
+            result += (char)chunk[i];
         }
-        data += c;
     }
-    return data;
+    return result;
 }
 
-// كتابة سلسلة نصية (String) في EEPROM الداخلية
+// كتابة سلسلة نصية (String) بكتابة واحدة
+// في EEPROM الداخلية يُضاف حرف النهاية، والخارجية تُكتب دون حرف نهاية كما سابقاً
 void EEPROMHelper::writeString(uint16_t address, String data) {
-    int len = data.length();
-    for (int i = 0; i < len; ++i) {
-        EEPROM.write(address + i, data.charAt(i));
-    }
-    EEPROM.write(address + len, 0); // إضافة حرف النهاية (Null terminator)
-    EEPROM.commit(); // حفظ التغييرات
+#ifdef USE_EXTERNAL_EEPROM
+    writeBytes(address, (const byte*)data.c_str(), data.length());
+#else
+    writeBytes(address, (const byte*)data.c_str(), data.length() + 1); // مع حرف النهاية (Null terminator)
+#endif
 }
-
-#endif // USE_EXTERNAL_EEPROM
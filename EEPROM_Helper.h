@@ -5,6 +5,7 @@
 #include "Config.h" // لتضمين USE_EXTERNAL_EEPROM, EXTERNAL_EEPROM_ADDR
 
 // فئة مساعدة للتعامل مع عمليات قراءة وكتابة EEPROM
+// جميع العمليات تمر عبر readBytes و writeBytes، فتُحول إلى عامل التخزين عندما يعمل (انظر StorageWorker)
 class EEPROMHelper {
 public:
     // قراءة بايت واحد من عنوان محدد
@@ -35,6 +36,20 @@ public:
     static void get(int address, T& value) {
         readBytes(address, (byte*)&value, sizeof(T));
     }
+
+    // --- إحصائيات ---
+    static uint32_t reads() { return _reads; }     // عمليات القراءة من الجهاز
+    static uint32_t writes() { return _writes; }   // عمليات الكتابة على الجهاز
+    static uint32_t commits() { return _commits; } // دورات الكتابة الفعلية (صفحات 24C256، أو commit() للداخلية)
+
+private:
+    static uint32_t _reads;
+    static uint32_t _writes;
+    static uint32_t _commits;
+
+    // الوصول الفعلي إلى EEPROM (الخارجية عبر Wire أو الداخلية) في المهمة المستدعية
+    static void deviceRead(unsigned int address, byte* buffer, int length);
+    static void deviceWrite(unsigned int address, const byte* buffer, int length);
 };
 
 #endif // EEPROM_HELPER_H
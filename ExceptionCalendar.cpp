@@ -0,0 +1,137 @@
+// ExceptionCalendar.cpp
+#include "ExceptionCalendar.h"
+#include "RTCManager.h" // تنسيق التواريخ
+
+// أسماء أنواع الاستثناء في JSON (حسب ترتيب EXCEPTION_KIND_*)
+static const char* const EXCEPTION_KIND_NAMES[] = { "none", "suppress", "on", "off" };
+
+ExceptionCalendar::ExceptionCalendar() {
+    memset(&_header, 0, sizeof(_header));
+    memset(_yearMap, 0, sizeof(_yearMap));
+}
+
+// تحميل الفترات من EEPROM بقراءة واحدة (وتهيئة المنطقة إذا لم تكن مهيأة)
+void ExceptionCalendar::load() {
+    EEPROMHelper::get(EXCEPTION_REGION_ADDR, _header);
+    if (_header.magic != EXCEPTION_REGION_MAGIC || _header.count > MAX_SCHEDULE_EXCEPTIONS) {
+        _header.magic = EXCEPTION_REGION_MAGIC;
+        _header.nextId = 1;
+        _header.count = 0;
+        saveHeader();
+    }
+    if (_header.count > 0) {
+        EEPROMHelper::readBytes(EXCEPTION_RECORDS_ADDR, (byte*)_ranges, _header.count * sizeof(ExceptionRange));
+    }
+    _mapYear = 0; // تُبنى الخريطة عند أول فحص
+    Serial.print("تم تحميل فترات الاستثناء: "); Serial.println(_header.count);
+}
+
+// نوع الاستثناء المطبق في تاريخ معين
+// تكلفة ثابتة: قراءة 2 بت من خريطة السنة (تُعاد بناؤها مرة واحدة عند تغير السنة)
+uint8_t ExceptionCalendar::kindFor(const DateTime& date) {
+    if (_header.count == 0) {
+        return EXCEPTION_KIND_NONE;
+    }
+    if (date.year() != _mapYear) {
+        buildYearMap(date.year());
+    }
+    uint16_t dayOfYear = dayNumber(date) - dayNumber(DateTime(date.year(), 1, 1));
+    return (_yearMap[dayOfYear / 4] >> ((dayOfYear % 4) * 2)) & 0x03;
+}
+
+// إعادة بناء خريطة السنة من قائمة الفترات (النوع الأعلى يغلب عند التداخل)
+void ExceptionCalendar::buildYearMap(uint16_t year) {
+    memset(_yearMap, 0, sizeof(_yearMap));
+    _mapYear = year;
+    uint16_t yearFirst = dayNumber(DateTime(year, 1, 1));
+    uint16_t yearLast = dayNumber(DateTime(year, 12, 31));
+    for (uint8_t r = 0; r < _header.count; r++) {
+        const ExceptionRange& range = _ranges[r];
+        uint16_t first = range.firstDay > yearFirst ? range.firstDay : yearFirst;
+        uint16_t last = range.lastDay < yearLast ? range.lastDay : yearLast;
+        for (uint16_t day = first; day <= last && first <= last; day++) {
+            uint16_t index = day - yearFirst;
+            uint8_t shift = (index % 4) * 2;
+            uint8_t current = (_yearMap[index / 4] >> shift) & 0x03;
+            if (range.kind > current) {
+                _yearMap[index / 4] = (_yearMap[index / 4] & ~(0x03 << shift)) | (range.kind << shift);
+            }
+        }
+    }
+}
+
+// إضافة فترة في نهاية القائمة (كتابة السجل والرأس فقط)
+uint16_t ExceptionCalendar::add(const DateTime& first, const DateTime& last, uint8_t kind) {
+    if (_header.count >= MAX_SCHEDULE_EXCEPTIONS || kind == EXCEPTION_KIND_NONE || kind > EXCEPTION_KIND_FORCE_OFF) {
+        return 0;
+    }
+    ExceptionRange& range = _ranges[_header.count];
+    range.firstDay = dayNumber(first);
+    range.lastDay = dayNumber(last);
+    if (range.lastDay < range.firstDay) {
+        return 0; // فترة معكوسة
+    }
+    range.kind = kind;
+    range.id = _header.nextId;
+    if (range.id == 0) {
+        range.id = 1; // تخطي 0 بعد الالتفاف
+    }
+    _header.nextId = range.id + 1;
+    EEPROMHelper::put(EXCEPTION_RECORDS_ADDR + _header.count * sizeof(ExceptionRange), range);
+    _header.count++;
+    saveHeader();
+    _mapYear = 0;
+    return range.id;
+}
+
+// حذف فترة بمعرفها (إزاحة الفترات التالية وكتابتها في كتلة واحدة)
+bool ExceptionCalendar::remove(uint16_t id) {
+    for (uint8_t r = 0; r < _header.count; r++) {
+        if (_ranges[r].id != id) {
+            continue;
+        }
+        uint8_t tail = _header.count - r - 1;
+        memmove(&_ranges[r], &_ranges[r + 1], tail * sizeof(ExceptionRange));
+        _header.count--;
+        if (tail > 0) {
+            EEPROMHelper::writeBytes(EXCEPTION_RECORDS_ADDR + r * sizeof(ExceptionRange), (const byte*)&_ranges[r], tail * sizeof(ExceptionRange));
+        }
+        saveHeader();
+        _mapYear = 0;
+        return true;
+    }
+    return false;
+}
+
+// حفظ الرأس في EEPROM
+void ExceptionCalendar::saveHeader() {
+    EEPROMHelper::put(EXCEPTION_REGION_ADDR, _header);
+}
+
+// رقم اليوم منذ 1970-01-01 لتاريخ معين
+uint16_t ExceptionCalendar::dayNumber(const DateTime& date) {
+    return date.unixtime() / 86400UL;
+}
+
+// تحويل رقم اليوم إلى نص بالشكل YYYY-MM-DD
+String ExceptionCalendar::formatDay(uint16_t day) {
+    return RTCManager::formatDate(DateTime((uint32_t)day * 86400UL));
+}
+
+// اسم نوع الاستثناء في JSON
+const char* ExceptionCalendar::kindName(uint8_t kind) {
+    return kind <= EXCEPTION_KIND_FORCE_OFF ? EXCEPTION_KIND_NAMES[kind] : EXCEPTION_KIND_NAMES[0];
+}
+
+// تحويل اسم نوع من JSON إلى EXCEPTION_KIND_*، أو -1 إذا كان غير معروف
+int ExceptionCalendar::parseKind(const char* name) {
+    if (name == nullptr) {
+        return EXCEPTION_KIND_SUPPRESS; // النوع الافتراضي
+    }
+    for (int i = EXCEPTION_KIND_SUPPRESS; i <= EXCEPTION_KIND_FORCE_OFF; i++) {
+        if (strcmp(name, EXCEPTION_KIND_NAMES[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,50 @@
+// ExceptionCalendar.h
+#ifndef EXCEPTION_CALENDAR_H
+#define EXCEPTION_CALENDAR_H
+
+#include "Config.h"
+#include "EEPROM_Helper.h" // لحفظ الفترات في EEPROM
+
+// فئة ExceptionCalendar لإدارة أيام الاستثناء (العطل والإغلاقات) للجداول الزمنية
+// الفترات تُحفظ كقائمة مضغوطة في EEPROM، وتُفهرس في الذاكرة كخريطة للسنة الحالية (2 بت لكل يوم)
+// فيكون فحص "هل اليوم استثناء؟" بتكلفة ثابتة عند كل تقييم للجداول.
+// هذه الفئة لا ترث من MainControlClass وتعمل كأداة مساعدة مستقلة.
+class ExceptionCalendar {
+private:
+    ExceptionRegionHeader _header; // نسخة رأس المنطقة
+    ExceptionRange _ranges[MAX_SCHEDULE_EXCEPTIONS]; // نسخة الفترات في الذاكرة
+    uint8_t _yearMap[(366 * 2 + 7) / 8]; // نوع الاستثناء لكل يوم من السنة المفهرسة
+    uint16_t _mapYear = 0; // السنة المفهرسة في _yearMap (0 = تحتاج إعادة بناء)
+
+public:
+    ExceptionCalendar(); // مُنشئ بسيط
+
+    // تحميل الفترات من EEPROM بقراءة واحدة (وتهيئة المنطقة إذا لم تكن مهيأة)
+    void load();
+    // نوع الاستثناء المطبق في تاريخ معين (EXCEPTION_KIND_*)
+    uint8_t kindFor(const DateTime& date);
+    // إضافة فترة، وتُرجع معرفها أو 0 إذا امتلأت القائمة أو كانت الفترة غير صالحة
+    uint16_t add(const DateTime& first, const DateTime& last, uint8_t kind);
+    // حذف فترة بمعرفها، وتُرجع false إذا لم توجد
+    bool remove(uint16_t id);
+    // عدد الفترات المحفوظة
+    uint8_t count() const { return _header.count; }
+    // الوصول إلى فترة حسب ترتيبها (للعرض عبر API)
+    const ExceptionRange& at(uint8_t index) const { return _ranges[index]; }
+
+    // رقم اليوم منذ 1970-01-01 لتاريخ معين
+    static uint16_t dayNumber(const DateTime& date);
+    // تحويل رقم اليوم إلى نص بالشكل YYYY-MM-DD
+    static String formatDay(uint16_t day);
+    // اسم نوع الاستثناء في JSON وعكسه (-1 إذا كان الاسم غير معروف)
+    static const char* kindName(uint8_t kind);
+    static int parseKind(const char* name);
+
+private:
+    // حفظ الرأس في EEPROM
+    void saveHeader();
+    // إعادة بناء خريطة السنة من قائمة الفترات
+    void buildYearMap(uint16_t year);
+};
+
+#endif // EXCEPTION_CALENDAR_H
@@ -0,0 +1,178 @@
+// HttpSocketBackend.cpp
+#include "HttpSocketBackend.h"
+
+#if defined(ARDUINO)
+
+// بدء الاستماع (التأخير الصغير بين الحزم يؤخر الردود القصيرة، فيُعطَّل)
+bool WiFiSocketBackend::listen(uint16_t port) {
+    if (_listener == nullptr) {
+        _listener = new WiFiServer(port);
+    }
+    _listener->begin();
+    _listener->setNoDelay(true);
+    return true;
+}
+
+// قبول عميل منتظر في أول خانة فارغة
+int WiFiSocketBackend::accept() {
+    if (_listener == nullptr) {
+        return -1;
+    }
+    int slot = -1;
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++) {
+        if (!_used[i]) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        return -1; // يبقى العميل في طابور الاستماع حتى تفرغ خانة
+    }
+#if defined(ESP8266)
+    WiFiClient client = _listener->accept();
+#else
+    WiFiClient client = _listener->available();
+#endif
+    if (!client) {
+        return -1;
+    }
+    _clients[slot] = client;
+    _used[slot] = true;
+    return slot;
+}
+
+int WiFiSocketBackend::read(int handle, uint8_t* buffer, size_t size) {
+    WiFiClient& client = _clients[handle];
+    int available = client.available();
+    if (available <= 0) {
+        return client.connected() ? 0 : -1;
+    }
+    if ((size_t)available < size) {
+        size = available;
+    }
+    return client.read(buffer, size);
+}
+
+int WiFiSocketBackend::write(int handle, const uint8_t* data, size_t size) {
+    WiFiClient& client = _clients[handle];
+    if (!client.connected()) {
+        return -1;
+    }
+    return client.write(data, size);
+}
+
+void WiFiSocketBackend::close(int handle) {
+    _clients[handle].stop();
+    _used[handle] = false;
+}
+
+// لا يوجد انتظار على الأحداث في WiFiClient: loop() تستدعي handleClient() باستمرار
+void WiFiSocketBackend::wait(uint32_t timeoutMs, bool accepting) {
+    if (timeoutMs > 0) {
+        delay(timeoutMs);
+    }
+}
+
+#endif // ARDUINO
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+PosixSocketBackend::~PosixSocketBackend() {
+    if (_epollFd >= 0) {
+        ::close(_epollFd);
+    }
+    if (_listenFd >= 0) {
+        ::close(_listenFd);
+    }
+}
+
+// مقبس استماع دون حجب على جميع العناوين، مسجل في epoll
+bool PosixSocketBackend::listen(uint16_t port) {
+    _listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (_listenFd < 0) {
+        return false;
+    }
+    int one = 1;
+    setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(_listenFd, (sockaddr*)&address, sizeof(address)) < 0 || ::listen(_listenFd, SOMAXCONN) < 0) {
+        ::close(_listenFd);
+        _listenFd = -1;
+        return false;
+    }
+    _epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = _listenFd;
+    epoll_ctl(_epollFd, EPOLL_CTL_ADD, _listenFd, &event);
+    _accepting = true;
+    return true;
+}
+
+int PosixSocketBackend::accept() {
+    int fd = accept4(_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = fd;
+    epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event);
+    return fd;
+}
+
+int PosixSocketBackend::read(int handle, uint8_t* buffer, size_t size) {
+    ssize_t n = recv(handle, buffer, size, 0);
+    if (n > 0) {
+        return (int)n;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return 0;
+    }
+    return -1; // n == 0: أغلق العميل الاتصال
+}
+
+int PosixSocketBackend::write(int handle, const uint8_t* data, size_t size) {
+    ssize_t n = send(handle, data, size, MSG_NOSIGNAL);
+    if (n >= 0) {
+        return (int)n;
+    }
+    return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+}
+
+void PosixSocketBackend::close(int handle) {
+    epoll_ctl(_epollFd, EPOLL_CTL_DEL, handle, nullptr);
+    ::close(handle);
+}
+
+// epoll_wait حتى يصل اتصال أو بيانات (الأحداث نفسها لا تُستخدم: المحرك يمر على جميع اتصالاته)
+void PosixSocketBackend::wait(uint32_t timeoutMs, bool accepting) {
+    if (_epollFd < 0) {
+        return;
+    }
+    if (accepting != _accepting) {
+        // المحرك ممتلئ: إيقاف إيقاظ مقبس الاستماع (وإلا يبقى جاهزاً فيعود الانتظار فوراً)
+        epoll_event event = {};
+        event.events = accepting ? (uint32_t)EPOLLIN : 0u;
+        event.data.fd = _listenFd;
+        epoll_ctl(_epollFd, EPOLL_CTL_MOD, _listenFd, &event);
+        _accepting = accepting;
+    }
+    epoll_event events[16];
+    epoll_wait(_epollFd, events, 16, (int)timeoutMs);
+}
+
+#endif // __linux__ && !ARDUINO
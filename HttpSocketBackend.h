@@ -0,0 +1,68 @@
+// HttpSocketBackend.h
+#ifndef HTTP_SOCKET_BACKEND_H
+#define HTTP_SOCKET_BACKEND_H
+
+#include "Config.h"
+
+// واجهة المقابس تحت AsyncHttpServer: جميع العمليات دون حجب، والاتصال يُعرّف برقم (handle)
+class HttpSocketBackend {
+public:
+    virtual ~HttpSocketBackend() {}
+
+    // بدء الاستماع على المنفذ
+    virtual bool listen(uint16_t port) = 0;
+    // قبول اتصال جديد: رقمه، أو -1 إذا لا يوجد اتصال منتظر
+    virtual int accept() = 0;
+    // القراءة: عدد البايتات (> 0)، أو 0 إذا لا توجد بيانات بعد، أو -1 إذا أُغلق الاتصال
+    virtual int read(int handle, uint8_t* buffer, size_t size) = 0;
+    // الكتابة: عدد البايتات المرسلة (قد يكون 0 إذا امتلأ مخزن الإرسال)، أو -1 عند الخطأ
+    virtual int write(int handle, const uint8_t* data, size_t size) = 0;
+    // إغلاق الاتصال
+    virtual void close(int handle) = 0;
+    // انتظار نشاط على المقابس حتى timeoutMs (accepting = false: لا تُوقظ الاتصالات المنتظرة في طابور الاستماع)
+    virtual void wait(uint32_t timeoutMs, bool accepting) = 0;
+};
+
+#if defined(ARDUINO)
+// المقابس على الجهاز: WiFiServer و WiFiClient لكل اتصال (الرقم = خانة العميل)
+class WiFiSocketBackend : public HttpSocketBackend {
+public:
+    WiFiSocketBackend() : _listener(nullptr) {}
+
+    bool listen(uint16_t port) override;
+    int accept() override;
+    int read(int handle, uint8_t* buffer, size_t size) override;
+    int write(int handle, const uint8_t* data, size_t size) override;
+    void close(int handle) override;
+    void wait(uint32_t timeoutMs, bool accepting) override;
+
+private:
+    WiFiServer* _listener; // يُنشأ في listen() بعد معرفة المنفذ
+    WiFiClient _clients[HTTP_MAX_CONNECTIONS];
+    bool _used[HTTP_MAX_CONNECTIONS] = {};
+};
+#endif
+
+#if defined(__linux__) && !defined(ARDUINO)
+// مقابس POSIX على الحاسوب (لتشغيل نفس المعالجات واختبار الحمل بعملاء متزامنين كثيرين):
+// مقابس دون حجب مع epoll، والرقم = واصف الملف
+class PosixSocketBackend : public HttpSocketBackend {
+public:
+    PosixSocketBackend() : _listenFd(-1), _epollFd(-1), _accepting(true) {}
+    ~PosixSocketBackend() override;
+
+    bool listen(uint16_t port) override;
+    int accept() override;
+    int read(int handle, uint8_t* buffer, size_t size) override;
+    int write(int handle, const uint8_t* data, size_t size) override;
+    void close(int handle) override;
+    void wait(uint32_t timeoutMs, bool accepting) override;
+
+private:
+    int _listenFd;
+    int _epollFd;
+    bool _accepting; // هل مقبس الاستماع مسجل للإيقاظ في epoll؟
+};
+#endif
+
+#endif // HTTP_SOCKET_BACKEND_H
@@ -0,0 +1,11 @@
+// HttpTransport.cpp
+#include "HttpTransport.h"
+
+// محول مشترك لخادم: يُنشأ عند أول مدير، ويُعاد للمديرين التاليين على نفس الخادم
+WebServerTransport& WebServerTransport::of(WebServer& server) {
+    static WebServerTransport* shared = nullptr;
+    if (shared == nullptr || &shared->_server != &server) {
+        shared = new WebServerTransport(server);
+    }
+    return *shared;
+}
@@ -0,0 +1,74 @@
+// HttpTransport.h
+#ifndef HTTP_TRANSPORT_H
+#define HTTP_TRANSPORT_H
+
+#include "Config.h"
+#include <functional>
+
+// معالج نقطة نهاية (نفس شكل معالجات WebServer)
+typedef std::function<void(void)> HttpHandler;
+
+// واجهة النقل تحت تسجيلات _server.on(...): الجزء الذي تستخدمه المكتبة من WebServer.
+// المعالجات تقرأ الطلب الحالي (arg/hasArg/uri/method) وترد بـ send أو بالرد المجزأ
+// (setContentLength(CONTENT_LENGTH_UNKNOWN) ثم send ثم sendContent حتى sendContent("")).
+// التطبيقات: WebServerTransport (الخادم المتزامن السابق) و AsyncHttpServer (متعدد الاتصالات دون حجب).
+class HttpTransport {
+public:
+    virtual ~HttpTransport() {}
+
+    // تسجيل المعالجات وبدء الاستماع
+    virtual void on(const String& uri, HTTPMethod method, HttpHandler handler) = 0;
+    virtual void onNotFound(HttpHandler handler) = 0;
+    virtual void begin() = 0;
+    // معالجة الاتصالات (تُستدعى من MainControlClass::handleClient)
+    virtual void handleClient() = 0;
+
+    // --- الطلب الحالي (داخل المعالج فقط) ---
+    virtual bool hasArg(const String& name) = 0;
+    virtual String arg(const String& name) = 0; // "plain" = جسم الطلب
+    virtual String arg(int index) = 0;
+    virtual String argName(int index) = 0;
+    virtual int args() = 0;
+    virtual String uri() = 0;
+    virtual HTTPMethod method() = 0;
+
+    // --- الرد ---
+    virtual void send(int code, const char* contentType, const String& content) = 0;
+    virtual void setContentLength(size_t length) = 0;
+    virtual void sendContent(const String& content) = 0;
+};
+
+// تطبيق الواجهة فوق WebServer/ESP8266WebServer (السلوك السابق: طلب واحد في كل مرة)
+class WebServerTransport : public HttpTransport {
+public:
+    explicit WebServerTransport(WebServer& server) : _server(server) {}
+    // محول مشترك لخادم (المديرون المبنيون على نفس WebServer يتشاركون محولاً واحداً)
+    static WebServerTransport& of(WebServer& server);
+
+    void on(const String& uri, HTTPMethod method, HttpHandler handler) override { _server.on(uri, method, handler); }
+    void onNotFound(HttpHandler handler) override { _server.onNotFound(handler); }
+    void begin() override { _server.begin(); }
+    void handleClient() override { _server.handleClient(); }
+    bool hasArg(const String& name) override { return _server.hasArg(name); }
+    String arg(const String& name) override { return _server.arg(name); }
+    String arg(int index) override { return _server.arg(index); }
+    String argName(int index) override { return _server.argName(index); }
+    int args() override { return _server.args(); }
+    String uri() override { return _server.uri(); }
+    HTTPMethod method() override { return _server.method(); }
+    void send(int code, const char* contentType, const String& content) override { _server.send(code, contentType, content); }
+    void setContentLength(size_t length) override { _server.setContentLength(length); }
+    void sendContent(const String& content) override { _server.sendContent(content); }
+
+private:
+    WebServer& _server;
+};
+
+// معامل مُنشئات المديرين: يقبل WebServer (كما سابقاً، عبر محول مشترك) أو أي HttpTransport
+struct HttpServerRef {
+    HttpTransport* transport;
+    HttpServerRef(HttpTransport& server) : transport(&server) {}
+    HttpServerRef(WebServer& server) : transport(&WebServerTransport::of(server)) {}
+};
+
+#endif // HTTP_TRANSPORT_H
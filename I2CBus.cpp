@@ -0,0 +1,197 @@
+// I2CBus.cpp
+#include "I2CBus.h"
+
+// القفل حسب المنصة: قفل FreeRTOS متكرر على ESP32، أو std::recursive_mutex على الحاسوب، وإلا بدون قفل
+#if defined(ESP32)
+#define I2C_BUS_FREERTOS
+#elif !defined(ARDUINO)
+#define I2C_BUS_THREAD
+#include <mutex>
+#endif
+
+bool I2CBus::_started = false;
+uint32_t I2CBus::_clock = 0;
+uint8_t I2CBus::_depth = 0;
+I2CDeviceStats I2CBus::_stats[I2C_DEVICE_COUNT];
+
+#if defined(I2C_BUS_FREERTOS)
+static SemaphoreHandle_t busMutex = nullptr;
+// قبل تشغيل المجدول (مُنشئات الكائنات العامة) توجد مهمة واحدة فقط، فلا حاجة للقفل
+static bool schedulerRunning() {
+    return xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+}
+#elif defined(I2C_BUS_THREAD)
+static std::recursive_mutex* busMutex = nullptr; // يُنشأ في begin() (لا كائنات عامة بمُنشئات)
+#endif
+
+// تهيئة Wire مرة واحدة (بدلاً من Wire.begin() في beginAPAndWebServer و beginRTC)
+void I2CBus::begin() {
+    if (_started) {
+        return;
+    }
+    _started = true;
+#if defined(I2C_BUS_FREERTOS)
+    busMutex = xSemaphoreCreateRecursiveMutex();
+#elif defined(I2C_BUS_THREAD)
+    busMutex = new std::recursive_mutex();
+#endif
+#if defined(ESP32) || defined(ESP8266)
+    Wire.begin(EEPROM_SDA_PIN, EEPROM_SCL_PIN);
+#else
+    Wire.begin();
+#endif
+    _clock = 0; // تُضبط السرعة عند أول حجز
+}
+
+// حجز الناقل لجهاز وضبط سرعته إذا اختلفت عن السرعة الحالية
+void I2CBus::lock(uint8_t device) {
+    begin();
+#if defined(I2C_BUS_FREERTOS)
+    if (schedulerRunning()) {
+        xSemaphoreTakeRecursive(busMutex, portMAX_DELAY);
+    }
+#elif defined(I2C_BUS_THREAD)
+    busMutex->lock();
+#endif
+    _depth++;
+    uint32_t hz = clockHz(device);
+    if (_depth == 1 && hz != _clock) {
+        Wire.setClock(hz);
+        _clock = hz;
+    }
+}
+
+// تحرير الحجز
+void I2CBus::unlock() {
+    _depth--;
+#if defined(I2C_BUS_FREERTOS)
+    if (schedulerRunning()) {
+        xSemaphoreGiveRecursive(busMutex);
+    }
+#elif defined(I2C_BUS_THREAD)
+    busMutex->unlock();
+#endif
+}
+
+// كتابة معاملة واحدة مع إعادة المحاولة عند NACK
+bool I2CBus::write(uint8_t device, const uint8_t* prefix, uint8_t prefixLength, const uint8_t* data, size_t length) {
+    lock(device);
+    uint32_t delayUs = I2C_BACKOFF_START_US;
+    bool ok = false;
+    for (uint8_t attempt = 1; ; attempt++) {
+        Wire.beginTransmission(address(device));
+        Wire.write(prefix, prefixLength);
+        Wire.write(data, length);
+        uint8_t status = Wire.endTransmission();
+        if (status == 0) {
+            ok = true;
+            break;
+        }
+        if (!retryable(status) || attempt >= I2C_MAX_ATTEMPTS) {
+            break;
+        }
+        _stats[device].retries++;
+        backoff(delayUs);
+    }
+    account(device, prefixLength + length, ok);
+    unlock();
+    return ok;
+}
+
+// كتابة العنوان الداخلي ثم القراءة، مع إعادة المحاولة عند NACK أو نقص البيانات
+size_t I2CBus::read(uint8_t device, const uint8_t* prefix, uint8_t prefixLength, uint8_t* buffer, size_t length) {
+    lock(device);
+    uint32_t delayUs = I2C_BACKOFF_START_US;
+    size_t received = 0;
+    for (uint8_t attempt = 1; ; attempt++) {
+        Wire.beginTransmission(address(device));
+        Wire.write(prefix, prefixLength);
+        uint8_t status = Wire.endTransmission();
+        if (status == 0) {
+            Wire.requestFrom((int)address(device), (int)length);
+            received = 0;
+            while (received < length && Wire.available()) {
+                buffer[received++] = Wire.read();
+            }
+            if (received == length) {
+                break;
+            }
+        } else if (!retryable(status)) {
+            break;
+        }
+        if (attempt >= I2C_MAX_ATTEMPTS) {
+            break;
+        }
+        _stats[device].retries++;
+        backoff(delayUs);
+    }
+    account(device, prefixLength + received, received == length);
+    unlock();
+    return received;
+}
+
+// الاستطلاع حتى يستجيب الجهاز (EEPROM لا ترد على عنوانها أثناء دورة الكتابة)
+bool I2CBus::waitReady(uint8_t device) {
+    lock(device);
+    uint32_t delayUs = I2C_BACKOFF_START_US;
+    bool ok = false;
+    for (uint8_t attempt = 1; attempt <= I2C_MAX_ATTEMPTS; attempt++) {
+        Wire.beginTransmission(address(device));
+        if (Wire.endTransmission() == 0) {
+            ok = true;
+            break;
+        }
+        backoff(delayUs);
+    }
+    if (!ok) {
+        _stats[device].errors++;
+    }
+    unlock();
+    return ok;
+}
+
+// تسجيل معاملة في عدادات الجهاز
+void I2CBus::account(uint8_t device, uint16_t bytes, bool ok) {
+    if (device >= I2C_DEVICE_COUNT) {
+        return;
+    }
+    _stats[device].transactions++;
+    _stats[device].bytes += bytes;
+    if (!ok) {
+        _stats[device].errors++;
+    }
+}
+
+// اسم الجهاز (للتقارير)
+const char* I2CBus::deviceName(uint8_t device) {
+    return device == I2C_DEVICE_RTC ? "rtc" : "eeprom";
+}
+
+// سرعة الجهاز
+uint32_t I2CBus::clockHz(uint8_t device) {
+    return device == I2C_DEVICE_RTC ? I2C_RTC_CLOCK_HZ : I2C_EEPROM_CLOCK_HZ;
+}
+
+// عنوان I2C للجهاز
+uint8_t I2CBus::address(uint8_t device) {
+    return device == I2C_DEVICE_RTC ? DS3231_I2C_ADDR : EXTERNAL_EEPROM_ADDR;
+}
+
+// رموز endTransmission: 2 = NACK للعنوان، 3 = NACK للبيانات، 5 = انتهاء المهلة (ESP32)
+bool I2CBus::retryable(uint8_t status) {
+    return status == 2 || status == 3 || status == 5;
+}
+
+// الانتظار قبل المحاولة التالية ومضاعفة المدة حتى I2C_BACKOFF_MAX_US
+// (المدد من مللي ثانية فأكثر بـ delay() لتترك المعالج لبقية المهام)
+void I2CBus::backoff(uint32_t& delayUs) {
+    if (delayUs >= 1000) {
+        delay(delayUs / 1000);
+    } else {
+        delayMicroseconds(delayUs);
+    }
+    delayUs *= 2;
+    if (delayUs > I2C_BACKOFF_MAX_US) {
+        delayUs = I2C_BACKOFF_MAX_US;
+    }
+}
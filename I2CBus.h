@@ -0,0 +1,74 @@
+// I2CBus.h
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include "Config.h"
+
+// عدادات جهاز على الناقل
+struct I2CDeviceStats {
+    uint32_t transactions; // المعاملات المكتملة أو المحاولة
+    uint32_t bytes;        // البايتات المنقولة (العنوان الداخلي + البيانات)
+    uint32_t retries;      // إعادات المحاولة بعد NACK
+    uint32_t errors;       // معاملات فشلت بعد جميع المحاولات
+};
+
+// فئة مساعدة مشتركة لناقل I2C (DS3231 و 24C256 على نفس Wire):
+// تهيئة Wire مرة واحدة على EEPROM_SDA_PIN/EEPROM_SCL_PIN، وسرعة كل جهاز تُضبط عند حجز الناقل له،
+// والمعاملات متسلسلة بقفل متكرر (لمهام FreeRTOS متعددة أو std::thread على الحاسوب)،
+// و NACK يُعاد بانتظار متضاعف محدود (وهو أيضاً الاستطلاع حتى انتهاء دورة كتابة EEPROM).
+// الحالة أنواع بسيطة لأن RTC يُهيأ من مُنشئات كائنات عامة قبل تهيئة هذا الملف.
+class I2CBus {
+public:
+    // تهيئة Wire مرة واحدة (الاستدعاءات التالية لا تفعل شيئاً)
+    static void begin();
+    // حجز الناقل لجهاز وضبط سرعته (متكرر: يمكن الحجز مرة أخرى من نفس المهمة)
+    static void lock(uint8_t device);
+    // تحرير الحجز
+    static void unlock();
+
+    // كتابة prefix (مثل العنوان الداخلي) ثم data في معاملة واحدة، مع إعادة المحاولة عند NACK
+    static bool write(uint8_t device, const uint8_t* prefix, uint8_t prefixLength, const uint8_t* data, size_t length);
+    // كتابة prefix ثم قراءة length بايت في buffer، مع إعادة المحاولة عند NACK أو نقص البيانات
+    // (تُرجع عدد البايتات المقروءة)
+    static size_t read(uint8_t device, const uint8_t* prefix, uint8_t prefixLength, uint8_t* buffer, size_t length);
+    // الاستطلاع حتى يستجيب الجهاز (ACK) بعد دورة كتابة، بنفس الانتظار المتضاعف
+    static bool waitReady(uint8_t device);
+
+    // تسجيل معاملة نفذتها مكتبة أخرى عبر Wire (مثل RTClib) في عدادات الجهاز
+    static void account(uint8_t device, uint16_t bytes, bool ok = true);
+    // عدادات جهاز
+    static const I2CDeviceStats& stats(uint8_t device) { return _stats[device]; }
+    // اسم الجهاز وسرعته
+    static const char* deviceName(uint8_t device);
+    static uint32_t clockHz(uint8_t device);
+
+private:
+    static bool _started;
+    static uint32_t _clock;       // السرعة المضبوطة حالياً في Wire
+    static uint8_t _depth;        // عمق الحجز المتكرر للمهمة المالكة
+    static I2CDeviceStats _stats[I2C_DEVICE_COUNT];
+
+    // عنوان I2C للجهاز
+    static uint8_t address(uint8_t device);
+    // هل رمز endTransmission يستحق إعادة المحاولة؟ (NACK للعنوان أو البيانات، أو انتهاء المهلة)
+    static bool retryable(uint8_t status);
+    // الانتظار قبل المحاولة التالية ومضاعفة المدة
+    static void backoff(uint32_t& delayUs);
+};
+
+// حجز الناقل لجهاز طوال نطاق الكائن، مع تسجيل معاملة في عداداته
+// (لاستدعاءات المكتبات التي تستخدم Wire مباشرة، مثل RTClib)
+class I2CTransaction {
+public:
+    I2CTransaction(uint8_t device, uint16_t bytes = 0) : _device(device), _bytes(bytes) { I2CBus::lock(device); }
+    ~I2CTransaction() { I2CBus::account(_device, _bytes, _ok); I2CBus::unlock(); }
+    // تسجيل نتيجة المعاملة، وتُرجع ok كما هي
+    bool check(bool ok) { _ok = _ok && ok; return ok; }
+
+private:
+    uint8_t _device;
+    uint16_t _bytes;
+    bool _ok = true;
+};
+
+#endif // I2C_BUS_H
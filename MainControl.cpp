@@ -1,18 +1,32 @@
 // MainControl.cpp
 #include "MainControl.h"
 
+RelayTransitionSource* MainControlClass::_transitionSources[MAX_RELAY_SOURCES];
+uint8_t MainControlClass::_transitionSourceCount = 0;
+uint8_t MainControlClass::_restoreTask = TASK_NONE;
+RelayClaim MainControlClass::_relayClaims[RELAY_CHANNEL_COUNT][RELAY_SOURCE_COUNT];
+RelayArbiterConfig MainControlClass::_arbiterConfig;
+RelayChannelConfig MainControlClass::_channelConfig;
+bool MainControlClass::_arbiterLoaded = false;
+uint8_t MainControlClass::_relayWinner[RELAY_CHANNEL_COUNT];
+uint8_t MainControlClass::_relayMask = 0;
+uint32_t MainControlClass::_nextClaimExpiry = 0;
+
+// أسماء مصادر المرحل في JSON (حسب ترتيب RELAY_SOURCE_*)
+static const char* const RELAY_SOURCE_NAMES[RELAY_SOURCE_COUNT] = { "manual", "card", "schedule", "prayer" };
+
 #ifdef USE_EXTERNAL_EEPROM
-MainControlClass::MainControlClass(WebServer& serverRef, int relayPin)
-    : _server(serverRef), _relayPin(relayPin) {
+MainControlClass::MainControlClass(HttpServerRef serverRef, int relayPin)
+    : _metricsServer(*serverRef.transport), _server(_metricsServer), _relayPin(relayPin) {
 }
 #else
-MainControlClass::MainControlClass(WebServer& serverRef, int relayPin, EEPROMClass& eepromRef)
-    : _server(serverRef), _relayPin(relayPin), _eeprom(eepromRef) {
+MainControlClass::MainControlClass(HttpServerRef serverRef, int relayPin, EEPROMClass& eepromRef)
+    : _metricsServer(*serverRef.transport), _server(_metricsServer), _relayPin(relayPin), _eeprom(eepromRef) {
 }
 #endif
 
 void MainControlClass::beginAPAndWebServer(const char* ap_ssid, const char* ap_password) {
-    Wire.begin(); 
+    I2CBus::begin(); // الناقل المشترك (لا يفعل شيئاً إذا هيأته خدمة الوقت)
 
 #ifndef USE_EXTERNAL_EEPROM
     if (!_eeprom.begin(EEPROM_SIZE)) {
@@ -23,14 +37,21 @@ void MainControlClass::beginAPAndWebServer(const char* ap_ssid, const char* ap_p
     }
     Serial.println("تم تهيئة EEPROM الداخلية بنجاح.");
 #else
-    Serial.println("EEPROM الخارجية (24C256) مفترضة مهيأة عبر Wire.begin().");
+    Serial.println("EEPROM الخارجية (24C256) مفترضة مهيأة عبر I2CBus::begin().");
 #endif
-
-    pinMode(_relayPin, OUTPUT);
-    bool savedState = getRelayStateFromEEPROM();
-    digitalWrite(_relayPin, savedState ? HIGH : LOW);
-    Serial.print("الحالة الأولية للمرحل من EEPROM: ");
-    Serial.println(savedState ? "تشغيل" : "إيقاف");
+    StorageWorker::begin(); // مع USE_STORAGE_WORKER: عمليات I2C و EEPROM التالية في النواة الأخرى
+
+    uint8_t pins[RELAY_CHANNEL_COUNT] = RELAY_CHANNEL_PINS;
+    pins[0] = _relayPin;
+    RelayOutput::begin(pins);
+    _relayMask = getRelayStateFromEEPROM(); // تبقى حالة كل قناة حتى أول طلب عليها من أحد المصادر
+    RelayOutput::write(_relayMask);
+    for (uint8_t c = 0; c < RELAY_CHANNEL_COUNT; c++) {
+        _relayWinner[c] = RELAY_SOURCE_NONE;
+    }
+    loadArbiterConfig();
+    Serial.print("الحالة الأولية لقنوات المرحل من EEPROM: 0x");
+    Serial.println(_relayMask, HEX);
 
     String ssid = readStringFromEEPROM(SSID_ADDR, SSID_MAX_LEN);
     String password = readStringFromEEPROM(PASSWORD_ADDR, PASSWORD_MAX_LEN);
@@ -62,24 +83,49 @@ void MainControlClass::beginAPAndWebServer(const char* ap_ssid, const char* ap_p
     _server.on("/api/relay/set_state", HTTP_POST, [this]() { handleSetRelayState(); });
     _server.on("/api/relay/get_state", HTTP_GET, [this]() { handleGetRelayState(); });
     _server.on("/api/relay/toggle", HTTP_POST, [this]() { handleToggleRelay(); });
+    _server.on("/api/relay/set_arbiter", HTTP_POST, [this]() { handleSetRelayArbiter(); });
+    _server.on("/api/relay/get_arbiter", HTTP_GET, [this]() { handleGetRelayArbiter(); });
 
     _server.on("/api/reset", HTTP_POST, [this]() { resetConfigurations(); }); 
+    _server.on("/api/metrics", HTTP_GET, [this]() { handleGetMetrics(); });
 
     _server.onNotFound([this]() { handleNotFound(); });
 
     _server.begin();
     Serial.println("تم بدء تشغيل خادم HTTP");
+#ifdef USE_STALL_SAMPLER
+    if (Metrics::beginSampler()) {
+        Serial.println("تم بدء أخذ عينات التوقف على المؤقت العتادي.");
+    }
+#endif
 }
 
 void MainControlClass::handleClient() {
+    Metrics::beginLoop();
     _server.handleClient();
+    Metrics::phase(METRICS_PHASE_RELAY);
+    serviceRelayClaims();
+    Metrics::phase(METRICS_PHASE_STORAGE);
+    StorageWorker::poll();
+    Metrics::phase(METRICS_PHASE_TIME);
+    TimeService::poll();
+    Metrics::phase(METRICS_PHASE_TASKS);
+    TaskScheduler::service();
+    Metrics::endLoop();
 }
 
 void MainControlClass::resetConfigurations() {
     Serial.println("إعادة تعيين الإعدادات...");
     EEPROMHelper::writeInt(USER_TAG_COUNT_ADDR, 0); // إعادة تعيين عدد المستخدمين
-    saveRelayStateToEEPROM(false); // إيقاف المرحل
-    EEPROMHelper::writeByte(LAST_SCHEDULE_ID_ADDR, 0); // إعادة تعيين آخر معرف جدول زمني مباشرة باستخدام EEPROMHelper
+    saveRelayStateToEEPROM(0); // إيقاف جميع القنوات
+    EEPROMHelper::writeByte(LAST_SCHEDULE_ID_ADDR, 0); // إعادة تعيين المنطقة القديمة للجداول (لمنع إعادة ترحيلها)
+    ScheduleRegionHeader scheduleHeader = { SCHEDULE_REGION_MAGIC, 1, 0 }; // منطقة جداول فارغة
+    EEPROMHelper::put(SCHEDULE_REGION_ADDR, scheduleHeader);
+    byte emptyBitmap[SCHEDULE_BITMAP_SIZE];
+    memset(emptyBitmap, 0, sizeof(emptyBitmap)); // لا توجد خانات مشغولة
+    EEPROMHelper::writeBytes(SCHEDULE_BITMAP_ADDR, emptyBitmap, SCHEDULE_BITMAP_SIZE);
+    ExceptionRegionHeader exceptionHeader = { EXCEPTION_REGION_MAGIC, 1, 0 }; // لا توجد أيام استثناء
+    EEPROMHelper::put(EXCEPTION_REGION_ADDR, exceptionHeader);
     saveStringToEEPROM(SSID_ADDR, "Smart Timer", SSID_MAX_LEN); // إعادة تعيين SSID الافتراضي
     saveStringToEEPROM(PASSWORD_ADDR, "sM@rt123", PASSWORD_MAX_LEN); // إعادة تعيين كلمة المرور الافتراضية
     // تم حذف استدعاء writeOperationMethod(0);
@@ -92,48 +138,310 @@ void MainControlClass::resetConfigurations() {
         defaultConfig.minutesBefore[i] = 0;
     }
     EEPROMHelper::put(AUTO_RELAY_CONFIG_ADDR, defaultConfig);
+    PrayerRelayConfig relayConfig;
+    memset(&relayConfig, 0, sizeof(relayConfig));
+    relayConfig.magic = PRAYER_RELAY_MAGIC; // نوافذ جميع الأوقات معطلة
+    EEPROMHelper::put(PRAYER_RELAY_ADDR, relayConfig);
+    RelayArbiterConfig arbiterConfig;
+    memset(&arbiterConfig, 0, sizeof(arbiterConfig)); // تُكتب الافتراضيات عند الإقلاع التالي
+    EEPROMHelper::put(RELAY_ARBITER_ADDR, arbiterConfig);
+    RelayChannelConfig channelConfig;
+    memset(&channelConfig, 0, sizeof(channelConfig)); // القناة 0 لجميع المصادر عند الإقلاع التالي
+    EEPROMHelper::put(RELAY_CHANNEL_CONFIG_ADDR, channelConfig);
 
     Serial.println("تم إعادة تعيين الإعدادات. إعادة تشغيل ESP...");
     _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تمت إعادة التعيين\"}");
 
+    StorageWorker::flush(); // إكمال الكتابات المنتظرة قبل إعادة التشغيل
     delay(1000);
     ESP.restart();
 }
 
+// النص في كتابة واحدة ثم حرف النهاية (دورة كتابة لكل صفحة بدلاً من دورة لكل حرف)
 void MainControlClass::saveStringToEEPROM(int address, const String& data, int max_len) {
     int len = data.length();
     if (len > max_len) {
         len = max_len; 
     }
-    for (int i = 0; i < len; ++i) {
-        EEPROMHelper::writeByte(address + i, data.charAt(i));
-    }
+    EEPROMHelper::writeBytes(address, (const byte*)data.c_str(), len);
     EEPROMHelper::writeByte(address + len, 0);
 }
 
+// القراءة على كتل بحجم I2C_TRANSFER_CHUNK حتى حرف النهاية (معاملة واحدة لكل كتلة بدلاً من كل حرف)
 String MainControlClass::readStringFromEEPROM(int address, int max_len) {
     String data = "";
-    for (int i = 0; i < max_len; ++i) {
-        char c = EEPROMHelper::readByte(address + i);
-        if (c == 0) { 
-            break;
+    byte chunk[I2C_TRANSFER_CHUNK];
+    for (int offset = 0; offset < max_len; offset += sizeof(chunk)) {
+        int count = max_len - offset < (int)sizeof(chunk) ? max_len - offset : (int)sizeof(chunk);
+        EEPROMHelper::readBytes(address + offset, chunk, count);
+        for (int i = 0; i < count; ++i) {
+            if (chunk[i] == 0) { 
+                return data;
+            }
+            data += (char)chunk[i];
         }
-        data += c;
     }
     return data;
 }
 
-void MainControlClass::saveRelayStateToEEPROM(bool state) {
-    EEPROMHelper::writeByte(RELAY_STATE_ADDR, state ? 1 : 0);
+void MainControlClass::saveRelayStateToEEPROM(uint8_t mask) {
+    EEPROMHelper::writeByte(RELAY_STATE_ADDR, mask);
+}
+
+// القيمة 0xFF تعني EEPROM غير مهيأة (إيقاف جميع القنوات كما سابقاً)
+uint8_t MainControlClass::getRelayStateFromEEPROM() {
+    uint8_t mask = EEPROMHelper::readByte(RELAY_STATE_ADDR);
+    return mask == 0xFF ? 0 : (mask & RELAY_CHANNEL_ALL);
 }
 
-bool MainControlClass::getRelayStateFromEEPROM() {
-    return EEPROMHelper::readByte(RELAY_STATE_ADDR) == 1;
+void MainControlClass::setRelayPhysicalState(uint8_t mask) {
+    RelayOutput::write(mask);
+    saveRelayStateToEEPROM(mask);
 }
 
-void MainControlClass::setRelayPhysicalState(bool state) {
-    digitalWrite(_relayPin, state ? HIGH : LOW);
-    saveRelayStateToEEPROM(state);
+// قراءة إعدادات الحَكَم مرة واحدة (الافتراضيات: أولويات متساوية = آخر طلب يفوز، والبطاقة نبضة 5 ثوانٍ)
+void MainControlClass::loadArbiterConfig() {
+    if (_arbiterLoaded) {
+        return;
+    }
+    _arbiterLoaded = true;
+    EEPROMHelper::get(RELAY_CHANNEL_CONFIG_ADDR, _channelConfig);
+    if (_channelConfig.magic != RELAY_CHANNEL_CONFIG_MAGIC) {
+        _channelConfig.magic = RELAY_CHANNEL_CONFIG_MAGIC;
+        for (uint8_t i = 0; i < RELAY_SOURCE_COUNT; i++) {
+            _channelConfig.sourceChannels[i] = 0x01; // القناة 0 (سلوك المرحل الواحد)
+        }
+        EEPROMHelper::put(RELAY_CHANNEL_CONFIG_ADDR, _channelConfig);
+    }
+    EEPROMHelper::get(RELAY_ARBITER_ADDR, _arbiterConfig);
+    if (_arbiterConfig.magic == RELAY_ARBITER_MAGIC) {
+        return;
+    }
+    _arbiterConfig.magic = RELAY_ARBITER_MAGIC;
+    for (uint8_t i = 0; i < RELAY_SOURCE_COUNT; i++) {
+        _arbiterConfig.priority[i] = 1;
+        _arbiterConfig.timeoutSeconds[i] = 0;
+    }
+    _arbiterConfig.timeoutSeconds[RELAY_SOURCE_CARD] = 5;
+    EEPROMHelper::put(RELAY_ARBITER_ADDR, _arbiterConfig);
+}
+
+// القنوات الافتراضية لمصدر (ضمن القنوات الموجودة)
+uint8_t MainControlClass::sourceChannels(uint8_t source) {
+    loadArbiterConfig();
+    return source < RELAY_SOURCE_COUNT ? (_channelConfig.sourceChannels[source] & RELAY_CHANNEL_ALL) : 0;
+}
+
+// تغيير القنوات الافتراضية لمصدر: حفظ الإعدادات وسحب طلباته على القنوات المستبعدة،
+// ثم إعادة بناء الحالة لتطبيق الانتقالات التلقائية على القنوات المضافة
+void MainControlClass::setSourceChannels(uint8_t source, uint8_t channels) {
+    if (source >= RELAY_SOURCE_COUNT || channels == sourceChannels(source)) {
+        return;
+    }
+    uint8_t removed = _channelConfig.sourceChannels[source] & ~channels;
+    _channelConfig.sourceChannels[source] = channels;
+    EEPROMHelper::put(RELAY_CHANNEL_CONFIG_ADDR, _channelConfig);
+    for (uint8_t c = 0; c < RELAY_CHANNEL_COUNT; c++) {
+        if (removed & (1 << c)) {
+            _relayClaims[c][source].active = false;
+        }
+    }
+    reconstructRelayState(TimeService::now());
+}
+
+// تسجيل طلب قناة دون إعادة الاختيار؛ تكرار الطلب نفسه (الحالة والوقت) لا يغير شيئاً
+bool MainControlClass::fileRelayClaim(uint8_t channel, uint8_t source, bool state, uint32_t stamp, uint32_t timeoutSeconds) {
+    if (channel >= RELAY_CHANNEL_COUNT || source >= RELAY_SOURCE_COUNT) {
+        return false;
+    }
+    loadArbiterConfig();
+    if (stamp == 0) {
+        stamp = TimeService::now().unixtime();
+    }
+    if (timeoutSeconds == RELAY_TIMEOUT_DEFAULT) {
+        timeoutSeconds = _arbiterConfig.timeoutSeconds[source];
+    }
+    RelayClaim& claim = _relayClaims[channel][source];
+    uint32_t expires = timeoutSeconds > 0 ? stamp + timeoutSeconds : 0;
+    if (claim.active && claim.state == state && claim.stamp == stamp && claim.expires == expires) {
+        return false;
+    }
+    claim.active = true;
+    claim.state = state;
+    claim.stamp = stamp;
+    claim.expires = expires;
+    return true;
+}
+
+// طلب حالة قناة من مصدر، ثم إعادة اختيار الفائز
+void MainControlClass::requestRelay(uint8_t channel, uint8_t source, bool state, uint32_t stamp, uint32_t timeoutSeconds) {
+    if (fileRelayClaim(channel, source, state, stamp, timeoutSeconds)) {
+        applyRelayDecision();
+    }
+}
+
+// طلب حالة عدة قنوات معاً: جميع الطلبات بنفس الوقت، ثم قرار واحد (كتابة واحدة للمخارج و EEPROM)
+void MainControlClass::requestRelayMask(uint8_t source, uint8_t channels, uint8_t states, uint32_t stamp, uint32_t timeoutSeconds) {
+    if (stamp == 0) {
+        stamp = TimeService::now().unixtime();
+    }
+    bool changed = false;
+    for (uint8_t c = 0; c < RELAY_CHANNEL_COUNT; c++) {
+        if (channels & (1 << c)) {
+            changed |= fileRelayClaim(c, source, states & (1 << c), stamp, timeoutSeconds);
+        }
+    }
+    if (changed) {
+        applyRelayDecision();
+    }
+}
+
+// سحب طلب مصدر على القنوات المحددة
+void MainControlClass::releaseRelay(uint8_t source, uint8_t channels) {
+    if (source >= RELAY_SOURCE_COUNT) {
+        return;
+    }
+    bool changed = false;
+    for (uint8_t c = 0; c < RELAY_CHANNEL_COUNT; c++) {
+        if ((channels & (1 << c)) && _relayClaims[c][source].active) {
+            _relayClaims[c][source].active = false;
+            changed = true;
+        }
+    }
+    if (changed) {
+        applyRelayDecision();
+    }
+}
+
+// إنهاء الطلبات المنتهية (مقارنة واحدة في الحالة العادية)
+void MainControlClass::serviceRelayClaims() {
+    if (_nextClaimExpiry == 0 || TimeService::now().unixtime() < _nextClaimExpiry) {
+        return;
+    }
+    applyRelayDecision(); // يسحب الطلبات المنتهية ويعيد الاختيار
+}
+
+// اختيار الفائز لكل قناة: أعلى أولوية، وعند التساوي الأحدث
+// لا تُكتب المخارج ولا EEPROM إلا إذا تغير القناع الفعّال، ومرة واحدة لجميع القنوات
+// عند انتهاء آخر طلب على قناة أو سحبه تعود إلى الإيقاف (مثلاً: نهاية نبضة البطاقة)،
+// أما قبل أول طلب عليها منذ الإقلاع فتبقى الحالة المستعادة من EEPROM
+void MainControlClass::applyRelayDecision() {
+    uint32_t now = TimeService::now().unixtime();
+    uint8_t desiredMask = _relayMask;
+    _nextClaimExpiry = 0;
+    for (uint8_t c = 0; c < RELAY_CHANNEL_COUNT; c++) {
+        uint8_t previousWinner = _relayWinner[c];
+        uint8_t winner = RELAY_SOURCE_NONE;
+        RelayClaim* claims = _relayClaims[c];
+        for (uint8_t i = 0; i < RELAY_SOURCE_COUNT; i++) {
+            RelayClaim& claim = claims[i];
+            if (claim.active && claim.expires != 0 && now >= claim.expires) {
+                claim.active = false; // انتهت المهلة
+            }
+            if (!claim.active) {
+                continue;
+            }
+            if (claim.expires != 0 && (_nextClaimExpiry == 0 || claim.expires < _nextClaimExpiry)) {
+                _nextClaimExpiry = claim.expires;
+            }
+            if (winner == RELAY_SOURCE_NONE ||
+                _arbiterConfig.priority[i] > _arbiterConfig.priority[winner] ||
+                (_arbiterConfig.priority[i] == _arbiterConfig.priority[winner] && claim.stamp >= claims[winner].stamp)) {
+                winner = i;
+            }
+        }
+        _relayWinner[c] = winner;
+        if (winner == RELAY_SOURCE_NONE && previousWinner == RELAY_SOURCE_NONE) {
+            continue;
+        }
+        if (winner != RELAY_SOURCE_NONE && claims[winner].state) {
+            desiredMask |= (1 << c);
+        } else {
+            desiredMask &= ~(1 << c);
+        }
+    }
+    if (desiredMask == _relayMask) {
+        return;
+    }
+    uint8_t changed = desiredMask ^ _relayMask;
+    _relayMask = desiredMask;
+    setRelayPhysicalState(_relayMask);
+    for (uint8_t c = 0; c < RELAY_CHANNEL_COUNT; c++) {
+        if (!(changed & (1 << c))) {
+            continue;
+        }
+        Serial.print("المرحل ");
+        Serial.print(c);
+        Serial.print(": ");
+        Serial.print((_relayMask & (1 << c)) ? "تشغيل" : "إيقاف");
+        Serial.print(" (المصدر: ");
+        Serial.print(relaySourceName(_relayWinner[c]));
+        Serial.println(")");
+    }
+}
+
+// قراءة القنوات المحددة في طلب JSON: "channel":n أو "channels":[n,...]
+bool MainControlClass::parseRelayChannels(JsonDocument& doc, uint8_t defaultMask, uint8_t& mask) {
+    if (doc.containsKey("channel")) {
+        int channel = doc["channel"].as<int>();
+        if (channel < 0 || channel >= RELAY_CHANNEL_COUNT) {
+            return false;
+        }
+        mask = 1 << channel;
+        return true;
+    }
+    if (!doc.containsKey("channels")) {
+        mask = defaultMask;
+        return true;
+    }
+    mask = 0;
+    for (JsonVariant value : doc["channels"].as<JsonArray>()) {
+        int channel = value.as<int>();
+        if (channel < 0 || channel >= RELAY_CHANNEL_COUNT) {
+            return false;
+        }
+        mask |= 1 << channel;
+    }
+    return true;
+}
+
+// اسم المصدر في JSON
+const char* MainControlClass::relaySourceName(uint8_t source) {
+    return source < RELAY_SOURCE_COUNT ? RELAY_SOURCE_NAMES[source] : "none";
+}
+
+void MainControlClass::registerTransitionSource(RelayTransitionSource* source) {
+    if (_transitionSourceCount < MAX_RELAY_SOURCES) {
+        _transitionSources[_transitionSourceCount++] = source;
+    }
+}
+
+// آخر انتقال لكل مصدر على كل قناة يُسجل كطلب بوقت حدوثه، فيختار الحَكَم كما لو لم ينقطع التشغيل
+// (بدون انتقالات تبقى الحالة المستعادة من EEPROM)، ثم قرار واحد لجميع القنوات
+void MainControlClass::reconstructRelayState(const DateTime& now) {
+    bool changed = false;
+    for (uint8_t i = 0; i < _transitionSourceCount; i++) {
+        for (uint8_t c = 0; c < RELAY_CHANNEL_COUNT; c++) {
+            DateTime when;
+            bool state;
+            if (_transitionSources[i]->lastTransition(c, now, when, state)) {
+                changed |= fileRelayClaim(c, _transitionSources[i]->relaySource(), state, when.unixtime());
+            }
+        }
+    }
+    if (changed) {
+        applyRelayDecision();
+    }
+}
+
+// مهمة واحدة تُنشأ عند أول طلب، وتكرار الطلب قبل تنفيذها لا يضيف شيئاً
+void MainControlClass::requestRelayRestore() {
+    if (_restoreTask == TASK_NONE) {
+        _restoreTask = TaskScheduler::add([](void* self) {
+            static_cast<MainControlClass*>(self)->reconstructRelayState(TimeService::now());
+        }, this);
+    }
+    TaskScheduler::trigger(_restoreTask);
 }
 
 // --- Private Handlers Implementations for MainControlClass ---
@@ -207,6 +515,7 @@ void MainControlClass::handleSetnetworkinfo() {
         saveStringToEEPROM(SSID_ADDR, ssid, SSID_MAX_LEN);
         saveStringToEEPROM(PASSWORD_ADDR, password, PASSWORD_MAX_LEN);
         _server.send(200, "application/json", "{\"status\":\"تم تحديث الشبكة\"}");
+        StorageWorker::flush(); // إكمال الكتابات المنتظرة قبل إعادة التشغيل
         delay(1000);
         ESP.restart();
     } else {
@@ -214,37 +523,83 @@ void MainControlClass::handleSetnetworkinfo() {
     }
 }
 
+// تعيين المرحل يدوياً: {"state":"on"} أو {"state":"off"}، أو {"state":"auto"} لسحب الطلب اليدوي
+// والعودة إلى المصادر التلقائية. "seconds" اختياري لمهلة هذا الطلب (بدلاً من مهلة المصدر المحفوظة)
+// "channel":n أو "channels":[...] اختياري (الافتراضي قنوات المصدر اليدوي)؛ عدة قنوات تتبدل معاً بكتابة واحدة
 void MainControlClass::handleSetRelayState() {
     if (_server.hasArg("plain")) {
-        StaticJsonDocument<100> doc;
+        StaticJsonDocument<256> doc;
         DeserializationError error = deserializeJson(doc, _server.arg("plain"));
         if (error) {
             _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"JSON غير صالح\"}");
             return;
         }
+        uint8_t channels;
+        if (!parseRelayChannels(doc, sourceChannels(RELAY_SOURCE_MANUAL), channels)) {
+            _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"رقم القناة يجب أن يكون بين 0 و " + String(RELAY_CHANNEL_COUNT - 1) + "\"}");
+            return;
+        }
         String stateStr = doc["state"].as<String>();
+        uint32_t timeout = doc.containsKey("seconds") ? doc["seconds"].as<uint32_t>() : RELAY_TIMEOUT_DEFAULT;
         if (stateStr.equalsIgnoreCase("on")) {
-            setRelayPhysicalState(true);
-            _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم تعيين المرحل إلى تشغيل\"}");
+            requestRelayMask(RELAY_SOURCE_MANUAL, channels, channels, 0, timeout);
+            _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم تعيين المرحل إلى تشغيل\",\"mask\":" + String(_relayMask) + "}");
             Serial.println("تم تعيين المرحل إلى تشغيل");
             return;
         } else if (stateStr.equalsIgnoreCase("off")) {
-            setRelayPhysicalState(false);
-            _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم تعيين المرحل إلى إيقاف\"}");
+            requestRelayMask(RELAY_SOURCE_MANUAL, channels, 0, 0, timeout);
+            _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم تعيين المرحل إلى إيقاف\",\"mask\":" + String(_relayMask) + "}");
             Serial.println("تم تعيين المرحل إلى إيقاف");
             return;
+        } else if (stateStr.equalsIgnoreCase("auto")) {
+            releaseRelay(RELAY_SOURCE_MANUAL, channels);
+            _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تمت إعادة المرحل إلى التحكم التلقائي\",\"mask\":" + String(_relayMask) + "}");
+            return;
         }
     }
-    _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"جسم الطلب غير صالح. المتوقع {\"state\":\"on\"} أو {\"state\":\"off\"}\"}");
+    _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"جسم الطلب غير صالح. المتوقع {\"state\":\"on\"} أو {\"state\":\"off\"} أو {\"state\":\"auto\"}\"}");
 }
 
+// حالة قناة المرحل (?channel=n، الافتراضي 0) والمصدر الفائز وطلبات جميع المصادر عليها،
+// مع قناع جميع القنوات وحالة كل قناة
 void MainControlClass::handleGetRelayState() {
-    bool state = digitalRead(_relayPin) == HIGH; 
-    String stateStr = state ? "on" : "off";
-    String response = "{\"status\":\"success\",\"state\":\"" + stateStr + "\"}";
+    serviceRelayClaims();
+    int channel = _server.hasArg("channel") ? _server.arg("channel").toInt() : 0;
+    if (channel < 0 || channel >= RELAY_CHANNEL_COUNT) {
+        _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"رقم القناة يجب أن يكون بين 0 و " + String(RELAY_CHANNEL_COUNT - 1) + "\"}");
+        return;
+    }
+    uint32_t now = TimeService::now().unixtime();
+    String response = "{\"status\":\"success\",\"channel\":" + String(channel) +
+                      ",\"state\":\"" + String((_relayMask & (1 << channel)) ? "on" : "off") +
+                      "\",\"source\":\"" + String(relaySourceName(_relayWinner[channel])) +
+                      "\",\"mask\":" + String(_relayMask) + ",\"channels\":[";
+    for (uint8_t c = 0; c < RELAY_CHANNEL_COUNT; c++) {
+        if (c > 0) response += ",";
+        response += (_relayMask & (1 << c)) ? "\"on\"" : "\"off\"";
+    }
+    response += "],\"claims\":[";
+    bool first = true;
+    for (uint8_t i = 0; i < RELAY_SOURCE_COUNT; i++) {
+        const RelayClaim& claim = _relayClaims[channel][i];
+        if (!claim.active) {
+            continue;
+        }
+        if (!first) response += ",";
+        first = false;
+        response += "{\"source\":\"" + String(RELAY_SOURCE_NAMES[i]) + "\",\"state\":\"" + String(claim.state ? "on" : "off") +
+                    "\",\"priority\":" + String(_arbiterConfig.priority[i]);
+        if (claim.expires != 0) {
+            response += ",\"remaining\":" + String(claim.expires > now ? claim.expires - now : 0);
+        }
+        response += "}";
+    }
+    response += "]}";
     _server.send(200, "application/json", response);
 }
 
+// تشغيل المرحل لمدة محددة: طلب يدوي بمهلة، فيعود المرحل بعدها إلى ما تقرره بقية المصادر
+// (دون تعطيل الخادم بـ delay())
 void MainControlClass::handleToggleRelay() {
     if (_server.hasArg("plain")) {
         StaticJsonDocument<100> doc;
@@ -254,22 +609,211 @@ void MainControlClass::handleToggleRelay() {
             return;
         }
         int duration = doc["duration"].as<int>();
+        uint8_t channels;
+        if (!parseRelayChannels(doc, sourceChannels(RELAY_SOURCE_MANUAL), channels)) {
+            _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"رقم القناة يجب أن يكون بين 0 و " + String(RELAY_CHANNEL_COUNT - 1) + "\"}");
+            return;
+        }
 
         if (duration > 0) {
-            setRelayPhysicalState(true); 
+            requestRelayMask(RELAY_SOURCE_MANUAL, channels, channels, 0, duration);
             _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم تبديل المرحل إلى تشغيل لمدة " + String(duration) + " ثانية\"}");
             Serial.print("تم تبديل المرحل إلى تشغيل لمدة ");
             Serial.print(duration);
             Serial.println(" ثانية");
-            delay(duration * 1000);
-            setRelayPhysicalState(false); // Turn off
-            Serial.println("تم إيقاف المرحل بعد التبديل");
             return;
         }
     }
     _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"جسم الطلب غير صالح. المتوقع {\"duration\":1} أو {\"duration\":5}\"}");
 }
 
+// تعيين أولويات المصادر ومهلها وقنواتها الافتراضية:
+// {"priority":{"manual":3,...},"timeout":{"card":5,...},"channels":{"card":[0,1],...}} (الحقول الغائبة تبقى كما هي)
+// الجداول الزمنية تحمل قناة كل جدول، فلا تُقبل قنوات لمصدر "schedule"
+void MainControlClass::handleSetRelayArbiter() {
+    if (!_server.hasArg("plain")) {
+        _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"جسم الطلب مفقود\"}");
+        return;
+    }
+    StaticJsonDocument<384> doc;
+    DeserializationError error = deserializeJson(doc, _server.arg("plain"));
+    if (error) {
+        _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"JSON غير صالح\"}");
+        return;
+    }
+    loadArbiterConfig();
+    RelayArbiterConfig config = _arbiterConfig;
+    uint8_t channels[RELAY_SOURCE_COUNT];
+    for (uint8_t i = 0; i < RELAY_SOURCE_COUNT; i++) {
+        JsonVariant priority = doc["priority"][RELAY_SOURCE_NAMES[i]];
+        JsonVariant timeout = doc["timeout"][RELAY_SOURCE_NAMES[i]];
+        JsonVariant list = doc["channels"][RELAY_SOURCE_NAMES[i]];
+        channels[i] = _channelConfig.sourceChannels[i];
+        if (!list.isNull() && i != RELAY_SOURCE_SCHEDULE) {
+            channels[i] = 0;
+            for (JsonVariant value : list.as<JsonArray>()) {
+                int channel = value.as<int>();
+                if (channel < 0 || channel >= RELAY_CHANNEL_COUNT) {
+                    _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"رقم القناة يجب أن يكون بين 0 و " + String(RELAY_CHANNEL_COUNT - 1) + "\"}");
+                    return;
+                }
+                channels[i] |= 1 << channel;
+            }
+        }
+        if (!priority.isNull()) {
+            int value = priority.as<int>();
+            if (value < 0 || value > 255) {
+                _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"الأولوية يجب أن تكون بين 0 و 255\"}");
+                return;
+            }
+            config.priority[i] = value;
+        }
+        if (!timeout.isNull()) {
+            long value = timeout.as<long>();
+            if (value < 0 || value > 65535) {
+                _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"المهلة يجب أن تكون بين 0 و 65535 ثانية\"}");
+                return;
+            }
+            config.timeoutSeconds[i] = value;
+        }
+    }
+    _arbiterConfig = config;
+    EEPROMHelper::put(RELAY_ARBITER_ADDR, _arbiterConfig);
+    for (uint8_t i = 0; i < RELAY_SOURCE_COUNT; i++) {
+        setSourceChannels(i, channels[i]);
+    }
+    applyRelayDecision(); // قد يتغير الفائز بتغير الأولويات
+    _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم حفظ إعدادات الحَكَم\",\"mask\":" + String(_relayMask) + "}");
+}
+
+// الحصول على أولويات المصادر ومهلها
+void MainControlClass::handleGetRelayArbiter() {
+    loadArbiterConfig();
+    StaticJsonDocument<768> doc;
+    JsonObject priority = doc.createNestedObject("priority");
+    JsonObject timeout = doc.createNestedObject("timeout");
+    JsonObject channels = doc.createNestedObject("channels");
+    for (uint8_t i = 0; i < RELAY_SOURCE_COUNT; i++) {
+        priority[RELAY_SOURCE_NAMES[i]] = _arbiterConfig.priority[i];
+        timeout[RELAY_SOURCE_NAMES[i]] = _arbiterConfig.timeoutSeconds[i];
+        if (i == RELAY_SOURCE_SCHEDULE) {
+            continue; // قناة لكل جدول
+        }
+        JsonArray list = channels.createNestedArray(RELAY_SOURCE_NAMES[i]);
+        for (uint8_t c = 0; c < RELAY_CHANNEL_COUNT; c++) {
+            if (_channelConfig.sourceChannels[i] & (1 << c)) {
+                list.add(c);
+            }
+        }
+    }
+    doc["count"] = RELAY_CHANNEL_COUNT;
+    String output;
+    serializeJson(doc, output);
+    _server.send(200, "application/json", output);
+}
+
+// معالج للحصول على الوقت الحالي عبر API (من خدمة الوقت المشتركة دون قراءة RTC)
+void MainControlClass::handleGetTime() {
+    DateTime currentTime = TimeService::now(); // الحصول على الوقت الحالي
+    String response = "{ \"year\": " + String(currentTime.year()) +
+                      ", \"month\": " + String(currentTime.month()) +
+                      ", \"day\": " + String(currentTime.day()) +
+                      ", \"hour\": " + String(currentTime.hour()) +
+                      ", \"minute\": " + String(currentTime.minute()) +
+                      ", \"second\": " + String(currentTime.second()) + " }";
+    Serial.println(response);
+    _server.send(200, "application/json", response);
+}
+
+// معالج لتعيين الوقت عبر API
+// خدمة الوقت تُبلغ جميع المديرين المشتركين (إعادة حساب الحدث التالي وأوقات اليوم)،
+// وكل منهم يطلب إعادة تعيين المرحل حسب آخر انتقال، فتُنفذ مرة واحدة في الدورة التالية
+void MainControlClass::handleSetTime() {
+    if (_server.hasArg("plain")) {
+        StaticJsonDocument<200> doc;
+        deserializeJson(doc, _server.arg("plain"));
+        // قراءة قيم الوقت والتاريخ من JSON
+        int year = doc["year"];
+        int month = doc["month"];
+        int day = doc["day"];
+        int hour = doc["hour"];
+        int minute = doc["minute"];
+        int second = doc["second"];
+        // ضبط RTC بالقيم الجديدة
+        DateTime newTime(year, month, day, hour, minute, second);
+        TimeService::adjust(newTime);
+        _server.send(200, "application/json", "{\"status\":\"تم تحديث الوقت\"}");
+    } else {
+        _server.send(400, "application/json", "{\"error\":\"جسم الطلب مفقود\"}");
+    }
+}
+
+// مقاييس التشغيل بسطر لكل مقياس: "الاسم مفتاح=قيمة ..."، والمدرجات بعدد القياسات في كل خانة
+// (حدود الخانات بالميكروثانية في سطر buckets_us). المسارات تُرسل على أجزاء مثل الجدول السنوي
+void MainControlClass::handleGetMetrics() {
+    _server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    _server.send(200, "text/plain", "");
+    String chunk = "uptime_ms " + String(millis()) + "\nbuckets_us ";
+    Metrics::appendBuckets(chunk);
+    chunk += "\nloop";
+    Metrics::appendHistogram(chunk, Metrics::loop());
+    chunk += "\n";
+    _server.sendContent(chunk);
+
+    for (uint8_t i = 0; i < Metrics::routeCount(); i++) {
+        const MetricsRoute& route = Metrics::route(i);
+        if (route.latency.count == 0) {
+            continue; // مسارات لم تُطلب بعد
+        }
+        chunk = "route " + String(Metrics::methodName(route.method)) + " " + String(route.uri);
+        Metrics::appendHistogram(chunk, route.latency);
+        Metrics::appendMemory(chunk, route.memory);
+        chunk += "\n";
+        _server.sendContent(chunk);
+    }
+
+    chunk = "eeprom reads=" + String(EEPROMHelper::reads()) + " writes=" + String(EEPROMHelper::writes()) +
+            " commits=" + String(EEPROMHelper::commits()) + "\n";
+    for (uint8_t d = 0; d < I2C_DEVICE_COUNT; d++) {
+        const I2CDeviceStats& stats = I2CBus::stats(d);
+        chunk += "i2c " + String(I2CBus::deviceName(d)) + " transactions=" + String(stats.transactions) +
+                 " bytes=" + String(stats.bytes) + " retries=" + String(stats.retries) + " errors=" + String(stats.errors) + "\n";
+    }
+    chunk += "rtc reads=" + String(TimeService::rtcReads()) + " drift_ppm=" + String(TimeService::driftPpm()) + "\n";
+    chunk += "heap free=" + String(Metrics::heapFree()) + " min_free=" + String(Metrics::heapMinFree()) +
+             " largest_block=" + String(Metrics::heapLargestBlock()) + " fragmentation=" + String(Metrics::heapFragmentation()) + "\n";
+    // أقل مسافة متبقية إلى حد المكدس عند أعمق معالج (0xFFFFFFFF إذا لم يُرسم المكدس على المنصة)
+    chunk += "stack min_free=" + String(Metrics::stackMinFree()) + " paint_bytes=" + String(METRICS_STACK_PAINT_BYTES) + "\n";
+    for (uint8_t c = 0; c < RELAY_CHANNEL_COUNT; c++) {
+        chunk += "relay channel=" + String(c) + " actuations=" + String(RelayOutput::actuations(c)) +
+                 " state=" + String((_relayMask >> c) & 1) + "\n";
+    }
+    chunk += "tasks count=" + String(TaskScheduler::taskCount()) + " overruns=" + String(TaskScheduler::overruns()) +
+             " max_service_us=" + String(TaskScheduler::maxServiceMicros()) + " max_late_ms=" + String(TaskScheduler::maxLatenessMs()) + "\n";
+    if (StorageWorker::active()) {
+        chunk += "storage processed=" + String(StorageWorker::processed()) + " pending=" + String(StorageWorker::pending()) +
+                 " max_depth=" + String(StorageWorker::maxDepth()) + " stalls=" + String(StorageWorker::stalls()) + "\n";
+    }
+
+    // آخر التوقفات من الأحدث، ثم عينات المؤقت لكل موضع (إن وُجدت)
+    chunk += "stalls threshold_us=" + String(METRICS_STALL_THRESHOLD_US) + " total=" + String(Metrics::stallCount()) + "\n";
+    for (uint8_t i = 0; i < Metrics::storedStalls(); i++) {
+        const MetricsStall& stall = Metrics::stall(i);
+        chunk += "stall at_ms=" + String(stall.atMillis) + " us=" + String(stall.micros) + " in=";
+        Metrics::appendMarker(chunk, stall.marker);
+        chunk += "\n";
+    }
+    for (uint8_t m = 0; m < METRICS_MARKERS; m++) {
+        if (Metrics::samples(m) > 0) {
+            chunk += "sampled ticks=" + String(Metrics::samples(m)) + " in=";
+            Metrics::appendMarker(chunk, m);
+            chunk += "\n";
+        }
+    }
+    _server.sendContent(chunk);
+    _server.sendContent(""); // نهاية الرد المجزأ
+}
+
 void MainControlClass::handleNotFound() {
     String message = "الملف غير موجود\n\n";
     message += "URI: ";
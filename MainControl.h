@@ -4,13 +4,39 @@
 
 #include "Config.h"
 #include "EEPROM_Helper.h" // تضمين الفئة المساعدة لـ EEPROM
+#include "TimeService.h"   // الوقت المشترك بين جميع الفئات المشتقة
+#include "RelayOutput.h"   // إخراج جميع القنوات بكتابة واحدة
+#include "StorageWorker.h" // عمليات التخزين في النواة الأخرى (اختياري)
+#include "I2CBus.h"        // الناقل المشترك بين EEPROM و RTC
+#include "HttpTransport.h" // واجهة النقل تحت تسجيلات المسارات
+#include "Metrics.h"       // مقاييس التشغيل (/api/metrics)
+
+// واجهة لمصدر يغير حالة المرحل حسب الوقت (الجداول الزمنية، أوقات الصلاة)
+// تُستخدم لإعادة بناء حالة المرحل بعد إعادة التشغيل أو تعديل الساعة
+class RelayTransitionSource {
+public:
+    // آخر انتقال فعّال لقناة المرحل عند الوقت 'now' أو قبله: وقته والحالة الناتجة عنه
+    // تُرجع false إذا لم يكن لدى المصدر أي انتقال على هذه القناة (مثلاً: لا توجد جداول نشطة)
+    virtual bool lastTransition(uint8_t channel, const DateTime& now, DateTime& when, bool& state) = 0;
+    // مصدر الطلب في حَكَم المرحل (RELAY_SOURCE_*)
+    virtual uint8_t relaySource() const = 0;
+};
+
+// طلب مصدر واحد على قناة واحدة لدى حَكَم المرحل
+struct RelayClaim {
+    bool active;      // هل للمصدر طلب قائم؟
+    bool state;       // الحالة المطلوبة
+    uint32_t stamp;   // وقت الطلب (ثوانٍ منذ 1970) لترجيح الأحدث عند تساوي الأولوية
+    uint32_t expires; // وقت انتهاء الطلب (0 = بلا انتهاء)
+};
 
 // فئة التحكم الرئيسية (MainControlClass)
 // توفر الوظائف الأساسية للتحكم في الجهاز وإدارة الخادم الويب
 class MainControlClass {
 protected: // الأعضاء المحمية يمكن الوصول إليها من الفئات المشتقة
-    WebServer& _server; // مرجع لكائن خادم الويب الرئيسي
-    int _relayPin;      // دبوس المرحل (Relay)
+    MetricsTransport _metricsServer; // يلف تسجيلات المسارات بقياس زمنها (قبل _server في ترتيب التهيئة)
+    HttpTransport& _server; // واجهة خادم الويب (WebServer عبر محول، أو AsyncHttpServer) عبر _metricsServer
+    int _relayPin;      // دبوس المرحل (Relay) - القناة 0
 
 #ifndef USE_EXTERNAL_EEPROM
     EEPROMClass& _eeprom; // مرجع لكائن EEPROM الداخلية (فقط إذا لم يتم استخدام الخارجية)
@@ -19,29 +45,82 @@ protected: // الأعضاء المحمية يمكن الوصول إليها م
 public:
     // المُنشئ (Constructor) لفئة MainControlClass
 #ifdef USE_EXTERNAL_EEPROM
-    MainControlClass(WebServer& serverRef, int relayPin); // لا يوجد مرجع لـ EEPROMClass
+    MainControlClass(HttpServerRef serverRef, int relayPin); // لا يوجد مرجع لـ EEPROMClass
 #else
-    MainControlClass(WebServer& serverRef, int relayPin, EEPROMClass& eepromRef);
+    MainControlClass(HttpServerRef serverRef, int relayPin, EEPROMClass& eepromRef);
 #endif
 
     // بدء تشغيل نقطة الوصول (AP) وخادم الويب
     void beginAPAndWebServer(const char* ap_ssid, const char* ap_password);
-    // معالجة طلبات العملاء (يجب استدعاؤها بشكل متكرر في دالة loop())
+    // معالجة طلبات العملاء ومقاطعة RTC وتشغيل المهام المستحقة لجميع المديرين
+    // (الاستدعاء الوحيد المطلوب في دالة loop())
     void handleClient();
     // إعادة تعيين جميع الإعدادات إلى القيم الافتراضية
     void resetConfigurations();
-    // تعيين الحالة الفيزيائية للمرحل وحفظها في EEPROM
-    void setRelayPhysicalState(bool state);
+    // تعيين الحالة الفيزيائية لجميع القنوات بكتابة واحدة وحفظ القناع في EEPROM
+    // (يستدعيها الحَكَم عند تغير الحالة الفعّالة فقط)
+    void setRelayPhysicalState(uint8_t mask);
+
+    // --- حَكَم المرحل ---
+    // طلب حالة قناة من مصدر؛ stamp = 0 يعني الآن، و timeoutSeconds = RELAY_TIMEOUT_DEFAULT يعني مهلة المصدر المحفوظة
+    void requestRelay(uint8_t channel, uint8_t source, bool state, uint32_t stamp = 0, uint32_t timeoutSeconds = RELAY_TIMEOUT_DEFAULT);
+    // طلب حالة عدة قنوات معاً (البت i من states = حالة القناة i)، بقرار وكتابة واحدة
+    void requestRelayMask(uint8_t source, uint8_t channels, uint8_t states, uint32_t stamp = 0, uint32_t timeoutSeconds = RELAY_TIMEOUT_DEFAULT);
+    // سحب طلب مصدر على القنوات المحددة (مثلاً: إعادة التحكم اليدوي إلى المصادر التلقائية)
+    void releaseRelay(uint8_t source, uint8_t channels = RELAY_CHANNEL_ALL);
+    // إنهاء الطلبات المنتهية مهلتها (تُستدعى من handleClient)
+    void serviceRelayClaims();
+    // المصدر الفائز حالياً على القناة (RELAY_SOURCE_NONE إذا لم يوجد طلب)
+    static uint8_t relayWinner(uint8_t channel = 0) { return channel < RELAY_CHANNEL_COUNT ? _relayWinner[channel] : RELAY_SOURCE_NONE; }
+    // الحالة الفعّالة لجميع القنوات (البت i = القناة i)
+    static uint8_t relayMask() { return _relayMask; }
+    // القنوات الافتراضية لمصدر لا يحدد قناة في طلبه
+    static uint8_t sourceChannels(uint8_t source);
+    // تغيير القنوات الافتراضية لمصدر وحفظها (تُسحب طلباته على القنوات المستبعدة)
+    void setSourceChannels(uint8_t source, uint8_t channels);
+    // اسم المصدر في JSON
+    static const char* relaySourceName(uint8_t source);
     
     // وظائف متعلقة بـ EEPROM (تستخدم EEPROMHelper)
     // قراءة سلسلة نصية من EEPROM
     String readStringFromEEPROM(int address, int max_len);
     // حفظ سلسلة نصية في EEPROM
     void saveStringToEEPROM(int address, const String& data, int max_len);
-    // حفظ حالة المرحل في EEPROM
-    void saveRelayStateToEEPROM(bool state);
-    // الحصول على حالة المرحل من EEPROM
-    bool getRelayStateFromEEPROM();
+    // حفظ قناع حالة القنوات في EEPROM (كتابة بايت واحد)
+    void saveRelayStateToEEPROM(uint8_t mask);
+    // الحصول على قناع حالة القنوات من EEPROM
+    uint8_t getRelayStateFromEEPROM();
+
+    // تسجيل مصدر انتقالات للمرحل (مشترك بين جميع الفئات المشتقة)
+    static void registerTransitionSource(RelayTransitionSource* source);
+    // تعيين جميع القنوات حسب آخر انتقال فعّال عبر جميع المصادر المسجلة عند الوقت 'now'
+    // زمن التنفيذ محدود ولا يعتمد على مدة انقطاع الطاقة
+    void reconstructRelayState(const DateTime& now);
+
+protected:
+    static RelayTransitionSource* _transitionSources[MAX_RELAY_SOURCES]; // المصادر المسجلة
+    static uint8_t _transitionSourceCount; // عدد المصادر المسجلة
+    static uint8_t _restoreTask;     // مهمة إعادة بناء حالة المرحل (مشتركة بين جميع المديرين)
+    static RelayClaim _relayClaims[RELAY_CHANNEL_COUNT][RELAY_SOURCE_COUNT]; // طلبات المصادر لكل قناة
+    static RelayArbiterConfig _arbiterConfig; // الأولويات والمهل
+    static RelayChannelConfig _channelConfig; // القنوات الافتراضية لكل مصدر
+    static bool _arbiterLoaded;      // هل قُرئت الإعدادات من EEPROM؟
+    static uint8_t _relayWinner[RELAY_CHANNEL_COUNT]; // المصدر الفائز حالياً لكل قناة
+    static uint8_t _relayMask;       // الحالة الفعّالة المطبقة على المخارج (البت i = القناة i)
+    static uint32_t _nextClaimExpiry; // أقرب انتهاء لطلب قائم (0 = لا يوجد)
+
+    // طلب إعادة بناء حالة المرحل في الدورة التالية لجدول المهام
+    // (بعد الإقلاع حين تكون جميع المصادر مسجلة، أو بعد تغير الساعة)
+    void requestRelayRestore();
+    // قراءة إعدادات الحَكَم وقنوات المصادر (أو الافتراضيات) مرة واحدة
+    static void loadArbiterConfig();
+    // تسجيل طلب قناة دون إعادة الاختيار (لتجميع عدة طلبات في قرار واحد)، و true إذا تغير الطلب
+    bool fileRelayClaim(uint8_t channel, uint8_t source, bool state, uint32_t stamp, uint32_t timeoutSeconds = RELAY_TIMEOUT_DEFAULT);
+    // اختيار الطلب الفائز لكل قناة وتطبيق القناع الناتج على المخارج إذا تغير
+    void applyRelayDecision();
+    // قراءة القنوات المحددة في طلب JSON: "channel":n أو "channels":[...]، أو defaultMask إذا غابا
+    // تُرجع false إذا كانت إحدى القنوات خارج النطاق
+    static bool parseRelayChannels(JsonDocument& doc, uint8_t defaultMask, uint8_t& mask);
 
 protected: // المعالجات الخاصة (الآن محمية للوصول من الفئات المشتقة)
     // --- معالجات إدارة Wi-Fi ---
@@ -56,8 +135,15 @@ protected: // المعالجات الخاصة (الآن محمية للوصول
     void handleSetRelayState();
     void handleGetRelayState();
     void handleToggleRelay();
+    void handleSetRelayArbiter();
+    void handleGetRelayArbiter();
+
+    // --- معالجات الوقت (مشتركة، تُسجل تحت مسار كل مدير) ---
+    void handleGetTime(); // الحصول على الوقت
+    void handleSetTime(); // تعيين الوقت وإبلاغ جميع المشتركين
 
     // --- معالجات عامة ---
+    void handleGetMetrics(); // مقاييس التشغيل بصيغة نصية مختصرة
     void handleNotFound(); // معالج الطلبات غير الموجودة
 };
 
@@ -0,0 +1,390 @@
+// Metrics.cpp
+#include "Metrics.h"
+#include <string.h>
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+// حد المكدس حسب المنصة: بداية مكدس مهمة FreeRTOS على ESP32، ومكدس سياق loop() على ESP8266،
+// وحدود الخيط من pthread على الحاسوب
+#if defined(ESP32)
+#define METRICS_STACK_FREERTOS
+#elif defined(ESP8266)
+#define METRICS_STACK_CONT
+#include <cont.h>
+extern "C" cont_t* g_pcont;
+#elif !defined(ARDUINO)
+#define METRICS_STACK_THREAD
+#include <pthread.h>
+#endif
+
+// الرسم والمسح يلمسان مكدساً خارج أي إطار، فلا يفحصهما AddressSanitizer
+#if defined(__SANITIZE_ADDRESS__)
+#define METRICS_NO_SANITIZE __attribute__((no_sanitize_address))
+#else
+#define METRICS_NO_SANITIZE
+#endif
+
+MetricsRoute Metrics::_routes[METRICS_MAX_ROUTES];
+uint8_t Metrics::_routeCount = 0;
+MetricsHistogram Metrics::_loop;
+volatile bool Metrics::_inLoop = false;
+volatile uint32_t Metrics::_loopStart = 0;
+volatile uint8_t Metrics::_marker = METRICS_PHASE_SERVER;
+uint32_t Metrics::_phaseStart = 0;
+uint32_t Metrics::_longestPhaseUs = 0;
+uint8_t Metrics::_longestPhase = METRICS_PHASE_SERVER;
+bool Metrics::_stallInLoop = false;
+MetricsStall Metrics::_stalls[METRICS_STALL_SLOTS];
+uint32_t Metrics::_stallCount = 0;
+volatile uint32_t Metrics::_samples[METRICS_MARKERS];
+uint32_t Metrics::_stackMinFree = 0xFFFFFFFFUL;
+
+// أسماء مراحل الدورة (حسب ترتيب METRICS_PHASE_*)
+static const char* const PHASE_NAMES[METRICS_MARKERS - METRICS_MAX_ROUTES] = {
+    "loop.server", "loop.relay", "loop.storage", "loop.time", "loop.tasks"
+};
+
+uint8_t Metrics::addRoute(const String& uri, HTTPMethod method) {
+    if (_routeCount >= METRICS_MAX_ROUTES) {
+        return METRICS_NO_ROUTE;
+    }
+    MetricsRoute& route = _routes[_routeCount];
+    route.uri = strdup(uri.c_str()); // المسارات تُسجل مرة واحدة عند الإقلاع ولا تُحذف
+    route.method = method;
+    memset(&route.latency, 0, sizeof(route.latency));
+    memset(&route.memory, 0, sizeof(route.memory));
+    return _routeCount++;
+}
+
+// اللقطة تؤخذ قبل بدء التوقيت، فلا يدخل زمن الرسم وقراءة الكومة في زمن المعالج
+void Metrics::enterRoute(uint8_t route, MetricsProbe& probe) {
+    paintStack(probe);
+    probe.heapFree = heapFree();
+    probe.fragmentation = heapFragmentation();
+#ifdef HOST_HEAP_HOOK
+    probe.allocations = HostHeap::allocations();
+    probe.allocatedBytes = HostHeap::bytes();
+#else
+    probe.allocations = 0;
+    probe.allocatedBytes = 0;
+#endif
+    probe.previous = _marker;
+    _marker = route;
+    probe.start = micros();
+}
+
+void Metrics::leaveRoute(uint8_t route, MetricsProbe& probe) {
+    uint32_t elapsed = micros() - probe.start;
+    _marker = probe.previous;
+    if (route >= _routeCount) {
+        return;
+    }
+    record(_routes[route].latency, elapsed);
+    if (elapsed >= METRICS_STALL_THRESHOLD_US) {
+        addStall(route, elapsed);
+        _stallInLoop = true; // الدورة المحيطة متوقفة بسبب هذا المعالج
+    }
+
+    MetricsMemory& memory = _routes[route].memory;
+#ifdef HOST_HEAP_HOOK
+    // العدادات التراكمية تلتف بعد 2^32، والفرق صحيح رغم الالتفاف
+    memory.allocations += HostHeap::allocations() - probe.allocations;
+    memory.allocatedBytes += HostHeap::bytes() - probe.allocatedBytes;
+#endif
+    uint32_t heapAfter = heapFree();
+    if (heapAfter < probe.heapFree && probe.heapFree - heapAfter > memory.heapRetained) {
+        memory.heapRetained = probe.heapFree - heapAfter;
+    }
+    uint8_t fragmentation = heapFragmentation();
+    if (fragmentation > probe.fragmentation && fragmentation - probe.fragmentation > memory.fragmentation) {
+        memory.fragmentation = fragmentation - probe.fragmentation;
+    }
+
+    if (probe.paintLow == nullptr) {
+        return;
+    }
+    // العمق من إطار الغلاف (موضع probe) إلى أعمق كلمة تغيرت؛ إذا لم تتغير كلمة فالعمق لم يتجاوز بداية الرسم
+    uint32_t* deepest = deepestUse(probe);
+    uint32_t depth = (uint32_t)((uint8_t*)&probe - (uint8_t*)deepest);
+    if (depth > memory.stackPeak) {
+        memory.stackPeak = depth;
+    }
+    uint32_t remaining = (uint32_t)((uint8_t*)deepest - stackLimit());
+    if (remaining < _stackMinFree) {
+        _stackMinFree = remaining;
+    }
+}
+
+void Metrics::beginLoop() {
+    uint32_t now = micros();
+    _loopStart = now;
+    _phaseStart = now;
+    _longestPhaseUs = 0;
+    _longestPhase = METRICS_PHASE_SERVER;
+    _stallInLoop = false;
+    _marker = METRICS_PHASE_SERVER;
+    _inLoop = true;
+}
+
+// إغلاق المرحلة الحالية (مع حفظ أطولها) وبدء التالية
+void Metrics::phase(uint8_t marker) {
+    uint32_t now = micros();
+    uint32_t elapsed = now - _phaseStart;
+    if (elapsed > _longestPhaseUs) {
+        _longestPhaseUs = elapsed;
+        _longestPhase = _marker;
+    }
+    _phaseStart = now;
+    _marker = marker;
+}
+
+// الدورة المتوقفة دون معالج متوقف تُنسب لأطول مراحلها
+void Metrics::endLoop() {
+    phase(METRICS_PHASE_SERVER);
+    _inLoop = false;
+    uint32_t elapsed = _phaseStart - _loopStart;
+    record(_loop, elapsed);
+    if (elapsed >= METRICS_STALL_THRESHOLD_US && !_stallInLoop) {
+        addStall(_longestPhase, elapsed);
+    }
+}
+
+void Metrics::addStall(uint8_t marker, uint32_t micros) {
+    MetricsStall& entry = _stalls[_stallCount % METRICS_STALL_SLOTS];
+    entry.atMillis = millis();
+    entry.micros = micros;
+    entry.marker = marker;
+    _stallCount++;
+}
+
+const MetricsStall& Metrics::stall(uint8_t index) {
+    return _stalls[(_stallCount - 1 - index) % METRICS_STALL_SLOTS];
+}
+
+// نبضة المؤقت: عينة من الموضع الحالي إذا تجاوزت الدورة حد التوقف
+void IRAM_ATTR Metrics::sampleTick() {
+    if (_inLoop && (uint32_t)(micros() - _loopStart) >= METRICS_STALL_THRESHOLD_US) {
+        uint8_t marker = _marker;
+        if (marker < METRICS_MARKERS) {
+            _samples[marker] = _samples[marker] + 1;
+        }
+    }
+}
+
+// مؤقت عتادي دوري بـ METRICS_SAMPLE_PERIOD_US: المؤقت 1 على ESP8266 (5 MHz بعد القسمة على 16)،
+// ومؤقت عام على ESP32 (واجهة النواة 3.x أو 2.x)
+bool Metrics::beginSampler() {
+#if defined(USE_STALL_SAMPLER) && defined(ESP32)
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    hw_timer_t* timer = timerBegin(1000000);
+    if (timer == nullptr) {
+        return false;
+    }
+    timerAttachInterrupt(timer, sampleTick);
+    timerAlarm(timer, METRICS_SAMPLE_PERIOD_US, true, 0);
+#else
+    hw_timer_t* timer = timerBegin(1, 80, true); // 80 MHz / 80 = 1 MHz
+    if (timer == nullptr) {
+        return false;
+    }
+    timerAttachInterrupt(timer, sampleTick, true);
+    timerAlarmWrite(timer, METRICS_SAMPLE_PERIOD_US, true);
+    timerAlarmEnable(timer);
+#endif
+    return true;
+#elif defined(USE_STALL_SAMPLER) && defined(ESP8266)
+    timer1_attachInterrupt(sampleTick);
+    timer1_enable(TIM_DIV16, TIM_EDGE, TIM_LOOP);
+    timer1_write(METRICS_SAMPLE_PERIOD_US * 5);
+    return true;
+#else
+    return false;
+#endif
+}
+
+// الخانة من موضع أعلى بت في الزمن بعد إزاحته (تعليمة واحدة CLZ أو NSAU على ESP32/ESP8266)
+void Metrics::record(MetricsHistogram& histogram, uint32_t micros) {
+    uint32_t scaled = micros >> METRICS_BUCKET_SHIFT;
+    uint8_t bucket = scaled == 0 ? 0 : 32 - __builtin_clz(scaled);
+    if (bucket >= METRICS_LATENCY_BUCKETS) {
+        bucket = METRICS_LATENCY_BUCKETS - 1;
+    }
+    histogram.buckets[bucket]++;
+    histogram.count++;
+    histogram.totalMicros += micros;
+    if (micros > histogram.maxMicros) {
+        histogram.maxMicros = micros;
+    }
+}
+
+// ESP8266 لا يحفظ أدنى قيمة للكومة، فتُعرض القيمة الحالية
+uint32_t Metrics::heapFree() {
+    return ESP.getFreeHeap();
+}
+
+uint32_t Metrics::heapMinFree() {
+#if defined(ESP8266)
+    return ESP.getFreeHeap();
+#else
+    return ESP.getMinFreeHeap();
+#endif
+}
+
+uint32_t Metrics::heapLargestBlock() {
+#if defined(ESP8266)
+    return ESP.getMaxFreeBlockSize();
+#else
+    return ESP.getMaxAllocHeap();
+#endif
+}
+
+// نسبة الكومة الحرة التي لا تقع في أكبر كتلة (نفس تعريف ESP8266)
+uint8_t Metrics::heapFragmentation() {
+#if defined(ESP8266)
+    return ESP.getHeapFragmentation();
+#else
+    uint32_t free = heapFree();
+    if (free == 0) {
+        return 0;
+    }
+    uint32_t largest = heapLargestBlock();
+    return largest >= free ? 0 : (uint8_t)(100 - (uint64_t)largest * 100 / free);
+#endif
+}
+
+// --- المكدس ---
+
+uint8_t* Metrics::stackLimit() {
+#if defined(METRICS_STACK_FREERTOS)
+    return (uint8_t*)pxTaskGetStackStart(xTaskGetCurrentTaskHandle());
+#elif defined(METRICS_STACK_CONT)
+    return (uint8_t*)g_pcont->stack;
+#elif defined(METRICS_STACK_THREAD)
+    // المعالجات تعمل دائماً في خيط loop()، فيكفي حساب حده مرة واحدة
+    static uint8_t* limit = nullptr;
+    if (limit == nullptr) {
+        pthread_attr_t attributes;
+        if (pthread_getattr_np(pthread_self(), &attributes) == 0) {
+            void* address = nullptr;
+            size_t size = 0;
+            if (pthread_attr_getstack(&attributes, &address, &size) == 0) {
+                limit = (uint8_t*)address;
+            }
+            pthread_attr_destroy(&attributes);
+        }
+    }
+    return limit;
+#else
+    return nullptr;
+#endif
+}
+
+// الرسم من تحت إطار هذه الدالة بهامش METRICS_STACK_MARGIN نزولاً حتى METRICS_STACK_PAINT_BYTES
+// أو حارس حد المكدس؛ ما فوق الهامش تكتبه الدوال التالية على أي حال
+METRICS_NO_SANITIZE __attribute__((noinline)) void Metrics::paintStack(MetricsProbe& probe) {
+    probe.paintLow = nullptr;
+    probe.paintHigh = nullptr;
+    uint8_t* limit = stackLimit();
+    uint8_t* frame = (uint8_t*)__builtin_frame_address(0);
+    if (limit == nullptr || frame < limit + METRICS_STACK_GUARD + METRICS_STACK_MARGIN + sizeof(uint32_t)) {
+        return;
+    }
+    uint32_t* high = (uint32_t*)((uintptr_t)(frame - METRICS_STACK_MARGIN) & ~(uintptr_t)3);
+    uint8_t* floor = limit + METRICS_STACK_GUARD;
+    if ((uint32_t)((uint8_t*)high - floor) > METRICS_STACK_PAINT_BYTES) {
+        floor = (uint8_t*)high - METRICS_STACK_PAINT_BYTES;
+    }
+    uint32_t* low = (uint32_t*)(((uintptr_t)floor + 3) & ~(uintptr_t)3);
+    for (volatile uint32_t* word = low; word < high; word++) {
+        *word = METRICS_STACK_PATTERN;
+    }
+    probe.paintLow = low;
+    probe.paintHigh = high;
+}
+
+// أول كلمة من الأسفل لم تعد النمط هي أعمق ما وصل إليه المعالج (قد تطابق كلمة مكتوبة النمط صدفة، فيُقدّر العمق بأقل قليلاً)
+METRICS_NO_SANITIZE __attribute__((noinline)) uint32_t* Metrics::deepestUse(const MetricsProbe& probe) {
+    volatile uint32_t* word = probe.paintLow;
+    while (word < probe.paintHigh && *word == METRICS_STACK_PATTERN) {
+        word++;
+    }
+    return (uint32_t*)word;
+}
+
+const char* Metrics::methodName(HTTPMethod method) {
+    switch (method) {
+        case HTTP_GET: return "GET";
+        case HTTP_POST: return "POST";
+        case HTTP_PUT: return "PUT";
+        case HTTP_DELETE: return "DELETE";
+        default: return "ANY";
+    }
+}
+
+void Metrics::appendBuckets(String& out) {
+    for (uint8_t i = 0; i + 1 < METRICS_LATENCY_BUCKETS; i++) {
+        out += String(1UL << (METRICS_BUCKET_SHIFT + i));
+        out += ',';
+    }
+    out += "+Inf";
+}
+
+void Metrics::appendMarker(String& out, uint8_t marker) {
+    if (marker < _routeCount) {
+        out += methodName(_routes[marker].method);
+        out += ' ';
+        out += _routes[marker].uri;
+    } else if (marker >= METRICS_MAX_ROUTES && marker < METRICS_MARKERS) {
+        out += PHASE_NAMES[marker - METRICS_MAX_ROUTES];
+    } else {
+        out += '?';
+    }
+}
+
+void Metrics::appendHistogram(String& out, const MetricsHistogram& histogram) {
+    out += " n=" + String(histogram.count);
+    out += " sum_ms=" + String((unsigned long)(histogram.totalMicros / 1000));
+    out += " max_us=" + String(histogram.maxMicros);
+    out += " hist=";
+    for (uint8_t i = 0; i < METRICS_LATENCY_BUCKETS; i++) {
+        if (i > 0) {
+            out += ',';
+        }
+        out += String(histogram.buckets[i]);
+    }
+}
+
+void Metrics::appendMemory(String& out, const MetricsMemory& memory) {
+    out += " stack=" + String(memory.stackPeak);
+    out += " heap_retained=" + String(memory.heapRetained);
+    out += " frag_delta=" + String(memory.fragmentation);
+#ifdef HOST_HEAP_HOOK
+    out += " allocs=" + String(memory.allocations);
+    out += " alloc_bytes=" + String(memory.allocatedBytes);
+#endif
+}
+
+// --- MetricsTransport ---
+
+HttpHandler MetricsTransport::measured(uint8_t route, HttpHandler handler) {
+    if (route == METRICS_NO_ROUTE) {
+        return handler;
+    }
+    return [route, handler]() {
+        MetricsProbe probe;
+        Metrics::enterRoute(route, probe);
+        handler();
+        Metrics::leaveRoute(route, probe);
+    };
+}
+
+void MetricsTransport::on(const String& uri, HTTPMethod method, HttpHandler handler) {
+    _inner.on(uri, method, measured(Metrics::addRoute(uri, method), handler));
+}
+
+// الطلبات غير الموجودة في خانة باسم "*"
+void MetricsTransport::onNotFound(HttpHandler handler) {
+    _inner.onNotFound(measured(Metrics::addRoute("*", HTTP_ANY), handler));
+}
@@ -0,0 +1,165 @@
+// Metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "Config.h"
+#include "HttpTransport.h"
+
+// مدرج تكراري لزمن التنفيذ بخانات لوغاريتمية (انظر METRICS_BUCKET_SHIFT)
+struct MetricsHistogram {
+    uint32_t count;                              // عدد القياسات
+    uint32_t maxMicros;                          // أطول قياس
+    uint64_t totalMicros;                        // مجموع الأزمنة (للمتوسط)
+    uint32_t buckets[METRICS_LATENCY_BUCKETS];   // عدد القياسات في كل خانة
+};
+
+// ذاكرة معالج مسار: أسوأ قيمة عبر جميع الطلبات، والتخصيصات مجموعها
+struct MetricsMemory {
+    uint32_t stackPeak;      // أقصى عمق مكدس تحت موضع دخول المعالج (بايت، 0 إذا لم يُرسم المكدس)
+    uint32_t heapRetained;   // أكبر نقص في الكومة الحرة بعد المعالج (ما بقي محجوزاً بعده)
+    uint8_t fragmentation;   // أكبر زيادة في تجزئة الكومة (نقاط مئوية)
+    uint32_t allocations;    // عدد التخصيصات (مع خطاف على المنصة فقط، مثل HostHeap)
+    uint32_t allocatedBytes; // مجموع أحجامها
+};
+
+// مسار مسجل ومدرج زمن معالجه
+struct MetricsRoute {
+    const char* uri;            // نسخة من المسار تُحجز مرة واحدة عند التسجيل
+    HTTPMethod method;
+    MetricsHistogram latency;
+    MetricsMemory memory;
+};
+
+// حالة معالج جارٍ بين enterRoute و leaveRoute (على مكدس الغلاف)
+struct MetricsProbe {
+    uint32_t start;          // micros() عند الدخول
+    uint8_t previous;        // الموضع السابق
+    uint32_t* paintLow;      // المنطقة المرسومة من المكدس (nullptr = لم تُرسم)
+    uint32_t* paintHigh;
+    uint32_t heapFree;       // الكومة الحرة وتجزئتها عند الدخول
+    uint8_t fragmentation;
+    uint32_t allocations;    // عدادات الخطاف عند الدخول
+    uint32_t allocatedBytes;
+};
+
+// موضع التنفيذ الحالي: رقم مسار أثناء معالجه، أو مرحلة من دورة handleClient() خارج المعالجات
+#define METRICS_PHASE_SERVER (METRICS_MAX_ROUTES + 0)  // اتصالات الخادم (خارج المعالجات)
+#define METRICS_PHASE_RELAY (METRICS_MAX_ROUTES + 1)   // انتهاء طلبات المرحل
+#define METRICS_PHASE_STORAGE (METRICS_MAX_ROUTES + 2) // إكمالات عامل التخزين
+#define METRICS_PHASE_TIME (METRICS_MAX_ROUTES + 3)    // مقاطعة RTC
+#define METRICS_PHASE_TASKS (METRICS_MAX_ROUTES + 4)   // جدول المهام
+#define METRICS_MARKERS (METRICS_MAX_ROUTES + 5)
+
+// توقف مسجل: معالج أو دورة تجاوزت METRICS_STALL_THRESHOLD_US
+struct MetricsStall {
+    uint32_t atMillis; // millis() عند انتهائه
+    uint32_t micros;   // مدته
+    uint8_t marker;    // المسار، أو أطول مرحلة في الدورة إذا لم يتوقف معالج
+};
+
+// فئة مساعدة مشتركة لمقاييس التشغيل: مدرج زمن كل مسار HTTP ومدرج زمن دورة handleClient()،
+// وكاشف توقف يحفظ آخر المعالجات أو مراحل الدورة التي تجاوزت METRICS_STALL_THRESHOLD_US في حلقة صغيرة.
+// التسجيل بتكلفة ثابتة (قراءتا micros() وبضع زيادات، دون بحث أو تخصيص ذاكرة)،
+// والعرض النصي في /api/metrics يجمعها مع عدادات EEPROM و I2C و RTC والكومة والمرحل من وحداتها.
+// الحالة أنواع بسيطة لأن المديرين يُنشؤون من مُنشئات كائنات عامة.
+class Metrics {
+public:
+    // حجز خانة لمسار، وتُرجع رقمها أو METRICS_NO_ROUTE إذا امتلأ الجدول
+    static uint8_t addRoute(const String& uri, HTTPMethod method);
+    // دخول معالج مسار: رسم المكدس وأخذ لقطة من الكومة، وخروجه: تسجيل الزمن والذاكرة وفحص التوقف
+    static void enterRoute(uint8_t route, MetricsProbe& probe);
+    static void leaveRoute(uint8_t route, MetricsProbe& probe);
+    // حدود دورة handleClient() ومراحلها (تُنسب الدورة المتوقفة لأطول مرحلة)
+    static void beginLoop();
+    static void phase(uint8_t marker);
+    static void endLoop();
+    // بدء أخذ العينات على مؤقت عتادي (مع USE_STALL_SAMPLER)، و false إذا لم يتوفر
+    static bool beginSampler();
+
+    static uint8_t routeCount() { return _routeCount; }
+    static const MetricsRoute& route(uint8_t index) { return _routes[index]; }
+    static const MetricsHistogram& loop() { return _loop; }
+    // التوقفات: العدد الكلي، وآخرها بالترتيب من الأحدث (index < storedStalls())
+    static uint32_t stallCount() { return _stallCount; }
+    static uint8_t storedStalls() { return _stallCount < METRICS_STALL_SLOTS ? _stallCount : METRICS_STALL_SLOTS; }
+    static const MetricsStall& stall(uint8_t index);
+    // عينات المؤقت لكل موضع أثناء الدورات المتوقفة
+    static uint32_t samples(uint8_t marker) { return marker < METRICS_MARKERS ? _samples[marker] : 0; }
+
+    // الكومة: الحرة الآن، وأدنى قيمة منذ الإقلاع، وأكبر كتلة يمكن حجزها، والتجزئة (%)
+    static uint32_t heapFree();
+    static uint32_t heapMinFree();
+    static uint32_t heapLargestBlock();
+    static uint8_t heapFragmentation();
+    // أقل مسافة رُصدت بين أعمق استخدام للمكدس في معالج وحد المكدس (0xFFFFFFFF قبل أول قياس)
+    static uint32_t stackMinFree() { return _stackMinFree; }
+
+    // --- العرض النصي ---
+    // اسم طريقة HTTP
+    static const char* methodName(HTTPMethod method);
+    // حدود الخانات: "128,256,...,+Inf"
+    static void appendBuckets(String& out);
+    // " n=.. sum_ms=.. max_us=.. hist=a,b,..."
+    static void appendHistogram(String& out, const MetricsHistogram& histogram);
+    // " stack=.. heap_retained=.. frag_delta=.." (و " allocs=.. alloc_bytes=.." مع الخطاف)
+    static void appendMemory(String& out, const MetricsMemory& memory);
+    // اسم الموضع: "POST /api/..." للمسار أو "loop.tasks" للمرحلة
+    static void appendMarker(String& out, uint8_t marker);
+
+private:
+    static MetricsRoute _routes[METRICS_MAX_ROUTES];
+    static uint8_t _routeCount;
+    static MetricsHistogram _loop;
+    // الدورة الحالية (يقرؤها معالج المؤقت)
+    static volatile bool _inLoop;
+    static volatile uint32_t _loopStart;
+    static volatile uint8_t _marker;
+    static uint32_t _phaseStart;      // بداية المرحلة الحالية
+    static uint32_t _longestPhaseUs;  // أطول مرحلة في الدورة الحالية
+    static uint8_t _longestPhase;
+    static bool _stallInLoop;         // سُجل توقف معالج في الدورة الحالية
+    // حلقة آخر التوقفات
+    static MetricsStall _stalls[METRICS_STALL_SLOTS];
+    static uint32_t _stallCount;
+    static volatile uint32_t _samples[METRICS_MARKERS];
+    static uint32_t _stackMinFree;
+
+    static void record(MetricsHistogram& histogram, uint32_t micros);
+    static void addStall(uint8_t marker, uint32_t micros);
+    static void sampleTick();
+    // حد مكدس المهمة الحالية (أدنى عنوان)، أو nullptr إذا لم يُعرف على المنصة
+    static uint8_t* stackLimit();
+    // رسم المكدس تحت الموضع الحالي، وقياس أعمق كلمة تغيرت بعد المعالج
+    static void paintStack(MetricsProbe& probe);
+    static uint32_t* deepestUse(const MetricsProbe& probe);
+};
+
+// محول نقل يلف كل تسجيل مسار بقياس زمن معالجه، ويمرر ما عداه إلى النقل الفعلي كما هو
+// (يملكه كل مدير، فتُقاس مسارات جميع المديرين دون تعديل تسجيلاتها)
+class MetricsTransport : public HttpTransport {
+public:
+    explicit MetricsTransport(HttpTransport& inner) : _inner(inner) {}
+
+    void on(const String& uri, HTTPMethod method, HttpHandler handler) override;
+    void onNotFound(HttpHandler handler) override;
+    void begin() override { _inner.begin(); }
+    void handleClient() override { _inner.handleClient(); }
+    bool hasArg(const String& name) override { return _inner.hasArg(name); }
+    String arg(const String& name) override { return _inner.arg(name); }
+    String arg(int index) override { return _inner.arg(index); }
+    String argName(int index) override { return _inner.argName(index); }
+    int args() override { return _inner.args(); }
+    String uri() override { return _inner.uri(); }
+    HTTPMethod method() override { return _inner.method(); }
+    void send(int code, const char* contentType, const String& content) override { _inner.send(code, contentType, content); }
+    void setContentLength(size_t length) override { _inner.setContentLength(length); }
+    void sendContent(const String& content) override { _inner.sendContent(content); }
+
+private:
+    HttpTransport& _inner;
+
+    // المعالج ملفوفاً بقياس زمنه في خانة المسار (أو كما هو إذا لم تُحجز خانة)
+    static HttpHandler measured(uint8_t route, HttpHandler handler);
+};
+
+#endif // METRICS_H
@@ -0,0 +1,179 @@
+// PrayerCalc.cpp
+#include "PrayerCalc.h"
+
+// معاملات طرق الحساب: زاوية الفجر، وزاوية العشاء أو عدد الدقائق بعد المغرب
+struct PrayerMethodParams {
+    const char* name;  // الاسم في JSON
+    float fajrAngle;   // زاوية الفجر تحت الأفق
+    float ishaValue;   // زاوية العشاء، أو دقائق بعد المغرب إذا كان ishaMinutes
+    bool ishaMinutes;
+};
+
+// حسب ترتيب PRAYER_METHOD_*
+static const PrayerMethodParams PRAYER_METHODS[PRAYER_METHOD_COUNT] = {
+    { "egyptian", 19.5f, 17.5f, false },
+    { "mwl",      18.0f, 17.0f, false },
+    { "isna",     15.0f, 15.0f, false },
+    { "makkah",   18.5f, 90.0f, true  },
+    { "karachi",  18.0f, 18.0f, false },
+};
+
+// دوال مثلثية بالدرجات (دقة مفردة)
+static const float DEG = 0.017453292f;
+static inline float dsin(float d) { return sinf(d * DEG); }
+static inline float dcos(float d) { return cosf(d * DEG); }
+static inline float dtan(float d) { return tanf(d * DEG); }
+static inline float darcsin(float x) { return asinf(x) / DEG; }
+static inline float darctan2(float y, float x) { return atan2f(y, x) / DEG; }
+static inline float darccot(float x) { return atanf(1.0f / x) / DEG; }
+static inline float fixAngle(float a) { return a - 360.0f * floorf(a / 360.0f); }
+static inline float fixHour(float h) { return h - 24.0f * floorf(h / 24.0f); }
+
+// موقع الشمس بعد D يوماً من J2000.0 (الصيغ المبسطة من U.S. Naval Observatory)
+// D أقل من 40000 حتى 2099، فتبقى دقة float ضمن جزء من الثانية
+void PrayerCalc::sunPosition(float D, float& declination, float& equation) {
+    float g = fixAngle(357.529f + 0.98560028f * D);
+    float q = fixAngle(280.459f + 0.98564736f * D);
+    float L = fixAngle(q + 1.915f * dsin(g) + 0.020f * dsin(2 * g));
+    float e = 23.439f - 0.00000036f * D;
+    float RA = darctan2(dcos(e) * dsin(L), dcos(L)) / 15.0f;
+    equation = q / 15.0f - fixHour(RA);
+    declination = darcsin(dsin(e) * dsin(L));
+}
+
+// وقت وصول الشمس إلى زاوية معينة تحت الأفق
+// إذا لم تصل الشمس إلى الزاوية (خطوط العرض العالية صيفاً) يُقيد الناتج، ثم يُصحح بقاعدة منتصف الليل
+float PrayerCalc::sunAngleTime(float declination, float equation, float latitude, float angle, bool ccw) {
+    float noon = fixHour(12.0f - equation);
+    float cosT = (-dsin(angle) - dsin(declination) * dsin(latitude)) / (dcos(declination) * dcos(latitude));
+    if (cosT > 1.0f) cosT = 1.0f;
+    if (cosT < -1.0f) cosT = -1.0f;
+    float T = acosf(cosT) / DEG / 15.0f;
+    return noon + (ccw ? -T : T);
+}
+
+// وقت العصر: طول الظل = معامل × طول الجسم + ظل الزوال
+float PrayerCalc::asrTime(float declination, float equation, float latitude, uint8_t factor) {
+    float angle = -darccot(factor + dtan(fabsf(latitude - declination)));
+    return sunAngleTime(declination, equation, latitude, angle, false);
+}
+
+// أوقات العينات كجزء من اليوم (تكرار واحد بأوقات تقريبية كما في خوارزمية PrayTimes)
+const float PrayerCalc::SAMPLE_TIMES[PrayerCalc::SUN_SAMPLES] = { 5.0f / 24, 6.0f / 24, 12.0f / 24, 13.0f / 24, 18.0f / 24 };
+
+// الأيام منذ J2000.0 (ظهر 2000-01-01 UTC) عند منتصف الليل المحلي الشمسي، بحساب صحيح ثم تحويل إلى float
+float PrayerCalc::dayOffset(const PrayerSettings& settings, const DateTime& date) {
+    int32_t days = (int32_t)(DateTime(date.year(), date.month(), date.day()).unixtime() / 86400UL) - 10957;
+    return days - 0.5f - (float)settings.longitude / 360.0f;
+}
+
+// حساب أوقات اليوم بالدقائق من منتصف الليل (حسب ترتيب PrayerIndex)
+void PrayerCalc::calculateDay(const PrayerSettings& settings, const DateTime& date, int minutes[PRAYER_COUNT]) {
+    float D0 = dayOffset(settings, date);
+    float declination[SUN_SAMPLES], equation[SUN_SAMPLES];
+    for (uint8_t i = 0; i < SUN_SAMPLES; i++) {
+        sunPosition(D0 + SAMPLE_TIMES[i], declination[i], equation[i]);
+    }
+    timesFromSun(settings, declination, equation, minutes);
+}
+
+// حساب أوقات اليوم من موقع الشمس عند أوقات العينات
+void PrayerCalc::timesFromSun(const PrayerSettings& settings, const float declination[], const float equation[], int minutes[PRAYER_COUNT]) {
+    const PrayerMethodParams& method = PRAYER_METHODS[settings.method < PRAYER_METHOD_COUNT ? settings.method : PRAYER_METHOD_EGYPTIAN];
+    float latitude = settings.latitude;
+    float longitude = settings.longitude;
+
+    // العينات بالترتيب: 0 الفجر، 1 الشروق، 2 الظهر، 3 العصر، 4 الغروب والعشاء
+    float times[PRAYER_COUNT];
+    times[PRAYER_FAJR] = sunAngleTime(declination[0], equation[0], latitude, method.fajrAngle, true);
+    times[PRAYER_SUNRISE] = sunAngleTime(declination[1], equation[1], latitude, 0.833f, true);
+    times[PRAYER_DHUHR] = fixHour(12.0f - equation[2]);
+    times[PRAYER_ASR] = asrTime(declination[3], equation[3], latitude, settings.asrFactor == PRAYER_ASR_HANAFI ? 2 : 1);
+    times[PRAYER_MAGHRIB] = sunAngleTime(declination[4], equation[4], latitude, 0.833f, false);
+    times[PRAYER_ISHA] = method.ishaMinutes ? times[PRAYER_MAGHRIB] + method.ishaValue / 60.0f
+                                            : sunAngleTime(declination[4], equation[4], latitude, method.ishaValue, false);
+
+    // خطوط العرض العالية: الفجر والعشاء لا يبعدان عن الشروق/الغروب أكثر من نصف الليل
+    float night = fixHour(times[PRAYER_SUNRISE] - times[PRAYER_MAGHRIB]);
+    if (fixHour(times[PRAYER_SUNRISE] - times[PRAYER_FAJR]) > night / 2) {
+        times[PRAYER_FAJR] = times[PRAYER_SUNRISE] - night / 2;
+    }
+    if (!method.ishaMinutes && fixHour(times[PRAYER_ISHA] - times[PRAYER_MAGHRIB]) > night / 2) {
+        times[PRAYER_ISHA] = times[PRAYER_MAGHRIB] + night / 2;
+    }
+
+    // التحويل من التوقيت الشمسي إلى المنطقة الزمنية، والتقريب لأقرب دقيقة
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        float local = fixHour(times[i] + settings.timezone - longitude / 15.0f + 0.5f / 60.0f);
+        minutes[i] = (int)(local * 60.0f);
+    }
+}
+
+PrayerDayIterator::PrayerDayIterator(const PrayerSettings& settings, const DateTime& first)
+    : _settings(settings) {
+    _D = PrayerCalc::dayOffset(settings, first);
+    PrayerCalc::sunPosition(_D, _declination, _equation);
+}
+
+// أوقات اليوم الحالي ثم الانتقال إلى اليوم التالي
+void PrayerDayIterator::next(int minutes[PRAYER_COUNT]) {
+    float nextDeclination, nextEquation;
+    PrayerCalc::sunPosition(_D + 1.0f, nextDeclination, nextEquation);
+    float equationStep = nextEquation - _equation;
+    // معادلة الوقت محسوبة بفرق زاويتين قد يلتف بمقدار 24 ساعة بين العينتين
+    if (equationStep > 12.0f) equationStep -= 24.0f;
+    if (equationStep < -12.0f) equationStep += 24.0f;
+
+    float declination[PrayerCalc::SUN_SAMPLES], equation[PrayerCalc::SUN_SAMPLES];
+    for (uint8_t i = 0; i < PrayerCalc::SUN_SAMPLES; i++) {
+        float f = PrayerCalc::SAMPLE_TIMES[i];
+        declination[i] = _declination + (nextDeclination - _declination) * f;
+        equation[i] = _equation + equationStep * f;
+    }
+    PrayerCalc::timesFromSun(_settings, declination, equation, minutes);
+
+    _D += 1.0f;
+    _declination = nextDeclination;
+    _equation = nextEquation;
+}
+
+// قراءة إعدادات الموقع وطريقة الحساب المحفوظة
+void PrayerCalc::readConfig(PrayerSettings& settings) {
+    EEPROMHelper::get(PRAYER_CONFIG_ADDR, settings.latitude);
+    EEPROMHelper::get(PRAYER_CONFIG_ADDR + sizeof(double), settings.longitude);
+    EEPROMHelper::get(PRAYER_CONFIG_ADDR + 2 * sizeof(double), settings.timezone);
+    if (abs(settings.latitude) < 0.0001 && abs(settings.longitude) < 0.0001 && settings.timezone == 0) {
+        settings.latitude = 30.0444; // خط عرض القاهرة
+        settings.longitude = 31.2357; // خط طول القاهرة
+        settings.timezone = 2;        // المنطقة الزمنية للقاهرة (UTC+2)
+    }
+    PrayerMethodConfig config;
+    EEPROMHelper::get(PRAYER_METHOD_ADDR, config);
+    // EEPROM غير مكتوبة: الطريقة المصرية والعصر الشافعي (السلوك السابق)
+    settings.method = config.method < PRAYER_METHOD_COUNT ? config.method : PRAYER_METHOD_EGYPTIAN;
+    settings.asrFactor = config.asrFactor == PRAYER_ASR_HANAFI ? PRAYER_ASR_HANAFI : PRAYER_ASR_SHAFII;
+}
+
+// حفظ طريقة الحساب ومعامل العصر
+void PrayerCalc::saveMethod(uint8_t method, uint8_t asrFactor) {
+    PrayerMethodConfig config = { method, asrFactor };
+    EEPROMHelper::put(PRAYER_METHOD_ADDR, config);
+}
+
+// اسم طريقة الحساب في JSON
+const char* PrayerCalc::methodName(uint8_t method) {
+    return PRAYER_METHODS[method < PRAYER_METHOD_COUNT ? method : PRAYER_METHOD_EGYPTIAN].name;
+}
+
+// تحويل اسم طريقة من JSON إلى PRAYER_METHOD_*، أو -1 إذا كان غير معروف
+int PrayerCalc::parseMethod(const char* name) {
+    if (name == nullptr) {
+        return -1;
+    }
+    for (int i = 0; i < PRAYER_METHOD_COUNT; i++) {
+        if (strcmp(name, PRAYER_METHODS[i].name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
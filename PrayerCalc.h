@@ -0,0 +1,78 @@
+// PrayerCalc.h
+#ifndef PRAYER_CALC_H
+#define PRAYER_CALC_H
+
+#include "Config.h"
+#include "EEPROM_Helper.h" // لقراءة إعدادات الموقع من EEPROM
+
+// ترتيب أوقات اليوم في جميع المصفوفات المستخدمة في المكتبة
+enum PrayerIndex {
+    PRAYER_FAJR = 0,   // الفجر
+    PRAYER_SUNRISE,    // الشروق
+    PRAYER_DHUHR,      // الظهر
+    PRAYER_ASR,        // العصر
+    PRAYER_MAGHRIB,    // المغرب (الغروب)
+    PRAYER_ISHA,       // العشاء
+    PRAYER_COUNT
+};
+
+// إعدادات حساب أوقات الصلاة لموقع معين
+struct PrayerSettings {
+    double latitude;    // خط العرض
+    double longitude;   // خط الطول
+    int timezone;       // المنطقة الزمنية (ساعات عن UTC)
+    uint8_t method;     // PRAYER_METHOD_*
+    uint8_t asrFactor;  // PRAYER_ASR_SHAFII أو PRAYER_ASR_HANAFI
+};
+
+// فئة مساعدة لحساب أوقات الصلاة والشمس ليوم محدد
+// محرك داخلي بدقة مفردة (float): على ESP8266 بدون وحدة فاصلة عائمة تكون العمليات المفردة
+// أسرع بكثير من الدقة المضاعفة، والخطأ الناتج أقل بكثير من دقيقة.
+// مشتركة بين PrayerTimesManagementClass والجدول السنوي والجداول المرتبطة بالشروق/الغروب/الصلاة
+class PrayerCalc {
+public:
+    // حساب أوقات اليوم بالدقائق من منتصف الليل (حسب ترتيب PrayerIndex)
+    static void calculateDay(const PrayerSettings& settings, const DateTime& date, int minutes[PRAYER_COUNT]);
+    // قراءة إعدادات الموقع وطريقة الحساب المحفوظة (القاهرة والطريقة المصرية افتراضياً إذا لم تُكتب بعد)
+    static void readConfig(PrayerSettings& settings);
+    // حفظ طريقة الحساب ومعامل العصر
+    static void saveMethod(uint8_t method, uint8_t asrFactor);
+    // اسم طريقة الحساب في JSON وعكسه (-1 إذا كان الاسم غير معروف)
+    static const char* methodName(uint8_t method);
+    static int parseMethod(const char* name);
+
+    // الأيام منذ J2000.0 عند منتصف الليل المحلي الشمسي لتاريخ معين
+    static float dayOffset(const PrayerSettings& settings, const DateTime& date);
+    // موقع الشمس بعد D يوماً من J2000.0: الميل ومعادلة الوقت (بالساعات)
+    static void sunPosition(float D, float& declination, float& equation);
+    // حساب أوقات اليوم من موقع الشمس عند أوقات العينات (PRAYER_SUN_SAMPLES)
+    static void timesFromSun(const PrayerSettings& settings, const float declination[], const float equation[], int minutes[PRAYER_COUNT]);
+
+    // عدد أوقات العينات في اليوم وأجزاؤها من اليوم (الفجر، الشروق، الظهر، العصر، الغروب/العشاء)
+    static const uint8_t SUN_SAMPLES = 5;
+    static const float SAMPLE_TIMES[SUN_SAMPLES];
+
+private:
+    // وقت وصول الشمس إلى زاوية معينة تحت الأفق قبل الزوال (ccw) أو بعده
+    static float sunAngleTime(float declination, float equation, float latitude, float angle, bool ccw);
+    // وقت العصر حسب معامل الظل
+    static float asrTime(float declination, float equation, float latitude, uint8_t factor);
+};
+
+// حساب أوقات أيام متتالية بشكل تدريجي
+// موقع الشمس يُحسب مرة واحدة عند كل منتصف ليل ويُستوفى خطياً لأوقات العينات داخل اليوم،
+// فيكلف كل يوم حساباً واحداً لموقع الشمس بدلاً من خمسة، وتُعاد قيمة نهاية اليوم كبداية لليوم التالي.
+class PrayerDayIterator {
+public:
+    PrayerDayIterator(const PrayerSettings& settings, const DateTime& first);
+    // أوقات اليوم الحالي بالدقائق من منتصف الليل، ثم الانتقال إلى اليوم التالي
+    void next(int minutes[PRAYER_COUNT]);
+
+private:
+    PrayerSettings _settings;
+    float _D;                // بداية اليوم الحالي (أيام منذ J2000.0)
+    float _declination;      // ميل الشمس عند بداية اليوم
+    float _equation;         // معادلة الوقت عند بداية اليوم
+};
+
+#endif // PRAYER_CALC_H
@@ -0,0 +1,134 @@
+// PrayerTable.cpp
+#include "PrayerTable.h"
+
+PrayerTableHeader PrayerTable::_header;
+bool PrayerTable::_headerLoaded = false;
+
+// التأكد من أن الجدول يطابق الإعدادات والسنة، وإعادة توليده إذا لم يطابق
+bool PrayerTable::ensure(const PrayerSettings& settings, uint16_t year) {
+    if (!sameKey(settings, year)) {
+        generate(settings, year);
+    }
+    return _header.magic == PRAYER_TABLE_MAGIC;
+}
+
+// أوقات يوم من الجدول إذا كان مطابقاً، وإلا بالحساب المباشر
+void PrayerTable::getDay(const PrayerSettings& settings, const DateTime& date, int minutes[PRAYER_COUNT]) {
+    int16_t month[31][PRAYER_COUNT];
+    uint8_t days = readMonth(settings, date.year(), date.month(), month);
+    if (days == 0) {
+        PrayerCalc::calculateDay(settings, date, minutes);
+        return;
+    }
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        minutes[i] = month[date.day() - 1][i];
+    }
+}
+
+// قراءة أوقات شهر كامل: القيمة المرجعية ثم جمع الفروق يوماً بيوم
+uint8_t PrayerTable::readMonth(const PrayerSettings& settings, uint16_t year, uint8_t month, int16_t out[31][PRAYER_COUNT]) {
+    if (month < 1 || month > 12 || !sameKey(settings, year) || _header.magic != PRAYER_TABLE_MAGIC) {
+        return 0;
+    }
+    uint8_t days = daysInMonth(year, month);
+    uint16_t keyframe[PRAYER_TABLE_TIMES];
+    uint8_t deltas[31 * PRAYER_TABLE_DAY_BYTES];
+    EEPROMHelper::readBytes(PRAYER_TABLE_KEYFRAMES_ADDR + (month - 1) * sizeof(keyframe), (byte*)keyframe, sizeof(keyframe));
+    EEPROMHelper::readBytes(PRAYER_TABLE_DELTAS_ADDR + firstDayOfMonth(year, month) * PRAYER_TABLE_DAY_BYTES, deltas, days * PRAYER_TABLE_DAY_BYTES);
+
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        out[0][i] = keyframe[i];
+    }
+    for (uint8_t d = 1; d < days; d++) {
+        for (int i = 0; i < PRAYER_COUNT; i++) {
+            int index = d * PRAYER_TABLE_TIMES + i;
+            int8_t delta = (deltas[index / 2] >> ((index % 2) * 4)) & 0x0F;
+            if (delta & 0x08) {
+                delta -= 16; // إشارة القيمة ذات 4 بت
+            }
+            out[d][i] = out[d - 1][i] + delta;
+        }
+    }
+    return days;
+}
+
+// هل حُسب الجدول (أو حاول) بهذه الإعدادات والسنة؟
+bool PrayerTable::sameKey(const PrayerSettings& settings, uint16_t year) {
+    if (!_headerLoaded) {
+        EEPROMHelper::get(PRAYER_TABLE_ADDR, _header);
+        _headerLoaded = true;
+    }
+    return (_header.magic == PRAYER_TABLE_MAGIC || _header.magic == PRAYER_TABLE_MAGIC_UNENCODABLE) &&
+           _header.year == year &&
+           _header.latitudeE4 == (int32_t)lround(settings.latitude * 10000) &&
+           _header.longitudeE4 == (int32_t)lround(settings.longitude * 10000) &&
+           _header.timezone == settings.timezone &&
+           _header.method == settings.method &&
+           _header.asrFactor == settings.asrFactor;
+}
+
+// توليد الجدول للسنة كاملة وكتابته شهراً بشهر
+// الرأس يُبطل أولاً ثم يُكتب أخيراً، فلا يُستخدم جدول نصف مكتوب بعد انقطاع الطاقة
+void PrayerTable::generate(const PrayerSettings& settings, uint16_t year) {
+    Serial.print("توليد جدول أوقات الصلاة لسنة "); Serial.println(year);
+    _header.magic = 0;
+    EEPROMHelper::put(PRAYER_TABLE_ADDR, _header);
+
+    bool encodable = true;
+    for (uint8_t month = 1; month <= 12; month++) {
+        uint8_t days = daysInMonth(year, month);
+        uint16_t keyframe[PRAYER_TABLE_TIMES];
+        uint8_t deltas[31 * PRAYER_TABLE_DAY_BYTES];
+        memset(deltas, 0, sizeof(deltas));
+        int previous[PRAYER_COUNT];
+        for (uint8_t d = 0; d < days; d++) {
+            int minutes[PRAYER_COUNT];
+            PrayerCalc::calculateDay(settings, DateTime(year, month, d + 1), minutes);
+            for (int i = 0; i < PRAYER_COUNT; i++) {
+                if (d == 0) {
+                    keyframe[i] = minutes[i];
+                } else {
+                    int delta = minutes[i] - previous[i];
+                    if (delta < -8 || delta > 7) {
+                        encodable = false;
+                    }
+                    int index = d * PRAYER_TABLE_TIMES + i;
+                    deltas[index / 2] |= (delta & 0x0F) << ((index % 2) * 4);
+                }
+                previous[i] = minutes[i];
+            }
+            yield(); // الحساب بطيء على ESP8266، تجنب تفعيل مؤقت المراقبة
+        }
+        EEPROMHelper::writeBytes(PRAYER_TABLE_KEYFRAMES_ADDR + (month - 1) * sizeof(keyframe), (const byte*)keyframe, sizeof(keyframe));
+        EEPROMHelper::writeBytes(PRAYER_TABLE_DELTAS_ADDR + firstDayOfMonth(year, month) * PRAYER_TABLE_DAY_BYTES, deltas, days * PRAYER_TABLE_DAY_BYTES);
+    }
+
+    // تُحفظ الإعدادات حتى عند تعذر الترميز، لتجنب إعادة المحاولة في كل مرة
+    _header.year = year;
+    _header.latitudeE4 = (int32_t)lround(settings.latitude * 10000);
+    _header.longitudeE4 = (int32_t)lround(settings.longitude * 10000);
+    _header.timezone = settings.timezone;
+    _header.method = settings.method;
+    _header.asrFactor = settings.asrFactor;
+    _header.magic = encodable ? PRAYER_TABLE_MAGIC : PRAYER_TABLE_MAGIC_UNENCODABLE;
+    EEPROMHelper::put(PRAYER_TABLE_ADDR, _header);
+    if (!encodable) {
+        Serial.println("تعذر ترميز جدول أوقات الصلاة لهذا الموقع، سيُستخدم الحساب المباشر.");
+    }
+}
+
+// عدد أيام الشهر
+uint8_t PrayerTable::daysInMonth(uint16_t year, uint8_t month) {
+    static const uint8_t DAYS[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return DAYS[month - 1] + (month == 2 && leap ? 1 : 0);
+}
+
+// ترتيب أول يوم في الشهر ضمن السنة (0-365)
+uint16_t PrayerTable::firstDayOfMonth(uint16_t year, uint8_t month) {
+    uint16_t day = 0;
+    for (uint8_t m = 1; m < month; m++) {
+        day += daysInMonth(year, m);
+    }
+    return day;
+}
@@ -0,0 +1,39 @@
+// PrayerTable.h
+#ifndef PRAYER_TABLE_H
+#define PRAYER_TABLE_H
+
+#include "Config.h"
+#include "EEPROM_Helper.h" // لحفظ الجدول في EEPROM
+#include "PrayerCalc.h"    // لتوليد الجدول
+
+// فئة مساعدة لجدول أوقات الصلاة السنوي المحفوظ في EEPROM
+// يُولد مرة واحدة لكل سنة أو عند تغيير الموقع/المنطقة الزمنية/طريقة الحساب،
+// فتُقرأ أوقات أي يوم بعد ذلك دون حساب (مهم على ESP8266 حيث الحساب بدقة مضاعفة بطيء).
+// الترميز: قيمة مرجعية لأول يوم في كل شهر، ثم فرق كل يوم عن سابقه بحجم 4 بت (-8 إلى +7 دقائق).
+class PrayerTable {
+public:
+    // التأكد من أن الجدول يطابق الإعدادات والسنة، وإعادة توليده إذا لم يطابق
+    // تُرجع false إذا تعذر الترميز (فروق يومية كبيرة في خطوط العرض القصوى)، فيُستخدم الحساب المباشر
+    static bool ensure(const PrayerSettings& settings, uint16_t year);
+    // هل حُسب الجدول (أو حاول) بهذه الإعدادات والسنة؟ (false: يلزم ensure، وحتى ذلك يُستخدم الحساب المباشر)
+    static bool matches(const PrayerSettings& settings, uint16_t year) { return sameKey(settings, year); }
+    // أوقات يوم بالدقائق من منتصف الليل: من الجدول إذا كان مطابقاً، وإلا بالحساب المباشر
+    static void getDay(const PrayerSettings& settings, const DateTime& date, int minutes[PRAYER_COUNT]);
+    // قراءة أوقات شهر كامل من الجدول بقراءة واحدة للفروق، وتُرجع عدد الأيام أو 0 إذا لم يطابق الجدول
+    static uint8_t readMonth(const PrayerSettings& settings, uint16_t year, uint8_t month, int16_t out[31][PRAYER_COUNT]);
+    // عدد أيام الشهر
+    static uint8_t daysInMonth(uint16_t year, uint8_t month);
+
+private:
+    static PrayerTableHeader _header; // نسخة رأس الجدول
+    static bool _headerLoaded;        // هل قُرئ الرأس من EEPROM؟
+
+    // هل حُسب الجدول (أو حاول) بهذه الإعدادات والسنة؟
+    static bool sameKey(const PrayerSettings& settings, uint16_t year);
+    // توليد الجدول للسنة كاملة وكتابته شهراً بشهر
+    static void generate(const PrayerSettings& settings, uint16_t year);
+    // ترتيب أول يوم في الشهر ضمن السنة (0-365)
+    static uint16_t firstDayOfMonth(uint16_t year, uint8_t month);
+};
+
+#endif // PRAYER_TABLE_H
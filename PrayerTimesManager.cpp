@@ -3,50 +3,58 @@
 
 // المُنشئ (Constructor) لفئة PrayerTimesManagementClass
 #ifdef USE_EXTERNAL_EEPROM
-PrayerTimesManagementClass::PrayerTimesManagementClass(WebServer& serverRef, int relayPin)
-    : MainControlClass(serverRef, relayPin), _rtcManager() { // تهيئة RTCManager
-    // بدء تشغيل RTC
-    if (!_rtcManager.beginRTC()) {
-        Serial.println("فشل تهيئة RTC في PrayerTimesManager. يرجى التحقق من التوصيلات والبطارية.");
-    } else {
-        Serial.println("تم تهيئة RTC في PrayerTimesManager بنجاح.");
-    }
+PrayerTimesManagementClass::PrayerTimesManagementClass(HttpServerRef serverRef, int relayPin)
+    : MainControlClass(serverRef, relayPin) {
+    // بدء خدمة الوقت المشتركة (تهيئة RTC مرة واحدة لجميع المديرين) والاشتراك في تغيرات الساعة
+    TimeService::begin();
+    TimeService::subscribe(this);
+    // مهمة الحافة قبل قراءة الإعدادات (ترحيل الإعدادات القديمة يشغلها)، وتُشغل أيضاً فور مقاطعة Alarm2
+    _edgeTask = TaskScheduler::add([](void* self) { static_cast<PrayerTimesManagementClass*>(self)->runRelayEdge(); }, this, 0);
+    TimeService::bindWake(TIME_WAKE_PRAYER, _edgeTask);
+    // مهمة توليد الجدول السنوي: في أول دورة، ثم كلما تغيرت الإعدادات أو السنة (وليس داخل معالج طلب)
+    _tableTask = TaskScheduler::add([](void* self) { static_cast<PrayerTimesManagementClass*>(self)->runTableRefresh(); }, this, 0);
     // قراءة الإعدادات من EEPROM أولاً
     readPrayerConfig(_latitude, _longitude, _timezone);
-    _autoRelayConfig = readAutoRelayConfig();
-
-    // تهيئة كائن PrayerTimes بالقيم المقروءة
-    _prayerTimes.setCoordinates(_latitude, _longitude, _timezone);
-    _prayerTimes.setCalcMethod(MWL); // طريقة حساب افتراضية (يمكن تغييرها عبر API)
-    _prayerTimes.setHanafi(false); // إعداد افتراضي (يمكن تغييرها عبر API)
+    PrayerSettings stored;
+    PrayerCalc::readConfig(stored); // طريقة الحساب ومعامل العصر
+    _method = stored.method;
+    _asrFactor = stored.asrFactor;
+    _relayConfig = readAutoRelayConfig();
 
     Serial.print("إعدادات الصلاة الأولية: خط العرض="); Serial.print(_latitude, 4);
     Serial.print(", خط الطول="); Serial.print(_longitude, 4);
-    Serial.print(", المنطقة الزمنية="); Serial.println(_timezone);
-    Serial.print("المرحل التلقائي مفعل: "); Serial.println(_autoRelayConfig.enabled ? "صحيح" : "خطأ");
+    Serial.print(", المنطقة الزمنية="); Serial.print(_timezone);
+    Serial.print(", طريقة الحساب="); Serial.println(PrayerCalc::methodName(_method));
+    Serial.print("المرحل التلقائي مفعل: "); Serial.println(_relayConfig.enabled ? "صحيح" : "خطأ");
+    registerTransitionSource(this);
+    requestRelayRestore(); // أول دورة بعد الإقلاع: تعيين المرحل حسب آخر انتقال فائت عبر جميع المصادر
 }
 #else
-PrayerTimesManagementClass::PrayerTimesManagementClass(WebServer& serverRef, int relayPin, EEPROMClass& eepromRef)
-    : MainControlClass(serverRef, relayPin, eepromRef), _rtcManager() { // تهيئة RTCManager
-    // بدء تشغيل RTC
-    if (!_rtcManager.beginRTC()) {
-        Serial.println("فشل تهيئة RTC في PrayerTimesManager. يرجى التحقق من التوصيلات والبطارية.");
-    } else {
-        Serial.println("تم تهيئة RTC في PrayerTimesManager بنجاح.");
-    }
+PrayerTimesManagementClass::PrayerTimesManagementClass(HttpServerRef serverRef, int relayPin, EEPROMClass& eepromRef)
+    : MainControlClass(serverRef, relayPin, eepromRef) {
+    // بدء خدمة الوقت المشتركة (تهيئة RTC مرة واحدة لجميع المديرين) والاشتراك في تغيرات الساعة
+    TimeService::begin();
+    TimeService::subscribe(this);
+    // مهمة الحافة قبل قراءة الإعدادات (ترحيل الإعدادات القديمة يشغلها)، وتُشغل أيضاً فور مقاطعة Alarm2
+    _edgeTask = TaskScheduler::add([](void* self) { static_cast<PrayerTimesManagementClass*>(self)->runRelayEdge(); }, this, 0);
+    TimeService::bindWake(TIME_WAKE_PRAYER, _edgeTask);
+    // مهمة توليد الجدول السنوي: في أول دورة، ثم كلما تغيرت الإعدادات أو السنة (وليس داخل معالج طلب)
+    _tableTask = TaskScheduler::add([](void* self) { static_cast<PrayerTimesManagementClass*>(self)->runTableRefresh(); }, this, 0);
     // قراءة الإعدادات من EEPROM أولاً
     readPrayerConfig(_latitude, _longitude, _timezone);
-    _autoRelayConfig = readAutoRelayConfig();
-
-    // تهيئة كائن PrayerTimes بالقيم المقروءة
-    _prayerTimes.setCoordinates(_latitude, _longitude, _timezone);
-    _prayerTimes.setCalcMethod(MWL); // طريقة حساب افتراضية (يمكن تغييرها عبر API)
-    _prayerTimes.setHanafi(false); // إعداد افتراضي (يمكن تغييرها عبر API)
+    PrayerSettings stored;
+    PrayerCalc::readConfig(stored); // طريقة الحساب ومعامل العصر
+    _method = stored.method;
+    _asrFactor = stored.asrFactor;
+    _relayConfig = readAutoRelayConfig();
 
     Serial.print("إعدادات الصلاة الأولية: خط العرض="); Serial.print(_latitude, 4);
     Serial.print(", خط الطول="); Serial.print(_longitude, 4);
-    Serial.print(", المنطقة الزمنية="); Serial.println(_timezone);
-    Serial.print("المرحل التلقائي مفعل: "); Serial.println(_autoRelayConfig.enabled ? "صحيح" : "خطأ");
+    Serial.print(", المنطقة الزمنية="); Serial.print(_timezone);
+    Serial.print(", طريقة الحساب="); Serial.println(PrayerCalc::methodName(_method));
+    Serial.print("المرحل التلقائي مفعل: "); Serial.println(_relayConfig.enabled ? "صحيح" : "خطأ");
+    registerTransitionSource(this);
+    requestRelayRestore(); // أول دورة بعد الإقلاع: تعيين المرحل حسب آخر انتقال فائت عبر جميع المصادر
 }
 #endif
 
@@ -55,23 +63,39 @@ void PrayerTimesManagementClass::setupPrayerEndpoints() {
     _server.on("/api/prayer/set_config", HTTP_POST, [this]() { handleSetPrayerConfig(); });
     _server.on("/api/prayer/get_config", HTTP_GET, [this]() { handleGetPrayerConfig(); });
     _server.on("/api/prayer/get_times", HTTP_GET, [this]() { handleGetPrayerTimes(); });
+    _server.on("/api/prayer/get_calendar", HTTP_GET, [this]() { handleGetPrayerCalendar(); });
     _server.on("/api/prayer/set_auto_relay_config", HTTP_POST, [this]() { handleSetAutoRelayConfig(); });
     _server.on("/api/prayer/get_auto_relay_config", HTTP_GET, [this]() { handleGetAutoRelayConfig(); });
 
-    // نقاط نهاية RTC خاصة بـ PrayerTimesManager
+    // نقاط نهاية الوقت (المعالجات مشتركة في MainControlClass، والمسار محفوظ للتوافق)
     _server.on("/api/prayer/time/get", HTTP_GET, [this]() { handleGetTime(); });
     _server.on("/api/prayer/time/set", HTTP_POST, [this]() { handleSetTime(); });
 }
 
-// وظيفة يتم استدعاؤها في دالة loop() الرئيسية لفحص المرحل التلقائي
+// محفوظة للتوافق مع المخططات السابقة: المهام تُشغل من handleClient()
 void PrayerTimesManagementClass::loopTasks() {
-    // فحص أوقات الصلاة كل 30 ثانية على الأقل لتجنب التحميل الزائد
-    if (millis() - _lastPrayerCheck >= 30000) { 
-        if (_autoRelayConfig.enabled) {
-            handleAutoRelayByPrayerTimes();
-        }
-        _lastPrayerCheck = millis();
+    TaskScheduler::service();
+}
+
+// مهمة الحافة: تُشغل عند موعد الحافة التالية (أو لإعادة المزامنة الدورية) أو عند مقاطعة Alarm2
+// أو بعد تغيير الإعدادات، فلا تُقرأ RTC بينها
+void PrayerTimesManagementClass::runRelayEdge() {
+    TimeService::wakeFired(TIME_WAKE_PRAYER); // استهلاك علم المقاطعة إن وُجد
+    if (!_relayConfig.enabled) {
+        return; // تبقى المهمة بلا موعد حتى يُفعّل المرحل التلقائي
     }
+    DateTime now = TimeService::sync(); // قراءة فعلية لـ RTC: دقة الثانية عند الحافة
+    if (_relayEdgeArmed && now < _nextRelayEdge) {
+        sleepUntilRelayEdge(now); // استيقاظ مبكر (إعادة مزامنة أو الثانية الأخيرة قبل الحافة)
+        return;
+    }
+    handleAutoRelayByPrayerTimes(now);
+}
+
+// مهمة الجدول السنوي: إعادة توليده لسنة اليوم الحالي إذا لم يطابق الإعدادات
+// (تُشغل حتى مع تعطيل المرحل التلقائي، فتقرأ المعالجات الجدول بدل الحساب المباشر)
+void PrayerTimesManagementClass::runTableRefresh() {
+    PrayerTable::ensure(currentSettings(), TimeService::now().year());
 }
 
 // حفظ إعدادات أوقات الصلاة في EEPROM
@@ -98,41 +122,75 @@ void PrayerTimesManagementClass::readPrayerConfig(double& lat, double& lon, int&
     }
 }
 
+// إعدادات الحساب الحالية كهيكل واحد
+PrayerSettings PrayerTimesManagementClass::currentSettings() const {
+    PrayerSettings settings = { _latitude, _longitude, _timezone, _method, _asrFactor };
+    return settings;
+}
+
+// فهارس الصلوات في إعدادات المرحل التلقائي القديمة (الفجر، المغرب، العشاء)
+static const int LEGACY_AUTO_RELAY_INDEX[3] = { PRAYER_FAJR, PRAYER_MAGHRIB, PRAYER_ISHA };
+
 // حفظ إعدادات المرحل التلقائي لأوقات الصلاة في EEPROM
-void PrayerTimesManagementClass::saveAutoRelayConfig(const AutoRelayPrayerConfig& config) {
-    EEPROMHelper::put(AUTO_RELAY_CONFIG_ADDR, config);
-    _autoRelayConfig = config; // تحديث النسخة المحلية
+void PrayerTimesManagementClass::saveAutoRelayConfig(const PrayerRelayConfig& config) {
+    EEPROMHelper::put(PRAYER_RELAY_ADDR, config);
+    _relayConfig = config; // تحديث النسخة المحلية
+    invalidatePrayerCache(); // إعادة تجميع النوافذ وحساب الحافة التالية
     Serial.println("تم حفظ إعدادات المرحل التلقائي لأوقات الصلاة.");
 }
 
 // قراءة إعدادات المرحل التلقائي لأوقات الصلاة من EEPROM
-AutoRelayPrayerConfig PrayerTimesManagementClass::readAutoRelayConfig() {
-    AutoRelayPrayerConfig config;
-    EEPROMHelper::get(AUTO_RELAY_CONFIG_ADDR, config);
-   
+// إذا لم تكن المنطقة الجديدة مهيأة تُرحل نوافذ الفجر والمغرب والعشاء من التخطيط القديم
+PrayerRelayConfig PrayerTimesManagementClass::readAutoRelayConfig() {
+    PrayerRelayConfig config;
+    EEPROMHelper::get(PRAYER_RELAY_ADDR, config);
+    bool isValid = config.magic == PRAYER_RELAY_MAGIC;
+    for (int i = 0; i < PRAYER_COUNT && isValid; ++i) {
+        isValid = config.minutesBefore[i] >= 0 && config.minutesAfter[i] >= 0 &&
+                  config.minutesBefore[i] <= 1440 && config.minutesAfter[i] <= 1440;
+    }
+    if (isValid) {
+        return config;
+    }
+
+    memset(&config, 0, sizeof(config));
+    config.magic = PRAYER_RELAY_MAGIC;
+    AutoRelayPrayerConfig legacy;
+    EEPROMHelper::get(AUTO_RELAY_CONFIG_ADDR, legacy);
     // تحقق بسيط للقيم غير الصالحة (مثل 0xFF من EEPROM غير المكتوبة)
-    bool isValid = true;
+    bool legacyValid = true;
     for (int i = 0; i < 3; ++i) {
-        if (config.minutesBefore[i] < 0 || config.minutesAfter[i] < 0 ||
-            config.minutesBefore[i] > 1440 || config.minutesAfter[i] > 1440) { 
-            isValid = false;
+        if (legacy.minutesBefore[i] < 0 || legacy.minutesAfter[i] < 0 ||
+            legacy.minutesBefore[i] > 1440 || legacy.minutesAfter[i] > 1440) {
+            legacyValid = false;
             break;
         }
     }
-
-    if (!isValid) {
-        // إعادة تعيين إلى القيم الافتراضية إذا كانت غير صالحة
-        config.enabled = false;
+    if (legacyValid) {
+        config.enabled = legacy.enabled;
         for (int i = 0; i < 3; i++) {
-            config.minutesBefore[i] = 0;
-            config.minutesAfter[i] = 0;
+            int index = LEGACY_AUTO_RELAY_INDEX[i];
+            config.prayerMask |= 1 << index;
+            config.minutesBefore[index] = legacy.minutesBefore[i];
+            config.minutesAfter[index] = legacy.minutesAfter[i];
         }
+        Serial.println("تم ترحيل إعدادات المرحل التلقائي القديمة (الفجر، المغرب، العشاء).");
+    } else {
         Serial.println("تم إعادة تعيين إعدادات المرحل التلقائي إلى الافتراضيات بسبب قيم غير صالحة.");
-        saveAutoRelayConfig(config); // حفظ الافتراضيات
     }
+    saveAutoRelayConfig(config); // حفظ الإعدادات بالتخطيط الجديد
     return config;
 }
 
+// إلغاء أوقات اليوم المحفوظة ونوافذ المرحل (تُحسب من جديد عند الحاجة التالية)
+void PrayerTimesManagementClass::invalidatePrayerCache() {
+    _cacheValid = false;
+    _windowsValid = false;
+    _relayEdgeArmed = false;
+    TaskScheduler::trigger(_edgeTask); // تقييم المرحل في الدورة التالية
+    TaskScheduler::trigger(_tableTask); // إعادة توليد الجدول السنوي بالإعدادات الجديدة
+}
+
 // معالج لتعيين إعدادات أوقات الصلاة
 void PrayerTimesManagementClass::handleSetPrayerConfig() {
     if (_server.hasArg("plain")) {
@@ -142,16 +200,31 @@ void PrayerTimesManagementClass::handleSetPrayerConfig() {
             _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"JSON غير صالح\"}");
             return;
         }
+        // طريقة الحساب ومعامل العصر اختياريان (تبقى القيم الحالية إذا لم يُرسلا)
+        int method = doc.containsKey("method") ? PrayerCalc::parseMethod(doc["method"]) : _method;
+        const char* asr = doc["asr"];
+        int asrFactor = asr == nullptr ? _asrFactor
+                      : strcmp(asr, "hanafi") == 0 ? PRAYER_ASR_HANAFI
+                      : strcmp(asr, "shafii") == 0 ? PRAYER_ASR_SHAFII : -1;
+        if (method < 0 || asrFactor < 0) {
+            _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"طريقة الحساب أو مذهب العصر غير معروف\"}");
+            return;
+        }
         _latitude = doc["latitude"].as<double>();
         _longitude = doc["longitude"].as<double>();
         _timezone = doc["timezone"].as<int>();
         savePrayerConfig(_latitude, _longitude, _timezone);
-        // تحديث كائن PrayerTimes بالإعدادات الجديدة
-        _prayerTimes.setCoordinates(_latitude, _longitude, _timezone); 
+        if (method != _method || asrFactor != _asrFactor) {
+            _method = method;
+            _asrFactor = asrFactor;
+            PrayerCalc::saveMethod(_method, _asrFactor);
+        }
+        invalidatePrayerCache(); // تغير الموقع، إعادة حساب أوقات اليوم عند الطلب التالي
         _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم حفظ إعدادات الصلاة\"}");
         Serial.print("تم تعيين إعدادات الصلاة إلى: خط العرض="); Serial.print(_latitude, 4);
         Serial.print(", خط الطول="); Serial.print(_longitude, 4);
-        Serial.print(", المنطقة الزمنية="); Serial.println(_timezone);
+        Serial.print(", المنطقة الزمنية="); Serial.print(_timezone);
+        Serial.print(", طريقة الحساب="); Serial.println(PrayerCalc::methodName(_method));
     } else {
         _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"جسم الطلب مفقود\"}");
     }
@@ -162,196 +235,416 @@ void PrayerTimesManagementClass::handleGetPrayerConfig() {
     readPrayerConfig(_latitude, _longitude, _timezone); // التأكد من تحميل القيم الحالية
     String json = "{ \"latitude\": " + String(_latitude, 6) +
                   ", \"longitude\": " + String(_longitude, 6) +
-                  ", \"timezone\": " + String(_timezone) + " }";
+                  ", \"timezone\": " + String(_timezone) +
+                  ", \"method\": \"" + String(PrayerCalc::methodName(_method)) +
+                  "\", \"asr\": \"" + String(_asrFactor == PRAYER_ASR_HANAFI ? "hanafi" : "shafii") + "\" }";
     _server.send(200, "application/json", json);
 }
 
-// معالج للحصول على أوقات الصلاة لليوم الحالي
+// أسماء أوقات اليوم في JSON (حسب ترتيب PrayerIndex)
+static const char* const PRAYER_NAMES[PRAYER_COUNT] = { "Fajr", "Sunrise", "Dhuhr", "Asr", "Maghrib", "Isha" };
+
+// معالج للحصول على أوقات الصلاة لليوم الحالي (من الذاكرة المؤقتة دون إعادة الحساب)
 void PrayerTimesManagementClass::handleGetPrayerTimes() {
-    DateTime nowDt = _rtcManager.now(); // الحصول على التاريخ الحالي من كائن RTCManager
-    
-    // التأكد من أن كائن PrayerTimes مهيأ بالإعدادات الصحيحة
-    _prayerTimes.setCoordinates(_latitude, _longitude, _timezone);
-    _prayerTimes.setCalcMethod(Egyptian); // تعيين طريقة الحساب
-    _prayerTimes.setAdjustments(0, 0, 0, 0, 0, 0); // تعديلات اختيارية
-
-    int fajrH, fajrM, sunH, sunM, dhuhrH, dhuhrM;
-    int asrH, asrM, maghribH, maghribM, ishaH, ishaM;
-
-    _prayerTimes.calculate(
-        nowDt.day(), nowDt.month(), nowDt.dayOfTheWeek(), nowDt.year(),
-        fajrH, fajrM,
-        sunH, sunM,
-        dhuhrH, dhuhrM,
-        asrH, asrM,
-        maghribH, maghribM,
-        ishaH, ishaM
-    );
+    DateTime nowDt = TimeService::now(); // الحصول على التاريخ الحالي من خدمة الوقت
+    const int* minutes = prayerMinutesFor(nowDt);
 
     StaticJsonDocument<512> doc;
-    char buf[6]; // لتنسيق الوقت HH:MM
-
-    sprintf(buf, "%02d:%02d", fajrH, fajrM); doc["Fajr"] = buf;
-    sprintf(buf, "%02d:%02d", sunH, sunM); doc["Sunrise"] = buf;
-    sprintf(buf, "%02d:%02d", dhuhrH, dhuhrM); doc["Dhuhr"] = buf;
-    sprintf(buf, "%02d:%02d", asrH, asrM); doc["Asr"] = buf;
-    sprintf(buf, "%02d:%02d", maghribH, maghribM); doc["Maghrib"] = buf;
-    sprintf(buf, "%02d:%02d", ishaH, ishaM); doc["Isha"] = buf;
+    char buf[24]; // لتنسيق الوقت HH:MM (بحجم أي قيمتي int)
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        snprintf(buf, sizeof(buf), "%02d:%02d", minutes[i] / 60, minutes[i] % 60);
+        doc[PRAYER_NAMES[i]] = buf;
+    }
 
     String output;
     serializeJsonPretty(doc, output);
     _server.send(200, "application/json", output);
 }
 
+// معالج للحصول على أوقات شهر أو سنة كاملة
+// ?year=YYYY&month=M (السنة الحالية افتراضياً، وبدون month تُرسل السنة كاملة)
+// أو ?from=YYYY-MM-DD&days=N لمدى أيام اعتباراً من تاريخ معين (انظر streamPrayerRange)
+// كل يوم مصفوفة مضغوطة [الشهر، اليوم، الفجر، الشروق، الظهر، العصر، المغرب، العشاء] بالدقائق من منتصف الليل
+// يُرسل الرد على أجزاء (شهر في كل جزء) دون بناء مستند JSON كبير في الذاكرة
+void PrayerTimesManagementClass::handleGetPrayerCalendar() {
+    if (_server.hasArg("from")) {
+        streamPrayerRange();
+        return;
+    }
+    DateTime nowDt = TimeService::now();
+    int year = _server.hasArg("year") ? _server.arg("year").toInt() : nowDt.year();
+    int month = _server.hasArg("month") ? _server.arg("month").toInt() : 0;
+    if (year < 2000 || year > 2099 || month < 0 || month > 12) {
+        _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"سنة أو شهر غير صالح\"}");
+        return;
+    }
+
+    _server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    _server.send(200, "application/json", "");
+    String chunk = "{\"year\":" + String(year) + ",\"fields\":[\"month\",\"day\"";
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        chunk += ",\"" + String(PRAYER_NAMES[i]) + "\"";
+    }
+    chunk += "],\"days\":[";
+
+    bool first = true;
+    for (int m = (month ? month : 1); m <= (month ? month : 12); m++) {
+        int16_t days[31][PRAYER_COUNT];
+        uint8_t count = PrayerTable::readMonth(currentSettings(), year, m, days);
+        if (count == 0) {
+            // سنة أخرى غير سنة الجدول أو تعذر الترميز: حساب مباشر
+            count = PrayerTable::daysInMonth(year, m);
+            for (uint8_t d = 0; d < count; d++) {
+                int minutes[PRAYER_COUNT];
+                calculatePrayerMinutes(DateTime(year, m, d + 1), minutes);
+                for (int i = 0; i < PRAYER_COUNT; i++) days[d][i] = minutes[i];
+                yield();
+            }
+        }
+        for (uint8_t d = 0; d < count; d++) {
+            if (!first) chunk += ",";
+            first = false;
+            chunk += "[" + String(m) + "," + String(d + 1);
+            for (int i = 0; i < PRAYER_COUNT; i++) {
+                chunk += "," + String(days[d][i]);
+            }
+            chunk += "]";
+        }
+        _server.sendContent(chunk);
+        chunk = "";
+    }
+    _server.sendContent("]}");
+    _server.sendContent(""); // نهاية الرد المجزأ
+}
+
+// أوقات N يوماً ابتداءً من تاريخ معين: ?from=YYYY-MM-DD&days=N (حتى PRAYER_CALENDAR_MAX_DAYS)
+// الأيام تُحسب بالتتابع عبر PrayerDayIterator (حساب واحد لموقع الشمس لكل يوم)
+// وتُرسل كمصفوفات مضغوطة على أجزاء، دون مستند JSON لكل يوم
+void PrayerTimesManagementClass::streamPrayerRange() {
+    DateTime from;
+    if (!RTCManager::parseDate(_server.arg("from").c_str(), from)) {
+        _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"تاريخ البداية غير صالح، المتوقع YYYY-MM-DD\"}");
+        return;
+    }
+    int days = _server.hasArg("days") ? _server.arg("days").toInt() : PRAYER_CALENDAR_DEFAULT_DAYS;
+    if (days < 1 || days > PRAYER_CALENDAR_MAX_DAYS) {
+        _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"عدد الأيام يجب أن يكون بين 1 و " + String(PRAYER_CALENDAR_MAX_DAYS) + "\"}");
+        return;
+    }
+
+    _server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    _server.send(200, "application/json", "");
+    String chunk;
+    chunk.reserve(512);
+    chunk = "{\"from\":\"" + RTCManager::formatDate(from) + "\",\"days\":" + String(days) + ",\"fields\":[";
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        if (i > 0) chunk += ",";
+        chunk += "\"" + String(PRAYER_NAMES[i]) + "\"";
+    }
+    chunk += "],\"times\":[";
+
+    PrayerDayIterator iterator(currentSettings(), from);
+    for (int d = 0; d < days; d++) {
+        int minutes[PRAYER_COUNT];
+        iterator.next(minutes);
+        if (d > 0) chunk += ",";
+        chunk += "[";
+        for (int i = 0; i < PRAYER_COUNT; i++) {
+            if (i > 0) chunk += ",";
+            chunk += String(minutes[i]);
+        }
+        chunk += "]";
+        if (chunk.length() > 400) {
+            _server.sendContent(chunk);
+            chunk = "";
+            yield();
+        }
+    }
+    chunk += "]}";
+    _server.sendContent(chunk);
+    _server.sendContent(""); // نهاية الرد المجزأ
+}
+
 // معالج لتعيين إعدادات المرحل التلقائي لأوقات الصلاة
+// {"enabled":true,"minutesBefore":[...],"minutesAfter":[...],"prayers":["Fajr","Maghrib",...],"channels":[0,2]}
+// المصفوفات بطول 6 (بترتيب fields في get_auto_relay_config) أو بطول 3 بالتخطيط القديم (الفجر، المغرب، العشاء)
+// و prayers اختياري: بدونه تُفعل جميع الأوقات (أو الصلوات الثلاث مع المصفوفات القديمة)
+// و channels (أو channel) اختياري: قنوات المرحل التي يقودها المصدر (بدونه تبقى القنوات الحالية)
 void PrayerTimesManagementClass::handleSetAutoRelayConfig() {
     if (_server.hasArg("plain")) {
-        StaticJsonDocument<256> doc;
+        StaticJsonDocument<512> doc;
         DeserializationError error = deserializeJson(doc, _server.arg("plain"));
         if (error) {
             _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"JSON غير صالح\"}");
             return;
         }
 
-        AutoRelayPrayerConfig newConfig;
-        newConfig.enabled = doc["enabled"].as<bool>();
         JsonArray minutesBeforeArray = doc["minutesBefore"];
         JsonArray minutesAfterArray = doc["minutesAfter"];
-
-        if (minutesBeforeArray.size() == 3 && minutesAfterArray.size() == 3) {
-            for (int i = 0; i < 3; i++) {
-                newConfig.minutesBefore[i] = minutesBeforeArray[i].as<int>();
-                newConfig.minutesAfter[i] = minutesAfterArray[i].as<int>();
+        size_t size = minutesBeforeArray.size();
+        if ((size == PRAYER_COUNT || size == 3) && minutesAfterArray.size() == size) {
+            PrayerRelayConfig newConfig;
+            memset(&newConfig, 0, sizeof(newConfig));
+            newConfig.magic = PRAYER_RELAY_MAGIC;
+            newConfig.enabled = doc["enabled"].as<bool>();
+            for (size_t i = 0; i < size; i++) {
+                int index = size == 3 ? LEGACY_AUTO_RELAY_INDEX[i] : (int)i;
+                int before = minutesBeforeArray[i].as<int>();
+                int after = minutesAfterArray[i].as<int>();
+                if (before < 0 || after < 0 || before > 1440 || after > 1440) {
+                    _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"الدقائق يجب أن تكون بين 0 و 1440\"}");
+                    return;
+                }
+                newConfig.minutesBefore[index] = before;
+                newConfig.minutesAfter[index] = after;
+                newConfig.prayerMask |= 1 << index;
+            }
+            if (doc.containsKey("prayers")) {
+                newConfig.prayerMask = 0;
+                for (const char* name : doc["prayers"].as<JsonArray>()) {
+                    int index = -1;
+                    for (int i = 0; i < PRAYER_COUNT; i++) {
+                        if (name != nullptr && strcmp(name, PRAYER_NAMES[i]) == 0) {
+                            index = i;
+                        }
+                    }
+                    if (index < 0) {
+                        _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"اسم وقت غير معروف في prayers\"}");
+                        return;
+                    }
+                    newConfig.prayerMask |= 1 << index;
+                }
+            }
+            uint8_t channels;
+            if (!parseRelayChannels(doc, sourceChannels(RELAY_SOURCE_PRAYER), channels)) {
+                _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"رقم القناة يجب أن يكون بين 0 و " + String(RELAY_CHANNEL_COUNT - 1) + "\"}");
+                return;
             }
             saveAutoRelayConfig(newConfig); // حفظ الإعدادات الجديدة
+            setSourceChannels(RELAY_SOURCE_PRAYER, channels);
             _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم حفظ إعدادات المرحل التلقائي\"}");
             Serial.println("تم تحديث إعدادات المرحل التلقائي.");
             return;
         }
     }
-    _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"جسم الطلب غير صالح. المتوقع {\"enabled\":true/false, \"minutesBefore\":[b0,b1,b2], \"minutesAfter\":[a0,a1,a2]}\"}");
+    _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"جسم الطلب غير صالح. المتوقع {\"enabled\":true/false, \"minutesBefore\":[6 قيم], \"minutesAfter\":[6 قيم], \"prayers\":[\"Fajr\",...]}\"}");
 }
 
 // معالج للحصول على إعدادات المرحل التلقائي لأوقات الصلاة
+// مع فترات التشغيل المدموجة لليوم الحالي (دقائق من منتصف الليل، والنهاية غير مشمولة)
 void PrayerTimesManagementClass::handleGetAutoRelayConfig() {
-    _autoRelayConfig = readAutoRelayConfig(); // التأكد من تحميل القيم الحالية
-    StaticJsonDocument<256> doc;
-    doc["enabled"] = _autoRelayConfig.enabled;
+    StaticJsonDocument<1024> doc;
+    doc["enabled"] = _relayConfig.enabled;
+    JsonArray fields = doc.createNestedArray("fields");
+    JsonArray prayers = doc.createNestedArray("prayers");
     JsonArray beforeArr = doc.createNestedArray("minutesBefore");
     JsonArray afterArr = doc.createNestedArray("minutesAfter");
-    for (int i = 0; i < 3; i++) {
-        beforeArr.add(_autoRelayConfig.minutesBefore[i]);
-        afterArr.add(_autoRelayConfig.minutesAfter[i]);
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        fields.add(PRAYER_NAMES[i]);
+        if (_relayConfig.prayerMask & (1 << i)) {
+            prayers.add(PRAYER_NAMES[i]);
+        }
+        beforeArr.add(_relayConfig.minutesBefore[i]);
+        afterArr.add(_relayConfig.minutesAfter[i]);
+    }
+    JsonArray channels = doc.createNestedArray("channels");
+    for (uint8_t c = 0; c < RELAY_CHANNEL_COUNT; c++) {
+        if (sourceChannels(RELAY_SOURCE_PRAYER) & (1 << c)) {
+            channels.add(c);
+        }
+    }
+    JsonArray windows = doc.createNestedArray("windows");
+    DateTime nowDt = TimeService::now();
+    relayWindowsFor(nowDt);
+    for (uint8_t k = 0; k < _windowCount; k++) {
+        if (_windowEnd[k] <= 0 || _windowStart[k] >= 24 * 60) {
+            continue; // فترة من الأمس أو الغد لا تمس اليوم
+        }
+        JsonArray window = windows.createNestedArray();
+        window.add(_windowStart[k]);
+        window.add(_windowEnd[k]);
     }
     String output;
     serializeJsonPretty(doc, output);
     _server.send(200, "application/json", output);
 }
 
-// وظيفة داخلية لتشغيل المرحل تلقائياً بناءً على أوقات الصلاة
-void PrayerTimesManagementClass::handleAutoRelayByPrayerTimes() {
-    if (!_autoRelayConfig.enabled) {
-        return; // لا تفعل شيئاً إذا لم يكن المرحل التلقائي مفعلاً
+// حساب أوقات الصلاة ليوم محدد بالدقائق من منتصف الليل
+// الترتيب: الفجر، الشروق، الظهر، العصر، المغرب، العشاء
+void PrayerTimesManagementClass::calculatePrayerMinutes(const DateTime& date, int minutes[6]) {
+    PrayerTable::getDay(currentSettings(), date, minutes);
+}
+
+// أوقات اليوم من الذاكرة المؤقتة
+// تُقرأ من الجدول السنوي مرة واحدة لكل يوم، أو بعد تغيير الموقع أو الساعة.
+// إذا لم يطابق الجدول السنة أو الإعدادات تُحسب أوقات اليوم مباشرة، ويُطلب توليد الجدول من مهمته
+// (قد تُستدعى من معالج طلب، فلا يُولد الجدول هنا)
+const int* PrayerTimesManagementClass::prayerMinutesFor(const DateTime& date) {
+    if (!_cacheValid || date.day() != _cachedDate.day() || date.month() != _cachedDate.month() || date.year() != _cachedDate.year()) {
+        if (!PrayerTable::matches(currentSettings(), date.year())) {
+            TaskScheduler::trigger(_tableTask);
+        }
+        calculatePrayerMinutes(date, _cachedMinutes); // من الجدول، أو بالحساب المباشر إذا لم يطابق
+        _cachedDate = date;
+        _cacheValid = true;
     }
+    return _cachedMinutes;
+}
 
-    DateTime nowDt = _rtcManager.now(); // الحصول على الوقت والتاريخ الحاليين من RTCManager
-    
-    // التأكد من أن كائن PrayerTimes مهيأ بالإعدادات الصحيحة
-    _prayerTimes.setCoordinates(_latitude, _longitude, _timezone);
-    _prayerTimes.setCalcMethod(Egyptian); 
-    _prayerTimes.setAdjustments(0, 0, 0, 0, 0, 0);
-
-    int fajrH, fajrM, sunH, sunM, dhuhrH, dhuhrM;
-    int asrH, asrM, maghribH, maghribM, ishaH, ishaM;
-
-    _prayerTimes.calculate(
-        nowDt.day(), nowDt.month(), nowDt.dayOfTheWeek(), nowDt.year(),
-        fajrH, fajrM,
-        sunH, sunM,
-        dhuhrH, dhuhrM,
-        asrH, asrM,
-        maghribH, maghribM,
-        ishaH, ishaM
-    );
-
-    // تعريف أوقات الصلاة ذات الصلة للمرحل التلقائي (الفجر، المغرب، العشاء)
-    struct PrayerTimeInfo {
-        int hour;
-        int minute;
-        int beforeMinutes;
-        int afterMinutes;
-    };
-
-    PrayerTimeInfo prayers[3] = {
-        { fajrH, fajrM, _autoRelayConfig.minutesBefore[0], _autoRelayConfig.minutesAfter[0] },   // الفجر
-        { maghribH, maghribM, _autoRelayConfig.minutesBefore[1], _autoRelayConfig.minutesAfter[1] }, // المغرب
-        { ishaH, ishaM, _autoRelayConfig.minutesBefore[2], _autoRelayConfig.minutesAfter[2] }     // العشاء
-    };
-
-    bool shouldBeOn = false;
-    int nowMinutes = nowDt.hour() * 60 + nowDt.minute(); // الوقت الحالي بالدقائق من منتصف الليل
-
-    for (int i = 0; i < 3; i++) {
-        int totalPrayerMinutes = prayers[i].hour * 60 + prayers[i].minute;
-        int start = totalPrayerMinutes - prayers[i].beforeMinutes;
-        int end = totalPrayerMinutes + prayers[i].afterMinutes;
-
-        // معالجة الالتفاف حول منتصف الليل
-        if (start < 0) start += 24 * 60;
-        if (end < 0) end += 24 * 60; 
-
-        if (start <= end) { 
-            // الحالة الطبيعية (مثال: 10:00 إلى 11:00)
-            if (nowMinutes >= start && nowMinutes <= end) {
-                shouldBeOn = true;
-                break;
+// تجميع فترات التشغيل ليوم محدد: نوافذ الأمس واليوم والغد بالدقائق من منتصف ليل اليوم
+// تُرتب حسب البداية ثم تُدمج المتداخلة والمتلاصقة، فتبقى قائمة فترات غير متداخلة
+// (النافذة تشمل دقيقة النهاية، لذا تُخزن نهايتها كأول دقيقة بعدها)
+void PrayerTimesManagementClass::buildRelayWindows(const DateTime& date) {
+    int16_t starts[3 * PRAYER_COUNT];
+    int16_t ends[3 * PRAYER_COUNT];
+    uint8_t count = 0;
+    DateTime midnight(date.year(), date.month(), date.day());
+    const int* today = prayerMinutesFor(date);
+    for (int dayShift = -1; dayShift <= 1; dayShift++) {
+        int minutes[PRAYER_COUNT];
+        if (dayShift == 0) {
+            memcpy(minutes, today, sizeof(minutes));
+        } else {
+            calculatePrayerMinutes(midnight + TimeSpan(dayShift, 0, 0, 0), minutes);
+        }
+        for (int i = 0; i < PRAYER_COUNT; i++) {
+            if (!(_relayConfig.prayerMask & (1 << i))) {
+                continue;
             }
-        } else { 
-            // تلتف حول منتصف الليل (مثال: 23:00 إلى 01:00)
-            if (nowMinutes >= start || nowMinutes <= end) {
-                shouldBeOn = true;
-                break;
+            int16_t start = dayShift * 24 * 60 + minutes[i] - _relayConfig.minutesBefore[i];
+            int16_t end = dayShift * 24 * 60 + minutes[i] + _relayConfig.minutesAfter[i] + 1;
+            uint8_t k = count++;
+            while (k > 0 && starts[k - 1] > start) { // ترتيب بالإدراج (18 عنصراً على الأكثر)
+                starts[k] = starts[k - 1];
+                ends[k] = ends[k - 1];
+                k--;
             }
+            starts[k] = start;
+            ends[k] = end;
         }
     }
+    _windowCount = 0;
+    for (uint8_t k = 0; k < count; k++) {
+        if (_windowCount > 0 && starts[k] <= _windowEnd[_windowCount - 1]) {
+            if (ends[k] > _windowEnd[_windowCount - 1]) {
+                _windowEnd[_windowCount - 1] = ends[k];
+            }
+        } else {
+            _windowStart[_windowCount] = starts[k];
+            _windowEnd[_windowCount] = ends[k];
+            _windowCount++;
+        }
+    }
+    _windowDate = midnight;
+    _windowsValid = true;
+}
 
-    bool currentRelayState = digitalRead(_relayPin) == HIGH;
-    if (shouldBeOn != currentRelayState) {
-        setRelayPhysicalState(shouldBeOn); // تعيين حالة المرحل
-        Serial.print("المرحل التلقائي: تعيين المرحل إلى ");
-        Serial.println(shouldBeOn ? "تشغيل" : "إيقاف");
+// التأكد من أن فترات التشغيل تخص يوم 'date' (تُجمع مرة واحدة لكل يوم)
+void PrayerTimesManagementClass::relayWindowsFor(const DateTime& date) {
+    if (!_windowsValid || date.day() != _windowDate.day() || date.month() != _windowDate.month() || date.year() != _windowDate.year()) {
+        buildRelayWindows(date);
     }
 }
 
-// معالج للحصول على الوقت الحالي عبر API (خاص بـ PrayerTimesManager)
-void PrayerTimesManagementClass::handleGetTime() {
-    DateTime currentTime = _rtcManager.now(); // الحصول على الوقت الحالي
-    String response = "{ \"year\": " + String(currentTime.year()) +
-                      ", \"month\": " + String(currentTime.month()) +
-                      ", \"day\": " + String(currentTime.day()) +
-                      ", \"hour\": " + String(currentTime.hour()) +
-                      ", \"minute\": " + String(currentTime.minute()) +
-                      ", \"second\": " + String(currentTime.second()) + " }";
-    Serial.println(response);
-    _server.send(200, "application/json", response);
+// فهرس فترة التشغيل التي تحتوي الدقيقة المحددة، أو -1
+int PrayerTimesManagementClass::relayWindowAt(int minute) const {
+    for (uint8_t k = 0; k < _windowCount && _windowStart[k] <= minute; k++) {
+        if (minute < _windowEnd[k]) {
+            return k;
+        }
+    }
+    return -1;
 }
 
-// معالج لتعيين الوقت عبر API (خاص بـ PrayerTimesManager)
-void PrayerTimesManagementClass::handleSetTime() {
-    if (_server.hasArg("plain")) {
-        StaticJsonDocument<200> doc;
-        deserializeJson(doc, _server.arg("plain"));
-        // قراءة قيم الوقت والتاريخ من JSON
-        int year = doc["year"];
-        int month = doc["month"];
-        int day = doc["day"];
-        int hour = doc["hour"];
-        int minute = doc["minute"];
-        int second = doc["second"];
-        // ضبط RTC بالقيم الجديدة
-        _rtcManager.adjustRTC(DateTime(year, month, day, hour, minute, second));
-        _server.send(200, "application/json", "{\"status\":\"تم تحديث الوقت\"}");
+// آخر حافة لنوافذ الصلاة على القناة (إذا كانت من قنوات مصدر الصلاة)
+bool PrayerTimesManagementClass::lastTransition(uint8_t channel, const DateTime& now, DateTime& when, bool& state) {
+    return (sourceChannels(RELAY_SOURCE_PRAYER) & (1 << channel)) && windowTransition(now, when, state);
+}
+
+// آخر حافة لنوافذ الصلاة عند 'now' أو قبله: بداية الفترة الحالية، أو نهاية آخر فترة انتهت
+bool PrayerTimesManagementClass::windowTransition(const DateTime& now, DateTime& when, bool& state) {
+    if (!_relayConfig.enabled) {
+        return false;
+    }
+    relayWindowsFor(now);
+    int nowMinutes = now.hour() * 60 + now.minute();
+    int current = relayWindowAt(nowMinutes);
+    state = current >= 0;
+
+    bool found = state;
+    int latest = state ? _windowStart[current] : 0;
+    for (uint8_t k = 0; !state && k < _windowCount && _windowEnd[k] <= nowMinutes; k++) {
+        found = true; // الفترات مرتبة وغير متداخلة، فآخر نهاية سابقة هي الأحدث
+        latest = _windowEnd[k];
+    }
+    if (!found) {
+        return false;
+    }
+    when = _windowDate + TimeSpan((int32_t)latest * 60);
+    return true;
+}
+
+// حساب الحافة التالية بعد 'now': أقرب بداية أو نهاية فترة خلال اليوم،
+// أو منتصف الليل التالي لتجميع فترات اليوم الجديد
+void PrayerTimesManagementClass::armRelayEdge(const DateTime& now) {
+    int nowMinutes = now.hour() * 60 + now.minute();
+    int next = 24 * 60;
+    for (uint8_t k = 0; k < _windowCount; k++) {
+        if (_windowStart[k] > nowMinutes && _windowStart[k] < next) {
+            next = _windowStart[k];
+        }
+        if (_windowEnd[k] > nowMinutes && _windowEnd[k] < next) {
+            next = _windowEnd[k];
+        }
+    }
+    _nextRelayEdge = _windowDate + TimeSpan((int32_t)next * 60);
+    _relayEdgeArmed = true;
+    sleepUntilRelayEdge(now);
+}
+
+// ضبط مدة النوم من وقت RTC المقروء للتو حتى الحافة التالية
+// مع مقاطعة RTC توقظنا Alarm2 عند الحافة ومدة النوم احتياط فقط؛ وإلا نستيقظ قبل الحافة بثانية
+// ثم نفحص كل SCHEDULE_EDGE_POLL_MS (بنفس توقيت الجداول الزمنية، مع إعادة مزامنة كل SCHEDULE_RESYNC_MS على الأكثر)
+void PrayerTimesManagementClass::sleepUntilRelayEdge(const DateTime& now) {
+    int32_t remaining = (_nextRelayEdge - now).totalseconds();
+    bool interrupt = TimeService::armWake(TIME_WAKE_PRAYER, _nextRelayEdge);
+    unsigned long sleep;
+    if (remaining <= 0 || (remaining <= 1 && !interrupt)) {
+        sleep = SCHEDULE_EDGE_POLL_MS;
+    } else {
+        sleep = interrupt ? (unsigned long)remaining * 1000UL + RTC_ALARM_GRACE_MS
+                          : (unsigned long)(remaining - 1) * 1000UL;
+        if (sleep > SCHEDULE_RESYNC_MS) {
+            sleep = SCHEDULE_RESYNC_MS;
+        }
+    }
+    TaskScheduler::schedule(_edgeTask, sleep);
+}
+
+// طلب حالة المرحل التلقائي عند حافة (أو عند أول تقييم بعد تغيير الإعدادات) وتجهيز الحافة التالية
+// الطلب يحمل وقت الحافة الفعلي، فلا يتجاوز طلباً أحدث من مصدر آخر بنفس الأولوية،
+// ويشمل جميع قنوات مصدر الصلاة في قرار واحد
+void PrayerTimesManagementClass::handleAutoRelayByPrayerTimes(const DateTime& now) {
+    if (!_relayConfig.enabled) {
+        return; // لا تفعل شيئاً إذا لم يكن المرحل التلقائي مفعلاً
+    }
+    DateTime when;
+    bool shouldBeOn;
+    if (windowTransition(now, when, shouldBeOn)) { // يجمع نوافذ اليوم عند تغيره
+        uint8_t channels = sourceChannels(RELAY_SOURCE_PRAYER);
+        requestRelayMask(RELAY_SOURCE_PRAYER, channels, shouldBeOn ? channels : 0, when.unixtime());
+    }
+    armRelayEdge(now);
+}
+
+// إشعار من خدمة الوقت بتغير الساعة: تُعاد حالة المرحل في الدورة التالية
+// في نفس اليوم تبقى الأوقات والنوافذ صالحة وتُحسب الحافة التالية فقط، وإلا تُلغى أوقات اليوم المحفوظة
+void PrayerTimesManagementClass::onTimeChanged(const DateTime& now) {
+    if (_cacheValid && now.day() == _cachedDate.day() && now.month() == _cachedDate.month() && now.year() == _cachedDate.year()) {
+        _relayEdgeArmed = false;
+        TaskScheduler::trigger(_edgeTask);
     } else {
-        _server.send(400, "application/json", "{\"error\":\"جسم الطلب مفقود\"}");
+        invalidatePrayerCache();
     }
+    requestRelayRestore();
 }
@@ -4,54 +4,100 @@
 
 #include "Config.h"
 #include "MainControl.h" // الوراثة من MainControlClass
-#include "PrayerTimes.h" // تضمين مكتبة PrayerTimes
-#include "RTCManager.h"  // تضمين RTCManager كفئة مساعدة
+#include "TimeService.h" // خدمة الوقت المشتركة
+#include "PrayerCalc.h"  // حساب أوقات اليوم المشترك
+#include "PrayerTable.h" // جدول أوقات السنة المحسوب مسبقاً
 
 // فئة PrayerTimesManagementClass لإدارة أوقات الصلاة والمرحل التلقائي
-class PrayerTimesManagementClass : public MainControlClass { 
+class PrayerTimesManagementClass : public MainControlClass, public RelayTransitionSource, public TimeChangeListener { 
 private:
-    RTCManager _rtcManager; // كائن RTCManager لإدارة الوقت
-    PrayerTimes _prayerTimes; // كائن أوقات الصلاة
     double _latitude;         // خط العرض لموقع الصلاة
     double _longitude;        // خط الطول لموقع الصلاة
     int _timezone;            // المنطقة الزمنية لموقع الصلاة
-    AutoRelayPrayerConfig _autoRelayConfig; // إعدادات المرحل التلقائي لأوقات الصلاة
-    unsigned long _lastPrayerCheck = 0; // لتتبع آخر فحص لأوقات الصلاة
+    uint8_t _method;          // طريقة الحساب (PRAYER_METHOD_*)
+    uint8_t _asrFactor;       // معامل ظل العصر (شافعي/حنفي)
+    PrayerRelayConfig _relayConfig; // نوافذ المرحل التلقائي لأوقات اليوم
+    int _cachedMinutes[PRAYER_COUNT]; // أوقات اليوم المحسوبة مسبقاً (دقائق من منتصف الليل)
+    DateTime _cachedDate;     // اليوم الذي حُسبت له _cachedMinutes
+    bool _cacheValid = false; // هل _cachedMinutes صالحة؟ (تُلغى عند تغيير الإعدادات أو الساعة)
+
+    // فترات التشغيل المدموجة لليوم _windowDate بالدقائق من منتصف ليله [البداية، النهاية)
+    // (تشمل نوافذ الأمس والغد المتداخلة مع اليوم، لذا قد تكون سالبة أو بعد 1440)
+    int16_t _windowStart[3 * PRAYER_COUNT];
+    int16_t _windowEnd[3 * PRAYER_COUNT];
+    uint8_t _windowCount = 0;
+    DateTime _windowDate;
+    bool _windowsValid = false;
+
+    // الحافة التالية للمرحل التلقائي (لا تُقرأ RTC قبلها إلا لإعادة المزامنة)
+    DateTime _nextRelayEdge;
+    bool _relayEdgeArmed = false;
+    uint8_t _edgeTask = TASK_NONE; // مهمة الحافة في جدول المهام المشترك
+    uint8_t _tableTask = TASK_NONE; // مهمة توليد الجدول السنوي
 
 public:
     // المُنشئ (Constructor) لفئة PrayerTimesManagementClass
 #ifdef USE_EXTERNAL_EEPROM
-    PrayerTimesManagementClass(WebServer& serverRef, int relayPin);
+    PrayerTimesManagementClass(HttpServerRef serverRef, int relayPin);
 #else
-    PrayerTimesManagementClass(WebServer& serverRef, int relayPin, EEPROMClass& eepromRef);
+    PrayerTimesManagementClass(HttpServerRef serverRef, int relayPin, EEPROMClass& eepromRef);
 #endif
 
     // إعداد نقاط نهاية API المتعلقة بأوقات الصلاة
     void setupPrayerEndpoints();
-    // وظيفة يتم استدعاؤها في دالة loop() الرئيسية لفحص المرحل التلقائي
+    // محفوظة للتوافق: handleClient() يشغل جدول المهام المشترك، فلا حاجة لاستدعائها في loop()
     void loopTasks(); 
+    // آخر حافة لنوافذ المرحل التلقائي عند 'now' أو قبله على قنوات مصدر الصلاة (بداية نافذة أو نهايتها)
+    bool lastTransition(uint8_t channel, const DateTime& now, DateTime& when, bool& state) override;
+    // مصدر طلبات هذا المدير في حَكَم المرحل
+    uint8_t relaySource() const override { return RELAY_SOURCE_PRAYER; }
+    // إشعار من خدمة الوقت بتغير الساعة
+    void onTimeChanged(const DateTime& now) override;
 
 private: 
     // حفظ إعدادات أوقات الصلاة في EEPROM
     void savePrayerConfig(double lat, double lon, int tz);
     // قراءة إعدادات أوقات الصلاة من EEPROM
     void readPrayerConfig(double& lat, double& lon, int& tz);
+    // إعدادات الحساب الحالية كهيكل واحد (للجدول السنوي ومحرك الحساب)
+    PrayerSettings currentSettings() const;
     // حفظ إعدادات المرحل التلقائي لأوقات الصلاة في EEPROM
-    void saveAutoRelayConfig(const AutoRelayPrayerConfig& config);
-    // قراءة إعدادات المرحل التلقائي لأوقات الصلاة من EEPROM
-    AutoRelayPrayerConfig readAutoRelayConfig();
+    void saveAutoRelayConfig(const PrayerRelayConfig& config);
+    // قراءة إعدادات المرحل التلقائي من EEPROM (مع ترحيل إعدادات الصلوات الثلاث القديمة)
+    PrayerRelayConfig readAutoRelayConfig();
+    // إلغاء أوقات اليوم المحفوظة ونوافذ المرحل بعد تغيير الإعدادات أو الساعة
+    void invalidatePrayerCache();
+    // حساب أوقات الصلاة ليوم محدد بالدقائق من منتصف الليل (الفجر، الشروق، الظهر، العصر، المغرب، العشاء)
+    void calculatePrayerMinutes(const DateTime& date, int minutes[6]);
+    // أوقات اليوم من الذاكرة المؤقتة (تُحسب مرة واحدة لكل يوم)
+    const int* prayerMinutesFor(const DateTime& date);
+    // تجميع فترات التشغيل المدموجة ليوم محدد (مرة واحدة لكل يوم)
+    void buildRelayWindows(const DateTime& date);
+    // التأكد من أن فترات التشغيل تخص يوم 'date'
+    void relayWindowsFor(const DateTime& date);
+    // فهرس فترة التشغيل التي تحتوي الدقيقة المحددة، أو -1
+    int relayWindowAt(int minute) const;
+    // آخر حافة لنوافذ اليوم عند 'now' أو قبله (مشتركة بين جميع قنوات المصدر)
+    bool windowTransition(const DateTime& now, DateTime& when, bool& state);
+    // حساب الحافة التالية بعد 'now' وضبط مدة النوم حتى موعدها
+    void armRelayEdge(const DateTime& now);
+    // ضبط مدة النوم من وقت RTC المقروء للتو حتى الحافة التالية وجدولة المهمة
+    void sleepUntilRelayEdge(const DateTime& now);
+    // مهمة الحافة: تطبيق حالة المرحل التلقائي عند الحافة (أو إعادة المزامنة)
+    void runRelayEdge();
+    // مهمة الجدول السنوي: إعادة توليده إذا لم يطابق الإعدادات أو سنة اليوم
+    void runTableRefresh();
 
     // --- معالجات API لإدارة أوقات الصلاة ---
     void handleSetPrayerConfig();      // تعيين إعدادات أوقات الصلاة
     void handleGetPrayerConfig();      // الحصول على إعدادات أوقات الصلاة
     void handleGetPrayerTimes();       // الحصول على أوقات الصلاة لليوم الحالي
+    void handleGetPrayerCalendar();    // الحصول على أوقات شهر أو سنة كاملة من الجدول السنوي
+    void streamPrayerRange();          // أوقات N يوماً ابتداءً من تاريخ معين (حساب تدريجي)
     void handleSetAutoRelayConfig();   // تعيين إعدادات المرحل التلقائي لأوقات الصلاة
     void handleGetAutoRelayConfig();   // الحصول على إعدادات المرحل التلقائي لأوقات الصلاة
-    void handleAutoRelayByPrayerTimes(); // وظيفة داخلية لتشغيل المرحل تلقائياً بناءً على أوقات الصلاة
+    void handleAutoRelayByPrayerTimes(const DateTime& now); // تطبيق حالة المرحل التلقائي عند حافة وتجهيز الحافة التالية
 
-    // --- معالجات API لـ RTC (خاصة بـ PrayerTimesManager) ---
-    void handleGetTime(); // الحصول على الوقت
-    void handleSetTime(); // تعيين الوقت
 };
 
 #endif // PRAYER_TIMES_MANAGER_H
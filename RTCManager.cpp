@@ -1,13 +1,19 @@
 // RTCManager.cpp
 #include "RTCManager.h"
+#include "I2CBus.h" // حجز الناقل المشترك مع EEPROM وعداداته
+
+volatile bool RTCManager::_interruptPending = false;
+volatile unsigned long RTCManager::_interruptMillis = 0;
 
 RTCManager::RTCManager() : _rtc() {
 }
 
 // بدء تشغيل وحدة RTC
+// كل استدعاء لـ RTClib يحجز الناقل بسرعة RTC، والبايتات المسجلة هي سجلات DS3231 التي يقرؤها أو يكتبها
 bool RTCManager::beginRTC() {
-    Wire.begin(); // بدء اتصال I2C
-    if (!_rtc.begin()) {
+    I2CBus::begin(); // تهيئة الناقل المشترك مرة واحدة
+    I2CTransaction bus(I2C_DEVICE_RTC, 2);
+    if (!bus.check(_rtc.begin())) {
         Serial.println("لم يتم العثور على RTC! يرجى التحقق من التوصيلات.");
         return false;
     }
@@ -21,11 +27,92 @@ bool RTCManager::beginRTC() {
 
 // الحصول على الوقت والتاريخ الحالي من RTC
 DateTime RTCManager::now() {
+    I2CTransaction bus(I2C_DEVICE_RTC, 8); // عنوان السجل + 7 سجلات للوقت
     return _rtc.now();
 }
 
 // ضبط الوقت والتاريخ في RTC
 void RTCManager::adjustRTC(const DateTime& dateTime) {
+    I2CTransaction bus(I2C_DEVICE_RTC, 12); // سجلات الوقت + مسح علم فقدان الطاقة
     _rtc.adjust(dateTime);
 }
+
+// توجيه دبوس INT/SQW إلى مقاطعة
+// وضع التنبيه: INTCN=1 (بدون موجة مربعة) ويبقى الدبوس منخفضاً حتى مسح علم التنبيه
+// وضع SQW: نبضة 1 Hz تبدأ حافتها الهابطة مع بداية كل ثانية، والتنبيهات معطلة
+bool RTCManager::attachInterruptPin(int pin, uint8_t mode) {
+    if (pin < 0) {
+        return false;
+    }
+    I2CTransaction bus(I2C_DEVICE_RTC, 24);
+    _rtc.disable32K();
+    for (uint8_t alarm = 1; alarm <= 2; alarm++) {
+        _rtc.disableAlarm(alarm);
+        _rtc.clearAlarm(alarm);
+    }
+    _rtc.writeSqwPinMode(mode == RTC_PIN_MODE_SQW ? DS3231_SquareWave1Hz : DS3231_OFF);
+    pinMode(pin, INPUT_PULLUP); // خرج DS3231 مفتوح المصرف
+    attachInterrupt(digitalPinToInterrupt(pin), onInterrupt, FALLING);
+    return true;
+}
+
+// برمجة تنبيه يطابق التاريخ (يوم الشهر) والوقت
+bool RTCManager::setAlarm(uint8_t alarm, const DateTime& when) {
+    I2CTransaction bus(I2C_DEVICE_RTC, alarm == 1 ? 9 : 8);
+    clearAlarm(alarm); // مسح أي تنبيه سابق لم يُعالج
+    if (alarm == 1) {
+        return bus.check(_rtc.setAlarm1(when, DS3231_A1_Date));
+    }
+    return bus.check(_rtc.setAlarm2(when, DS3231_A2_Date));
+}
+
+// هل انطلق التنبيه؟
+bool RTCManager::alarmFired(uint8_t alarm) {
+    I2CTransaction bus(I2C_DEVICE_RTC, 2);
+    return _rtc.alarmFired(alarm);
+}
+
+// مسح علم التنبيه
+void RTCManager::clearAlarm(uint8_t alarm) {
+    I2CTransaction bus(I2C_DEVICE_RTC, 4);
+    _rtc.clearAlarm(alarm);
+}
+
+// معالج المقاطعة: تسجيل الوقت فقط
+void IRAM_ATTR RTCManager::onInterrupt() {
+    _interruptMillis = millis();
+    _interruptPending = true;
+}
+
+// هل وصلت مقاطعة منذ آخر استدعاء؟
+bool RTCManager::takeInterrupt(unsigned long& atMillis) {
+    if (!_interruptPending) {
+        return false;
+    }
+    noInterrupts();
+    atMillis = _interruptMillis;
+    _interruptPending = false;
+    interrupts();
+    return true;
+}
+
+// قراءة تاريخ بالشكل YYYY-MM-DD (السنوات 2000-2099 التي يدعمها DS3231)
+bool RTCManager::parseDate(const char* text, DateTime& date) {
+    int year, month, day;
+    if (text == nullptr || sscanf(text, "%d-%d-%d", &year, &month, &day) != 3) {
+        return false;
+    }
+    if (year < 2000 || year > 2099 || month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    date = DateTime(year, month, day);
+    return date.isValid();
+}
+
+// تنسيق تاريخ بالشكل YYYY-MM-DD
+String RTCManager::formatDate(const DateTime& date) {
+    char buffer[16]; // بحجم أطول إخراج لحقول DateTime ("65535-255-255")، لا 11 للتواريخ الصالحة فقط
+    snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", date.year(), date.month(), date.day());
+    return String(buffer);
+}
 // لا توجد معالجات API هنا
@@ -10,6 +10,8 @@
 class RTCManager { 
 private:
     RTC_DS3231 _rtc; // كائن RTC
+    static volatile bool _interruptPending;            // تُضبط من معالج المقاطعة
+    static volatile unsigned long _interruptMillis;    // millis() عند آخر مقاطعة
 
 public:
     RTCManager(); // مُنشئ بسيط
@@ -20,6 +22,26 @@ public:
     DateTime now();
     // ضبط الوقت والتاريخ في RTC
     void adjustRTC(const DateTime& dateTime);
+
+    // --- تنبيهات DS3231 ودبوس INT/SQW ---
+    // توجيه دبوس INT/SQW إلى مقاطعة (mode = RTC_PIN_MODE_ALARM أو RTC_PIN_MODE_SQW)
+    bool attachInterruptPin(int pin, uint8_t mode);
+    // برمجة تنبيه (1 = بدقة الثانية، 2 = بدقة الدقيقة) ليطابق التاريخ والوقت المحددين
+    bool setAlarm(uint8_t alarm, const DateTime& when);
+    // هل انطلق التنبيه؟ ومسح علمه (يُحرر دبوس المقاطعة)
+    bool alarmFired(uint8_t alarm);
+    void clearAlarm(uint8_t alarm);
+    // هل وصلت مقاطعة منذ آخر استدعاء؟ (تُصفر العلم وتُرجع قيمة millis() عند المقاطعة)
+    static bool takeInterrupt(unsigned long& atMillis);
+    // معالج مقاطعة دبوس INT/SQW (يضبط العلم فقط، والقراءة عبر I2C تتم خارج المقاطعة)
+    static void IRAM_ATTR onInterrupt();
+    // هل توجد مقاطعة لم تُعالج بعد؟ (دون تصفيرها)
+    static bool interruptPending() { return _interruptPending; }
+
+    // قراءة تاريخ بالشكل YYYY-MM-DD، وتُرجع false إذا كان غير صالح
+    static bool parseDate(const char* text, DateTime& date);
+    // تنسيق تاريخ بالشكل YYYY-MM-DD
+    static String formatDate(const DateTime& date);
     // لا توجد نقاط نهاية API هنا، حيث أنها فئة مساعدة
 };
 
@@ -0,0 +1,77 @@
+// RelayOutput.cpp
+#include "RelayOutput.h"
+#if defined(ESP32)
+#include "soc/gpio_reg.h"
+#endif
+
+// إخراج عبر مسجل إزاحة إذا عُرفت دبابيسه الثلاثة
+#if defined(RELAY_SHIFT_DATA_PIN) && defined(RELAY_SHIFT_CLOCK_PIN) && defined(RELAY_SHIFT_LATCH_PIN)
+#define RELAY_OUTPUT_SHIFT_REGISTER
+#endif
+
+uint8_t RelayOutput::_pins[RELAY_CHANNEL_COUNT];
+uint8_t RelayOutput::_lastMask = 0;
+uint32_t RelayOutput::_actuations[RELAY_CHANNEL_COUNT];
+
+// تهيئة المخارج (دون تغيير حالتها؛ يكتب المستدعي القناع المستعاد مباشرة بعدها)
+void RelayOutput::begin(const uint8_t pins[RELAY_CHANNEL_COUNT]) {
+    memcpy(_pins, pins, sizeof(_pins));
+#ifdef RELAY_OUTPUT_SHIFT_REGISTER
+    pinMode(RELAY_SHIFT_DATA_PIN, OUTPUT);
+    pinMode(RELAY_SHIFT_CLOCK_PIN, OUTPUT);
+    pinMode(RELAY_SHIFT_LATCH_PIN, OUTPUT);
+#else
+    for (uint8_t i = 0; i < RELAY_CHANNEL_COUNT; i++) {
+        pinMode(_pins[i], OUTPUT);
+    }
+#endif
+}
+
+// تطبيق قناع القنوات: تجميع بتات التشغيل والإيقاف لكل منفذ ثم كتابتها مرة واحدة
+void RelayOutput::write(uint8_t mask) {
+    uint8_t changed = mask ^ _lastMask;
+    for (uint8_t i = 0; changed != 0 && i < RELAY_CHANNEL_COUNT; i++) {
+        if (changed & (1 << i)) {
+            _actuations[i]++;
+        }
+    }
+    _lastMask = mask;
+#ifdef RELAY_OUTPUT_SHIFT_REGISTER
+    // المخارج لا تتغير إلا عند حافة latch، فتنتقل جميع القنوات في لحظة واحدة
+    digitalWrite(RELAY_SHIFT_LATCH_PIN, LOW);
+    shiftOut(RELAY_SHIFT_DATA_PIN, RELAY_SHIFT_CLOCK_PIN, MSBFIRST, mask);
+    digitalWrite(RELAY_SHIFT_LATCH_PIN, HIGH);
+#elif defined(ESP32)
+    uint32_t set0 = 0, clear0 = 0, set1 = 0, clear1 = 0;
+    for (uint8_t i = 0; i < RELAY_CHANNEL_COUNT; i++) {
+        bool on = mask & (1 << i);
+        if (_pins[i] < 32) {
+            (on ? set0 : clear0) |= 1UL << _pins[i];
+        } else {
+            (on ? set1 : clear1) |= 1UL << (_pins[i] - 32);
+        }
+    }
+    REG_WRITE(GPIO_OUT_W1TS_REG, set0);
+    REG_WRITE(GPIO_OUT_W1TC_REG, clear0);
+#ifdef GPIO_OUT1_W1TS_REG
+    REG_WRITE(GPIO_OUT1_W1TS_REG, set1);
+    REG_WRITE(GPIO_OUT1_W1TC_REG, clear1);
+#endif
+#elif defined(ESP8266)
+    uint32_t set = 0, clear = 0;
+    for (uint8_t i = 0; i < RELAY_CHANNEL_COUNT; i++) {
+        bool on = mask & (1 << i);
+        if (_pins[i] == 16) {
+            GP16O = on ? 1 : 0; // GPIO16 في سجل منفصل (RTC)
+        } else {
+            (on ? set : clear) |= 1UL << _pins[i];
+        }
+    }
+    GPOS = set;
+    GPOC = clear;
+#else
+    for (uint8_t i = 0; i < RELAY_CHANNEL_COUNT; i++) {
+        digitalWrite(_pins[i], (mask & (1 << i)) ? HIGH : LOW);
+    }
+#endif
+}
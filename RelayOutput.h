@@ -0,0 +1,26 @@
+// RelayOutput.h
+#ifndef RELAY_OUTPUT_H
+#define RELAY_OUTPUT_H
+
+#include "Config.h"
+
+// فئة مساعدة لإخراج حالة جميع قنوات المرحل بكتابة واحدة
+// مع مسجل إزاحة (RELAY_SHIFT_*_PIN): إزاحة القناع ثم نبضة latch واحدة فتتغير جميع المخارج معاً.
+// مع الدبابيس المباشرة: كتابة سجلات الضبط/المسح للمنفذ (W1TS/W1TC على ESP32، و GPOS/GPOC على ESP8266)
+// بدلاً من digitalWrite() لكل قناة.
+class RelayOutput {
+public:
+    // تهيئة دبابيس القنوات (أو دبابيس مسجل الإزاحة) كمخارج وتجهيز أقنعة المنفذ
+    static void begin(const uint8_t pins[RELAY_CHANNEL_COUNT]);
+    // تطبيق قناع القنوات (البت i = القناة i) على المخارج
+    static void write(uint8_t mask);
+    // عدد مرات تغير حالة القناة منذ الإقلاع (كل تشغيل أو إيقاف فعلي للمرحل)
+    static uint32_t actuations(uint8_t channel) { return channel < RELAY_CHANNEL_COUNT ? _actuations[channel] : 0; }
+
+private:
+    static uint8_t _pins[RELAY_CHANNEL_COUNT]; // دبوس كل قناة (مع الدبابيس المباشرة)
+    static uint8_t _lastMask;                  // آخر قناع مكتوب (المخارج تبدأ مطفأة)
+    static uint32_t _actuations[RELAY_CHANNEL_COUNT];
+};
+
+#endif // RELAY_OUTPUT_H
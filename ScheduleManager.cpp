@@ -3,28 +3,42 @@
 
 // المُنشئ (Constructor) لفئة ScheduleManagerClass
 #ifdef USE_EXTERNAL_EEPROM
-ScheduleManagerClass::ScheduleManagerClass(WebServer& serverRef, int relayPin)
-    : MainControlClass(serverRef, relayPin), _rtcManager() { // تهيئة RTCManager
-    // بدء تشغيل RTC
-    if (!_rtcManager.beginRTC()) {
-        Serial.println("فشل تهيئة RTC في ScheduleManager. يرجى التحقق من التوصيلات والبطارية.");
-    } else {
-        Serial.println("تم تهيئة RTC في ScheduleManager بنجاح.");
-    }
-    // تهيئة _lastCheckedTime بالوقت الحالي عند بدء التشغيل
-    _lastCheckedTime = _rtcManager.now(); 
+ScheduleManagerClass::ScheduleManagerClass(HttpServerRef serverRef, int relayPin)
+    : MainControlClass(serverRef, relayPin) {
+    // بدء خدمة الوقت المشتركة (تهيئة RTC مرة واحدة لجميع المديرين) والاشتراك في تغيرات الساعة
+    TimeService::begin();
+    TimeService::subscribe(this);
+    // مهمة الخط الزمني في جدول المهام المشترك، وتُشغل أيضاً فور مقاطعة Alarm1
+    _timelineTask = TaskScheduler::add([](void* self) { static_cast<ScheduleManagerClass*>(self)->runTimeline(); }, this);
+    TimeService::bindWake(TIME_WAKE_SCHEDULE, _timelineTask);
+    // تحميل جدول الجداول الزمنية إلى الذاكرة مرة واحدة
+    loadSchedulesFromEEPROM();
+    _exceptions.load();
+    // تجميع فهرس اليوم وحساب الحدث التالي (الوقت المقروء عند تهيئة الخدمة يهيئ _lastCheckedTime)
+    DateTime now = TimeService::now();
+    rebuildScheduleIndex(now);
+    rebuildTimeline(now);
+    registerTransitionSource(this);
+    requestRelayRestore(); // أول دورة بعد الإقلاع: تعيين المرحل حسب آخر انتقال فائت
 }
 #else
-ScheduleManagerClass::ScheduleManagerClass(WebServer& serverRef, int relayPin, EEPROMClass& eepromRef)
-    : MainControlClass(serverRef, relayPin, eepromRef), _rtcManager() { // تهيئة RTCManager
-    // بدء تشغيل RTC
-    if (!_rtcManager.beginRTC()) {
-        Serial.println("فشل تهيئة RTC في ScheduleManager. يرجى التحقق من التوصيلات والبطارية.");
-    } else {
-        Serial.println("تم تهيئة RTC في ScheduleManager بنجاح.");
-    }
-    // تهيئة _lastCheckedTime بالوقت الحالي عند بدء التشغيل
-    _lastCheckedTime = _rtcManager.now(); 
+ScheduleManagerClass::ScheduleManagerClass(HttpServerRef serverRef, int relayPin, EEPROMClass& eepromRef)
+    : MainControlClass(serverRef, relayPin, eepromRef) {
+    // بدء خدمة الوقت المشتركة (تهيئة RTC مرة واحدة لجميع المديرين) والاشتراك في تغيرات الساعة
+    TimeService::begin();
+    TimeService::subscribe(this);
+    // مهمة الخط الزمني في جدول المهام المشترك، وتُشغل أيضاً فور مقاطعة Alarm1
+    _timelineTask = TaskScheduler::add([](void* self) { static_cast<ScheduleManagerClass*>(self)->runTimeline(); }, this);
+    TimeService::bindWake(TIME_WAKE_SCHEDULE, _timelineTask);
+    // تحميل جدول الجداول الزمنية إلى الذاكرة مرة واحدة
+    loadSchedulesFromEEPROM();
+    _exceptions.load();
+    // تجميع فهرس اليوم وحساب الحدث التالي (الوقت المقروء عند تهيئة الخدمة يهيئ _lastCheckedTime)
+    DateTime now = TimeService::now();
+    rebuildScheduleIndex(now);
+    rebuildTimeline(now);
+    registerTransitionSource(this);
+    requestRelayRestore(); // أول دورة بعد الإقلاع: تعيين المرحل حسب آخر انتقال فائت
 }
 #endif
 
@@ -35,93 +49,593 @@ void ScheduleManagerClass::setupScheduleEndpoints() {
     _server.on("/api/schedules/update", HTTP_POST, [this]() { handleUpdateSchedule(); });
     _server.on("/api/schedules/delete", HTTP_POST, [this]() { handleDeleteSchedule(); });
 
-    // نقاط نهاية RTC خاصة بـ ScheduleManager
+    // نقاط نهاية تقويم الاستثناءات (العطل والإغلاقات)
+    _server.on("/api/schedules/exceptions/add", HTTP_POST, [this]() { handleAddException(); });
+    _server.on("/api/schedules/exceptions/get_all", HTTP_GET, [this]() { handleGetExceptions(); });
+    _server.on("/api/schedules/exceptions/delete", HTTP_POST, [this]() { handleDeleteException(); });
+
+    // نقاط نهاية الوقت (المعالجات مشتركة في MainControlClass، والمسار محفوظ للتوافق)
     _server.on("/api/schedules/time/get", HTTP_GET, [this]() { handleGetTime(); });
     _server.on("/api/schedules/time/set", HTTP_POST, [this]() { handleSetTime(); });
 }
 
-// وظيفة يتم استدعاؤها في دالة loop() الرئيسية لفحص الجداول الزمنية
+// هل يقع الوقتان في نفس اليوم؟
+static bool sameDay(const DateTime& a, const DateTime& b) {
+    return a.year() == b.year() && a.month() == b.month() && a.day() == b.day();
+}
+
+// هل يعتمد الجدول على وقت شمسي/صلاة (يتغير من يوم لآخر)؟
+static bool isAnchoredSchedule(const Schedule& s) {
+    return s.anchor != SCHEDULE_ANCHOR_CLOCK ||
+           (s.kind == SCHEDULE_KIND_INTERVAL && s.endAnchor != SCHEDULE_ANCHOR_CLOCK);
+}
+
+// أسماء مراجع الوقت في JSON (حسب ترتيب SCHEDULE_ANCHOR_*)
+static const char* const SCHEDULE_ANCHOR_NAMES[SCHEDULE_ANCHOR_COUNT] = {
+    "clock", "fajr", "sunrise", "dhuhr", "asr", "sunset", "isha"
+};
+
+// تحويل اسم مرجع من JSON إلى SCHEDULE_ANCHOR_*، أو -1 إذا كان غير معروف (الغياب يعني ساعة ثابتة)
+static int parseScheduleAnchor(const char* name) {
+    if (name == nullptr) {
+        return SCHEDULE_ANCHOR_CLOCK;
+    }
+    if (strcmp(name, "maghrib") == 0) {
+        return SCHEDULE_ANCHOR_SUNSET;
+    }
+    for (int i = 0; i < SCHEDULE_ANCHOR_COUNT; i++) {
+        if (strcmp(name, SCHEDULE_ANCHOR_NAMES[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// محفوظة للتوافق مع المخططات السابقة: المهام تُشغل من handleClient()
 void ScheduleManagerClass::loopTasks() {
-    // فحص الجداول الزمنية كل 5 ثوانٍ على الأقل لتجنب التحميل الزائد على المعالج
-    if (millis() - _lastScheduleCheck >= 5000) { 
-        checkSchedules();
-        _lastScheduleCheck = millis();
+    TaskScheduler::service();
+}
+
+// مهمة الخط الزمني: تُشغل عند انتهاء مدة النوم المحسوبة حتى الحدث التالي أو عند مقاطعة Alarm1،
+// فلا تُقرأ RTC بينهما ولا يوجد فحص دوري بـ millis()
+void ScheduleManagerClass::runTimeline() {
+    TimeService::wakeFired(TIME_WAKE_SCHEDULE); // استهلاك علم المقاطعة إن وُجد
+    if (!_timelineArmed) {
+        return;
+    }
+    DateTime now = TimeService::sync(); // قراءة فعلية لـ RTC: دقة الثانية عند الحدث
+    if (now < _nextEventTime) {
+        // استيقاظ مبكر (إعادة مزامنة دورية أو الثانية الأخيرة قبل الحدث)
+        armSleep(now);
+        return;
+    }
+    if (_anchoredCount > 0 && !sameDay(_nextEventTime, _indexDate)) {
+        rebuildScheduleIndex(_nextEventTime); // يوم جديد: إعادة تجميع الجداول المرتبطة بالشمس/الصلاة
+    }
+    DateTime handled = _nextEventTime;
+    checkSchedules(handled);
+    applyExceptionOverride(handled); // بداية يوم استثناء بحالة مفروضة
+    // تأخر الاستيقاظ لما بعد حدث آخر (توليد الجدول السنوي، عميل عالق): بدلاً من تنفيذ الأحداث الفائتة
+    // بالتتابع (تبديل فعلي سريع للمرحل) تُعاد الحالة مرة واحدة من آخر انتقال حتى الوقت الحالي
+    findNextEvent(handled);
+    bool missed = _timelineArmed && _nextEventTime <= now;
+    if (_anchoredCount > 0 && !sameDay(now, _indexDate)) {
+        rebuildScheduleIndex(now); // تأخر الاستيقاظ لما بعد منتصف الليل
+    }
+    rebuildTimeline(now);
+    if (missed) {
+        requestRelayRestore();
     }
 }
 
-// حفظ جدول زمني في EEPROM في فهرس محدد
-void ScheduleManagerClass::saveScheduleToEEPROM(int index, const Schedule& s) {
-    int base = SCHEDULE_START_ADDR + index * SCHEDULE_SIZE;
-    EEPROMHelper::writeByte(base, s.id);
-    EEPROMHelper::writeByte(base + 1, s.hour);
-    EEPROMHelper::writeByte(base + 2, s.minute);
-    EEPROMHelper::writeByte(base + 3, s.turnOn);
-    EEPROMHelper::writeByte(base + 4, s.repeatEveryDay);
+// تقدير الوقت الحالي من خدمة الوقت المشتركة دون حركة على ناقل I2C
+DateTime ScheduleManagerClass::estimatedNow() {
+    return TimeService::now();
+}
+
+// قناع أيام التنفيذ لجدول زمني (البت 0 = الأحد ... البت 6 = السبت)
+static uint8_t scheduleDayMask(const Schedule& s) {
+    if (s.repeatEveryDay) {
+        return 0x7F;
+    }
+    uint8_t mask = 0;
     for (int i = 0; i < 7; i++) {
-        EEPROMHelper::writeByte(base + 5 + i, s.days[i]);
+        if (s.days[i]) {
+            mask |= (1 << i);
+        }
     }
-    EEPROMHelper::writeByte(base + 12, s.active);
+    return mask;
 }
 
-// قراءة جدول زمني من EEPROM من فهرس محدد
-Schedule ScheduleManagerClass::readScheduleFromEEPROM(int index) {
-    Schedule s;
-    int base = SCHEDULE_START_ADDR + index * SCHEDULE_SIZE;
-    s.id = EEPROMHelper::readByte(base);
-    s.hour = EEPROMHelper::readByte(base + 1);
-    s.minute = EEPROMHelper::readByte(base + 2);
-    s.turnOn = EEPROMHelper::readByte(base + 3);
-    s.repeatEveryDay = EEPROMHelper::readByte(base + 4);
-    for (int i = 0; i < 7; i++) {
-        s.days[i] = EEPROMHelper::readByte(base + 5 + i);
+// مقارنة مدخلات الفهرس: حسب الدقيقة ثم حسب الخانة (للحفاظ على ترتيب التنفيذ القديم عند التزامن)
+static int compareScheduleEvents(const void* a, const void* b) {
+    const ScheduleEvent* ea = (const ScheduleEvent*)a;
+    const ScheduleEvent* eb = (const ScheduleEvent*)b;
+    if (ea->minuteOfDay != eb->minuteOfDay) {
+        return (int)ea->minuteOfDay - (int)eb->minuteOfDay;
+    }
+    return (int)ea->slot - (int)eb->slot;
+}
+
+// حساب أول دقيقة (بعد دقيقة 'from') يُنفذ فيها الجدول، أو false إذا لم يكن نشطاً
+// (الأقرب بين حدثي البداية والنهاية للجدول الفتري)
+bool ScheduleManagerClass::nextOccurrence(const Schedule& s, const DateTime& from, DateTime& next) {
+    ScheduleEvent compiled[2];
+    uint8_t count = compileSchedule(s, 0, compiled);
+    DateTime midnight(from.year(), from.month(), from.day());
+    int fromMinutes = from.hour() * 60 + from.minute();
+    bool found = false;
+    for (uint8_t c = 0; c < count; c++) {
+        uint16_t m = compiled[c].minuteOfDay;
+        // البحث في الأيام الثمانية القادمة (اليوم نفسه مرة ثانية بعد أسبوع)
+        for (int offset = 0; offset <= 7; offset++) {
+            if (offset == 0 && m <= fromMinutes) {
+                continue; // الحدث اليوم قد مضى أو يقع في الدقيقة الحالية
+            }
+            if (compiled[c].dayMask & (1 << ((from.dayOfTheWeek() + offset) % 7))) {
+                DateTime candidate = midnight + TimeSpan(offset, m / 60, m % 60, 0);
+                if (!found || candidate < next) {
+                    next = candidate;
+                    found = true;
+                }
+                break;
+            }
+        }
+    }
+    return found; // false: غير نشط أو لا توجد أيام محددة
+}
+
+// دقيقة اليوم لوقت ثابت أو لمرجع شمسي/صلاة مع إزاحة (مقيدة بحدود اليوم)
+uint16_t ScheduleManagerClass::resolveMinute(uint8_t anchor, uint8_t hour, uint8_t minute, int16_t offset) {
+    if (anchor == SCHEDULE_ANCHOR_CLOCK || anchor >= SCHEDULE_ANCHOR_COUNT) {
+        return hour * 60 + minute;
+    }
+    // SCHEDULE_ANCHOR_FAJR ... SCHEDULE_ANCHOR_ISHA تطابق ترتيب PrayerIndex بعد طرح 1
+    int m = _anchorMinutes[anchor - 1] + offset;
+    if (m < 0) m = 0;
+    if (m > 1439) m = 1439;
+    return m;
+}
+
+// ترجمة جدول إلى أحداث يومية حسب أوقات الشمس لليوم المُجمّع
+// الفترة التي تنتهي قبل بدايتها تمتد بعد منتصف الليل، فيُنقل قناع حدث النهاية يوماً للأمام
+uint8_t ScheduleManagerClass::compileSchedule(const Schedule& s, uint16_t slot, ScheduleEvent out[2]) {
+    uint8_t mask = scheduleDayMask(s);
+    if (!s.active || mask == 0) {
+        return 0; // لا يُنفذ أبداً
+    }
+    uint16_t start = resolveMinute(s.anchor, s.hour, s.minute, s.offset);
+    out[0].minuteOfDay = start;
+    out[0].dayMask = mask;
+    out[0].turnOn = s.kind == SCHEDULE_KIND_INTERVAL ? true : s.turnOn;
+    out[0].slot = slot;
+    if (s.kind != SCHEDULE_KIND_INTERVAL) {
+        return 1;
+    }
+    uint16_t end = resolveMinute(s.endAnchor, s.endHour, s.endMinute, s.endOffset);
+    if (end == start) {
+        return 1; // فترة فارغة
+    }
+    out[1].minuteOfDay = end;
+    out[1].dayMask = end < start ? (((mask << 1) | (mask >> 6)) & 0x7F) : mask;
+    out[1].turnOn = false;
+    out[1].slot = slot;
+    return 2;
+}
+
+// إعادة حساب أوقات الشمس/الصلاة لليوم المحدد (من نفس الجدول السنوي لـ PrayerTimesManager)
+void ScheduleManagerClass::refreshAnchors(const DateTime& day) {
+    PrayerSettings settings;
+    PrayerCalc::readConfig(settings);
+    PrayerTable::getDay(settings, day, _anchorMinutes);
+    _indexDate = day;
+}
+
+// إعادة بناء فهرس الأحداث المرتب من جدول الذاكرة لليوم المحدد
+// لا حركة على ناقل I2C، وحساب أوقات الشمس فقط إذا وُجدت جداول مرتبطة بها
+void ScheduleManagerClass::rebuildScheduleIndex(const DateTime& day) {
+    _anchoredCount = 0;
+    for (uint16_t i = 0; i < MAX_SCHEDULES; i++) {
+        if (isSlotUsed(i) && _schedules[i].active && isAnchoredSchedule(_schedules[i])) {
+            _anchoredCount++;
+        }
+    }
+    if (_anchoredCount > 0) {
+        refreshAnchors(day);
+    } else {
+        _indexDate = day;
+    }
+
+    _eventCount = 0;
+    for (uint16_t i = 0; i < MAX_SCHEDULES; i++) {
+        if (isSlotUsed(i)) {
+            _eventCount += compileSchedule(_schedules[i], i, &_events[_eventCount]);
+        }
+    }
+    qsort(_events, _eventCount, sizeof(ScheduleEvent), compareScheduleEvents);
+}
+
+// إدراج أحداث جدول في مواضعها من الفهرس المرتب
+void ScheduleManagerClass::insertScheduleEvent(uint16_t slot) {
+    ScheduleEvent compiled[2];
+    uint8_t count = compileSchedule(_schedules[slot], slot, compiled);
+    for (uint8_t c = 0; c < count; c++) {
+        uint16_t minuteOfDay = compiled[c].minuteOfDay;
+        uint16_t pos = lowerBoundEvent(minuteOfDay);
+        while (pos < _eventCount && _events[pos].minuteOfDay == minuteOfDay && _events[pos].slot < slot) {
+            pos++; // الحفاظ على ترتيب الخانات داخل نفس الدقيقة
+        }
+        memmove(&_events[pos + 1], &_events[pos], (_eventCount - pos) * sizeof(ScheduleEvent));
+        _events[pos] = compiled[c];
+        _eventCount++;
+    }
+}
+
+// إزالة أحداث جدول من الفهرس (يجب استدعاؤها قبل تعديل الجدول في الذاكرة)
+void ScheduleManagerClass::removeScheduleEvent(uint16_t slot) {
+    ScheduleEvent compiled[2];
+    uint8_t count = compileSchedule(_schedules[slot], slot, compiled);
+    for (uint8_t c = 0; c < count; c++) {
+        uint16_t minuteOfDay = compiled[c].minuteOfDay;
+        for (uint16_t pos = lowerBoundEvent(minuteOfDay); pos < _eventCount && _events[pos].minuteOfDay == minuteOfDay; pos++) {
+            if (_events[pos].slot == slot) {
+                memmove(&_events[pos], &_events[pos + 1], (_eventCount - pos - 1) * sizeof(ScheduleEvent));
+                _eventCount--;
+                break;
+            }
+        }
+    }
+}
+
+// أول مدخل في الفهرس دقيقته >= minuteOfDay (بحث ثنائي)
+uint16_t ScheduleManagerClass::lowerBoundEvent(uint16_t minuteOfDay) {
+    uint16_t low = 0;
+    uint16_t high = _eventCount;
+    while (low < high) {
+        uint16_t mid = (low + high) / 2;
+        if (_events[mid].minuteOfDay < minuteOfDay) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// آخر حدث جدول نُفذ على القناة عند 'now' أو قبله
+// بحث عكسي من الدقيقة الحالية في الفهرس المرتب ثم الأيام السابقة (8 أيام كحد أقصى)
+// الأيام السابقة تستخدم أوقات الشمس لليوم المُجمّع (فرق دقائق قليلة عن اليوم الفعلي)
+// الحالة المفروضة تُطبق في يوم الاستثناء نفسه فقط؛ بعد انتهاء الفترة لم يُنفذ فيها أي جدول (كـ suppress)
+bool ScheduleManagerClass::lastTransition(uint8_t channel, const DateTime& now, DateTime& when, bool& state) {
+    if (!(scheduledChannels() & (1 << channel))) {
+        return false; // لا توجد جداول على هذه القناة، ولا تُفرض عليها أيام الاستثناء
+    }
+    DateTime midnight(now.year(), now.month(), now.day());
+    uint16_t end = lowerBoundEvent(now.hour() * 60 + now.minute() + 1); // الأحداث حتى الدقيقة الحالية
+    for (int offset = 0; offset <= 7; offset++) {
+        uint8_t dayBit = 1 << ((now.dayOfTheWeek() + 7 - offset) % 7);
+        DateTime day = midnight - TimeSpan(offset, 0, 0, 0);
+        uint8_t exception = _exceptions.kindFor(day);
+        if (offset == 0 && (exception == EXCEPTION_KIND_FORCE_ON || exception == EXCEPTION_KIND_FORCE_OFF)) {
+            when = day; // الحالة المفروضة تبدأ عند منتصف ليل يوم الاستثناء
+            state = exception == EXCEPTION_KIND_FORCE_ON;
+            return true;
+        }
+        if (exception != EXCEPTION_KIND_NONE) {
+            continue; // لم يُنفذ أي جدول في هذا اليوم
+        }
+        // داخل نفس الدقيقة، الخانة الأعلى هي آخر ما نُفذ (نفس ترتيب checkSchedules)
+        for (int e = (offset == 0 ? end : _eventCount) - 1; e >= 0; e--) {
+            if ((_events[e].dayMask & dayBit) && _schedules[_events[e].slot].channel == channel) {
+                uint16_t m = _events[e].minuteOfDay;
+                when = day + TimeSpan(0, m / 60, m % 60, 0);
+                state = _events[e].turnOn;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// إعادة حساب الحدث التالي عبر جميع الجداول
+void ScheduleManagerClass::rebuildTimeline() {
+    rebuildTimeline(TimeService::now());
+}
+
+// الحدث التالي بعد الوقت الحالي، ثم جدولة مهمة الخط الزمني حتى موعده
+void ScheduleManagerClass::rebuildTimeline(const DateTime& now) {
+    findNextEvent(now);
+    armSleep(now);
+}
+
+// يبدأ البحث من أول حدث بعد دقيقة 'from' في الفهرس المرتب، ثم الأيام التالية بالترتيب
+// مع وجود جداول مرتبطة بالشمس أو أيام استثناء لا يتجاوز الاستيقاظ منتصف الليل التالي
+// (لإعادة تجميع الفهرس وتطبيق حالة يوم الاستثناء)
+void ScheduleManagerClass::findNextEvent(const DateTime& from) {
+    _timelineArmed = false;
+    DateTime midnight(from.year(), from.month(), from.day());
+    uint16_t first = lowerBoundEvent(from.hour() * 60 + from.minute() + 1);
+    for (int offset = 0; offset <= 7 && !_timelineArmed; offset++) {
+        uint8_t dayBit = 1 << ((from.dayOfTheWeek() + offset) % 7);
+        for (uint16_t e = (offset == 0 ? first : 0); e < _eventCount; e++) {
+            if (_events[e].dayMask & dayBit) {
+                uint16_t m = _events[e].minuteOfDay;
+                _nextEventTime = midnight + TimeSpan(offset, m / 60, m % 60, 0);
+                _timelineArmed = true;
+                break;
+            }
+        }
+    }
+    if (needsMidnightWake()) {
+        DateTime nextMidnight = midnight + TimeSpan(1, 0, 0, 0);
+        if (!_timelineArmed || nextMidnight < _nextEventTime) {
+            _nextEventTime = nextMidnight;
+            _timelineArmed = true;
+        }
+    }
+}
+
+// تحديث تدريجي: تقديم موعد الحدث التالي إذا كان الجدول المضاف/المعدل أقرب
+void ScheduleManagerClass::considerSchedule(const Schedule& s) {
+    if (!_timelineArmed) {
+        rebuildTimeline(); // لا يوجد مرجع زمني حديث، حساب كامل من الوقت الحالي
+        return;
+    }
+    DateTime candidate;
+    if (nextOccurrence(s, estimatedNow(), candidate) && candidate < _nextEventTime) {
+        _nextEventTime = candidate;
+        updateSleepDuration(); // دون تغيير مرجع الوقت لتجنب تراكم خطأ التقريب
     }
-    s.active = EEPROMHelper::readByte(base + 12);
-    return s;
 }
 
-// قراءة آخر معرف جدول زمني تم استخدامه
-uint8_t ScheduleManagerClass::readLastScheduleId() {
-    return EEPROMHelper::readByte(LAST_SCHEDULE_ID_ADDR);
+// ضبط مدة النوم حتى الحدث التالي انطلاقاً من وقت RTC المقروء للتو
+void ScheduleManagerClass::armSleep(const DateTime& now) {
+    _lastCheckedTime = now;
+    _lastScheduleCheck = millis();
+    updateSleepDuration();
 }
 
-// كتابة آخر معرف جدول زمني تم استخدامه
-void ScheduleManagerClass::writeLastScheduleId(uint8_t id) {
-    EEPROMHelper::writeByte(LAST_SCHEDULE_ID_ADDR, id);
+// حساب مدة النوم من مرجع الوقت الحالي حتى الحدث التالي وجدولة مهمة الخط الزمني بعدها
+// إذا كانت مقاطعة RTC متاحة فهي التي توقظنا عند الحدث، ومدة النوم احتياط فقط؛
+// وإلا فدقة RTC ثانية واحدة، لذا نستيقظ قبل الحدث بثانية ثم نفحص كل SCHEDULE_EDGE_POLL_MS
+void ScheduleManagerClass::updateSleepDuration() {
+    if (!_timelineArmed) {
+        TaskScheduler::cancel(_timelineTask);
+        return;
+    }
+    int32_t remaining = (_nextEventTime - _lastCheckedTime).totalseconds();
+    bool interrupt = TimeService::armWake(TIME_WAKE_SCHEDULE, _nextEventTime);
+    unsigned long sleep;
+    if (remaining <= 0 || (remaining <= 1 && !interrupt)) {
+        sleep = SCHEDULE_EDGE_POLL_MS;
+    } else {
+        sleep = interrupt ? (unsigned long)remaining * 1000UL + RTC_ALARM_GRACE_MS
+                          : (unsigned long)(remaining - 1) * 1000UL;
+        if (sleep > SCHEDULE_RESYNC_MS) {
+            sleep = SCHEDULE_RESYNC_MS;
+        }
+    }
+    // المدة من مرجع _lastScheduleCheck، فيُطرح ما مضى منذه (considerSchedule لا يغير المرجع)
+    unsigned long elapsed = millis() - _lastScheduleCheck;
+    TaskScheduler::schedule(_timelineTask, sleep > elapsed ? sleep - elapsed : 0);
+}
+
+// تحميل جميع الجداول من EEPROM إلى الذاكرة بقراءة واحدة مجمعة
+void ScheduleManagerClass::loadSchedulesFromEEPROM() {
+    memset(_occupancy, 0, sizeof(_occupancy));
+    memset(_schedules, 0, sizeof(_schedules));
+    EEPROMHelper::get(SCHEDULE_REGION_ADDR, _header);
+    if (_header.magic == SCHEDULE_REGION_MAGIC) {
+        EEPROMHelper::readBytes(SCHEDULE_BITMAP_ADDR, _occupancy, SCHEDULE_BITMAP_SIZE);
+    } else {
+        migrateLegacySchedules(); // أول تشغيل بعد التحديث أو EEPROM غير مهيأة
+    }
+
+    // الخريطة هي المرجع: إعادة حساب العدد، وآخر خانة مشغولة لقراءة أقصر مدى ممكن
+    _header.count = 0;
+    int highestSlot = -1;
+    for (uint16_t i = 0; i < MAX_SCHEDULES; i++) {
+        if (isSlotUsed(i)) {
+            _header.count++;
+            highestSlot = i;
+        }
+    }
+    if (highestSlot >= 0) {
+        EEPROMHelper::readBytes(SCHEDULE_RECORDS_ADDR, (byte*)_schedules, (highestSlot + 1) * SCHEDULE_SIZE);
+    }
+
+    // مكدس الخانات الفارغة (الخانات الأصغر في الأعلى لتُستخدم أولاً)
+    _freeCount = 0;
+    for (int i = MAX_SCHEDULES - 1; i >= 0; i--) {
+        if (!isSlotUsed(i)) {
+            _schedules[i].active = false;
+            _freeSlots[_freeCount++] = i;
+        }
+    }
+    Serial.print("تم تحميل الجداول الزمنية إلى الذاكرة: "); Serial.println(_header.count);
+}
+
+// ترحيل الجداول من المنطقة القديمة (معرف 8 بت، 13 بايت) إلى المنطقة المخصصة
+void ScheduleManagerClass::migrateLegacySchedules() {
+    _header.magic = SCHEDULE_REGION_MAGIC;
+    _header.nextId = 1;
+    _header.count = 0;
+
+    uint8_t legacyCount = EEPROMHelper::readByte(LAST_SCHEDULE_ID_ADDR);
+    if (legacyCount > LEGACY_MAX_SCHEDULES) {
+        legacyCount = 0; // EEPROM غير مهيأة
+    }
+    if (legacyCount > 0) {
+        // السجلات القديمة تبدأ من الخانة 1
+        byte legacy[LEGACY_MAX_SCHEDULES * LEGACY_SCHEDULE_SIZE];
+        EEPROMHelper::readBytes(SCHEDULE_START_ADDR + LEGACY_SCHEDULE_SIZE, legacy, legacyCount * LEGACY_SCHEDULE_SIZE);
+        for (int i = 0; i < legacyCount; i++) {
+            const byte* record = legacy + i * LEGACY_SCHEDULE_SIZE;
+            if (!record[LEGACY_SCHEDULE_SIZE - 1]) {
+                continue; // غير نشط
+            }
+            Schedule s;
+            memset(&s, 0, sizeof(s)); // الحقول غير الموجودة في السجل القديم = 0 (السلوك القديم)
+            s.id = record[0];
+            // بقية الحقول بنفس الترتيب بعد المعرف
+            memcpy((byte*)&s + sizeof(s.id), record + 1, LEGACY_SCHEDULE_SIZE - 1);
+            _occupancy[_header.count / 8] |= (1 << (_header.count % 8));
+            _schedules[_header.count++] = s;
+            if (s.id >= _header.nextId) {
+                _header.nextId = s.id + 1;
+            }
+        }
+        EEPROMHelper::writeBytes(SCHEDULE_RECORDS_ADDR, (const byte*)_schedules, _header.count * SCHEDULE_SIZE);
+    }
+    EEPROMHelper::writeBytes(SCHEDULE_BITMAP_ADDR, _occupancy, SCHEDULE_BITMAP_SIZE);
+    saveScheduleHeader();
+    Serial.print("تم ترحيل الجداول الزمنية القديمة: "); Serial.println(_header.count);
+}
+
+// حفظ جدول زمني في الذاكرة و EEPROM في فهرس محدد (كتابة مباشرة)
+void ScheduleManagerClass::saveScheduleToEEPROM(int index, const Schedule& s) {
+    _schedules[index] = s;
+    EEPROMHelper::put(SCHEDULE_RECORDS_ADDR + index * SCHEDULE_SIZE, s);
+}
+
+// حفظ رأس منطقة الجداول (العدد والمعرف التالي)
+void ScheduleManagerClass::saveScheduleHeader() {
+    EEPROMHelper::put(SCHEDULE_REGION_ADDR, _header);
+}
+
+// هل الخانة مشغولة بجدول؟
+bool ScheduleManagerClass::isSlotUsed(uint16_t slot) {
+    return _occupancy[slot / 8] & (1 << (slot % 8));
+}
+
+// تعيين حالة إشغال خانة في الذاكرة و EEPROM (كتابة بايت واحد من الخريطة)
+void ScheduleManagerClass::setSlotUsed(uint16_t slot, bool used) {
+    if (used) {
+        _occupancy[slot / 8] |= (1 << (slot % 8));
+    } else {
+        _occupancy[slot / 8] &= ~(1 << (slot % 8));
+    }
+    EEPROMHelper::writeByte(SCHEDULE_BITMAP_ADDR + slot / 8, _occupancy[slot / 8]);
+}
+
+// البحث عن فهرس جدول نشط بمعرفه، أو -1
+int ScheduleManagerClass::findScheduleIndex(uint16_t id) {
+    for (uint16_t i = 0; i < MAX_SCHEDULES; i++) {
+        if (isSlotUsed(i) && _schedules[i].id == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// قراءة حقول الجدول من طلب JSON (مشتركة بين الإضافة والتحديث)
+// الحقول الجديدة اختيارية: بدونها يبقى الجدول نقطياً بساعة ثابتة كما في السابق
+bool ScheduleManagerClass::parseScheduleFields(JsonDocument& doc, Schedule& s) {
+    s.hour = doc["hour"];
+    s.minute = doc["minute"];
+    s.turnOn = doc["turnOn"];
+    s.repeatEveryDay = doc["repeatEveryDay"];
+    JsonArray daysArray = doc["days"];
+    for (int i = 0; i < 7; i++) {
+        s.days[i] = daysArray[i];
+    }
+
+    const char* type = doc["type"];
+    if (type == nullptr || strcmp(type, "point") == 0) {
+        s.kind = SCHEDULE_KIND_POINT;
+    } else if (strcmp(type, "interval") == 0) {
+        s.kind = SCHEDULE_KIND_INTERVAL;
+    } else {
+        return false;
+    }
+    int anchor = parseScheduleAnchor(doc["anchor"]);
+    int endAnchor = parseScheduleAnchor(doc["endAnchor"]);
+    if (anchor < 0 || endAnchor < 0) {
+        return false;
+    }
+    s.anchor = anchor;
+    s.offset = doc["offset"] | 0;
+    s.endHour = doc["endHour"] | 0;
+    s.endMinute = doc["endMinute"] | 0;
+    s.endAnchor = endAnchor;
+    s.endOffset = doc["endOffset"] | 0;
+    int channel = doc["channel"] | 0;
+    if (channel < 0 || channel >= RELAY_CHANNEL_COUNT) {
+        return false;
+    }
+    s.channel = channel;
+    return s.hour < 24 && s.minute < 60 && s.endHour < 24 && s.endMinute < 60;
+}
+
+// تحويل جدول زمني إلى JSON وإلحاقه بسلسلة نصية
+void ScheduleManagerClass::appendScheduleJson(String& out, const Schedule& s) {
+    out += "{\"id\":" + String(s.id) +
+           ",\"hour\":" + String(s.hour) +
+           ",\"minute\":" + String(s.minute) +
+           ",\"turnOn\":" + String(s.turnOn ? "true" : "false") +
+           ",\"repeatEveryDay\":" + String(s.repeatEveryDay ? "true" : "false") +
+           ",\"days\":[";
+    for (int j = 0; j < 7; j++) {
+        if (j > 0) out += ",";
+        out += s.days[j] ? "true" : "false";
+    }
+    out += "],\"active\":" + String(s.active ? "true" : "false") +
+           ",\"type\":\"" + String(s.kind == SCHEDULE_KIND_INTERVAL ? "interval" : "point") +
+           "\",\"anchor\":\"" + String(SCHEDULE_ANCHOR_NAMES[s.anchor < SCHEDULE_ANCHOR_COUNT ? s.anchor : 0]) +
+           "\",\"offset\":" + String(s.offset) +
+           ",\"endHour\":" + String(s.endHour) +
+           ",\"endMinute\":" + String(s.endMinute) +
+           ",\"endAnchor\":\"" + String(SCHEDULE_ANCHOR_NAMES[s.endAnchor < SCHEDULE_ANCHOR_COUNT ? s.endAnchor : 0]) +
+           "\",\"endOffset\":" + String(s.endOffset) +
+           ",\"channel\":" + String(s.channel) + "}";
 }
 
 // معالج لإضافة جدول زمني جديد
 void ScheduleManagerClass::handleAddSchedule() {
     if (_server.hasArg("plain")) {
-        StaticJsonDocument<300> doc; // Adjust size as needed
+        StaticJsonDocument<400> doc; // Adjust size as needed
         DeserializationError error = deserializeJson(doc, _server.arg("plain"));
         if (error) {
             _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"JSON غير صالح\"}");
             return;
         }
 
-        uint8_t lastId = readLastScheduleId();
-        if(lastId >= MAX_SCHEDULES){
-            _server.send(400, "application/json", "{\"status\":\"schedule_id_full\",\"message\":\"الحد الأقصى للجداول الزمنية (10) قد اكتمل\"}");
+        if (_freeCount == 0) {
+            _server.send(400, "application/json", "{\"status\":\"schedule_id_full\",\"message\":\"الحد الأقصى للجداول الزمنية (" + String(MAX_SCHEDULES) + ") قد اكتمل\"}");
             return;
         }
-        
-        // استخدام معرف جديد (lastId + 1) كمعرف للجدول الزمني
-        uint8_t newId = lastId + 1;
+
+        // معرف 16 بت جديد من العداد (مع تخطي 0 و 0xFFFF والمعرفات المستخدمة بعد الالتفاف)
+        uint16_t newId = _header.nextId;
+        while (newId == 0 || newId == 0xFFFF || findScheduleIndex(newId) != -1) {
+            newId++;
+        }
 
         Schedule s;
         s.id = newId; // تعيين المعرف الجديد
-        s.hour = doc["hour"];
-        s.minute = doc["minute"];
-        s.turnOn = doc["turnOn"];
-        s.repeatEveryDay = doc["repeatEveryDay"];
-        JsonArray daysArray = doc["days"];
-        for (int i = 0; i < 7; i++) {
-            s.days[i] = daysArray[i];
+        if (!parseScheduleFields(doc, s)) {
+            _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"حقول الجدول الزمني غير صالحة\"}");
+            return;
         }
         s.active = true; // تفعيل الجدول الزمني عند الإضافة
 
-        saveScheduleToEEPROM(newId, s); // حفظ الجدول الزمني في EEPROM
-        writeLastScheduleId(newId); // تحديث آخر معرف جدول زمني
+        // أخذ خانة فارغة من المكدس: كتابة السجل وبايت الخريطة والرأس فقط مهما كان عدد الجداول
+        uint16_t slot = _freeSlots[--_freeCount];
+        saveScheduleToEEPROM(slot, s);
+        setSlotUsed(slot, true);
+        _header.count++;
+        _header.nextId = newId + 1;
+        saveScheduleHeader(); // تحديث العدد والمعرف التالي
+        if (isAnchoredSchedule(s) && _anchoredCount++ == 0) {
+            // أول جدول مرتبط بالشمس: حساب أوقات اليوم وتقييد الاستيقاظ بمنتصف الليل
+            DateTime now = TimeService::now();
+            refreshAnchors(now);
+            insertScheduleEvent(slot);
+            rebuildTimeline(now);
+        } else {
+            insertScheduleEvent(slot);
+            considerSchedule(s); // تحديث الحدث التالي
+        }
 
         _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تمت إضافة الجدول الزمني بنجاح\",\"id\":" + String(newId) + "}");
     } else {
@@ -129,30 +643,46 @@ void ScheduleManagerClass::handleAddSchedule() {
     }
 }
 
-// معالج للحصول على جميع الجداول الزمنية
+// معالج للحصول على الجداول الزمنية
+// بدون معاملات: مصفوفة بجميع الجداول (كما في السابق). مع ?offset=&limit=: كائن يحوي صفحة واحدة والعدد الكلي.
+// يُرسل الرد على أجزاء لتجنب بناء مستند JSON كبير في الذاكرة.
 void ScheduleManagerClass::handleGetSchedules() {
-    StaticJsonDocument<2048> doc; // حجم كبير بما يكفي لعدة جداول
-    JsonArray arr = doc.to<JsonArray>();
-    uint8_t count = readLastScheduleId(); // الحصول على عدد الجداول الزمنية النشطة
-
-    for (int i = 1; i <= count; i++) { // التكرار من 1 إلى العدد الحالي للجداول
-        Schedule s = readScheduleFromEEPROM(i);
-        // إضافة الجداول النشطة فقط
-        if (s.active) {
-            JsonObject o = arr.createNestedObject();
-            o["id"] = s.id;
-            o["hour"] = s.hour;
-            o["minute"] = s.minute;
-            o["turnOn"] = s.turnOn;
-            o["repeatEveryDay"] = s.repeatEveryDay;
-            JsonArray d = o.createNestedArray("days");
-            for (int j = 0; j < 7; j++) d.add(s.days[j]);
-            o["active"] = s.active;
-        }
-    }
-    String output;
-    serializeJsonPretty(doc, output); // تنسيق JSON بشكل جميل
-    _server.send(200, "application/json", output);
+    bool paged = _server.hasArg("offset") || _server.hasArg("limit");
+    int offset = paged ? _server.arg("offset").toInt() : 0;
+    int limit = _server.hasArg("limit") ? _server.arg("limit").toInt() : (paged ? SCHEDULE_PAGE_DEFAULT_LIMIT : MAX_SCHEDULES);
+    if (offset < 0) offset = 0;
+    if (limit <= 0) limit = SCHEDULE_PAGE_DEFAULT_LIMIT;
+    int end = offset + limit;
+
+    _server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    _server.send(200, "application/json", "");
+
+    String chunk;
+    chunk.reserve(512);
+    if (paged) {
+        chunk = "{\"total\":" + String(_header.count) + ",\"offset\":" + String(offset) +
+                ",\"limit\":" + String(limit) + ",\"schedules\":";
+    }
+    chunk += "[";
+    int index = 0; // ترتيب الجدول بين الخانات المشغولة
+    for (uint16_t slot = 0; slot < MAX_SCHEDULES && index < end; slot++) {
+        if (!isSlotUsed(slot)) {
+            continue;
+        }
+        if (index >= offset) {
+            if (index > offset) chunk += ",";
+            appendScheduleJson(chunk, _schedules[slot]);
+            if (chunk.length() > 400) {
+                _server.sendContent(chunk);
+                chunk = "";
+            }
+        }
+        index++;
+    }
+    chunk += "]";
+    if (paged) chunk += "}";
+    _server.sendContent(chunk);
+    _server.sendContent(""); // نهاية الرد المجزأ
 }
 
 // معالج لحذف جدول زمني
@@ -164,33 +694,31 @@ void ScheduleManagerClass::handleDeleteSchedule() {
             _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"JSON غير صالح\"}");
             return;
         }
-        int idToDelete = doc["id"];
-        uint8_t count = readLastScheduleId();
-        
-        bool found = false;
-        for (int i = 1; i <= count; i++) {
-            Schedule s = readScheduleFromEEPROM(i);
-            if (s.id == idToDelete && s.active) { // البحث عن الجدول الزمني النشط بالمعرف
-                found = true;
-                // إزاحة الجداول الزمنية اللاحقة لملء الفجوة
-                for (int j = i; j < count; j++) {
-                    Schedule next_s = readScheduleFromEEPROM(j + 1);
-                    next_s.id = j; // تحديث المعرف للحفاظ على الترتيب التسلسلي
-                    saveScheduleToEEPROM(j, next_s);
-                }
-                // مسح آخر خانة في EEPROM (اختياري، ولكن يفضل لتنظيف البيانات)
-                for (int k = 0; k < SCHEDULE_SIZE; ++k) {
-                    EEPROMHelper::writeByte(SCHEDULE_START_ADDR + (count * SCHEDULE_SIZE) + k, 0xFF);
-                }
-                writeLastScheduleId(count - 1); // تحديث آخر معرف جدول زمني
-                _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم حذف الجدول الزمني بنجاح\"}");
-                Serial.print("تم حذف الجدول الزمني بالمعرف: "); Serial.println(idToDelete);
-                return;
-            }
-        }
-        if (!found) {
+        uint16_t idToDelete = doc["id"];
+        int i = findScheduleIndex(idToDelete); // البحث عن الجدول الزمني النشط بالمعرف
+        if (i == -1) {
             _server.send(404, "application/json", "{\"status\":\"error\",\"message\":\"لم يتم العثور على الجدول الزمني\"}");
+            return;
         }
+        // هل كان هذا الجدول هو الحدث المنتظر؟
+        DateTime pending;
+        bool wasPending = _timelineArmed && nextOccurrence(_schedules[i], estimatedNow(), pending) && pending == _nextEventTime;
+
+        // تحرير الخانة: كتابة بايت واحد من الخريطة، دون إزاحة أو تغيير معرفات الجداول الأخرى
+        // (عدد الرأس يُعاد حسابه من الخريطة عند التحميل، فلا حاجة لكتابته هنا)
+        removeScheduleEvent(i);
+        if (isAnchoredSchedule(_schedules[i])) {
+            _anchoredCount--;
+        }
+        _schedules[i].active = false;
+        setSlotUsed(i, false);
+        _freeSlots[_freeCount++] = i;
+        _header.count--;
+        if (wasPending) {
+            rebuildTimeline(); // قد يشترك جدول آخر في نفس الدقيقة
+        }
+        _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم حذف الجدول الزمني بنجاح\"}");
+        Serial.print("تم حذف الجدول الزمني بالمعرف: "); Serial.println(idToDelete);
     } else {
         _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"جسم الطلب مفقود\"}");
     }
@@ -199,97 +727,190 @@ void ScheduleManagerClass::handleDeleteSchedule() {
 // معالج لتحديث جدول زمني موجود
 void ScheduleManagerClass::handleUpdateSchedule() {
     if (_server.hasArg("plain")) {
-        StaticJsonDocument<300> doc;
+        StaticJsonDocument<400> doc;
         DeserializationError error = deserializeJson(doc, _server.arg("plain"));
         if (error) {
             _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"JSON غير صالح\"}");
             return;
         }
-        int idToUpdate = doc["id"];
-        uint8_t count = readLastScheduleId();
-        for (int i = 1; i <= count; i++) { 
-            Schedule s = readScheduleFromEEPROM(i);
-            if (s.id == idToUpdate && s.active) { // البحث عن الجدول الزمني النشط بالمعرف
-                s.hour = doc["hour"];
-                s.minute = doc["minute"];
-                s.turnOn = doc["turnOn"];
-                s.repeatEveryDay = doc["repeatEveryDay"];
-                JsonArray daysArray = doc["days"];
-                for (int j = 0; j < 7; j++) s.days[j] = daysArray[j];
-                saveScheduleToEEPROM(i, s); // حفظ التغييرات في نفس الفهرس
-                _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم تحديث الجدول الزمني بنجاح\"}");
-                Serial.print("تم تحديث الجدول الزمني بالمعرف: "); Serial.println(idToUpdate);
-                return;
-            }
+        uint16_t idToUpdate = doc["id"];
+        int i = findScheduleIndex(idToUpdate); // البحث عن الجدول الزمني النشط بالمعرف
+        if (i == -1) {
+            _server.send(404, "application/json", "{\"status\":\"error\",\"message\":\"لم يتم العثور على الجدول الزمني\"}");
+            return;
         }
-        _server.send(404, "application/json", "{\"status\":\"error\",\"message\":\"لم يتم العثور على الجدول الزمني\"}");
+        Schedule s = _schedules[i];
+        DateTime pending;
+        bool wasPending = _timelineArmed && nextOccurrence(s, estimatedNow(), pending) && pending == _nextEventTime;
+        if (!parseScheduleFields(doc, s)) {
+            _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"حقول الجدول الزمني غير صالحة\"}");
+            return;
+        }
+        bool wasAnchored = isAnchoredSchedule(_schedules[i]);
+        removeScheduleEvent(i); // بالوقت القديم قبل الكتابة
+        saveScheduleToEEPROM(i, s); // حفظ التغييرات في نفس الفهرس
+        if (wasAnchored) {
+            _anchoredCount--;
+        }
+        if (isAnchoredSchedule(s) && _anchoredCount++ == 0) {
+            refreshAnchors(TimeService::now()); // أول جدول مرتبط بالشمس
+            wasPending = true; // إعادة الحساب لتقييد الاستيقاظ بمنتصف الليل
+        }
+        insertScheduleEvent(i);
+        if (wasPending) {
+            rebuildTimeline();
+        } else {
+            considerSchedule(s);
+        }
+        _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم تحديث الجدول الزمني بنجاح\"}");
+        Serial.print("تم تحديث الجدول الزمني بالمعرف: "); Serial.println(idToUpdate);
     } else {
         _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"جسم الطلب مفقود\"}");
     }
 }
 
-// وظيفة داخلية لفحص وتفعيل الجداول الزمنية
-void ScheduleManagerClass::checkSchedules() {
-    DateTime currentTime = _rtcManager.now(); // الحصول على الوقت والتاريخ الحاليين من RTCManager
+// تفعيل الجداول الزمنية المستحقة في دقيقة الحدث
+// البحث الثنائي في الفهرس يلمس فقط الجداول المقررة في هذه الدقيقة
+// في أيام الاستثناء تُتجاهل جميع الجداول (فحص ثابت التكلفة في خريطة السنة)
+// طلبات جميع القنوات في هذه الدقيقة تُجمع في قرار واحد (كتابة واحدة للمخارج و EEPROM)
+void ScheduleManagerClass::checkSchedules(const DateTime& eventTime) {
+    if (_exceptions.kindFor(eventTime) != EXCEPTION_KIND_NONE) {
+        return;
+    }
+    uint16_t minuteOfDay = eventTime.hour() * 60 + eventTime.minute();
+    uint8_t dayBit = 1 << eventTime.dayOfTheWeek();
+    bool changed = false;
+
+    for (uint16_t e = lowerBoundEvent(minuteOfDay); e < _eventCount && _events[e].minuteOfDay == minuteOfDay; e++) {
+        if (!(_events[e].dayMask & dayBit)) {
+            continue; // لا يُنفذ في هذا اليوم
+        }
+        const ScheduleEvent& event = _events[e];
+        const Schedule& s = _schedules[event.slot];
+        // بداية/نهاية الفترة أو حالة الجدول النقطي (داخل نفس الدقيقة، الخانة الأعلى تغلب على نفس القناة)
+        changed |= fileRelayClaim(s.channel, RELAY_SOURCE_SCHEDULE, event.turnOn, eventTime.unixtime());
+        Serial.print("تم تفعيل الجدول الزمني ID: ");
+        Serial.print(s.id);
+        Serial.print("، تعيين القناة ");
+        Serial.print(s.channel);
+        Serial.print(" إلى: ");
+        Serial.println(event.turnOn ? "تشغيل" : "إيقاف");
+    }
+    if (changed) {
+        applyRelayDecision();
+    }
+}
 
-    // التحقق فقط إذا تغيرت الدقيقة لتجنب التكرار الزائد
-    if (currentTime.minute() == _lastCheckedTime.minute() &&
-        currentTime.hour() == _lastCheckedTime.hour() &&
-        currentTime.day() == _lastCheckedTime.day() &&
-        currentTime.month() == _lastCheckedTime.month() &&
-        currentTime.year() == _lastCheckedTime.year()) {
-        return; // لم تتغير الدقيقة، لا تفعل شيئاً
+// طلب حالة المرحل المفروضة في يوم استثناء على جميع قنوات الجداول
+// (بوقت بداية اليوم، والحَكَم لا يكتب إذا كانت الحالة مطابقة)
+// في اليوم التالي لنهاية فترة مفروضة تُعاد القنوات للجداول (آخر انتقال قبل الفترة)
+void ScheduleManagerClass::applyExceptionOverride(const DateTime& now) {
+    uint8_t exception = _exceptions.kindFor(now);
+    if (exception != EXCEPTION_KIND_FORCE_ON && exception != EXCEPTION_KIND_FORCE_OFF) {
+        uint8_t previous = _exceptions.kindFor(DateTime(now.year(), now.month(), now.day()) - TimeSpan(1, 0, 0, 0));
+        if (previous == EXCEPTION_KIND_FORCE_ON || previous == EXCEPTION_KIND_FORCE_OFF) {
+            requestRelayRestore();
+        }
+        return;
     }
+    uint8_t channels = scheduledChannels();
+    requestRelayMask(RELAY_SOURCE_SCHEDULE, channels, exception == EXCEPTION_KIND_FORCE_ON ? channels : 0,
+                     DateTime(now.year(), now.month(), now.day()).unixtime());
+}
 
-    uint8_t count = readLastScheduleId(); 
+// قناع القنوات التي لها أحداث في الفهرس (بدون جداول: القناة 0، كما في المرحل الواحد)
+uint8_t ScheduleManagerClass::scheduledChannels() {
+    uint8_t mask = 0;
+    for (uint16_t e = 0; e < _eventCount && mask != RELAY_CHANNEL_ALL; e++) {
+        mask |= (1 << _schedules[_events[e].slot].channel) & RELAY_CHANNEL_ALL;
+    }
+    return mask != 0 ? mask : 0x01;
+}
 
-    for (int i = 1; i <= count; i++) { 
-        Schedule s = readScheduleFromEEPROM(i);
+// هل يحتاج الخط الزمني للاستيقاظ عند منتصف الليل؟
+bool ScheduleManagerClass::needsMidnightWake() {
+    return _anchoredCount > 0 || _exceptions.count() > 0;
+}
 
-        // التحقق مما إذا كان الجدول الزمني نشطاً والوقت الحالي يطابق وقت الجدول
-        if (s.active && s.hour == currentTime.hour() && s.minute == currentTime.minute()) {
-            bool today = s.repeatEveryDay || s.days[currentTime.dayOfTheWeek()];
-            if (today) {
-                setRelayPhysicalState(s.turnOn); // تعيين حالة المرحل
-                Serial.print("تم تفعيل الجدول الزمني ID: ");
-                Serial.print(s.id);
-                Serial.print("، تعيين المرحل إلى: ");
-                Serial.println(s.turnOn ? "تشغيل" : "إيقاف");
-            }
+// معالج لإضافة فترة استثناء
+// {"from":"YYYY-MM-DD","to":"YYYY-MM-DD","kind":"suppress|on|off"} - "to" و "kind" اختياريان
+void ScheduleManagerClass::handleAddException() {
+    if (_server.hasArg("plain")) {
+        StaticJsonDocument<200> doc;
+        DeserializationError error = deserializeJson(doc, _server.arg("plain"));
+        if (error) {
+            _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"JSON غير صالح\"}");
+            return;
+        }
+        const char* from = doc["from"];
+        const char* to = doc["to"];
+        int kind = ExceptionCalendar::parseKind(doc["kind"]);
+        DateTime first, last;
+        if (!RTCManager::parseDate(from, first) || !RTCManager::parseDate(to ? to : from, last) || kind < 0) {
+            _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"تاريخ أو نوع غير صالح\"}");
+            return;
+        }
+        if (_exceptions.count() >= MAX_SCHEDULE_EXCEPTIONS) {
+            _server.send(400, "application/json", "{\"status\":\"exception_full\",\"message\":\"الحد الأقصى لفترات الاستثناء (" + String(MAX_SCHEDULE_EXCEPTIONS) + ") قد اكتمل\"}");
+            return;
         }
+        uint16_t id = _exceptions.add(first, last, kind);
+        if (id == 0) {
+            _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"نهاية الفترة قبل بدايتها\"}");
+            return;
+        }
+        DateTime now = TimeService::now();
+        applyExceptionOverride(now); // إذا كانت الفترة تشمل اليوم
+        rebuildTimeline(now);        // الاستيقاظ عند منتصف الليل لبداية الفترة
+        _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تمت إضافة فترة الاستثناء بنجاح\",\"id\":" + String(id) + "}");
+    } else {
+        _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"جسم الطلب مفقود\"}");
     }
-    _lastCheckedTime = currentTime; // تحديث آخر وقت تم فحصه
 }
 
-// معالج للحصول على الوقت الحالي عبر API (خاص بـ ScheduleManager)
-void ScheduleManagerClass::handleGetTime() {
-    DateTime currentTime = _rtcManager.now(); // الحصول على الوقت الحالي
-    String response = "{ \"year\": " + String(currentTime.year()) +
-                      ", \"month\": " + String(currentTime.month()) +
-                      ", \"day\": " + String(currentTime.day()) +
-                      ", \"hour\": " + String(currentTime.hour()) +
-                      ", \"minute\": " + String(currentTime.minute()) +
-                      ", \"second\": " + String(currentTime.second()) + " }";
-    Serial.println(response);
+// معالج للحصول على جميع فترات الاستثناء
+void ScheduleManagerClass::handleGetExceptions() {
+    String response = "[";
+    for (uint8_t i = 0; i < _exceptions.count(); i++) {
+        const ExceptionRange& range = _exceptions.at(i);
+        if (i > 0) response += ",";
+        response += "{\"id\":" + String(range.id) +
+                    ",\"from\":\"" + ExceptionCalendar::formatDay(range.firstDay) +
+                    "\",\"to\":\"" + ExceptionCalendar::formatDay(range.lastDay) +
+                    "\",\"kind\":\"" + ExceptionCalendar::kindName(range.kind) + "\"}";
+    }
+    response += "]";
     _server.send(200, "application/json", response);
 }
 
-// معالج لتعيين الوقت عبر API (خاص بـ ScheduleManager)
-void ScheduleManagerClass::handleSetTime() {
+// معالج لحذف فترة استثناء
+void ScheduleManagerClass::handleDeleteException() {
     if (_server.hasArg("plain")) {
-        StaticJsonDocument<200> doc;
-        deserializeJson(doc, _server.arg("plain"));
-        // قراءة قيم الوقت والتاريخ من JSON
-        int year = doc["year"];
-        int month = doc["month"];
-        int day = doc["day"];
-        int hour = doc["hour"];
-        int minute = doc["minute"];
-        int second = doc["second"];
-        // ضبط RTC بالقيم الجديدة
-        _rtcManager.adjustRTC(DateTime(year, month, day, hour, minute, second));
-        _server.send(200, "application/json", "{\"status\":\"تم تحديث الوقت\"}");
+        StaticJsonDocument<100> doc;
+        DeserializationError error = deserializeJson(doc, _server.arg("plain"));
+        if (error) {
+            _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"JSON غير صالح\"}");
+            return;
+        }
+        uint16_t id = doc["id"];
+        if (!_exceptions.remove(id)) {
+            _server.send(404, "application/json", "{\"status\":\"error\",\"message\":\"لم يتم العثور على فترة الاستثناء\"}");
+            return;
+        }
+        rebuildTimeline();
+        requestRelayRestore(); // إذا كانت الفترة المحذوفة تفرض حالة اليوم
+        _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم حذف فترة الاستثناء بنجاح\"}");
     } else {
-        _server.send(400, "application/json", "{\"error\":\"جسم الطلب مفقود\"}");
+        _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"جسم الطلب مفقود\"}");
+    }
+}
+
+// إشعار من خدمة الوقت بتغير الساعة: أوقات الشمس لليوم الجديد والحدث التالي،
+// ثم تعيين المرحل حسب آخر انتقال في الدورة التالية
+void ScheduleManagerClass::onTimeChanged(const DateTime& now) {
+    if (_anchoredCount > 0 && !sameDay(now, _indexDate)) {
+        rebuildScheduleIndex(now); // تغير اليوم: أوقات الشمس لليوم الجديد
     }
+    rebuildTimeline(now); // تغيرت الساعة، إعادة حساب الحدث التالي
+    requestRelayRestore();
 }
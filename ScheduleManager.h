@@ -4,49 +4,129 @@
 
 #include "Config.h"
 #include "MainControl.h" // الوراثة من MainControlClass
-#include "RTCManager.h"  // تضمين RTCManager كفئة مساعدة
+#include "TimeService.h" // خدمة الوقت المشتركة
+#include "PrayerTable.h" // أوقات الشروق/الغروب/الصلاة للجداول المرتبطة بها
+#include "ExceptionCalendar.h" // أيام العطل والإغلاق
+
+// مدخل في فهرس الأحداث اليومي (مرتب حسب الدقيقة من بداية اليوم)
+// الجدول النقطي يُترجم إلى حدث واحد، والجدول الفتري إلى حدثين (تشغيل عند البداية وإيقاف عند النهاية)
+struct __attribute__((packed)) ScheduleEvent {
+    uint16_t minuteOfDay;   // دقيقة التنفيذ من منتصف الليل (0-1439)
+    uint8_t dayMask;        // أيام التنفيذ (البت 0 = الأحد ... البت 6 = السبت)
+    bool turnOn;            // حالة المرحل عند هذا الحدث
+    uint16_t slot;          // فهرس الجدول في _schedules
+};
 
 // فئة ScheduleManagerClass لإدارة الجداول الزمنية لتشغيل/إيقاف المرحل
-class ScheduleManagerClass : public MainControlClass {
+class ScheduleManagerClass : public MainControlClass, public RelayTransitionSource, public TimeChangeListener {
 private:
-    RTCManager _rtcManager; // كائن RTCManager لإدارة الوقت
-    unsigned long _lastScheduleCheck = 0; // لتتبع آخر فحص للجدول الزمني (لمنع التكرار)
-    DateTime _lastCheckedTime; // لتخزين آخر وقت تم فحص الجداول فيه
+    unsigned long _lastScheduleCheck = 0; // قيمة millis() عند آخر قراءة لـ RTC (مرجع مدة النوم)
+    DateTime _lastCheckedTime; // وقت RTC عند آخر قراءة (مرجع حساب مدة النوم)
+    uint8_t _timelineTask = TASK_NONE; // مهمة الخط الزمني في جدول المهام المشترك
+    DateTime _nextEventTime;   // وقت الحدث التالي عبر جميع الجداول النشطة
+    bool _timelineArmed = false; // هل يوجد حدث قادم مُجدول؟
+    Schedule _schedules[MAX_SCHEDULES]; // نسخة الجداول في الذاكرة (الفهرس يطابق خانة EEPROM ولا يتغير)
+    ScheduleRegionHeader _header; // نسخة رأس منطقة الجداول (العدد والمعرف التالي)
+    uint8_t _occupancy[SCHEDULE_BITMAP_SIZE]; // خريطة إشغال الخانات (نسخة من EEPROM)
+    uint16_t _freeSlots[MAX_SCHEDULES]; // مكدس الخانات الفارغة لإعادة استخدامها بتكلفة ثابتة
+    uint16_t _freeCount = 0;   // عدد الخانات في _freeSlots
+    ScheduleEvent _events[2 * MAX_SCHEDULES]; // فهرس الأحداث مرتباً حسب الدقيقة من بداية اليوم
+    uint16_t _eventCount = 0;  // عدد المدخلات في _events
+    int _anchorMinutes[PRAYER_COUNT]; // أوقات الشمس/الصلاة لليوم المُجمّع في الفهرس (دقائق من منتصف الليل)
+    DateTime _indexDate;       // اليوم الذي حُسبت له _anchorMinutes
+    uint16_t _anchoredCount = 0; // عدد الجداول المرتبطة بوقت شمسي/صلاة (يُعاد تجميعها يومياً)
+    ExceptionCalendar _exceptions; // أيام الاستثناء التي تُتجاهل فيها الجداول أو يُفرض فيها المرحل
 
 public:
     // المُنشئ (Constructor) لفئة ScheduleManagerClass
 #ifdef USE_EXTERNAL_EEPROM
-    ScheduleManagerClass(WebServer& serverRef, int relayPin);
+    ScheduleManagerClass(HttpServerRef serverRef, int relayPin);
 #else
-    ScheduleManagerClass(WebServer& serverRef, int relayPin, EEPROMClass& eepromRef);
+    ScheduleManagerClass(HttpServerRef serverRef, int relayPin, EEPROMClass& eepromRef);
 #endif
 
     // إعداد نقاط نهاية API المتعلقة بالجداول الزمنية
     void setupScheduleEndpoints();
-    // وظيفة يتم استدعاؤها في دالة loop() الرئيسية لفحص الجداول الزمنية
-    void loopTasks(); 
+    // محفوظة للتوافق: handleClient() يشغل جدول المهام المشترك، فلا حاجة لاستدعائها في loop()
+    void loopTasks();
+    // آخر حدث جدول نُفذ على القناة عند 'now' أو قبله (بحث عكسي في فهرس الأحداث، 8 أيام كحد أقصى)
+    bool lastTransition(uint8_t channel, const DateTime& now, DateTime& when, bool& state) override;
+    // مصدر طلبات هذا المدير في حَكَم المرحل
+    uint8_t relaySource() const override { return RELAY_SOURCE_SCHEDULE; }
+    // إشعار من خدمة الوقت بتغير الساعة
+    void onTimeChanged(const DateTime& now) override;
 
 private:
     // --- وظائف مساعدة لـ EEPROM (تستخدم EEPROMHelper) ---
-    // حفظ جدول زمني في EEPROM في فهرس محدد
+    // تحميل جميع الجداول من EEPROM إلى الذاكرة بقراءة واحدة مجمعة
+    void loadSchedulesFromEEPROM();
+    // ترحيل الجداول من المنطقة القديمة (معرف 8 بت) إلى المنطقة المخصصة
+    void migrateLegacySchedules();
+    // حفظ جدول زمني في الذاكرة و EEPROM في فهرس محدد (كتابة مباشرة)
     void saveScheduleToEEPROM(int index, const Schedule& s);
-    // قراءة جدول زمني من EEPROM من فهرس محدد
-    Schedule readScheduleFromEEPROM(int index);    
-    // قراءة آخر معرف جدول زمني تم استخدامه
-    uint8_t readLastScheduleId();
-    // كتابة آخر معرف جدول زمني تم استخدامه
-    void writeLastScheduleId(uint8_t id);
-    
+    // حفظ رأس منطقة الجداول (العدد والمعرف التالي)
+    void saveScheduleHeader();
+    // هل الخانة مشغولة بجدول؟
+    bool isSlotUsed(uint16_t slot);
+    // تعيين حالة إشغال خانة في الذاكرة و EEPROM (كتابة بايت واحد من الخريطة)
+    void setSlotUsed(uint16_t slot, bool used);
+    // البحث عن فهرس جدول نشط بمعرفه، أو -1
+    int findScheduleIndex(uint16_t id);
+    // قراءة حقول الجدول من طلب JSON (مشتركة بين الإضافة والتحديث)، أو false إذا كانت غير صالحة
+    bool parseScheduleFields(JsonDocument& doc, Schedule& s);
+    // تحويل جدول زمني إلى JSON وإلحاقه بسلسلة نصية
+    void appendScheduleJson(String& out, const Schedule& s);
+
     // --- معالجات API لإدارة الجداول الزمنية ---
     void handleAddSchedule();    // إضافة جدول زمني جديد
-    void handleGetSchedules();   // الحصول على جميع الجداول الزمنية
+    void handleGetSchedules();   // الحصول على الجداول الزمنية (مع دعم الترقيم)
     void handleUpdateSchedule(); // تحديث جدول زمني موجود
     void handleDeleteSchedule(); // حذف جدول زمني
-    void checkSchedules();       // وظيفة داخلية لفحص وتفعيل الجداول الزمنية
+    void checkSchedules(const DateTime& eventTime); // تفعيل الجداول الزمنية المستحقة في دقيقة الحدث
+
+    // --- معالجات API لتقويم الاستثناءات ---
+    void handleAddException();    // إضافة فترة استثناء
+    void handleGetExceptions();   // الحصول على جميع فترات الاستثناء
+    void handleDeleteException(); // حذف فترة استثناء
+    // تطبيق حالة المرحل المفروضة في يوم استثناء (تشغيل/إيقاف)، إن وُجدت
+    void applyExceptionOverride(const DateTime& now);
+    // هل يحتاج الخط الزمني للاستيقاظ عند منتصف الليل؟ (جداول مرتبطة بالشمس أو أيام استثناء)
+    bool needsMidnightWake();
+    // قناع القنوات التي لها أحداث في الفهرس (تطبق عليها حالة أيام الاستثناء المفروضة)
+    uint8_t scheduledChannels();
+
+    // --- فهرس الأحداث والخط الزمني للأحداث القادمة ---
+    // ترجمة جدول إلى أحداث يومية (0 أو 1 أو 2) حسب أوقات الشمس لليوم المُجمّع
+    uint8_t compileSchedule(const Schedule& s, uint16_t slot, ScheduleEvent out[2]);
+    // دقيقة اليوم لوقت ثابت أو لمرجع شمسي/صلاة مع إزاحة (مقيدة بحدود اليوم)
+    uint16_t resolveMinute(uint8_t anchor, uint8_t hour, uint8_t minute, int16_t offset);
+    // إعادة حساب أوقات الشمس/الصلاة لليوم المحدد
+    void refreshAnchors(const DateTime& day);
+    // إعادة بناء فهرس الأحداث المرتب من جدول الذاكرة لليوم المحدد
+    void rebuildScheduleIndex(const DateTime& day);
+    // إدراج/إزالة أحداث جدول في الفهرس المرتب دون إعادة بنائه
+    void insertScheduleEvent(uint16_t slot);
+    void removeScheduleEvent(uint16_t slot);
+    // أول مدخل في الفهرس دقيقته >= minuteOfDay (بحث ثنائي)
+    uint16_t lowerBoundEvent(uint16_t minuteOfDay);
+    // حساب أول دقيقة (بعد دقيقة 'from') يُنفذ فيها أحد أحداث الجدول، أو false إذا لم يكن نشطاً
+    bool nextOccurrence(const Schedule& s, const DateTime& from, DateTime& next);
+    // إعادة حساب الحدث التالي عبر جميع الجداول (بعد ضبط الساعة أو حذف/تعديل الحدث المنتظر)
+    void rebuildTimeline();
+    void rebuildTimeline(const DateTime& now);
+    // أول حدث (أو استيقاظ منتصف الليل) بعد دقيقة 'from' في _nextEventTime، دون جدولة المهمة
+    void findNextEvent(const DateTime& from);
+    // تحديث تدريجي: تقديم موعد الحدث التالي إذا كان الجدول المضاف/المعدل أقرب
+    void considerSchedule(const Schedule& s);
+    // مهمة الخط الزمني: تنفيذ الحدث المستحق (أو إعادة المزامنة) وجدولة الحدث التالي
+    void runTimeline();
+    // ضبط مدة النوم حتى الحدث التالي انطلاقاً من وقت RTC المقروء للتو
+    void armSleep(const DateTime& now);
+    // حساب مدة النوم من مرجع الوقت الحالي (_lastCheckedTime) حتى الحدث التالي وجدولة المهمة
+    void updateSleepDuration();
+    // تقدير الوقت الحالي من خدمة الوقت المشتركة دون حركة على ناقل I2C
+    DateTime estimatedNow();
 
-    // --- معالجات API لـ RTC (خاصة بـ ScheduleManager) ---
-    void handleGetTime(); // الحصول على الوقت
-    void handleSetTime(); // تعيين الوقت
 };
 
 #endif // SCHEDULE_MANAGER_H
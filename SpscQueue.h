@@ -0,0 +1,56 @@
+// SpscQueue.h
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+// طابور حلقي بلا أقفال لمنتج واحد ومستهلك واحد (كل طرف في مهمة أو نواة مختلفة)
+// المنتج وحده يكتب _head والمستهلك وحده يكتب _tail، وترتيب acquire/release يضمن
+// أن العنصر مكتوب بالكامل قبل أن يرى الطرف الآخر المؤشر الجديد.
+// لا يوجد مُنشئ: النسخ الساكنة تبدأ فارغة بالتهيئة الصفرية قبل تنفيذ أي مُنشئ عام.
+// N قوة للعدد 2، والسعة الفعلية N - 1 (خانة فارغة تميز الامتلاء عن الفراغ)
+template <typename T, uint16_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "سعة الطابور يجب أن تكون قوة للعدد 2");
+
+public:
+    // إضافة عنصر (المنتج فقط)، وتُرجع false إذا كان الطابور ممتلئاً
+    bool push(const T& item) {
+        uint16_t head = _head.load(std::memory_order_relaxed);
+        uint16_t next = (head + 1) & (N - 1);
+        if (next == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        _items[head] = item;
+        _head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // سحب أقدم عنصر (المستهلك فقط)، وتُرجع false إذا كان الطابور فارغاً
+    bool pop(T& item) {
+        uint16_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[tail];
+        _tail.store((tail + 1) & (N - 1), std::memory_order_release);
+        return true;
+    }
+
+    // عدد العناصر المنتظرة (تقريبي إذا قُرئ من طرف ثالث)
+    uint16_t size() const {
+        return (_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire)) & (N - 1);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    static constexpr uint16_t capacity() { return N - 1; }
+
+private:
+    T _items[N];
+    std::atomic<uint16_t> _head;
+    std::atomic<uint16_t> _tail;
+};
+
+#endif // SPSC_QUEUE_H
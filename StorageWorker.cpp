@@ -0,0 +1,283 @@
+// StorageWorker.cpp
+#include "StorageWorker.h"
+#include "EEPROM_Helper.h"
+
+// التنفيذ حسب المنصة: مهمة FreeRTOS على ESP32، أو std::thread على الحاسوب، وإلا بدون عامل
+#if defined(USE_STORAGE_WORKER) && defined(ESP32)
+#define STORAGE_WORKER_FREERTOS
+#elif defined(USE_STORAGE_WORKER) && !defined(ARDUINO)
+#define STORAGE_WORKER_THREAD
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+std::atomic<bool> StorageWorker::_running;
+SpscQueue<StorageRequest, STORAGE_QUEUE_DEPTH> StorageWorker::_requests;
+SpscQueue<StorageCompletion, STORAGE_QUEUE_DEPTH> StorageWorker::_completions;
+std::atomic<uint32_t> StorageWorker::_processed;
+uint16_t StorageWorker::_maxDepth = 0;
+uint32_t StorageWorker::_stalls = 0;
+
+#if defined(STORAGE_WORKER_FREERTOS)
+static TaskHandle_t workerTask = nullptr;   // مهمة العامل
+static TaskHandle_t producerTask = nullptr; // مهمة loop() التي بدأت العامل
+#elif defined(STORAGE_WORKER_THREAD)
+// كائنات المزامنة تُنشأ في begin() (لا كائنات عامة بمُنشئات في هذا الملف)
+struct StorageThreadState {
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool signaled = false;
+};
+static StorageThreadState* threadState = nullptr;
+#endif
+
+// بدء مهمة العامل
+bool StorageWorker::begin() {
+    if (_running) {
+        return true;
+    }
+#if defined(STORAGE_WORKER_FREERTOS)
+    producerTask = xTaskGetCurrentTaskHandle();
+    _running = true; // قبل إنشاء المهمة: حلقتها تتوقف عند false
+    if (xTaskCreatePinnedToCore([](void*) { run(); }, "storage", STORAGE_WORKER_STACK, nullptr,
+                                STORAGE_WORKER_PRIORITY, &workerTask, STORAGE_WORKER_CORE) != pdPASS) {
+        _running = false;
+        Serial.println("فشل إنشاء مهمة عامل التخزين، العمليات ستُنفذ مباشرة.");
+        return false;
+    }
+    Serial.print("تم تشغيل عامل التخزين على النواة "); Serial.println(STORAGE_WORKER_CORE);
+    return true;
+#elif defined(STORAGE_WORKER_THREAD)
+    threadState = new StorageThreadState();
+    _running = true;
+    threadState->thread = std::thread(run);
+    return true;
+#else
+    return false;
+#endif
+}
+
+// إفراغ الطابور وإيقاف العامل
+void StorageWorker::end() {
+    if (!_running || onWorker()) {
+        return;
+    }
+    flush();
+    poll();
+    _running = false;
+#if defined(STORAGE_WORKER_FREERTOS)
+    signalWorker();
+    while (workerTask != nullptr) { // تُصفره المهمة قبل حذف نفسها
+        vTaskDelay(1);
+    }
+#elif defined(STORAGE_WORKER_THREAD)
+    signalWorker();
+    threadState->thread.join();
+    delete threadState;
+    threadState = nullptr;
+#endif
+}
+
+// هل المستدعي هو مهمة العامل؟
+bool StorageWorker::onWorker() {
+#if defined(STORAGE_WORKER_FREERTOS)
+    return workerTask != nullptr && xTaskGetCurrentTaskHandle() == workerTask;
+#elif defined(STORAGE_WORKER_THREAD)
+    return threadState != nullptr && std::this_thread::get_id() == threadState->thread.get_id();
+#else
+    return false;
+#endif
+}
+
+// تنفيذ عمل في العامل والانتظار حتى ينتهي
+// أثناء الانتظار تُنفذ إشعارات الإكمال الواصلة، فلا يتوقف العامل على طابور إكمال ممتلئ
+void StorageWorker::call(StorageJob job, void* context) {
+    if (!offload()) {
+        job(context);
+        return;
+    }
+    std::atomic<bool> finished(false);
+    StorageRequest request;
+    request.kind = STORAGE_REQUEST_CALL;
+    request.job = job;
+    request.context = context;
+    request.done = nullptr;
+    request.doneContext = nullptr;
+    request.finished = &finished;
+    request.address = 0;
+    request.length = 0;
+    enqueue(request);
+    while (!finished.load(std::memory_order_acquire)) {
+        poll();
+        waitForWorker();
+    }
+}
+
+// تنفيذ عمل على نسخة من البيانات دون انتظار (post يضمن عند الترجمة أن size <= STORAGE_PAYLOAD_SIZE)
+void StorageWorker::postBytes(StorageJob job, const void* data, uint8_t size, StorageJob done, void* doneContext) {
+    if (!offload()) {
+        uint8_t copy[STORAGE_PAYLOAD_SIZE];
+        memcpy(copy, data, size);
+        job(copy);
+        if (done) {
+            done(doneContext);
+        }
+        return;
+    }
+    StorageRequest request;
+    request.kind = STORAGE_REQUEST_POST;
+    request.job = job;
+    request.context = nullptr;
+    request.done = done;
+    request.doneContext = doneContext;
+    request.finished = nullptr;
+    request.address = 0;
+    request.length = size;
+    memcpy(request.payload, data, size);
+    enqueue(request);
+}
+
+// كتابة بايتات في EEPROM دون انتظار
+void StorageWorker::write(uint16_t address, const uint8_t* data, int length, StorageJob done, void* doneContext) {
+    if (!offload()) {
+        EEPROMHelper::writeBytes(address, data, length);
+        if (done) {
+            done(doneContext);
+        }
+        return;
+    }
+    StorageRequest request;
+    request.kind = STORAGE_REQUEST_WRITE;
+    request.job = nullptr;
+    request.context = nullptr;
+    request.finished = nullptr;
+    int offset = 0;
+    do {
+        // حتى نهاية الصفحة الحالية: كل طلب دورة كتابة واحدة في العامل
+        int chunk = EXTERNAL_EEPROM_PAGE_SIZE - ((address + offset) % EXTERNAL_EEPROM_PAGE_SIZE);
+        if (chunk > length - offset) {
+            chunk = length - offset;
+        }
+        bool last = offset + chunk >= length;
+        request.done = last ? done : nullptr;
+        request.doneContext = last ? doneContext : nullptr;
+        request.address = address + offset;
+        request.length = chunk;
+        memcpy(request.payload, data + offset, chunk);
+        enqueue(request);
+        offset += chunk;
+    } while (offset < length);
+}
+
+// الانتظار حتى تُنفذ جميع الطلبات السابقة (طلب فارغ متزامن خلفها في الطابور)
+void StorageWorker::flush() {
+    call([](void*) {}, nullptr);
+}
+
+// تنفيذ إشعارات الإكمال الواصلة في نواة الويب
+void StorageWorker::poll() {
+    StorageCompletion completion;
+    while (_completions.pop(completion)) {
+        completion.done(completion.context);
+    }
+}
+
+// إضافة طلب إلى الطابور وإيقاظ العامل
+void StorageWorker::enqueue(const StorageRequest& request) {
+    while (!_requests.push(request)) {
+        _stalls++; // الطابور ممتلئ: العامل متأخر عن loop()
+        signalWorker();
+        poll();
+        waitForWorker();
+    }
+    uint16_t depth = _requests.size();
+    if (depth > _maxDepth) {
+        _maxDepth = depth;
+    }
+    signalWorker();
+}
+
+// حلقة العامل: تنفيذ الطلبات بالترتيب حتى end()
+void StorageWorker::run() {
+    StorageRequest request;
+    while (_running || !_requests.empty()) {
+        if (!_requests.pop(request)) {
+            waitForWork();
+            continue;
+        }
+        execute(request);
+    }
+#if defined(STORAGE_WORKER_FREERTOS)
+    workerTask = nullptr;
+    vTaskDelete(nullptr);
+#endif
+}
+
+// تنفيذ طلب واحد في العامل (عمليات EEPROMHelper هنا تُنفذ مباشرة لأن المستدعي هو العامل)
+void StorageWorker::execute(StorageRequest& request) {
+    switch (request.kind) {
+        case STORAGE_REQUEST_CALL:
+            request.job(request.context);
+            break;
+        case STORAGE_REQUEST_POST:
+            request.job(request.payload);
+            break;
+        case STORAGE_REQUEST_WRITE:
+            EEPROMHelper::writeBytes(request.address, request.payload, request.length);
+            break;
+    }
+    _processed.fetch_add(1, std::memory_order_relaxed);
+    if (request.finished != nullptr) {
+        request.finished->store(true, std::memory_order_release);
+        signalProducer();
+    }
+    if (request.done != nullptr) {
+        StorageCompletion completion = { request.done, request.doneContext };
+        while (!_completions.push(completion)) {
+            waitForWork(); // loop() تفرغ الإشعارات، وانتظار مؤقت يكفي هنا
+        }
+    }
+}
+
+// --- أدوات الانتظار حسب المنصة ---
+// إشعارات مهام FreeRTOS عدادات، فلا يضيع إيقاظ وصل قبل بدء الانتظار؛ والانتظار محدود بنبضة واحدة
+// في loop() لأن الإشعار قد يخص طلباً سابقاً
+void StorageWorker::signalWorker() {
+#if defined(STORAGE_WORKER_FREERTOS)
+    if (workerTask != nullptr) {
+        xTaskNotifyGive(workerTask);
+    }
+#elif defined(STORAGE_WORKER_THREAD)
+    {
+        std::lock_guard<std::mutex> lock(threadState->mutex);
+        threadState->signaled = true;
+    }
+    threadState->wake.notify_one();
+#endif
+}
+
+void StorageWorker::waitForWork() {
+#if defined(STORAGE_WORKER_FREERTOS)
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+#elif defined(STORAGE_WORKER_THREAD)
+    std::unique_lock<std::mutex> lock(threadState->mutex);
+    threadState->wake.wait_for(lock, std::chrono::milliseconds(10), [] { return threadState->signaled; });
+    threadState->signaled = false;
+#endif
+}
+
+void StorageWorker::signalProducer() {
+#if defined(STORAGE_WORKER_FREERTOS)
+    xTaskNotifyGive(producerTask);
+#endif
+}
+
+void StorageWorker::waitForWorker() {
+#if defined(STORAGE_WORKER_FREERTOS)
+    ulTaskNotifyTake(pdTRUE, 1);
+#elif defined(STORAGE_WORKER_THREAD)
+    std::this_thread::yield();
+#endif
+}
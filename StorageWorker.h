@@ -0,0 +1,102 @@
+// StorageWorker.h
+#ifndef STORAGE_WORKER_H
+#define STORAGE_WORKER_H
+
+#include "Config.h"
+#include "SpscQueue.h"
+
+// عمل يُنفذ في مهمة العامل، أو إشعار إكمال يُنفذ في نواة الويب
+typedef void (*StorageJob)(void* context);
+
+// أنواع الطلبات في الطابور
+#define STORAGE_REQUEST_CALL 0  // تنفيذ job(context) وإبلاغ المنتظر
+#define STORAGE_REQUEST_POST 1  // تنفيذ job(payload) دون انتظار
+#define STORAGE_REQUEST_WRITE 2 // كتابة payload في EEPROM عند address دون انتظار
+
+// طلب في طابور العامل (أنواع بسيطة تُنسخ كما هي)
+struct StorageRequest {
+    StorageJob job;                     // العمل المطلوب (غير مستخدم في الكتابة)
+    void* context;                      // معامل العمل في الطلب المتزامن
+    StorageJob done;                    // إشعار الإكمال في نواة الويب (اختياري)
+    void* doneContext;                  // معامل إشعار الإكمال
+    std::atomic<bool>* finished;        // يُضبط عند انتهاء الطلب المتزامن
+    uint16_t address;                   // عنوان الكتابة في EEPROM
+    uint8_t kind;                       // STORAGE_REQUEST_*
+    uint8_t length;                     // طول البيانات في payload
+    uint8_t payload[STORAGE_PAYLOAD_SIZE]; // نسخة من البيانات (لا تعتمد على ذاكرة المستدعي)
+};
+
+// إشعار إكمال عائد من العامل إلى نواة الويب
+struct StorageCompletion {
+    StorageJob done;
+    void* context;
+};
+
+// فئة مساعدة مشتركة لعامل التخزين: مع USE_STORAGE_WORKER على ESP32 تُنفذ جميع عمليات I2C و EEPROM
+// في مهمة FreeRTOS مثبتة على النواة STORAGE_WORKER_CORE، وتغذيها loop() عبر طابور بلا أقفال لمنتج
+// واحد ومستهلك واحد؛ والإشعارات تعود بطابور ثانٍ تفرغه handleClient(). الطابور بترتيب الوصول، فالقراءة
+// بعد كتابة لم تُنفذ بعد ترى البيانات الجديدة. على الحاسوب (بدون ARDUINO) يحل std::thread محل المهمة
+// لتجربة الطوابير تحت الضغط. بدون USE_STORAGE_WORKER، أو قبل begin()، أو من داخل العامل نفسه
+// تُنفذ كل العمليات مباشرة في المستدعي كما سابقاً.
+// المنتج الوحيد هو مهمة loop() (لا تُستدعى من المقاطعات ولا من مهام أخرى).
+class StorageWorker {
+public:
+    // بدء مهمة العامل (من setup()، بعد تهيئة Wire و EEPROM)، وتُرجع false إذا لم يُفعّل العامل
+    static bool begin();
+    // إفراغ الطابور وإيقاف العامل (العمليات التالية تعود مباشرة)
+    static void end();
+    // هل العامل يعمل؟
+    static bool active() { return _running.load(std::memory_order_acquire); }
+    // هل المستدعي هو مهمة العامل؟
+    static bool onWorker();
+    // هل يجب تحويل العملية إلى العامل؟ (يعمل، والمستدعي ليس العامل)
+    static bool offload() { return _running && !onWorker(); }
+
+    // تنفيذ job(context) في العامل والانتظار حتى ينتهي (للقراءات: لا تتداخل مع الكتابات المنتظرة)
+    static void call(StorageJob job, void* context);
+    // تنفيذ job على نسخة من data في العامل دون انتظار، ثم done(doneContext) في نواة الويب
+    // (حجم البيانات يُتحقق منه عند الترجمة: النسخة يجب أن تتسع في طلب واحد)
+    template <typename T>
+    static void post(StorageJob job, const T& data, StorageJob done = nullptr, void* doneContext = nullptr) {
+        static_assert(sizeof(T) <= STORAGE_PAYLOAD_SIZE, "StorageWorker::post: البيانات أكبر من STORAGE_PAYLOAD_SIZE");
+        postBytes(job, &data, sizeof(T), done, doneContext);
+    }
+    // كتابة بايتات في EEPROM دون انتظار (تُقسم عند حدود صفحات EEPROM، طلب واحد لكل صفحة)،
+    // ثم done(doneContext) في نواة الويب بعد آخر جزء
+    static void write(uint16_t address, const uint8_t* data, int length, StorageJob done = nullptr, void* doneContext = nullptr);
+    // الانتظار حتى تُنفذ جميع الطلبات السابقة (مثلاً قبل إعادة التشغيل)
+    static void flush();
+    // تنفيذ إشعارات الإكمال الواصلة (تُستدعى من handleClient)
+    static void poll();
+
+    // --- إحصائيات ---
+    static uint32_t processed() { return _processed.load(std::memory_order_relaxed); } // طلبات نفذها العامل
+    static uint16_t pending() { return _requests.size(); } // طلبات تنتظر التنفيذ
+    static uint16_t maxDepth() { return _maxDepth; }       // أعلى عدد طلبات منتظرة
+    static uint32_t stalls() { return _stalls; }           // مرات انتظار المنتج لامتلاء الطابور
+
+private:
+    static std::atomic<bool> _running;
+    static SpscQueue<StorageRequest, STORAGE_QUEUE_DEPTH> _requests;       // loop() ← المنتج، العامل ← المستهلك
+    static SpscQueue<StorageCompletion, STORAGE_QUEUE_DEPTH> _completions; // العامل ← المنتج، loop() ← المستهلك
+    static std::atomic<uint32_t> _processed;
+    static uint16_t _maxDepth;
+    static uint32_t _stalls;
+
+    // إضافة طلب إلى الطابور (مع الانتظار إذا كان ممتلئاً) وإيقاظ العامل
+    // تنفيذ post بعد التحقق من الحجم
+    static void postBytes(StorageJob job, const void* data, uint8_t size, StorageJob done, void* doneContext);
+    static void enqueue(const StorageRequest& request);
+    // حلقة العامل: سحب الطلبات وتنفيذها بالترتيب
+    static void run();
+    // تنفيذ طلب واحد في العامل
+    static void execute(StorageRequest& request);
+
+    // --- أدوات الانتظار حسب المنصة ---
+    static void signalWorker();   // إيقاظ العامل بعد إضافة طلب
+    static void waitForWork();    // نوم العامل حتى يصل طلب
+    static void signalProducer(); // إيقاظ loop() بعد إكمال طلب متزامن
+    static void waitForWorker();  // انتظار قصير في loop() حتى يتقدم العامل
+};
+
+#endif // STORAGE_WORKER_H
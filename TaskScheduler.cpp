@@ -0,0 +1,302 @@
+// TaskScheduler.cpp
+#include "TaskScheduler.h"
+
+// قيم حقل list للمهام خارج خانات العجلة
+#define TASK_LIST_NONE 0xFFFF
+#define TASK_LIST_READY 0xFFFE
+// قناع فهرس الخانة داخل المستوى
+#define TASK_WHEEL_MASK (TASK_WHEEL_SLOTS - 1)
+// أبعد موعد يمكن وضعه في العجلة مباشرة (بالنبضات)
+#define TASK_WHEEL_SPAN (1UL << (TASK_WHEEL_BITS * TASK_WHEEL_LEVELS))
+
+static_assert(TASK_WHEEL_BITS * TASK_WHEEL_LEVELS < 32, "مدى عجلة المهام يجب أن يكون أقل من 2^32 نبضة");
+static_assert(MAX_SCHEDULED_TASKS < TASK_NONE, "عدد المهام يجب أن يكون أقل من TASK_NONE");
+
+bool TaskScheduler::_started = false;
+ScheduledTask TaskScheduler::_tasks[MAX_SCHEDULED_TASKS];
+uint8_t TaskScheduler::_heads[TASK_WHEEL_LEVELS * TASK_WHEEL_SLOTS];
+uint64_t TaskScheduler::_occupied[TASK_WHEEL_LEVELS];
+uint8_t TaskScheduler::_readyHead = TASK_NONE;
+uint8_t TaskScheduler::_readyTail = TASK_NONE;
+uint32_t TaskScheduler::_tick = 0;
+unsigned long TaskScheduler::_tickMillis = 0;
+uint8_t TaskScheduler::_taskCount = 0;
+uint32_t TaskScheduler::_overruns = 0;
+uint32_t TaskScheduler::_maxServiceMicros = 0;
+uint32_t TaskScheduler::_maxLateness = 0;
+
+// تهيئة القوائم مرة واحدة (عند أول تسجيل)
+void TaskScheduler::begin() {
+    if (_started) {
+        return;
+    }
+    _started = true;
+    memset(_heads, TASK_NONE, sizeof(_heads));
+    memset(_occupied, 0, sizeof(_occupied));
+    for (uint8_t i = 0; i < MAX_SCHEDULED_TASKS; i++) {
+        _tasks[i].used = false;
+        _tasks[i].list = TASK_LIST_NONE;
+    }
+    _tick = 0;
+    _tickMillis = millis();
+}
+
+// تسجيل مهمة في أول خانة فارغة
+uint8_t TaskScheduler::add(TaskCallback callback, void* context, uint32_t delayMs, uint32_t periodMs) {
+    begin();
+    for (uint8_t i = 0; i < MAX_SCHEDULED_TASKS; i++) {
+        ScheduledTask& t = _tasks[i];
+        if (t.used) {
+            continue;
+        }
+        t.used = true;
+        t.callback = callback;
+        t.context = context;
+        t.period = periodMs > 0 ? toTicks(periodMs) : 0;
+        t.list = TASK_LIST_NONE;
+        _taskCount++;
+        schedule(i, delayMs);
+        return i;
+    }
+    Serial.println("جدول المهام ممتلئ: زد MAX_SCHEDULED_TASKS");
+    return TASK_NONE;
+}
+
+// تحديد موعد المهمة بعد delayMs من الآن
+void TaskScheduler::schedule(uint8_t task, uint32_t delayMs) {
+    if (task >= MAX_SCHEDULED_TASKS || !_tasks[task].used) {
+        return;
+    }
+    unlink(task);
+    if (delayMs == TASK_NO_DEADLINE) {
+        return;
+    }
+    _tasks[task].expires = currentTick() + toTicks(delayMs);
+    insert(task);
+}
+
+// تنفيذ المهمة في أول دورة قادمة
+void TaskScheduler::trigger(uint8_t task) {
+    if (task >= MAX_SCHEDULED_TASKS || !_tasks[task].used) {
+        return;
+    }
+    unlink(task);
+    _tasks[task].expires = _tick;
+    pushReady(task);
+}
+
+// إلغاء موعد المهمة
+void TaskScheduler::cancel(uint8_t task) {
+    if (task < MAX_SCHEDULED_TASKS && _tasks[task].used) {
+        unlink(task);
+    }
+}
+
+// حذف المهمة وتحرير خانتها
+void TaskScheduler::remove(uint8_t task) {
+    if (task < MAX_SCHEDULED_TASKS && _tasks[task].used) {
+        unlink(task);
+        _tasks[task].used = false;
+        _taskCount--;
+    }
+}
+
+// تقديم العجلة حتى الآن ثم تنفيذ المهام المستحقة بالترتيب حتى نفاد الميزانية
+// (مهمة واحدة على الأقل في كل دورة حتى لا تتوقف المهام الطويلة)
+void TaskScheduler::service() {
+    if (!_started) {
+        return;
+    }
+    unsigned long start = micros();
+    uint32_t elapsed = (millis() - _tickMillis) / TASK_TICK_MS;
+    _tickMillis += elapsed * TASK_TICK_MS;
+    advance(_tick + elapsed);
+
+    bool ran = false;
+    while (_readyHead != TASK_NONE) {
+        if (ran && micros() - start >= TASK_SERVICE_BUDGET_US) {
+            _overruns++; // بقية المستحقة في الدورة التالية
+            break;
+        }
+        uint8_t task = _readyHead;
+        unlink(task);
+        ScheduledTask& t = _tasks[task];
+        uint32_t late = _tick - t.expires;
+        if ((int32_t)late > 0 && late > _maxLateness) {
+            _maxLateness = late;
+        }
+        if (t.period > 0) {
+            // الموعد التالي من الموعد السابق (دون انزياح)، أو من الآن إذا فاتت دورة كاملة
+            t.expires += t.period;
+            if ((int32_t)(t.expires - _tick) <= 0) {
+                t.expires = _tick + t.period;
+            }
+            insert(task);
+        }
+        t.callback(t.context);
+        ran = true;
+    }
+    uint32_t spent = micros() - start;
+    if (spent > _maxServiceMicros) {
+        _maxServiceMicros = spent;
+    }
+}
+
+// المدة حتى أقرب موعد (مع احتساب الزمن المنقضي منذ آخر تقديم للعجلة)
+uint32_t TaskScheduler::nextDeadline() {
+    if (!_started) {
+        return TASK_NO_DEADLINE;
+    }
+    if (_readyHead != TASK_NONE) {
+        return 0;
+    }
+    uint32_t distance = nextOccupiedDistance();
+    if (distance == TASK_NO_DEADLINE) {
+        return TASK_NO_DEADLINE;
+    }
+    uint32_t lag = (millis() - _tickMillis) / TASK_TICK_MS;
+    return distance > lag ? (distance - lag) * TASK_TICK_MS : 0;
+}
+
+// النبضة الحالية حسب millis() دون تقديم العجلة
+uint32_t TaskScheduler::currentTick() {
+    return _tick + (millis() - _tickMillis) / TASK_TICK_MS;
+}
+
+// تحويل مدة إلى نبضات (للأعلى)، مقيدة بنصف مدى العداد حتى تبقى المقارنات بالفرق صحيحة
+uint32_t TaskScheduler::toTicks(uint32_t ms) {
+    uint32_t ticks = ms / TASK_TICK_MS + (ms % TASK_TICK_MS ? 1 : 0);
+    return ticks < 0x40000000UL ? ticks : 0x40000000UL;
+}
+
+// ربط مهمة بالخانة المناسبة: المستوى l يحمل المواعيد على بعد [2^(6l)، 2^(6(l+1))) نبضة،
+// والخانة هي بتات الموعد في ذلك المستوى؛ ما بعد مدى العجلة يوضع في أبعد خانة ويُعاد وضعه عند نقلها
+void TaskScheduler::insert(uint8_t task) {
+    ScheduledTask& t = _tasks[task];
+    uint32_t delta = t.expires - _tick;
+    if (delta == 0 || (int32_t)delta < 0) {
+        pushReady(task); // مستحقة الآن أو فات موعدها
+        return;
+    }
+    uint8_t level = 0;
+    while (level < TASK_WHEEL_LEVELS - 1 && delta >= (1UL << (TASK_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    uint32_t at = t.expires;
+    if (delta >= TASK_WHEEL_SPAN) {
+        at = _tick + TASK_WHEEL_SPAN - (1UL << (TASK_WHEEL_BITS * (TASK_WHEEL_LEVELS - 1)));
+    }
+    uint8_t slot = (at >> (TASK_WHEEL_BITS * level)) & TASK_WHEEL_MASK;
+    uint16_t list = level * TASK_WHEEL_SLOTS + slot;
+    t.prev = TASK_NONE;
+    t.next = _heads[list];
+    if (t.next != TASK_NONE) {
+        _tasks[t.next].prev = task;
+    }
+    _heads[list] = task;
+    t.list = list;
+    _occupied[level] |= 1ULL << slot;
+}
+
+// فك ربط مهمة من قائمتها الحالية (وتحديث خريطة الإشغال إذا فرغت الخانة)
+void TaskScheduler::unlink(uint8_t task) {
+    ScheduledTask& t = _tasks[task];
+    if (t.list == TASK_LIST_NONE) {
+        return;
+    }
+    if (t.next != TASK_NONE) {
+        _tasks[t.next].prev = t.prev;
+    }
+    if (t.list == TASK_LIST_READY) {
+        if (t.prev != TASK_NONE) {
+            _tasks[t.prev].next = t.next;
+        } else {
+            _readyHead = t.next;
+        }
+        if (t.next == TASK_NONE) {
+            _readyTail = t.prev;
+        }
+    } else {
+        if (t.prev != TASK_NONE) {
+            _tasks[t.prev].next = t.next;
+        } else {
+            _heads[t.list] = t.next;
+        }
+        if (_heads[t.list] == TASK_NONE) {
+            _occupied[t.list / TASK_WHEEL_SLOTS] &= ~(1ULL << (t.list % TASK_WHEEL_SLOTS));
+        }
+    }
+    t.list = TASK_LIST_NONE;
+}
+
+// إلحاق مهمة بنهاية طابور المستحقة
+void TaskScheduler::pushReady(uint8_t task) {
+    ScheduledTask& t = _tasks[task];
+    t.next = TASK_NONE;
+    t.prev = _readyTail;
+    if (_readyTail != TASK_NONE) {
+        _tasks[_readyTail].next = task;
+    } else {
+        _readyHead = task;
+    }
+    _readyTail = task;
+    t.list = TASK_LIST_READY;
+}
+
+// أقرب خانة مشغولة في كل مستوى: الخانات بعد الفهرس الحالي في هذه الدورة للمستوى،
+// وإلا أول خانة مشغولة في الدورة التالية
+uint32_t TaskScheduler::nextOccupiedDistance() {
+    uint32_t best = TASK_NO_DEADLINE;
+    for (uint8_t level = 0; level < TASK_WHEEL_LEVELS; level++) {
+        uint64_t occupied = _occupied[level];
+        if (occupied == 0) {
+            continue;
+        }
+        uint8_t shift = TASK_WHEEL_BITS * level;
+        uint8_t index = (_tick >> shift) & TASK_WHEEL_MASK;
+        uint64_t above = occupied & ~((2ULL << index) - 1);
+        uint32_t windowBase = _tick & ~((1UL << (shift + TASK_WHEEL_BITS)) - 1);
+        uint32_t at = above != 0 ? windowBase + ((uint32_t)__builtin_ctzll(above) << shift)
+                                 : windowBase + (1UL << (shift + TASK_WHEEL_BITS)) + ((uint32_t)__builtin_ctzll(occupied) << shift);
+        uint32_t distance = at - _tick;
+        if (distance < best) {
+            best = distance;
+        }
+    }
+    return best;
+}
+
+// تقديم العجلة بالقفز من خانة مشغولة إلى التالية (الخانات الفارغة بينهما لا تُلمس)
+// عند كل حد مستوى تُنقل مهام خانته إلى المستويات الأدنى (من الأعلى للأدنى)،
+// ثم تُنقل مهام خانة المستوى 0 إلى طابور المستحقة
+void TaskScheduler::advance(uint32_t target) {
+    while (_tick != target) {
+        uint32_t step = nextOccupiedDistance();
+        if (step > target - _tick) {
+            _tick = target; // لا توجد خانة مشغولة حتى الهدف
+            return;
+        }
+        _tick += step;
+        for (int8_t level = TASK_WHEEL_LEVELS - 1; level >= 0; level--) {
+            uint8_t shift = TASK_WHEEL_BITS * level;
+            if (level > 0 && (_tick & ((1UL << shift) - 1)) != 0) {
+                continue; // ليس حداً لهذا المستوى
+            }
+            uint8_t slot = (_tick >> shift) & TASK_WHEEL_MASK;
+            uint16_t list = level * TASK_WHEEL_SLOTS + slot;
+            uint8_t task = _heads[list];
+            _heads[list] = TASK_NONE;
+            _occupied[level] &= ~(1ULL << slot);
+            while (task != TASK_NONE) {
+                uint8_t next = _tasks[task].next;
+                _tasks[task].list = TASK_LIST_NONE;
+                if (level == 0) {
+                    pushReady(task);
+                } else {
+                    insert(task); // موعد أقرب الآن: مستوى أدنى أو طابور المستحقة
+                }
+                task = next;
+            }
+        }
+    }
+}
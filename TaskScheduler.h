@@ -0,0 +1,84 @@
+// TaskScheduler.h
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include "Config.h"
+
+// دالة مهمة: تستقبل السياق المسجل معها (عادة مؤشر المدير)
+typedef void (*TaskCallback)(void* context);
+
+// مهمة مسجلة في العجلة (أنواع بسيطة فقط، انظر ملاحظة التهيئة أدناه)
+struct ScheduledTask {
+    TaskCallback callback; // الدالة المنفذة عند الموعد
+    void* context;         // السياق الممرر للدالة
+    uint32_t expires;      // نبضة الموعد
+    uint32_t period;       // الدورة بالنبضات (0 = مرة واحدة)
+    uint16_t list;         // القائمة المرتبطة بها: خانة العجلة، أو TASK_LIST_READY، أو TASK_LIST_NONE
+    uint8_t next;          // المهمة التالية في نفس القائمة
+    uint8_t prev;          // المهمة السابقة في نفس القائمة
+    bool used;             // هل الخانة محجوزة لمهمة؟
+};
+
+// فئة مساعدة مشتركة لجدولة المهام: عجلة مؤقتات هرمية بـ TASK_WHEEL_LEVELS مستويات من 64 خانة
+// التسجيل والإلغاء وإعادة الجدولة بتكلفة ثابتة، وتقدم العجلة يقفز مباشرة إلى أقرب خانة مشغولة
+// (خرائط إشغال بت لكل مستوى)، فلا يعتمد العمل في كل دورة على عدد المؤقتات ولا على مدة الانقطاع.
+// المهام المستحقة تُنفذ ضمن ميزانية TASK_SERVICE_BUDGET_US، والباقي يُؤجل للدورة التالية ويُحسب تجاوزاً.
+// الحالة أنواع بسيطة لأن المديرين يسجلون مهامهم من مُنشئات كائنات عامة قد تُنفذ قبل تهيئة هذا الملف.
+class TaskScheduler {
+public:
+    // تسجيل مهمة تُنفذ بعد delayMs ثم كل periodMs (0 = مرة واحدة)، وتُرجع معرفها أو TASK_NONE
+    // المهمة بمدة TASK_NO_DEADLINE تبقى مسجلة دون موعد حتى schedule() أو trigger()
+    static uint8_t add(TaskCallback callback, void* context, uint32_t delayMs = TASK_NO_DEADLINE, uint32_t periodMs = 0);
+    // تحديد موعد المهمة بعد delayMs من الآن (يستبدل الموعد السابق)
+    static void schedule(uint8_t task, uint32_t delayMs);
+    // تنفيذ المهمة في أول دورة قادمة (مثلاً: عند مقاطعة)
+    static void trigger(uint8_t task);
+    // إلغاء موعد المهمة مع إبقائها مسجلة
+    static void cancel(uint8_t task);
+    // حذف المهمة وتحرير خانتها
+    static void remove(uint8_t task);
+    // تقديم العجلة حتى الوقت الحالي وتنفيذ المهام المستحقة (تُستدعى من handleClient)
+    static void service();
+    // المدة (ms) حتى أقرب موعد: 0 إذا وُجدت مهام مستحقة، و TASK_NO_DEADLINE إذا لم توجد مهام
+    // (حد أدنى: قد يكون موعد نقل مهام بين المستويات، وهذا يكفي للنوم بأمان)
+    static uint32_t nextDeadline();
+
+    // --- إحصائيات ---
+    static uint32_t overruns() { return _overruns; }               // دورات تجاوزت الميزانية وأجلت مهاماً
+    static uint32_t maxServiceMicros() { return _maxServiceMicros; } // أطول زمن لدورة واحدة
+    static uint32_t maxLatenessMs() { return _maxLateness * TASK_TICK_MS; } // أكبر تأخر لمهمة عن موعدها
+    static uint8_t taskCount() { return _taskCount; }              // عدد المهام المسجلة
+
+private:
+    static bool _started;
+    static ScheduledTask _tasks[MAX_SCHEDULED_TASKS];
+    static uint8_t _heads[TASK_WHEEL_LEVELS * TASK_WHEEL_SLOTS]; // أول مهمة في كل خانة
+    static uint64_t _occupied[TASK_WHEEL_LEVELS]; // خريطة الخانات غير الفارغة لكل مستوى
+    static uint8_t _readyHead;          // أول مهمة مستحقة (طابور)
+    static uint8_t _readyTail;          // آخر مهمة مستحقة
+    static uint32_t _tick;              // النبضة التي وصلت إليها العجلة
+    static unsigned long _tickMillis;   // millis() المقابلة لـ _tick
+    static uint8_t _taskCount;
+    static uint32_t _overruns;
+    static uint32_t _maxServiceMicros;
+    static uint32_t _maxLateness;
+
+    // تهيئة القوائم مرة واحدة
+    static void begin();
+    // النبضة الحالية حسب millis() دون تقديم العجلة
+    static uint32_t currentTick();
+    // تحويل مدة بالمللي ثانية إلى نبضات (للأعلى)
+    static uint32_t toTicks(uint32_t ms);
+    // ربط مهمة بقائمة حسب موعدها (خانة في العجلة أو طابور المستحقة)
+    static void insert(uint8_t task);
+    // فك ربط مهمة من قائمتها الحالية
+    static void unlink(uint8_t task);
+    // إلحاق مهمة بطابور المستحقة
+    static void pushReady(uint8_t task);
+    // المسافة بالنبضات من _tick حتى أقرب خانة مشغولة في أي مستوى (TASK_NO_DEADLINE إذا كانت العجلة فارغة)
+    static uint32_t nextOccupiedDistance();
+    // تقديم العجلة حتى النبضة target: نقل المهام بين المستويات ونقل المستحقة إلى الطابور
+    static void advance(uint32_t target);
+};
+
+#endif // TASK_SCHEDULER_H
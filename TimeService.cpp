@@ -0,0 +1,288 @@
+// TimeService.cpp
+#include "TimeService.h"
+#include "StorageWorker.h" // عمليات I2C في عامل التخزين عندما يعمل
+#if defined(ESP32) && defined(USE_RTC_LIGHT_SLEEP)
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#endif
+
+bool TimeService::_started = false;
+bool TimeService::_synced = false;
+uint32_t TimeService::_reference = 0;
+unsigned long TimeService::_referenceMillis = 0;
+unsigned long TimeService::_lastSyncMillis = 0;
+uint32_t TimeService::_driftBase = 0;
+unsigned long TimeService::_driftBaseMillis = 0;
+int32_t TimeService::_driftPpm = 0;
+uint32_t TimeService::_rtcReads = 0;
+int8_t TimeService::_interruptPin = -1;
+uint8_t TimeService::_pinMode = RTC_PIN_MODE_ALARM;
+uint32_t TimeService::_wakeTimes[TIME_WAKE_SLOTS];
+uint8_t TimeService::_firedMask = 0;
+uint8_t TimeService::_wakeTasks[TIME_WAKE_SLOTS] = { TASK_NONE, TASK_NONE };
+static_assert(TIME_WAKE_SLOTS == 2, "يجب تحديث القيم الأولية لـ _wakeTasks");
+TimeChangeListener* TimeService::_listeners[MAX_TIME_LISTENERS];
+uint8_t TimeService::_listenerCount = 0;
+
+// ساعة الوقت الحقيقي (نسخة واحدة تُنشأ عند أول استخدام)
+RTCManager& TimeService::rtc() {
+    static RTCManager instance;
+    return instance;
+}
+
+// تهيئة RTC مرة واحدة (بدلاً من rtc.begin() في كل مدير؛ الناقل يهيئه I2CBus)
+bool TimeService::begin() {
+    if (_started) {
+        return true;
+    }
+    if (!rtc().beginRTC()) {
+        Serial.println("فشل تهيئة RTC. يرجى التحقق من التوصيلات والبطارية.");
+        return false;
+    }
+    _started = true;
+    sync();
+    Serial.println("تم تهيئة خدمة الوقت المشتركة بنجاح.");
+    return true;
+}
+
+// الوقت الحالي دون قراءة RTC، إلا إذا مضت مدة إعادة المزامنة
+DateTime TimeService::now() {
+    unsigned long nowMillis = millis();
+    if (!_synced || nowMillis - _lastSyncMillis >= TIME_RESYNC_MS) {
+        return sync();
+    }
+    return estimateAt(nowMillis);
+}
+
+// قراءة RTC وتحديث المرجع
+// دقة RTC ثانية واحدة: إذا طابقت القراءة التقدير يبقى المرجع السابق (موضعه داخل الثانية أدق)،
+// وإلا يُنقل المرجع إلى القراءة. الفرق الكبير يعني أن الساعة تغيرت، فيُبلغ المشتركون.
+DateTime TimeService::sync() {
+    if (!_started && !begin()) {
+        return _synced ? estimateAt(millis()) : DateTime((uint32_t)0);
+    }
+    DateTime reading;
+    StorageWorker::call([](void* out) { *static_cast<DateTime*>(out) = rtc().now(); }, &reading);
+    _rtcReads++;
+    unsigned long nowMillis = millis();
+    _lastSyncMillis = nowMillis;
+    if (!_synced) {
+        anchor(reading, nowMillis, true);
+        return reading;
+    }
+
+    int32_t error = (reading - estimateAt(nowMillis)).totalseconds();
+    if (error > TIME_JUMP_SECONDS || error < -TIME_JUMP_SECONDS) {
+        Serial.print("تغيرت ساعة RTC بمقدار (ثانية): "); Serial.println(error);
+        anchor(reading, nowMillis, true);
+        notify(reading);
+        return reading;
+    }
+
+    // قياس الانحراف على فترة طويلة (دقة القراءة ثانية واحدة، أي حوالي 12 جزءاً من المليون خلال يوم)
+    unsigned long span = nowMillis - _driftBaseMillis;
+    if (span >= TIME_DRIFT_WINDOW_MS) {
+        int64_t rtcMillis = ((int64_t)reading.unixtime() - _driftBase) * 1000;
+        int32_t measured = (int32_t)((rtcMillis - (int64_t)span) * 1000000 / (int64_t)span);
+        if (measured > TIME_MAX_DRIFT_PPM || measured < -TIME_MAX_DRIFT_PPM) {
+            measured = _driftPpm; // قياس غير منطقي لبلورة، تجاهله
+        }
+        _driftPpm = _driftPpm == 0 ? measured : (3 * _driftPpm + measured) / 4; // تنعيم
+        _driftBase = reading.unixtime();
+        _driftBaseMillis = nowMillis;
+    }
+    if (error != 0 || nowMillis - _referenceMillis >= TIME_DRIFT_WINDOW_MS) {
+        anchor(reading, nowMillis, false);
+    }
+    return reading;
+}
+
+// ضبط RTC وإبلاغ جميع المشتركين (يبدأ قياس الانحراف من جديد)
+void TimeService::adjust(const DateTime& dateTime) {
+    begin();
+    // دون انتظار: القراءات التالية تمر بنفس الطابور بعد الضبط
+    StorageWorker::post([](void* when) { rtc().adjustRTC(*static_cast<DateTime*>(when)); }, dateTime);
+    unsigned long nowMillis = millis();
+    _lastSyncMillis = nowMillis;
+    anchor(dateTime, nowMillis, true);
+    notify(dateTime);
+}
+
+// توجيه دبوس INT/SQW إلى مقاطعة
+bool TimeService::attachInterruptPin(int pin, uint8_t mode) {
+    if (!begin()) {
+        return false;
+    }
+    struct PinArgs { int pin; uint8_t mode; bool ok; } args = { pin, mode, false };
+    StorageWorker::call([](void* context) {
+        PinArgs* args = static_cast<PinArgs*>(context);
+        args->ok = rtc().attachInterruptPin(args->pin, args->mode);
+    }, &args);
+    if (!args.ok) {
+        return false;
+    }
+    _interruptPin = pin;
+    _pinMode = mode;
+    memset(_wakeTimes, 0, sizeof(_wakeTimes));
+    Serial.print("تم توجيه مقاطعة RTC إلى الدبوس "); Serial.println(pin);
+    return true;
+}
+
+// طلب الاستيقاظ عند موعد (لا يُعاد برمجة التنبيه إذا لم يتغير الموعد)
+// في وضع التنبيه: المنفذ 0 يبرمج Alarm1 والمنفذ 1 يبرمج Alarm2 (بدقة الدقيقة، فيُقرب الموعد للأعلى)
+bool TimeService::armWake(uint8_t slot, const DateTime& when) {
+    if (_interruptPin < 0 || slot >= TIME_WAKE_SLOTS) {
+        return false;
+    }
+    DateTime target = when;
+    if (_pinMode == RTC_PIN_MODE_ALARM && slot == 1 && target.second() != 0) {
+        target = target + TimeSpan(60 - target.second());
+    }
+    if (_wakeTimes[slot] == target.unixtime()) {
+        return true;
+    }
+    _wakeTimes[slot] = target.unixtime();
+    _firedMask &= ~(1 << slot);
+    if (_pinMode == RTC_PIN_MODE_ALARM) {
+        // برمجة التنبيه دون انتظار (عدة معاملات I2C)
+        uint8_t alarm[1 + sizeof(uint32_t)] = { (uint8_t)(slot + 1) };
+        memcpy(alarm + 1, &_wakeTimes[slot], sizeof(uint32_t));
+        StorageWorker::post([](void* data) {
+            uint32_t when;
+            memcpy(&when, static_cast<uint8_t*>(data) + 1, sizeof(when));
+            rtc().setAlarm(*static_cast<uint8_t*>(data), DateTime(when));
+        }, alarm);
+    }
+    return true;
+}
+
+// هل حان موعد المنفذ؟
+bool TimeService::wakeFired(uint8_t slot) {
+    serviceInterrupt();
+    if (_firedMask & (1 << slot)) {
+        _firedMask &= ~(1 << slot);
+        return true;
+    }
+    return false;
+}
+
+// ربط مهمة بمنفذ
+void TimeService::bindWake(uint8_t slot, uint8_t task) {
+    if (slot < TIME_WAKE_SLOTS) {
+        _wakeTasks[slot] = task;
+    }
+}
+
+// معالجة مقاطعة معلقة (قراءة أعلام التنبيه تتم هنا، خارج سياق المقاطعة)
+void TimeService::poll() {
+    serviceInterrupt();
+}
+
+// تعليم منفذ بأنه حان موعده وتشغيل مهمته في الدورة الحالية لجدول المهام
+void TimeService::fire(uint8_t slot) {
+    _firedMask |= 1 << slot;
+    _wakeTimes[slot] = 0;
+    TaskScheduler::trigger(_wakeTasks[slot]);
+}
+
+// معالجة مقاطعة وصلت
+void TimeService::serviceInterrupt() {
+    unsigned long atMillis;
+    if (!RTCManager::takeInterrupt(atMillis)) {
+        return;
+    }
+    if (_pinMode == RTC_PIN_MODE_ALARM) {
+        uint8_t fired = 0;
+        StorageWorker::call([](void* mask) {
+            for (uint8_t slot = 0; slot < TIME_WAKE_SLOTS; slot++) {
+                if (rtc().alarmFired(slot + 1)) {
+                    rtc().clearAlarm(slot + 1); // تحرير الدبوس
+                    *static_cast<uint8_t*>(mask) |= 1 << slot;
+                }
+            }
+        }, &fired);
+        for (uint8_t slot = 0; slot < TIME_WAKE_SLOTS; slot++) {
+            if (fired & (1 << slot)) {
+                fire(slot);
+            }
+        }
+        return;
+    }
+    // وضع SQW: الحافة الهابطة تحدد بداية الثانية، فيُنقل المرجع إليها (أقرب ثانية للتقدير)
+    if (_synced) {
+        int64_t elapsed = (int64_t)(atMillis - _referenceMillis);
+        elapsed += elapsed * _driftPpm / 1000000;
+        uint32_t second = _reference + (uint32_t)((elapsed + 500) / 1000);
+        anchor(DateTime(second), atMillis, false);
+        for (uint8_t slot = 0; slot < TIME_WAKE_SLOTS; slot++) {
+            if (_wakeTimes[slot] != 0 && second >= _wakeTimes[slot]) {
+                fire(slot);
+            }
+        }
+    }
+}
+
+// انتظار المقاطعة التالية أو انتهاء المهلة (أو أقرب موعد في جدول المهام إن كان أقرب)
+// مع USE_RTC_LIGHT_SLEEP على ESP32 (وضع التنبيه فقط) يدخل المعالج النوم الخفيف حتى انخفاض دبوس التنبيه،
+// وإلا فالانتظار بـ delay(1) يسمح لمهمة الخمول بتوفير الطاقة تلقائياً
+void TimeService::idle(unsigned long maxMs) {
+    if (RTCManager::interruptPending() || _firedMask != 0) {
+        return;
+    }
+    uint32_t deadline = TaskScheduler::nextDeadline();
+    if (deadline < maxMs) {
+        maxMs = deadline;
+    }
+    if (maxMs == 0) {
+        return; // مهام مستحقة بالفعل
+    }
+#if defined(ESP32) && defined(USE_RTC_LIGHT_SLEEP)
+    if (_interruptPin >= 0 && _pinMode == RTC_PIN_MODE_ALARM) {
+        gpio_wakeup_enable((gpio_num_t)_interruptPin, GPIO_INTR_LOW_LEVEL);
+        esp_sleep_enable_gpio_wakeup();
+        esp_sleep_enable_timer_wakeup((uint64_t)maxMs * 1000ULL);
+        esp_light_sleep_start();
+        if (digitalRead(_interruptPin) == LOW) {
+            // الحافة حدثت أثناء النوم ولم يُستدعَ المعالج، والدبوس يبقى منخفضاً حتى مسح التنبيه
+            RTCManager::onInterrupt();
+        }
+        return;
+    }
+#endif
+    unsigned long start = millis();
+    while (!RTCManager::interruptPending() && millis() - start < maxMs) {
+        delay(1);
+    }
+}
+
+// تسجيل مشترك في إشعارات تغير الساعة
+void TimeService::subscribe(TimeChangeListener* listener) {
+    if (_listenerCount < MAX_TIME_LISTENERS) {
+        _listeners[_listenerCount++] = listener;
+    }
+}
+
+// الوقت المقدر: المرجع + الزمن المنقضي حسب millis() مصححاً بالانحراف المقاس
+DateTime TimeService::estimateAt(unsigned long nowMillis) {
+    int64_t elapsed = (int64_t)(nowMillis - _referenceMillis);
+    elapsed += elapsed * _driftPpm / 1000000;
+    return DateTime(_reference + (uint32_t)(elapsed / 1000));
+}
+
+// تعيين المرجع (وبداية فترة قياس الانحراف عند تغير الساعة)
+void TimeService::anchor(const DateTime& time, unsigned long nowMillis, bool resetDrift) {
+    _reference = time.unixtime();
+    _referenceMillis = nowMillis;
+    _synced = true;
+    if (resetDrift) {
+        _driftBase = time.unixtime();
+        _driftBaseMillis = nowMillis;
+    }
+}
+
+// إبلاغ جميع المشتركين بالوقت الجديد
+void TimeService::notify(const DateTime& time) {
+    for (uint8_t i = 0; i < _listenerCount; i++) {
+        _listeners[i]->onTimeChanged(time);
+    }
+}
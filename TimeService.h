@@ -0,0 +1,85 @@
+// TimeService.h
+#ifndef TIME_SERVICE_H
+#define TIME_SERVICE_H
+
+#include "Config.h"
+#include "RTCManager.h" // الوصول الفعلي إلى ساعة DS3231
+#include "TaskScheduler.h" // تشغيل مهمة المنفذ عند المقاطعة
+
+// واجهة لمشترك يحتاج إلى معرفة تغير الساعة (ضبط يدوي أو قفزة تكتشفها المزامنة)
+class TimeChangeListener {
+public:
+    // تُستدعى بعد تغير الساعة بالوقت الجديد
+    virtual void onTimeChanged(const DateTime& now) = 0;
+};
+
+// فئة مساعدة مشتركة للوقت: نسخة واحدة من RTCManager لجميع المديرين
+// تُقرأ RTC عند المزامنة فقط، ويُقدر الوقت بين القراءات من millis() مع تصحيح الانحراف المقاس،
+// فيكون now() عملية حسابية دون حركة على ناقل I2C.
+// الحالة أنواع بسيطة (ثوانٍ منذ 1970) لأن المديرين يستدعون begin() من مُنشئات كائنات عامة
+// قد تُنفذ قبل تهيئة المتغيرات الساكنة في هذا الملف.
+class TimeService {
+public:
+    // تهيئة RTC وقراءة الوقت مرة واحدة (الاستدعاءات التالية لا تفعل شيئاً)
+    static bool begin();
+    // الوقت الحالي المقدر من آخر مزامنة (يُزامن تلقائياً كل TIME_RESYNC_MS)
+    static DateTime now();
+    // قراءة RTC الآن وتحديث المرجع (للحظات التي تتطلب دقة الثانية، مثل حواف الجداول)
+    static DateTime sync();
+    // ضبط RTC وإبلاغ جميع المشتركين
+    static void adjust(const DateTime& dateTime);
+    // تسجيل مشترك في إشعارات تغير الساعة
+    static void subscribe(TimeChangeListener* listener);
+    // --- الاستيقاظ بمقاطعة DS3231 ---
+    // توجيه دبوس INT/SQW إلى مقاطعة (RTC_PIN_MODE_ALARM أو RTC_PIN_MODE_SQW)، يُستدعى من setup()
+    static bool attachInterruptPin(int pin, uint8_t mode = RTC_PIN_MODE_ALARM);
+    // طلب الاستيقاظ عند موعد لمنفذ TIME_WAKE_*، وتُرجع true إذا كانت المقاطعة ستوقظ المستدعي
+    // (وإلا يعتمد المستدعي على مدة نوم بـ millis() كما سابقاً)
+    static bool armWake(uint8_t slot, const DateTime& when);
+    // هل حان موعد المنفذ؟ (يُستهلك مرة واحدة، ولا حركة على I2C إلا بعد مقاطعة)
+    static bool wakeFired(uint8_t slot);
+    // ربط مهمة في جدول المهام بمنفذ: تُشغل فور وصول مقاطعة موعده
+    static void bindWake(uint8_t slot, uint8_t task);
+    // معالجة مقاطعة معلقة وتشغيل مهام المنافذ التي حان موعدها (تُستدعى من handleClient)
+    static void poll();
+    // انتظار المقاطعة التالية أو انتهاء المهلة (للاستدعاء في نهاية loop()، مثلاً بـ TaskScheduler::nextDeadline())
+    static void idle(unsigned long maxMs);
+
+    // انحراف millis() المقاس عن RTC بأجزاء من المليون (موجب = millis() أبطأ)
+    static int32_t driftPpm() { return _driftPpm; }
+    // عدد القراءات الفعلية لـ RTC منذ الإقلاع
+    static uint32_t rtcReads() { return _rtcReads; }
+
+private:
+    static bool _started;                     // هل تمت تهيئة RTC؟
+    static bool _synced;                      // هل يوجد مرجع زمني صالح؟
+    static uint32_t _reference;               // وقت RTC عند المرجع
+    static unsigned long _referenceMillis;    // millis() عند المرجع
+    static unsigned long _lastSyncMillis;     // millis() عند آخر قراءة لـ RTC
+    static uint32_t _driftBase;               // بداية فترة قياس الانحراف
+    static unsigned long _driftBaseMillis;    // millis() عند بداية فترة القياس
+    static int32_t _driftPpm;                 // الانحراف المقاس (0 حتى أول قياس)
+    static uint32_t _rtcReads;                // القراءات الفعلية لـ RTC
+    static int8_t _interruptPin;              // دبوس INT/SQW (-1 = بدون مقاطعة)
+    static uint8_t _pinMode;                  // RTC_PIN_MODE_*
+    static uint32_t _wakeTimes[TIME_WAKE_SLOTS]; // مواعيد الاستيقاظ المطلوبة (0 = لا يوجد)
+    static uint8_t _firedMask;                // المنافذ التي حان موعدها ولم تُستهلك
+    static uint8_t _wakeTasks[TIME_WAKE_SLOTS]; // مهمة كل منفذ (TASK_NONE = بدون)
+    static TimeChangeListener* _listeners[MAX_TIME_LISTENERS]; // المشتركون
+    static uint8_t _listenerCount;            // عدد المشتركين
+
+    // ساعة الوقت الحقيقي (نسخة واحدة تُنشأ عند أول استخدام)
+    static RTCManager& rtc();
+    // الوقت المقدر من المرجع عند قيمة millis() محددة
+    static DateTime estimateAt(unsigned long nowMillis);
+    // تعيين المرجع وبداية فترة قياس الانحراف
+    static void anchor(const DateTime& time, unsigned long nowMillis, bool resetDrift);
+    // معالجة مقاطعة وصلت: قراءة أعلام التنبيه، أو ضبط الطور عند نبضة SQW
+    static void serviceInterrupt();
+    // تعليم منفذ بأنه حان موعده وتشغيل مهمته
+    static void fire(uint8_t slot);
+    // إبلاغ جميع المشتركين بالوقت الجديد
+    static void notify(const DateTime& time);
+};
+
+#endif // TIME_SERVICE_H
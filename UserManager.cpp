@@ -3,7 +3,7 @@
 
 // المُنشئ (Constructor) لفئة UserManager
 #ifdef USE_EXTERNAL_EEPROM
-UserManager::UserManager(WebServer& serverRef, int relayPin)
+UserManager::UserManager(HttpServerRef serverRef, int relayPin)
     : MainControlClass(serverRef, relayPin) {
     // قراءة الحد الأقصى لعدد المستخدمين القابل للتكوين عند بدء التشغيل
     _maxConfigurableUsers = EEPROMHelper::readInt(MAX_NUM_OF_USERS_ADD);
@@ -18,7 +18,7 @@ UserManager::UserManager(WebServer& serverRef, int relayPin)
 #endif
 }
 #else
-UserManager::UserManager(WebServer& serverRef, int relayPin, EEPROMClass& eepromRef)
+UserManager::UserManager(HttpServerRef serverRef, int relayPin, EEPROMClass& eepromRef)
     : MainControlClass(serverRef, relayPin, eepromRef) {
     // قراءة الحد الأقصى لعدد المستخدمين القابل للتكوين عند بدء التشغيل
     _maxConfigurableUsers = EEPROMHelper::readInt(MAX_NUM_OF_USERS_ADD);
@@ -109,6 +109,8 @@ void UserManager::handleGenerateSSIDAndPASS() {
     uint64_t mac = ESP.getEfuseMac(); // الحصول على عنوان MAC 64 بت لـ ESP32
 #elif ESP8266
     uint32_t mac = ESP.getChipId();   // الحصول على معرف الشريحة 32 بت لـ ESP8266
+#else
+    uint64_t mac = ESP.getEfuseMac(); // البناء على الحاسوب: عنوان MAC ثابت من الطبقة البديلة
 #endif
 
     char macStr[13]; // مخزن مؤقت لسلسلة hex المكونة من 12 حرفاً + حرف النهاية
@@ -166,21 +168,66 @@ int UserManager::getUserTagCountFromEEPROM() {
 }
 
 // البحث عن فهرس علامة مستخدم معينة
-int UserManager::findUserTagIndex(const String& tag) {
+// المسح الكامل طلب واحد لعامل التخزين (إذا كان يعمل) بدلاً من ذهاب وإياب لكل علامة
+int UserManager::findUserTagIndex(const char* tag) {
+    struct TagScan { UserManager* self; const char* tag; int index; } scan = { this, tag, -1 };
+    StorageWorker::call([](void* context) {
+        TagScan* scan = static_cast<TagScan*>(context);
+        scan->index = scan->self->scanUserTags(scan->tag);
+    }, &scan);
+    return scan.index;
+}
+
+// مسح العلامات المخزنة بحثاً عن علامة (في المهمة المستدعية)
+// كل علامة تُقرأ بمعاملة واحدة إلى مخزن ثابت وتُقارن دون نسخها إلى String
+int UserManager::scanUserTags(const char* tag) {
+    size_t tagLength = strlen(tag);
     int userCount = getUserTagCountFromEEPROM();
     for (int i = 0; i < userCount; ++i) { 
         int currentTagAddr = USER_TAGS_START_ADDR + (i * USER_TAG_LEN);
-        String storedTag = readStringFromEEPROM(currentTagAddr, USER_TAG_LEN);
-        storedTag.trim(); // إزالة المسافات البيضاء
-        char firstChar = EEPROMHelper::readByte(currentTagAddr); // التحقق من أول بايت
-
-        if (storedTag == tag && !storedTag.isEmpty() && firstChar != 0xFF) {
+        char storedTag[USER_TAG_LEN];
+        EEPROMHelper::readBytes(currentTagAddr, (byte*)storedTag, USER_TAG_LEN);
+        if ((byte)storedTag[0] == 0xFF) {
+            continue; // خانة غير مهيأة
+        }
+        // النص حتى حرف النهاية دون المسافات البيضاء في طرفيه
+        size_t end = 0;
+        while (end < USER_TAG_LEN && storedTag[end] != 0) {
+            end++;
+        }
+        size_t start = 0;
+        while (start < end && isspace((unsigned char)storedTag[start])) {
+            start++;
+        }
+        while (end > start && isspace((unsigned char)storedTag[end - 1])) {
+            end--;
+        }
+        if (end > start && end - start == tagLength && memcmp(storedTag + start, tag, tagLength) == 0) {
             return i; // إرجاع الفهرس إذا تم العثور على العلامة
         }
     }
     return -1; // إرجاع -1 إذا لم يتم العثور على العلامة
 }
 
+// علامة الطلب محشوة بالأصفار البادئة حتى USER_TAG_LEN في مخزن ثابت (لمسارات البحث دون تخصيص String)
+// العلامة غير النصية تُؤخذ بتمثيلها في JSON كما في as<String>()؛ false (ونص فارغ) إذا تجاوزت USER_TAG_LEN فلا يمكن أن تطابق
+static bool padRequestTag(JsonVariant value, char paddedTag[USER_TAG_LEN + 1]) {
+    char text[USER_TAG_LEN + 2];
+    const char* tag = value.as<const char*>();
+    if (tag == nullptr) {
+        serializeJson(value, text, sizeof(text));
+        tag = text;
+    }
+    size_t length = strlen(tag);
+    if (length > USER_TAG_LEN) {
+        paddedTag[0] = '\0';
+        return false;
+    }
+    memset(paddedTag, '0', USER_TAG_LEN - length);
+    memcpy(paddedTag + USER_TAG_LEN - length, tag, length + 1);
+    return true;
+}
+
 // حفظ علامة مستخدم جديدة في EEPROM
 bool UserManager::storeTag(String tag) {
     // حشو بالأصفار البادئة إذا كانت العلامة أقصر من الطول المحدد
@@ -192,7 +239,7 @@ bool UserManager::storeTag(String tag) {
     Serial.print("علامة المستخدم المحشوة: ");
     Serial.println(paddedTag);
 
-    if (findUserTagIndex(paddedTag) != -1){
+    if (findUserTagIndex(paddedTag.c_str()) != -1){
         Serial.println("العلامة موجودة بالفعل");
         return false;
     }
@@ -296,7 +343,7 @@ void UserManager::handleAddUserTag() {
         Serial.print("علامة المستخدم للإضافة: ");
         Serial.println(paddedTag);
 
-        if (findUserTagIndex(paddedTag) != -1) {
+        if (findUserTagIndex(paddedTag.c_str()) != -1) {
             _server.send(409, "application/json", "{\"status\":\"error\",\"message\":\"العلامة موجودة بالفعل\"}");
             return;
         }
@@ -352,7 +399,7 @@ void UserManager::handleDeleteUserTag() {
         Serial.print("علامة المستخدم للحذف: ");
         Serial.println(paddedTag);
 
-        int index = findUserTagIndex(paddedTag);
+        int index = findUserTagIndex(paddedTag.c_str());
         if (index != -1) {
             shiftTagsAndDelete(index); // استخدام وظيفة المساعدة للحذف والإزاحة
             _server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"تم حذف علامة المستخدم بنجاح\"}");
@@ -378,17 +425,13 @@ void UserManager::handleCheckUserTag() {
             _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"JSON غير صالح\"}");
             return;
         }
-        String tag = doc["tag"].as<String>();
-        // حشو بالأصفار البادئة
-        String paddedTag = "";
-        for(int i = tag.length() ; i < USER_TAG_LEN ; i++){
-            paddedTag += "0";
-        }
-        paddedTag += tag;
+        // حشو بالأصفار البادئة (مخزن ثابت: مسار قارئ البطاقات لا يخصص من الكومة)
+        char paddedTag[USER_TAG_LEN + 1];
+        bool valid = padRequestTag(doc["tag"], paddedTag);
         Serial.print("علامة المستخدم للتحقق: ");
         Serial.println(paddedTag);
 
-        int index = findUserTagIndex(paddedTag);
+        int index = valid ? findUserTagIndex(paddedTag) : -1;
         if (index != -1) {
             _server.send(200, "application/json", "{\"status\":\"success\",\"found\":true,\"message\":\"تم العثور على علامة المستخدم\"}");
             Serial.print("تم العثور على علامة المستخدم: ");
@@ -438,24 +481,19 @@ void UserManager::handleUseUserTag() {
             _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"JSON غير صالح\"}");
             return;
         }
-        String tag = doc["tag"].as<String>();
-        // حشو بالأصفار البادئة
-        String paddedTag = "";
-        for(int i = tag.length() ; i < USER_TAG_LEN ; i++){
-            paddedTag += "0";
-        }
-        paddedTag += tag;
+        // حشو بالأصفار البادئة (مخزن ثابت: مسار قارئ البطاقات لا يخصص من الكومة)
+        char paddedTag[USER_TAG_LEN + 1];
+        bool valid = padRequestTag(doc["tag"], paddedTag);
         Serial.print("علامة المستخدم للاستخدام: ");
         Serial.println(paddedTag);
 
-        int index = findUserTagIndex(paddedTag);
+        int index = valid ? findUserTagIndex(paddedTag) : -1;
         if (index != -1) {
-            setRelayPhysicalState(true); // تشغيل المرحل
+            uint8_t channels = sourceChannels(RELAY_SOURCE_CARD);
+            requestRelayMask(RELAY_SOURCE_CARD, channels, channels); // نبضة تشغيل لقنوات البطاقة بمهلة مصدرها (5 ثوانٍ افتراضياً) دون delay()
             _server.send(200, "application/json", "{\"status\":\"success\",\"found\":true,\"message\":\"تم العثور على علامة المستخدم\"}");
             Serial.print("تم العثور على علامة المستخدم: ");
             Serial.println(paddedTag);
-            delay(5000); // تأخير 5 ثواني
-            setRelayPhysicalState(false); // إيقاف المرحل
 #ifdef ENABLE_USER_STATISTICS
             if (_statisticsEnabled) { // تحديث الإحصائيات فقط إذا كانت الميزة مفعلة
                 IncrementStatistics(index); // تحديث الإحصائيات لهذه العلامة
@@ -472,14 +510,6 @@ void UserManager::handleUseUserTag() {
     _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"جسم الطلب غير صالح. المتوقع {\\\"tag\\\":\\\"11_digits\\\"}\"}");
 }
 
-// --- وظائف إدارة إحصائيات المستخدمين ---
-
-#ifdef ENABLE_USER_STATISTICS
-// تحديث إحصائية مستخدم في فهرس معين بعدد معين
-void UserManager::UpdateStatistics(int index, int count){
-    EEPROMHelper::writeInt(index * sizeof(int) + STATISTICS_START_ADDR, count);
-}
-
 // معالج لحفظ الحد الأقصى لعدد المستخدمين
 void UserManager::handleSetUsersMaxNumber(){
     if (_server.hasArg("plain")) {
@@ -508,6 +538,19 @@ void UserManager::handleSetUsersMaxNumber(){
     _server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"جسم الطلب غير صالح. المتوقع {\"userNum\":number}\"}");
 }
 
+// معالج للحصول على الحد الأقصى لعدد المستخدمين
+void UserManager::handleGetUsersMaxNumber(){
+    _server.send(200, "application/json", "{\"status\":\"success\",\"userNum\":" + String(_maxConfigurableUsers) + ",\"max\":" + String(MAX_USER_TAGS) + "}");
+}
+
+// --- وظائف إدارة إحصائيات المستخدمين ---
+
+#ifdef ENABLE_USER_STATISTICS
+// تحديث إحصائية مستخدم في فهرس معين بعدد معين
+void UserManager::UpdateStatistics(int index, int count){
+    EEPROMHelper::writeInt(index * sizeof(int) + STATISTICS_START_ADDR, count);
+}
+
 // مسح إحصائية مستخدم في فهرس معين (تعيينها إلى 0)
 void UserManager::ClearStatisticsAtIndex(int index){
     EEPROMHelper::writeInt(index * sizeof(int) + STATISTICS_START_ADDR, 0); 
@@ -11,9 +11,9 @@ class UserManager : public MainControlClass {
 public:
     // المُنشئ (Constructor) لفئة UserManager
 #ifdef USE_EXTERNAL_EEPROM
-    UserManager(WebServer& serverRef, int relayPin);
+    UserManager(HttpServerRef serverRef, int relayPin);
 #else
-    UserManager(WebServer& serverRef, int relayPin, EEPROMClass& eepromRef);
+    UserManager(HttpServerRef serverRef, int relayPin, EEPROMClass& eepromRef);
 #endif
 
     // إعداد نقاط نهاية API المتعلقة بإدارة المستخدمين والإحصائيات
@@ -56,7 +56,8 @@ private:
     // --- وظائف إدارة علامات المستخدمين (البطاقات) في EEPROM ---
     void saveUserTagCountToEEPROM(int count);
     int getUserTagCountFromEEPROM();
-    int findUserTagIndex(const String& tag); // تم تغيير الاسم ليعكس إرجاع الفهرس
+    int findUserTagIndex(const char* tag); // تم تغيير الاسم ليعكس إرجاع الفهرس
+    int scanUserTags(const char* tag); // مسح العلامات المخزنة (يُنفذ في عامل التخزين عبر findUserTagIndex)
     bool storeTag(String tag); // حفظ علامة مستخدم جديدة
     void shiftTagsAndDelete(int indexToDelete); // وظيفة مساعدة لحذف العلامات وإزاحتها
 
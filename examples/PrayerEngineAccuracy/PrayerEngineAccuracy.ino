@@ -0,0 +1,92 @@
+// PrayerEngineAccuracy.ino
+// مقارنة محرك أوقات الصلاة الداخلي (PrayerCalc، دقة مفردة) مع مكتبة PrayerTimes الخارجية (دقة مضاعفة)
+// على شبكة من خطوط العرض والطول والتواريخ، ثم قياس زمن حساب يوم واحد بكل منهما.
+// النتيجة المتوقعة: جميع الفروق ضمن ±1 دقيقة.
+
+#include <PrayerCalc.h>
+#include <PrayerTimes.h>
+
+PrayerTimes reference; // التطبيق السابق للمقارنة
+
+// طرق الحساب المقابلة في مكتبة PrayerTimes (حسب ترتيب PRAYER_METHOD_*)
+const int REFERENCE_METHODS[PRAYER_METHOD_COUNT] = { Egyptian, MWL, ISNA, Makkah, Karachi };
+
+// حساب يوم بالمكتبة الخارجية بنفس طريقة الاستدعاء السابقة في المكتبة
+void referenceDay(const PrayerSettings& s, const DateTime& date, int minutes[PRAYER_COUNT]) {
+    reference.setCoordinates(s.latitude, s.longitude, s.timezone);
+    reference.setCalcMethod(REFERENCE_METHODS[s.method]);
+    reference.setHanafi(s.asrFactor == PRAYER_ASR_HANAFI);
+    reference.setAdjustments(0, 0, 0, 0, 0, 0);
+    int h[PRAYER_COUNT], m[PRAYER_COUNT];
+    reference.calculate(date.day(), date.month(), date.dayOfTheWeek(), date.year(),
+                        h[0], m[0], h[1], m[1], h[2], m[2], h[3], m[3], h[4], m[4], h[5], m[5]);
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        minutes[i] = h[i] * 60 + m[i];
+    }
+}
+
+void checkAccuracy() {
+    long samples = 0;
+    long outside = 0; // فروق أكبر من دقيقة
+    int worst = 0;
+    for (uint8_t method = 0; method < PRAYER_METHOD_COUNT; method++) {
+        for (uint8_t asr = PRAYER_ASR_SHAFII; asr <= PRAYER_ASR_HANAFI; asr++) {
+            for (int lat = -48; lat <= 60; lat += 12) {
+                for (int lon = -150; lon <= 180; lon += 30) {
+                    PrayerSettings s = { (double)lat, (double)lon, (int)lround(lon / 15.0), method, asr };
+                    for (int month = 1; month <= 12; month++) {
+                        for (int day = 1; day <= 28; day += 9) {
+                            DateTime date(2026, month, day);
+                            int native[PRAYER_COUNT], expected[PRAYER_COUNT];
+                            PrayerCalc::calculateDay(s, date, native);
+                            referenceDay(s, date, expected);
+                            for (int i = 0; i < PRAYER_COUNT; i++) {
+                                int diff = abs(native[i] - expected[i]);
+                                if (diff > 720) diff = 1440 - diff; // التفاف حول منتصف الليل
+                                if (diff > worst) worst = diff;
+                                if (diff > 1) outside++;
+                                samples++;
+                            }
+                        }
+                    }
+                    yield();
+                }
+            }
+        }
+    }
+    Serial.print("عدد العينات: "); Serial.println(samples);
+    Serial.print("أكبر فرق (دقائق): "); Serial.println(worst);
+    Serial.print("عينات خارج ±1 دقيقة: "); Serial.println(outside);
+}
+
+void benchmark() {
+    PrayerSettings s = { 30.0444, 31.2357, 2, PRAYER_METHOD_EGYPTIAN, PRAYER_ASR_SHAFII };
+    int minutes[PRAYER_COUNT];
+    const int days = 366;
+
+    unsigned long start = micros();
+    for (int d = 0; d < days; d++) {
+        PrayerCalc::calculateDay(s, DateTime(2026, 1, 1) + TimeSpan(d, 0, 0, 0), minutes);
+    }
+    unsigned long nativeMicros = micros() - start;
+
+    start = micros();
+    for (int d = 0; d < days; d++) {
+        referenceDay(s, DateTime(2026, 1, 1) + TimeSpan(d, 0, 0, 0), minutes);
+    }
+    unsigned long referenceMicros = micros() - start;
+
+    uint32_t mhz = ESP.getCpuFreqMHz();
+    Serial.print("المحرك الداخلي: دورات لكل يوم = "); Serial.println((uint32_t)(nativeMicros * mhz / days));
+    Serial.print("مكتبة PrayerTimes: دورات لكل يوم = "); Serial.println((uint32_t)(referenceMicros * mhz / days));
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+    checkAccuracy();
+    benchmark();
+}
+
+void loop() {
+}
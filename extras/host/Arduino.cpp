@@ -0,0 +1,191 @@
+// Arduino.cpp
+#include "Arduino.h"
+#include <stdarg.h>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <malloc.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+// --- الوقت ---
+
+unsigned long millis() {
+    return (unsigned long)(HostClock::micros() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)HostClock::micros();
+}
+
+// في وضع الوقت الحقيقي تنتظر فعلياً؛ وإلا تقدم الساعة الافتراضية فقط
+void delay(unsigned long ms) {
+    if (HostClock::realTime()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        HostClock::micros();
+        return;
+    }
+    HostClock::advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    if (HostClock::realTime()) {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+        HostClock::micros();
+        return;
+    }
+    HostClock::advance(us);
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+// --- الدبابيس ---
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    HostPins::mode(pin, mode);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    HostPins::write(pin, value);
+}
+
+int digitalRead(uint8_t pin) {
+    return HostPins::read(pin);
+}
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value) {
+    for (uint8_t i = 0; i < 8; i++) {
+        uint8_t bitValue = bitOrder == LSBFIRST ? (value >> i) & 1 : (value >> (7 - i)) & 1;
+        digitalWrite(dataPin, bitValue);
+        digitalWrite(clockPin, HIGH);
+        digitalWrite(clockPin, LOW);
+    }
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+    HostPins::attach(pin, isr, mode);
+}
+
+void detachInterrupt(uint8_t pin) {
+    HostPins::detach(pin);
+}
+
+// المقاطعات المحاكاة تُستدعى من مهمة تقدم الساعة، والمكتبة تحمي متغيراتها المشتركة بـ volatile
+void noInterrupts() {}
+void interrupts() {}
+
+// --- أرقام عشوائية ---
+
+static std::mt19937& generator() {
+    static std::mt19937 engine(0);
+    return engine;
+}
+
+long random(long howBig) {
+    if (howBig <= 0) {
+        return 0;
+    }
+    return (long)(generator()() % (unsigned long)howBig);
+}
+
+long random(long howSmall, long howBig) {
+    if (howSmall >= howBig) {
+        return howSmall;
+    }
+    return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) {
+    if (seed != 0) {
+        generator().seed((uint32_t)seed);
+    }
+}
+
+// --- الطباعة ---
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char small[128];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(small, sizeof(small), format, args);
+    va_end(args);
+    if (length < 0) {
+        return 0;
+    }
+    if ((size_t)length < sizeof(small)) {
+        return write((const uint8_t*)small, length);
+    }
+    String large;
+    large.resize(length + 1);
+    va_start(args, format);
+    vsnprintf(&large[0], length + 1, format, args);
+    va_end(args);
+    return write((const uint8_t*)large.c_str(), length);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    FILE* out = stream();
+    if (out != nullptr) {
+        fputc(c, out);
+    }
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    FILE* out = stream();
+    if (out != nullptr) {
+        fwrite(buffer, 1, size, out);
+    }
+    return size;
+}
+
+void HardwareSerial::flush() {
+    FILE* out = stream();
+    if (out != nullptr) {
+        fflush(out);
+    }
+}
+
+// --- الشريحة ---
+
+// حجم كومة ESP32 النموذجي بعد تشغيل WiFi
+#define HOST_HEAP_SIZE 327680UL
+
+void EspClass::restart() {
+    _restarts++;
+    Serial.println("[host] ESP.restart() (تجاهل: لا إعادة تشغيل على الحاسوب)");
+}
+
+uint32_t EspClass::getCycleCount() const {
+    return (uint32_t)(HostClock::micros() * getCpuFreqMHz());
+}
+
+uint32_t EspClass::getHeapSize() const {
+    return HOST_HEAP_SIZE;
+}
+
+uint32_t EspClass::getFreeHeap() {
+    struct mallinfo2 info = mallinfo2();
+    uint32_t used = info.uordblks > HOST_HEAP_SIZE ? HOST_HEAP_SIZE : (uint32_t)info.uordblks;
+    uint32_t free = HOST_HEAP_SIZE - used;
+    if (free < _minFreeHeap) {
+        _minFreeHeap = free;
+    }
+    return free;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    getFreeHeap();
+    return _minFreeHeap;
+}
@@ -0,0 +1,174 @@
+// Arduino.h
+// واجهة Arduino المستخدمة في المكتبة للبناء على الحاسوب (Linux):
+// الوقت من ساعة افتراضية (HostClock)، والدبابيس والمقاطعات محاكاة (HostPins)، والتخصيصات معدودة (HostHeap)،
+// و Serial يكتب إلى stdout. لا يُعرّف ARDUINO، فتختار ملفات المكتبة فروع الحاسوب (std::thread و epoll).
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include "WString.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define LSBFIRST 0
+#define MSBFIRST 1
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define bit(b) (1UL << (b))
+#define bitRead(value, b) (((value) >> (b)) & 0x01)
+#define bitSet(value, b) ((value) |= (1UL << (b)))
+#define bitClear(value, b) ((value) &= ~(1UL << (b)))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+using std::min;
+using std::max;
+
+// الذاكرة الومضية غير موجودة على الحاسوب
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+#define pgm_read_float(p) (*(const float*)(p))
+#define pgm_read_ptr(p) (*(void* const*)(p))
+#define IRAM_ATTR
+#define digitalPinToInterrupt(p) (p)
+class __FlashStringHelper;
+
+// --- الوقت (ساعة افتراضية: delay تقدمها دون انتظار فعلي) ---
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// --- الدبابيس والمقاطعات ---
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value);
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+void noInterrupts();
+void interrupts();
+
+// --- أرقام عشوائية (قابلة للتكرار بـ randomSeed) ---
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+
+// --- الطباعة ---
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write(text.c_str(), text.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC) { return print(String(value, (unsigned char)base)); }
+    size_t print(unsigned long value, int base = DEC) { return print(String(value, (unsigned char)base)); }
+    size_t print(long long value, int base = DEC) { return print(String(value, (unsigned char)base)); }
+    size_t print(unsigned long long value, int base = DEC) { return print(String(value, (unsigned char)base)); }
+    size_t print(double value, int digits = 2) { return print(String(value, (unsigned int)digits)); }
+    size_t print(const Printable& value) { return value.printTo(*this); }
+
+    size_t println() { return write("\r\n"); }
+    template<typename T> size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    template<typename T> size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    virtual void flush() {}
+};
+
+// المنفذ التسلسلي: يكتب إلى stdout، أو إلى ملف آخر، أو لا شيء (setOutput(nullptr) لقياس الأداء)
+class HardwareSerial : public Print {
+public:
+    HardwareSerial() : _output(nullptr), _outputSet(false) {}
+    void begin(unsigned long) {}
+    void end() {}
+    int available() { return 0; }
+    int read() { return -1; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    void flush() override;
+    operator bool() const { return true; }
+    void setOutput(FILE* output) { _output = output; _outputSet = true; }
+
+private:
+    FILE* _output;
+    bool _outputSet; // قبل setOutput يُكتب إلى stdout
+    FILE* stream() const { return _outputSet ? _output : stdout; }
+};
+extern HardwareSerial Serial;
+
+// --- الشريحة (واجهة ESP32) ---
+class EspClass {
+public:
+    // لا إعادة تشغيل على الحاسوب: تُعد الطلبات فقط (restartCount) ويكمل البرنامج
+    void restart();
+    uint32_t restartCount() const { return _restarts; }
+    uint64_t getEfuseMac() const { return 0x0000A4CF12F8D6E0ULL; }
+    uint32_t getChipId() const { return 0x00F8D6E0; }
+    uint32_t getCpuFreqMHz() const { return 240; }
+    uint32_t getCycleCount() const;
+    // الكومة: حجم ثابت بحجم كومة ESP32 ناقصاً ما خصصه البرنامج (mallinfo2)
+    uint32_t getHeapSize() const;
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap() { return getFreeHeap(); }
+
+private:
+    uint32_t _restarts = 0;
+    uint32_t _minFreeHeap = 0xFFFFFFFF;
+};
+extern EspClass ESP;
+
+#include "HostClock.h"
+#include "HostPins.h"
+#include "HostHeap.h"
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,43 @@
+// EEPROM.cpp
+#include "EEPROM.h"
+
+EEPROMClass EEPROM;
+
+bool EEPROMClass::begin(size_t size) {
+    if (size == 0) {
+        return false;
+    }
+    _data.resize(size, 0xFF);
+    return true;
+}
+
+uint8_t EEPROMClass::read(int address) {
+    return address >= 0 && (size_t)address < _data.size() ? _data[address] : 0;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+    if (address >= 0 && (size_t)address < _data.size()) {
+        _data[address] = value;
+    }
+}
+
+bool EEPROMClass::commit() {
+    _commits++;
+    return !_data.empty();
+}
+
+size_t EEPROMClass::readBytes(int address, void* value, size_t maxLength) {
+    if (value == nullptr || address < 0 || (size_t)address + maxLength > _data.size()) {
+        return 0;
+    }
+    memcpy(value, &_data[address], maxLength);
+    return maxLength;
+}
+
+size_t EEPROMClass::writeBytes(int address, const void* value, size_t length) {
+    if (value == nullptr || address < 0 || (size_t)address + length > _data.size()) {
+        return 0;
+    }
+    memcpy(&_data[address], value, length);
+    return length;
+}
@@ -0,0 +1,41 @@
+// EEPROM.h
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include "Arduino.h"
+#include <vector>
+
+// EEPROM الداخلية كما في ESP32 (ذاكرة مؤقتة تُحفظ بـ commit). تُستخدم عندما لا يُعرّف USE_EXTERNAL_EEPROM.
+// commits() يعد مرات الحفظ (كل commit على الشريحة يمسح قطاعاً كاملاً في الذاكرة الومضية).
+class EEPROMClass {
+public:
+    EEPROMClass() : _commits(0) {}
+
+    bool begin(size_t size);
+    void end() {}
+    uint8_t read(int address);
+    void write(int address, uint8_t value);
+    bool commit();
+    size_t readBytes(int address, void* value, size_t maxLength);
+    size_t writeBytes(int address, const void* value, size_t length);
+    size_t length() const { return _data.size(); }
+
+    template<typename T> T& get(int address, T& value) {
+        readBytes(address, &value, sizeof(T));
+        return value;
+    }
+    template<typename T> const T& put(int address, const T& value) {
+        writeBytes(address, &value, sizeof(T));
+        return value;
+    }
+
+    uint32_t commits() const { return _commits; }
+
+private:
+    std::vector<uint8_t> _data;
+    uint32_t _commits;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // HOST_EEPROM_H
@@ -0,0 +1,399 @@
+// HostBench.cpp
+// قياس المسارات الساخنة للمكتبة على الحاسوب مع نموذج توقيت لناقل I2C وذاكرة 24C256:
+// البحث عن علامة (موجودة وغير موجودة)، storeTag، shiftTagsAndDelete، checkSchedules خلال يوم كامل،
+// حساب أوقات الصلاة، ومعالجات القوائم. لكل عملية: زمن الحاسوب ودوراته (عداد TSC على x86، وإلا 0)،
+// والزمن المحاكى على الناقل (يشمل انتظار دورات الكتابة)، ومعاملات I2C، والبايتات المنقولة، ودورات كتابة EEPROM،
+// وتخصيصات الكومة من HostHeap (تشمل بناء الطلب والرد داخل العملية؛ المعالج وحده في سطر route من /api/metrics).
+// كل نموذج توقيت يُشغل في عملية فرعية مستقلة، فتبدأ المديرات والذاكرة من حالة نظيفة.
+//
+// الاستخدام: smartcontrol_bench [--clock 100000,400000] [--write-cycle-us 5000]
+//                               [--users 10,100,300,10000] [--schedules 10,100,256] [--csv]
+
+#include "UserManager.h"
+#include "ScheduleManager.h"
+#include "PrayerTimesManager.h"
+#include "PrayerCalc.h"
+#include "PrayerReference.h"
+#include "I2CBus.h"
+#include "Sim24C256.h"
+#include "SimDS3231.h"
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// دبوس المحاكاة الموصول بمخرج INT/SQW في DS3231 (نفس الخادم على الحاسوب)
+#define BENCH_RTC_INTERRUPT_PIN 4
+// أقصى عدد عينات لعملية واحدة (البحث موزع على مواضع القائمة)
+#define BENCH_MAX_SAMPLES 32
+// أساس العلامات المستخدمة في القياس (11 رقماً)، والعلامات غير الموجودة بعدها
+#define BENCH_TAG_BASE 10000000000ULL
+#define BENCH_MISSING_TAG_BASE 19000000000ULL
+
+struct BenchOptions {
+    std::vector<long> clocks = {100000, 400000};
+    long writeCycleUs = SIM_24C256_WRITE_CYCLE_US;
+    std::vector<long> users = {10, 100, 300, 10000};
+    std::vector<long> schedules = {10, 100, MAX_SCHEDULES};
+    bool csv = false;
+};
+
+// لقطة من العدادات؛ الفرق بين لقطتين هو كلفة العملية
+struct BenchSample {
+    uint64_t hostNs;
+    uint64_t cycles;
+    uint64_t simUs;
+    uint64_t transactions;
+    uint64_t bytes;
+    uint64_t writeCycles;
+    uint64_t allocations;
+
+    BenchSample& operator+=(const BenchSample& other) {
+        hostNs += other.hostNs;
+        cycles += other.cycles;
+        simUs += other.simUs;
+        transactions += other.transactions;
+        bytes += other.bytes;
+        writeCycles += other.writeCycles;
+        allocations += other.allocations;
+        return *this;
+    }
+};
+
+// وقت الانتظار في حلقة اليوم المحاكى، يُستبعد من الزمن المحاكى (يبقى زمن المعالجة والناقل فقط)
+static uint64_t idleUs = 0;
+
+// دورات المعالج على الحاسوب (TSC بالتردد الاسمي)؛ 0 إذا لم يتوفر عداد
+static uint64_t cycleCounter() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static BenchSample snapshot() {
+    BenchSample s = {};
+    s.hostNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    s.cycles = cycleCounter();
+    s.simUs = HostClock::micros() - idleUs;
+    for (uint8_t device = 0; device < I2C_DEVICE_COUNT; device++) {
+        s.transactions += I2CBus::stats(device).transactions;
+        s.bytes += I2CBus::stats(device).bytes;
+    }
+    s.writeCycles = HostI2C::eeprom().writeCycles();
+    s.allocations = HostHeap::allocations();
+    return s;
+}
+
+static BenchSample difference(const BenchSample& start, const BenchSample& end) {
+    BenchSample d;
+    d.hostNs = end.hostNs - start.hostNs;
+    d.cycles = end.cycles - start.cycles;
+    d.simUs = end.simUs - start.simUs;
+    d.transactions = end.transactions - start.transactions;
+    d.bytes = end.bytes - start.bytes;
+    d.writeCycles = end.writeCycles - start.writeCycles;
+    d.allocations = (uint32_t)(end.allocations - start.allocations); // العداد 32 بت ويلتف
+    return d;
+}
+
+static BenchOptions options;
+static WebServer* benchServer = nullptr;
+static UserManager* benchUsersManager = nullptr; // handleClient() يشغل جدول المهام المشترك
+static uint32_t failures = 0;
+
+// طلب إلى المعالج مباشرة؛ أي رمز غير متوقع يُطبع ويُحسب فشلاً
+static HostHttpResponse call(HTTPMethod method, const String& uri, const String& body = "", int expected = 200) {
+    HostHttpResponse response = benchServer->request(method, uri, body);
+    if (response.code != expected) {
+        failures++;
+        fprintf(stderr, "bench: %s -> %d %s\n", uri.c_str(), response.code, response.body.c_str());
+    }
+    return response;
+}
+
+static String tagBody(uint64_t tag) {
+    char text[24];
+    snprintf(text, sizeof(text), "{\"tag\":\"%011llu\"}", (unsigned long long)tag);
+    return String(text);
+}
+
+static void printHeader(long clock) {
+    if (options.csv) {
+        return;
+    }
+    printf("\n# I2C %ld kHz, EEPROM write cycle %ld us\n", clock / 1000, options.writeCycleUs);
+    printf("%-34s %6s %6s %11s %11s %11s %9s %9s %8s %9s\n", "operation", "n", "ops", "host us/op", "cycles/op",
+           "sim us/op", "i2c tx/op", "bytes/op", "wc/op", "allocs/op");
+}
+
+static void report(long clock, const char* name, long n, uint32_t ops, const BenchSample& total) {
+    double count = ops > 0 ? ops : 1;
+    if (options.csv) {
+        printf("%ld,%ld,%s,%ld,%u,%.3f,%.0f,%.1f,%.2f,%.1f,%.2f,%.1f\n", clock, options.writeCycleUs, name, n, ops,
+               total.hostNs / 1000.0 / count, total.cycles / count, total.simUs / count, total.transactions / count, total.bytes / count,
+               total.writeCycles / count, total.allocations / count);
+        return;
+    }
+    printf("%-34s %6ld %6u %11.3f %11.0f %11.1f %9.2f %9.1f %8.2f %9.1f\n", name, n, ops,
+           total.hostNs / 1000.0 / count, total.cycles / count, total.simUs / count, total.transactions / count, total.bytes / count, total.writeCycles / count,
+           total.allocations / count);
+}
+
+static void skip(const char* name, long n, const char* reason) {
+    if (options.csv) {
+        return;
+    }
+    printf("%-34s %6ld   (skipped: %s)\n", name, n, reason);
+}
+
+// تنفيذ العملية ops مرة وقياس كل مرة؛ cleanup (إن وجدت) تعيد الحالة بعد كل مرة خارج القياس
+static void measure(long clock, const char* name, long n, uint32_t ops, const std::function<void(uint32_t)>& body,
+                    const std::function<void(uint32_t)>& cleanup = nullptr) {
+    BenchSample total = {};
+    for (uint32_t i = 0; i < ops; i++) {
+        BenchSample start = snapshot();
+        body(i);
+        total += difference(start, snapshot());
+        if (cleanup) {
+            cleanup(i);
+        }
+    }
+    report(clock, name, n, ops, total);
+}
+
+// --- علامات المستخدمين ---
+
+static void benchUsers(long clock) {
+    call(HTTP_POST, "/api/users/delete_all_tags");
+    // ترتيب العلامات كما في الذاكرة (الإضافة في النهاية، والحذف يزيح ما بعدها)
+    std::vector<uint64_t> order;
+    for (long n : options.users) {
+        if (n > MAX_USER_TAGS) {
+            // القائمة محدودة بـ MAX_USER_TAGS، وعلامات أكثر لا تتسع في 24C256 بالتخطيط الحالي
+            skip("users.*", n, "exceeds MAX_USER_TAGS");
+            continue;
+        }
+        while ((long)order.size() < n) {
+            order.push_back(BENCH_TAG_BASE + order.size());
+            call(HTTP_POST, "/api/users/add_tag", tagBody(order.back()));
+        }
+        uint32_t samples = n < BENCH_MAX_SAMPLES ? (uint32_t)n : BENCH_MAX_SAMPLES;
+
+        // مواضع موزعة على القائمة (البحث الخطي يتناسب مع الموضع)
+        measure(clock, "users.check_tag (hit)", n, samples, [&](uint32_t i) {
+            call(HTTP_POST, "/api/users/check_tag", tagBody(order[(size_t)i * n / samples]));
+        });
+        measure(clock, "users.check_tag (miss)", n, samples, [&](uint32_t i) {
+            call(HTTP_POST, "/api/users/check_tag", tagBody(BENCH_MISSING_TAG_BASE + i));
+        });
+        if (n < MAX_USER_TAGS) {
+            // storeTag في نهاية القائمة، ثم حذفها (آخر علامة: بلا إزاحة) خارج القياس
+            measure(clock, "users.add_tag (storeTag)", n, 4, [&](uint32_t i) {
+                call(HTTP_POST, "/api/users/add_tag", tagBody(BENCH_MISSING_TAG_BASE + i));
+            }, [&](uint32_t i) {
+                call(HTTP_POST, "/api/users/delete_tag", tagBody(BENCH_MISSING_TAG_BASE + i));
+            });
+        } else {
+            skip("users.add_tag (storeTag)", n, "list full");
+        }
+        // حذف أول علامة (أسوأ إزاحة في shiftTagsAndDelete)، ثم إعادتها في النهاية خارج القياس
+        measure(clock, "users.delete_tag (shift first)", n, 4, [&](uint32_t) {
+            call(HTTP_POST, "/api/users/delete_tag", tagBody(order.front()));
+        }, [&](uint32_t) {
+            uint64_t tag = order.front();
+            order.erase(order.begin());
+            order.push_back(tag);
+            call(HTTP_POST, "/api/users/add_tag", tagBody(tag));
+        });
+        measure(clock, "users.get_tags", n, 4, [&](uint32_t) { call(HTTP_GET, "/api/users/get_tags"); });
+    }
+}
+
+// --- الجداول الزمنية ---
+
+// محاكاة يوم كامل بحلقة الجهاز: الانتظار حتى أقرب موعد في TaskScheduler (أو ثانية على الأكثر)
+static void runDay() {
+    uint64_t end = HostClock::micros() + 86400ULL * 1000000ULL;
+    while (HostClock::micros() < end) {
+        benchUsersManager->handleClient();
+        uint64_t remainingMs = (end - HostClock::micros()) / 1000;
+        uint32_t wait = TaskScheduler::nextDeadline();
+        if (wait > 1000) {
+            wait = 1000;
+        }
+        if (wait > remainingMs) {
+            wait = (uint32_t)remainingMs;
+        }
+        uint64_t before = HostClock::micros();
+        delay(wait > 0 ? wait : 1);
+        idleUs += HostClock::micros() - before;
+    }
+}
+
+static void benchSchedules(long clock) {
+    // خط الأساس: يوم بلا جداول (مهام المزامنة والصلاة فقط)
+    measure(clock, "schedules.day (baseline)", 0, 1, [&](uint32_t) { runDay(); });
+
+    long count = 0;
+    for (long n : options.schedules) {
+        if (n > MAX_SCHEDULES) {
+            skip("schedules.*", n, "exceeds MAX_SCHEDULES");
+            continue;
+        }
+        uint32_t added = (uint32_t)(n - count);
+        // مواعيد موزعة على اليوم بالتناوب بين التشغيل والإيقاف
+        measure(clock, "schedules.add", n, added, [&](uint32_t) {
+            long minuteOfDay = (count * 1440L) / n;
+            String body = "{\"hour\":" + String(minuteOfDay / 60) + ",\"minute\":" + String(minuteOfDay % 60) +
+                          ",\"turnOn\":" + String(count % 2 == 0 ? "true" : "false") + ",\"repeatEveryDay\":true}";
+            call(HTTP_POST, "/api/schedules/add", body);
+            count++;
+        });
+
+        // كلفة checkSchedules لكل حدث: اليوم كاملاً مقسوماً على عدد المواعيد
+        uint32_t relayWrites = HostPins::writes(RELAY_PIN);
+        measure(clock, "schedules.day (checkSchedules/evt)", n, (uint32_t)n, [&](uint32_t i) {
+            if (i == 0) {
+                runDay();
+            }
+        });
+        if (HostPins::writes(RELAY_PIN) == relayWrites) {
+            failures++;
+            fprintf(stderr, "bench: no relay writes during the simulated day with %ld schedules\n", n);
+        }
+        measure(clock, "schedules.get_all", n, 4, [&](uint32_t) { call(HTTP_GET, "/api/schedules/get_all"); });
+    }
+
+    for (uint32_t i = 0; i < MAX_SCHEDULE_EXCEPTIONS / 4; i++) {
+        char body[96];
+        snprintf(body, sizeof(body), "{\"from\":\"2027-%02u-%02u\",\"to\":\"2027-%02u-%02u\",\"kind\":\"suppress\"}",
+                 i / 8 + 1, i % 8 * 3 + 1, i / 8 + 1, i % 8 * 3 + 2);
+        call(HTTP_POST, "/api/schedules/exceptions/add", String(body));
+    }
+    measure(clock, "schedules.exceptions.get_all", MAX_SCHEDULE_EXCEPTIONS / 4, 4,
+            [&](uint32_t) { call(HTTP_GET, "/api/schedules/exceptions/get_all"); });
+}
+
+// --- أوقات الصلاة ---
+
+static void benchPrayer(long clock) {
+    PrayerSettings settings = {30.0444, 31.2357, 2, PRAYER_METHOD_EGYPTIAN, PRAYER_ASR_SHAFII};
+    int minutes[PRAYER_COUNT];
+    volatile int sink = 0;
+    DateTime first(2026, 1, 1, 0, 0, 0);
+    // دورات لكل يوم محسوب: المحرك (float) والمرجع بدقة مضاعفة (المحرك السابق كان double)
+    measure(clock, "prayer.calculateDay", 1, 366, [&](uint32_t day) {
+        PrayerCalc::calculateDay(settings, first + TimeSpan((int32_t)day, 0, 0, 0), minutes);
+        sink = sink + minutes[PRAYER_COUNT - 1];
+    });
+    measure(clock, "prayer.calculateDay (double ref)", 1, 366, [&](uint32_t day) {
+        PrayerReference::calculateDay(settings, first + TimeSpan((int32_t)day, 0, 0, 0), minutes);
+        sink = sink + minutes[PRAYER_COUNT - 1];
+    });
+    PrayerDayIterator iterator(settings, first);
+    measure(clock, "prayer.PrayerDayIterator", 1, 366, [&](uint32_t) {
+        iterator.next(minutes);
+        sink = sink + minutes[PRAYER_COUNT - 1];
+    });
+
+    measure(clock, "prayer.get_times", 1, 4, [&](uint32_t) { call(HTTP_GET, "/api/prayer/get_times"); });
+    measure(clock, "prayer.get_calendar (month)", 31, 4,
+            [&](uint32_t) { call(HTTP_GET, "/api/prayer/get_calendar?year=2026&month=3"); });
+    measure(clock, "prayer.get_calendar (year)", 365, 2,
+            [&](uint32_t) { call(HTTP_GET, "/api/prayer/get_calendar?year=2026"); });
+}
+
+// تشغيل كامل بنموذج توقيت واحد (في عملية فرعية)
+static int runModel(long clock) {
+    Serial.setOutput(nullptr);
+    HostI2C::setMaxClock((uint32_t)clock);
+    HostI2C::eeprom().setWriteCycle((uint32_t)options.writeCycleUs);
+    // ضبط الساعة قبل المديرات حتى لا يُرى فقدان الطاقة (OSF)
+    HostI2C::rtc().setTime(DateTime(2026, 1, 1, 0, 0, 0).unixtime());
+    HostI2C::rtc().connectInterrupt(BENCH_RTC_INTERRUPT_PIN);
+
+    static WebServer web(80);
+    static UserManager users(web, RELAY_PIN);
+    static ScheduleManagerClass schedules(web, RELAY_PIN);
+    static PrayerTimesManagementClass prayers(web, RELAY_PIN);
+    benchServer = &web;
+    benchUsersManager = &users;
+
+    users.beginAPAndWebServer("Smart Timer", "sM@rt123");
+    users.setupUserEndpoints();
+    schedules.setupScheduleEndpoints();
+    prayers.setupPrayerEndpoints();
+    TimeService::attachInterruptPin(BENCH_RTC_INTERRUPT_PIN);
+
+    printHeader(clock);
+    benchUsers(clock);
+    benchSchedules(clock);
+    benchPrayer(clock);
+    fflush(stdout);
+    return failures == 0 ? 0 : 1;
+}
+
+static std::vector<long> parseList(const char* text) {
+    std::vector<long> values;
+    for (const char* p = text; *p != '\0';) {
+        char* end = nullptr;
+        long value = strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        values.push_back(value);
+        p = *end == ',' ? end + 1 : end;
+    }
+    return values;
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : "";
+        if (arg == "--csv") {
+            options.csv = true;
+        } else if (arg == "--clock") {
+            options.clocks = parseList(value);
+            i++;
+        } else if (arg == "--write-cycle-us") {
+            options.writeCycleUs = strtol(value, nullptr, 10);
+            i++;
+        } else if (arg == "--users") {
+            options.users = parseList(value);
+            i++;
+        } else if (arg == "--schedules") {
+            options.schedules = parseList(value);
+            i++;
+        } else {
+            fprintf(stderr, "usage: %s [--clock HZ[,HZ]] [--write-cycle-us US] [--users N,...] [--schedules N,...] [--csv]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    if (options.csv) {
+        printf("clock_hz,write_cycle_us,operation,n,ops,host_us_per_op,cycles_per_op,sim_us_per_op,i2c_tx_per_op,bytes_per_op,"
+               "write_cycles_per_op,allocs_per_op\n");
+    }
+    fflush(stdout);
+    int status = 0;
+    for (long clock : options.clocks) {
+        pid_t child = fork();
+        if (child == 0) {
+            _exit(runModel(clock));
+        }
+        int result = 1;
+        if (child < 0 || waitpid(child, &result, 0) < 0 || !WIFEXITED(result) || WEXITSTATUS(result) != 0) {
+            status = 1;
+        }
+    }
+    return status;
+}
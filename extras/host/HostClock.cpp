@@ -0,0 +1,90 @@
+// HostClock.cpp
+#include "HostClock.h"
+#include <chrono>
+#include <thread>
+
+std::atomic<uint64_t> HostClock::_now(0);
+bool HostClock::_realTime = false;
+HostTimer* HostClock::_timers[HOST_MAX_TIMERS];
+uint8_t HostClock::_timerCount = 0;
+
+// التقدم متسلسل بين المهام، ومتكرر لأن المقاطعات داخل الأحداث تقرأ الوقت
+std::recursive_mutex& HostClock::mutex() {
+    static std::recursive_mutex instance;
+    return instance;
+}
+
+static thread_local bool advancing = false;
+
+uint64_t HostClock::micros() {
+    if (_realTime && !advancing) {
+        advanceTo(wallMicros());
+    }
+    return _now.load();
+}
+
+void HostClock::advance(uint64_t us) {
+    advanceTo(_now.load() + us);
+}
+
+// تنفيذ أحداث الأجهزة بالترتيب حتى الهدف، والساعة عند وقت كل حدث أثناء تنفيذه
+void HostClock::advanceTo(uint64_t target) {
+    std::lock_guard<std::recursive_mutex> lock(mutex());
+    if (advancing) {
+        // من داخل حدث: لا تداخل في التقدم، يكمله المستدعي الأول
+        if (target > _now.load()) {
+            _now.store(target);
+        }
+        return;
+    }
+    advancing = true;
+    for (uint32_t guard = 0; guard < 10000000UL; guard++) {
+        HostTimer* next = nullptr;
+        uint64_t when = HOST_NO_EVENT;
+        for (uint8_t i = 0; i < _timerCount; i++) {
+            uint64_t event = _timers[i]->nextEvent();
+            if (event < when) {
+                when = event;
+                next = _timers[i];
+            }
+        }
+        if (next == nullptr || when > target) {
+            break;
+        }
+        if (when > _now.load()) {
+            _now.store(when);
+        }
+        next->onEvent(_now.load());
+    }
+    if (target > _now.load()) {
+        _now.store(target);
+    }
+    advancing = false;
+}
+
+void HostClock::setRealTime(bool enabled) {
+    _realTime = enabled;
+}
+
+void HostClock::addTimer(HostTimer* timer) {
+    std::lock_guard<std::recursive_mutex> lock(mutex());
+    if (_timerCount < HOST_MAX_TIMERS) {
+        _timers[_timerCount++] = timer;
+    }
+}
+
+void HostClock::removeTimer(HostTimer* timer) {
+    std::lock_guard<std::recursive_mutex> lock(mutex());
+    for (uint8_t i = 0; i < _timerCount; i++) {
+        if (_timers[i] == timer) {
+            _timers[i] = _timers[--_timerCount];
+            return;
+        }
+    }
+}
+
+// الوقت الفعلي منذ أول استدعاء (أساس الساعة في وضع الوقت الحقيقي)
+uint64_t HostClock::wallMicros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
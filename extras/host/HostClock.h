@@ -0,0 +1,54 @@
+// HostClock.h
+#ifndef HOST_CLOCK_H
+#define HOST_CLOCK_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+
+// لا يوجد حدث قادم
+#define HOST_NO_EVENT UINT64_MAX
+// أقصى عدد أجهزة محاكاة لها أحداث على الساعة
+#define HOST_MAX_TIMERS 8
+
+// جهاز محاكاة له أحداث في وقت محدد (مثل حافة SQW أو تنبيه DS3231)
+class HostTimer {
+public:
+    virtual ~HostTimer() {}
+    // وقت الحدث القادم بالميكروثانية على الساعة الافتراضية (HOST_NO_EVENT إذا لا يوجد)
+    virtual uint64_t nextEvent() = 0;
+    // تنفيذ الحدث (الساعة متوقفة عند وقته، فـ millis() داخل المقاطعات تُرجع وقت الحافة نفسه)
+    virtual void onEvent(uint64_t now) = 0;
+};
+
+// الساعة الافتراضية خلف millis()/micros()/delay():
+// الوقت لا يتقدم إلا بـ delay أو advance، فالاختبارات والقياسات قابلة للتكرار ولا تنتظر فعلياً،
+// والأحداث تُنفذ بالترتيب عند أوقاتها أثناء التقدم. setRealTime(true) تجعلها تتبع الساعة الفعلية
+// (للخادم على الحاسوب، حيث تقيس مهلات الاتصالات وقتاً حقيقياً).
+class HostClock {
+public:
+    // الوقت الحالي بالميكروثانية منذ بدء البرنامج
+    static uint64_t micros();
+    // تقديم الساعة مع تنفيذ الأحداث المستحقة
+    static void advance(uint64_t us);
+    static void advanceTo(uint64_t target);
+    // تتبع الساعة الفعلية (delay تنتظر فعلياً أيضاً)
+    static void setRealTime(bool enabled);
+    static bool realTime() { return _realTime; }
+
+    // تسجيل جهاز له أحداث
+    static void addTimer(HostTimer* timer);
+    static void removeTimer(HostTimer* timer);
+    // قفل الساعة: التقدم وأحداث الأجهزة تحته، وتأخذه الأجهزة المحاكاة عند وصول المتحكم إليها من مهمة أخرى
+    static std::recursive_mutex& mutex();
+
+private:
+    static std::atomic<uint64_t> _now; // يُقرأ من مهمة عامل التخزين أيضاً
+    static bool _realTime;
+    static HostTimer* _timers[HOST_MAX_TIMERS];
+    static uint8_t _timerCount;
+
+    static uint64_t wallMicros();
+};
+
+#endif // HOST_CLOCK_H
@@ -0,0 +1,61 @@
+// HostHeap.cpp
+#include "HostHeap.h"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+static std::atomic<uint32_t> allocationCount(0);
+static std::atomic<uint32_t> allocatedBytes(0);
+
+uint32_t HostHeap::allocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+uint32_t HostHeap::bytes() {
+    return allocatedBytes.load(std::memory_order_relaxed);
+}
+
+void HostHeap::count(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add((uint32_t)size, std::memory_order_relaxed);
+}
+
+// --- استبدال operator new/delete (يُربط هذا الملف لأن Metrics يستخدم عداداته) ---
+
+void* operator new(size_t size) {
+    HostHeap::count(size);
+    void* pointer = malloc(size ? size : 1);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    HostHeap::count(size);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    free(pointer);
+}
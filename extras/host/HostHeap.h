@@ -0,0 +1,22 @@
+// HostHeap.h
+#ifndef HOST_HEAP_H
+#define HOST_HEAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// خطاف عد التخصيصات على الحاسوب: operator new/new[] مستبدلة تعد كل تخصيص وحجمه
+// (String و std::function والحاويات تمر بها)، فيقيس Metrics والاختبارات ما يخصصه مسار ساخن.
+// العدادات ذرية لأن عامل التخزين يعمل في خيط آخر.
+#define HOST_HEAP_HOOK
+
+class HostHeap {
+public:
+    // العدادات التراكمية منذ بدء البرنامج
+    static uint32_t allocations();
+    static uint32_t bytes();
+    // يُستدعى من operator new
+    static void count(size_t size);
+};
+
+#endif // HOST_HEAP_H
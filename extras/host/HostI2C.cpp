@@ -0,0 +1,39 @@
+// HostI2C.cpp
+#include "HostI2C.h"
+#include "Sim24C256.h"
+#include "SimDS3231.h"
+
+HostI2CDevice* HostI2C::_devices[128];
+bool HostI2C::_installed = false;
+uint32_t HostI2C::_maxClock = 0;
+
+void HostI2C::attach(uint8_t address, HostI2CDevice* device) {
+    installDefaults();
+    if (address < 128) {
+        _devices[address] = device;
+    }
+}
+
+HostI2CDevice* HostI2C::device(uint8_t address) {
+    installDefaults();
+    return address < 128 ? _devices[address] : nullptr;
+}
+
+Sim24C256& HostI2C::eeprom() {
+    static Sim24C256 instance;
+    return instance;
+}
+
+SimDS3231& HostI2C::rtc() {
+    static SimDS3231 instance;
+    return instance;
+}
+
+void HostI2C::installDefaults() {
+    if (_installed) {
+        return;
+    }
+    _installed = true;
+    _devices[HOST_EEPROM_I2C_ADDR] = &eeprom();
+    _devices[HOST_RTC_I2C_ADDR] = &rtc();
+}
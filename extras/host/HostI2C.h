@@ -0,0 +1,49 @@
+// HostI2C.h
+#ifndef HOST_I2C_H
+#define HOST_I2C_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// العناوين الافتراضية للأجهزة المحاكاة (نفس EXTERNAL_EEPROM_ADDR و DS3231_I2C_ADDR في Config.h)
+#define HOST_EEPROM_I2C_ADDR 0x50
+#define HOST_RTC_I2C_ADDR 0x68
+
+class Sim24C256;
+class SimDS3231;
+
+// جهاز على ناقل I2C المحاكى (يستدعيه TwoWire عند نهاية كل معاملة)
+class HostI2CDevice {
+public:
+    virtual ~HostI2CDevice() {}
+    // كتابة من المتحكم (length = 0 لفحص الوجود):
+    // 0 نجاح، 2 لم يُقَر بالعنوان (الجهاز مشغول)، 3 لم يُقَر بالبيانات (نفس رموز endTransmission)
+    virtual uint8_t receive(const uint8_t* data, size_t length) = 0;
+    // قراءة إلى المتحكم: عدد البايتات المرسلة، 0 إذا لم يُقَر بالعنوان
+    virtual size_t transmit(uint8_t* buffer, size_t length) = 0;
+};
+
+// سجل الأجهزة على الناقل. عند أول استخدام تُركّب ذاكرة 24C256 وساعة DS3231 على عنوانيهما،
+// ويمكن استبدال أي منهما أو إضافة أجهزة أخرى بـ attach (أو فصله بتمرير nullptr).
+class HostI2C {
+public:
+    static void attach(uint8_t address, HostI2CDevice* device);
+    static HostI2CDevice* device(uint8_t address);
+
+    // الجهازان الافتراضيان (لتحميل صورة الذاكرة، أو ضبط الساعة وقراءة مخرج INT في الاختبارات)
+    static Sim24C256& eeprom();
+    static SimDS3231& rtc();
+
+    // نموذج توقيت الناقل: أقصى سرعة فعلية (0 = كما يطلبها setClock)، لمحاكاة ناقل طويل أو مقاومات سحب ضعيفة
+    static void setMaxClock(uint32_t hz) { _maxClock = hz; }
+    static uint32_t maxClock() { return _maxClock; }
+
+private:
+    static HostI2CDevice* _devices[128];
+    static bool _installed;
+    static uint32_t _maxClock;
+
+    static void installDefaults();
+};
+
+#endif // HOST_I2C_H
@@ -0,0 +1,79 @@
+// HostPins.cpp
+#include "Arduino.h"
+
+uint8_t HostPins::_mode[HOST_PIN_COUNT];
+uint8_t HostPins::_output[HOST_PIN_COUNT];
+uint8_t HostPins::_input[HOST_PIN_COUNT];
+bool HostPins::_driven[HOST_PIN_COUNT];
+uint32_t HostPins::_writes[HOST_PIN_COUNT];
+void (*HostPins::_isr[HOST_PIN_COUNT])();
+uint8_t HostPins::_isrMode[HOST_PIN_COUNT];
+
+void HostPins::mode(uint8_t pin, uint8_t mode) {
+    if (pin >= HOST_PIN_COUNT) {
+        return;
+    }
+    _mode[pin] = mode;
+    if (!_driven[pin]) {
+        setInput(pin, mode == INPUT_PULLUP ? HIGH : LOW);
+    }
+}
+
+void HostPins::write(uint8_t pin, uint8_t level) {
+    if (pin >= HOST_PIN_COUNT) {
+        return;
+    }
+    _output[pin] = level ? HIGH : LOW;
+    _writes[pin]++;
+}
+
+// المخرج يُقرأ بقيمته المكتوبة، والدخل بمستواه الحالي
+int HostPins::read(uint8_t pin) {
+    if (pin >= HOST_PIN_COUNT) {
+        return LOW;
+    }
+    return _mode[pin] == OUTPUT ? _output[pin] : _input[pin];
+}
+
+void HostPins::drive(uint8_t pin, uint8_t level) {
+    if (pin >= HOST_PIN_COUNT) {
+        return;
+    }
+    _driven[pin] = true;
+    setInput(pin, level ? HIGH : LOW);
+}
+
+// تحرير الدبوس (مثل خرج مفتوح المصرف): يعود لمستوى مقاومة السحب
+void HostPins::release(uint8_t pin) {
+    if (pin >= HOST_PIN_COUNT) {
+        return;
+    }
+    _driven[pin] = false;
+    setInput(pin, _mode[pin] == INPUT_PULLUP ? HIGH : LOW);
+}
+
+void HostPins::attach(uint8_t pin, void (*isr)(), int mode) {
+    if (pin >= HOST_PIN_COUNT) {
+        return;
+    }
+    _isr[pin] = isr;
+    _isrMode[pin] = (uint8_t)mode;
+}
+
+void HostPins::detach(uint8_t pin) {
+    if (pin < HOST_PIN_COUNT) {
+        _isr[pin] = nullptr;
+    }
+}
+
+void HostPins::setInput(uint8_t pin, uint8_t level) {
+    uint8_t previous = _input[pin];
+    _input[pin] = level;
+    if (_isr[pin] == nullptr || previous == level) {
+        return;
+    }
+    bool rising = level == HIGH;
+    if (_isrMode[pin] == CHANGE || (_isrMode[pin] == RISING && rising) || (_isrMode[pin] == FALLING && !rising)) {
+        _isr[pin]();
+    }
+}
@@ -0,0 +1,42 @@
+// HostPins.h
+#ifndef HOST_PINS_H
+#define HOST_PINS_H
+
+#include <stdint.h>
+
+// عدد الدبابيس المحاكاة (أرقام GPIO في ESP32 أقل من 40)
+#define HOST_PIN_COUNT 64
+
+// الدبابيس المحاكاة خلف pinMode/digitalWrite/digitalRead/attachInterrupt:
+// المخارج تحفظ آخر قيمة وعدد الكتابات (للتحقق من المرحل)، والمداخل يقودها جهاز محاكاة
+// (مثل خرج INT في DS3231) بـ drive()، فتُستدعى المقاطعة المرتبطة عند الحافة المطابقة.
+class HostPins {
+public:
+    static void mode(uint8_t pin, uint8_t mode);
+    static void write(uint8_t pin, uint8_t level);
+    static int read(uint8_t pin);
+    // قيادة دبوس دخل من الخارج (مستوى منخفض أو مرتفع، أو تحريره ليعود لمستوى السحب)
+    static void drive(uint8_t pin, uint8_t level);
+    static void release(uint8_t pin);
+
+    static void attach(uint8_t pin, void (*isr)(), int mode);
+    static void detach(uint8_t pin);
+
+    // آخر قيمة مكتوبة على مخرج، وعدد الكتابات عليه
+    static uint8_t output(uint8_t pin) { return pin < HOST_PIN_COUNT ? _output[pin] : 0; }
+    static uint32_t writes(uint8_t pin) { return pin < HOST_PIN_COUNT ? _writes[pin] : 0; }
+
+private:
+    static uint8_t _mode[HOST_PIN_COUNT];
+    static uint8_t _output[HOST_PIN_COUNT];
+    static uint8_t _input[HOST_PIN_COUNT];
+    static bool _driven[HOST_PIN_COUNT];
+    static uint32_t _writes[HOST_PIN_COUNT];
+    static void (*_isr[HOST_PIN_COUNT])();
+    static uint8_t _isrMode[HOST_PIN_COUNT];
+
+    // تغيير مستوى الدخل واستدعاء المقاطعة عند الحافة
+    static void setInput(uint8_t pin, uint8_t level);
+};
+
+#endif // HOST_PINS_H
@@ -0,0 +1,72 @@
+// HostServer.cpp
+// خادم المكتبة على الحاسوب: جميع المديرين على AsyncHttpServer فوق مقابس POSIX،
+// مع ذاكرة 24C256 وساعة DS3231 محاكاتين (الساعة تبدأ بالوقت المحلي للحاسوب، ومخرج INT موصول بدبوس محاكى).
+// الاستخدام: smartcontrol_host_server [المنفذ] [ملف صورة EEPROM]
+// تُحمل صورة الذاكرة عند البدء إن وجدت، وتُحفظ عند الإيقاف (Ctrl+C)، فتبقى الإعدادات بين التشغيلات.
+
+#include "UserManager.h"
+#include "ScheduleManager.h"
+#include "PrayerTimesManager.h"
+#include "AsyncHttpServer.h"
+#include "HttpSocketBackend.h"
+#include "Sim24C256.h"
+#include "SimDS3231.h"
+#include <signal.h>
+#include <time.h>
+
+// دبوس المحاكاة الموصول بمخرج INT/SQW في DS3231
+#define HOST_RTC_INTERRUPT_PIN 4
+// أقصى انتظار للشبكة بين دورات الحلقة (أحداث الساعة المحاكاة تُنفذ عند قراءة الوقت)
+#define HOST_MAX_WAIT_MS 50
+
+static volatile sig_atomic_t running = 1;
+
+static void onSignal(int) {
+    running = 0;
+}
+
+// وقت الحاسوب المحلي (DS3231 في الجهاز مضبوطة على التوقيت المحلي)
+static uint32_t localUnixTime() {
+    time_t now = time(nullptr);
+    struct tm local;
+    localtime_r(&now, &local);
+    return DateTime(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday, local.tm_hour, local.tm_min, local.tm_sec).unixtime();
+}
+
+int main(int argc, char** argv) {
+    uint16_t port = argc > 1 ? (uint16_t)atoi(argv[1]) : 8080;
+    const char* image = argc > 2 ? argv[2] : "smartcontrol-eeprom.bin";
+
+    HostClock::setRealTime(true);
+    if (HostI2C::eeprom().load(image)) {
+        Serial.printf("[host] تم تحميل صورة EEPROM من %s\n", image);
+    }
+    HostI2C::rtc().setTime(localUnixTime());
+    HostI2C::rtc().connectInterrupt(HOST_RTC_INTERRUPT_PIN);
+
+    static PosixSocketBackend backend;
+    static AsyncHttpServer server(backend, port);
+    static UserManager users(server, RELAY_PIN);
+    static ScheduleManagerClass schedules(server, RELAY_PIN);
+    static PrayerTimesManagementClass prayers(server, RELAY_PIN);
+
+    users.beginAPAndWebServer("Smart Timer", "sM@rt123");
+    users.setupUserEndpoints();
+    schedules.setupScheduleEndpoints();
+    prayers.setupPrayerEndpoints();
+    TimeService::attachInterruptPin(HOST_RTC_INTERRUPT_PIN);
+    Serial.printf("[host] الخادم يستمع على المنفذ %u\n", port);
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    while (running) {
+        users.handleClient();
+        uint32_t wait = TaskScheduler::nextDeadline();
+        server.waitForActivity(wait < HOST_MAX_WAIT_MS ? wait : HOST_MAX_WAIT_MS);
+    }
+
+    if (HostI2C::eeprom().save(image)) {
+        Serial.printf("\n[host] تم حفظ صورة EEPROM في %s\n", image);
+    }
+    return 0;
+}
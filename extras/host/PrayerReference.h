@@ -0,0 +1,99 @@
+// PrayerReference.h
+// محرك مرجعي لأوقات الصلاة بدقة مضاعفة (double) على الحاسوب فقط: نفس صيغ PrayTimes وقواعدها
+// (عينات الأوقات التقريبية، وقاعدة منتصف الليل لخطوط العرض العالية)، لكن باليوم اليولياني الكامل
+// ودوال double، فيقيس اختبار الدقة وقياس الأداء خطأ PrayerCalc (float) وحده.
+#ifndef PRAYER_REFERENCE_H
+#define PRAYER_REFERENCE_H
+
+#include "PrayerCalc.h"
+#include <math.h>
+
+class PrayerReference {
+public:
+    // أوقات اليوم بالدقائق من منتصف الليل (حسب ترتيب PrayerIndex)، مقربة لأقرب دقيقة
+    static void calculateDay(const PrayerSettings& settings, const DateTime& date, int minutes[PRAYER_COUNT]) {
+        // زاوية الفجر، وزاوية العشاء أو دقائقه بعد المغرب (حسب ترتيب PRAYER_METHOD_*)
+        static const double FAJR[PRAYER_METHOD_COUNT] = { 19.5, 18.0, 15.0, 18.5, 18.0 };
+        static const double ISHA[PRAYER_METHOD_COUNT] = { 17.5, 17.0, 15.0, 90.0, 18.0 };
+        static const bool ISHA_MINUTES[PRAYER_METHOD_COUNT] = { false, false, false, true, false };
+        uint8_t method = settings.method < PRAYER_METHOD_COUNT ? settings.method : PRAYER_METHOD_EGYPTIAN;
+        double latitude = settings.latitude;
+
+        // اليوم اليولياني عند منتصف الليل المحلي الشمسي
+        double jd = julian(date.year(), date.month(), date.day()) - settings.longitude / 360.0;
+        double times[PRAYER_COUNT];
+        times[PRAYER_FAJR] = sunAngleTime(jd + 5.0 / 24, latitude, FAJR[method], true);
+        times[PRAYER_SUNRISE] = sunAngleTime(jd + 6.0 / 24, latitude, 0.833, true);
+        times[PRAYER_DHUHR] = midDay(jd + 12.0 / 24);
+        times[PRAYER_ASR] = asrTime(jd + 13.0 / 24, latitude, settings.asrFactor == PRAYER_ASR_HANAFI ? 2 : 1);
+        times[PRAYER_MAGHRIB] = sunAngleTime(jd + 18.0 / 24, latitude, 0.833, false);
+        times[PRAYER_ISHA] = ISHA_MINUTES[method] ? times[PRAYER_MAGHRIB] + ISHA[method] / 60.0
+                                                  : sunAngleTime(jd + 18.0 / 24, latitude, ISHA[method], false);
+
+        double night = fixHour(times[PRAYER_SUNRISE] - times[PRAYER_MAGHRIB]);
+        if (fixHour(times[PRAYER_SUNRISE] - times[PRAYER_FAJR]) > night / 2) {
+            times[PRAYER_FAJR] = times[PRAYER_SUNRISE] - night / 2;
+        }
+        if (!ISHA_MINUTES[method] && fixHour(times[PRAYER_ISHA] - times[PRAYER_MAGHRIB]) > night / 2) {
+            times[PRAYER_ISHA] = times[PRAYER_MAGHRIB] + night / 2;
+        }
+
+        for (int i = 0; i < PRAYER_COUNT; i++) {
+            double local = fixHour(times[i] + settings.timezone - settings.longitude / 15.0);
+            minutes[i] = (int)floor(local * 60.0 + 0.5) % 1440;
+        }
+    }
+
+private:
+    static double dsin(double d) { return sin(d * M_PI / 180); }
+    static double dcos(double d) { return cos(d * M_PI / 180); }
+    static double dtan(double d) { return tan(d * M_PI / 180); }
+    static double fixAngle(double a) { return a - 360.0 * floor(a / 360.0); }
+    static double fixHour(double h) { return h - 24.0 * floor(h / 24.0); }
+
+    // اليوم اليولياني عند منتصف ليل UTC (Meeus)
+    static double julian(int year, int month, int day) {
+        if (month <= 2) {
+            year -= 1;
+            month += 12;
+        }
+        double A = floor(year / 100.0);
+        double B = 2 - A + floor(A / 4);
+        return floor(365.25 * (year + 4716)) + floor(30.6001 * (month + 1)) + day + B - 1524.5;
+    }
+
+    // الميل ومعادلة الوقت (بالساعات) عند اليوم اليولياني jd
+    static void sunPosition(double jd, double& declination, double& equation) {
+        double D = jd - 2451545.0;
+        double g = fixAngle(357.529 + 0.98560028 * D);
+        double q = fixAngle(280.459 + 0.98564736 * D);
+        double L = fixAngle(q + 1.915 * dsin(g) + 0.020 * dsin(2 * g));
+        double e = 23.439 - 0.00000036 * D;
+        double RA = atan2(dcos(e) * dsin(L), dcos(L)) * 180 / M_PI / 15;
+        equation = q / 15 - fixHour(RA);
+        declination = asin(dsin(e) * dsin(L)) * 180 / M_PI;
+    }
+
+    static double midDay(double jd) {
+        double declination, equation;
+        sunPosition(jd, declination, equation);
+        return fixHour(12 - equation);
+    }
+
+    static double sunAngleTime(double jd, double latitude, double angle, bool ccw) {
+        double declination, equation;
+        sunPosition(jd, declination, equation);
+        double cosT = (-dsin(angle) - dsin(declination) * dsin(latitude)) / (dcos(declination) * dcos(latitude));
+        double T = acos(fmin(1.0, fmax(-1.0, cosT))) * 180 / M_PI / 15;
+        return fixHour(12 - equation) + (ccw ? -T : T);
+    }
+
+    static double asrTime(double jd, double latitude, int factor) {
+        double declination, equation;
+        sunPosition(jd, declination, equation);
+        double angle = -atan(1.0 / (factor + dtan(fabs(latitude - declination)))) * 180 / M_PI;
+        return sunAngleTime(jd, latitude, angle, false);
+    }
+};
+
+#endif // PRAYER_REFERENCE_H
@@ -0,0 +1,131 @@
+// RTClib.h
+#ifndef HOST_RTCLIB_H
+#define HOST_RTCLIB_H
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#define SECONDS_FROM_1970_TO_2000 946684800
+#define DS3231_ADDRESS 0x68
+#define DS3231_TIME 0x00
+#define DS3231_ALARM1 0x07
+#define DS3231_ALARM2 0x0B
+#define DS3231_CONTROL 0x0E
+#define DS3231_STATUSREG 0x0F
+#define DS3231_TEMPERATUREREG 0x11
+
+// الجزء المستخدم في المكتبة من Adafruit RTClib، بنفس الحسابات والتعامل مع سجلات DS3231 عبر Wire
+// (فيُختبر مع الساعة المحاكاة في SimDS3231 كما يعمل على الشريحة)
+
+class TimeSpan {
+public:
+    TimeSpan(int32_t seconds = 0) : _seconds(seconds) {}
+    TimeSpan(int16_t days, int8_t hours, int8_t minutes, int8_t seconds)
+        : _seconds((int32_t)days * 86400L + (int32_t)hours * 3600 + (int32_t)minutes * 60 + seconds) {}
+    int16_t days() const { return _seconds / 86400L; }
+    int8_t hours() const { return _seconds / 3600 % 24; }
+    int8_t minutes() const { return _seconds / 60 % 60; }
+    int8_t seconds() const { return _seconds % 60; }
+    int32_t totalseconds() const { return _seconds; }
+    TimeSpan operator+(const TimeSpan& right) const { return TimeSpan(_seconds + right._seconds); }
+    TimeSpan operator-(const TimeSpan& right) const { return TimeSpan(_seconds - right._seconds); }
+
+protected:
+    int32_t _seconds;
+};
+
+class DateTime {
+public:
+    DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000);
+    DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0);
+    // من __DATE__ ("Mmm dd yyyy") و __TIME__ ("hh:mm:ss")
+    DateTime(const char* date, const char* time);
+    // من ISO 8601 ("YYYY-MM-DDThh:mm:ss")
+    DateTime(const char* iso8601dateTime);
+
+    bool isValid() const;
+    uint16_t year() const { return 2000U + yOff; }
+    uint8_t month() const { return m; }
+    uint8_t day() const { return d; }
+    uint8_t hour() const { return hh; }
+    uint8_t minute() const { return mm; }
+    uint8_t second() const { return ss; }
+    // 0 = الأحد
+    uint8_t dayOfTheWeek() const;
+    uint32_t secondstime() const;
+    uint32_t unixtime() const;
+
+    DateTime operator+(const TimeSpan& span) const;
+    DateTime operator-(const TimeSpan& span) const;
+    TimeSpan operator-(const DateTime& right) const;
+    bool operator<(const DateTime& right) const { return unixtime() < right.unixtime(); }
+    bool operator>(const DateTime& right) const { return right < *this; }
+    bool operator<=(const DateTime& right) const { return !(*this > right); }
+    bool operator>=(const DateTime& right) const { return !(*this < right); }
+    bool operator==(const DateTime& right) const { return unixtime() == right.unixtime(); }
+    bool operator!=(const DateTime& right) const { return !(*this == right); }
+
+protected:
+    uint8_t yOff; // السنوات منذ 2000
+    uint8_t m;
+    uint8_t d;
+    uint8_t hh;
+    uint8_t mm;
+    uint8_t ss;
+};
+
+enum Ds3231SqwPinMode {
+    DS3231_OFF = 0x1C,
+    DS3231_SquareWave1Hz = 0x00,
+    DS3231_SquareWave1kHz = 0x08,
+    DS3231_SquareWave4kHz = 0x10,
+    DS3231_SquareWave8kHz = 0x18
+};
+
+enum Ds3231Alarm1Mode {
+    DS3231_A1_PerSecond = 0x0F,
+    DS3231_A1_Second = 0x0E,
+    DS3231_A1_Minute = 0x0C,
+    DS3231_A1_Hour = 0x08,
+    DS3231_A1_Date = 0x00,
+    DS3231_A1_Day = 0x10
+};
+
+enum Ds3231Alarm2Mode {
+    DS3231_A2_PerMinute = 0x7,
+    DS3231_A2_Minute = 0x6,
+    DS3231_A2_Hour = 0x4,
+    DS3231_A2_Date = 0x0,
+    DS3231_A2_Day = 0x8
+};
+
+class RTC_DS3231 {
+public:
+    RTC_DS3231() : _wire(nullptr) {}
+
+    bool begin(TwoWire* wireInstance = &Wire);
+    bool lostPower();
+    void adjust(const DateTime& dt);
+    DateTime now();
+    Ds3231SqwPinMode readSqwPinMode();
+    void writeSqwPinMode(Ds3231SqwPinMode mode);
+    bool setAlarm1(const DateTime& dt, Ds3231Alarm1Mode alarmMode);
+    bool setAlarm2(const DateTime& dt, Ds3231Alarm2Mode alarmMode);
+    void disableAlarm(uint8_t alarmNum);
+    void clearAlarm(uint8_t alarmNum);
+    bool alarmFired(uint8_t alarmNum);
+    void enable32K();
+    void disable32K();
+    bool isEnabled32K();
+    float getTemperature();
+
+private:
+    TwoWire* _wire;
+
+    uint8_t readRegister(uint8_t reg);
+    void writeRegister(uint8_t reg, uint8_t value);
+    bool writeBuffer(const uint8_t* buffer, size_t length);
+    bool readBuffer(uint8_t reg, uint8_t* buffer, size_t length);
+};
+
+#endif // HOST_RTCLIB_H
@@ -0,0 +1,73 @@
+// Sim24C256.cpp
+#include "Sim24C256.h"
+#include "HostClock.h"
+#include <stdio.h>
+#include <string.h>
+
+Sim24C256::Sim24C256() : _pointer(0), _busyUntil(0), _writeCycleUs(SIM_24C256_WRITE_CYCLE_US), _writeCycles(0), _bytesWritten(0) {
+    erase();
+}
+
+void Sim24C256::erase() {
+    memset(_memory, 0xFF, sizeof(_memory));
+}
+
+bool Sim24C256::busy() const {
+    return HostClock::micros() < _busyUntil;
+}
+
+uint8_t Sim24C256::receive(const uint8_t* data, size_t length) {
+    if (busy()) {
+        return 2;
+    }
+    if (length < 2) {
+        return 0; // فحص وجود (أو عنوان ناقص لا يغير العداد)
+    }
+    _pointer = (uint16_t)(((data[0] << 8) | data[1]) & (SIM_24C256_SIZE - 1));
+    if (length == 2) {
+        return 0; // ضبط العنوان قبل القراءة
+    }
+    // الكتابة تلتف داخل الصفحة، وتبدأ دورة كتابة واحدة للصفحة كلها
+    uint16_t page = _pointer & ~(SIM_24C256_PAGE_SIZE - 1);
+    uint16_t offset = _pointer & (SIM_24C256_PAGE_SIZE - 1);
+    for (size_t i = 2; i < length; i++) {
+        _memory[page + offset] = data[i];
+        offset = (offset + 1) & (SIM_24C256_PAGE_SIZE - 1);
+    }
+    _pointer = page + offset;
+    _bytesWritten += length - 2;
+    _writeCycles++;
+    _busyUntil = HostClock::micros() + _writeCycleUs;
+    return 0;
+}
+
+size_t Sim24C256::transmit(uint8_t* buffer, size_t length) {
+    if (busy()) {
+        return 0;
+    }
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = _memory[_pointer];
+        _pointer = (_pointer + 1) & (SIM_24C256_SIZE - 1);
+    }
+    return length;
+}
+
+bool Sim24C256::load(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    size_t read = fread(_memory, 1, sizeof(_memory), file);
+    fclose(file);
+    return read == sizeof(_memory);
+}
+
+bool Sim24C256::save(const char* path) const {
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    size_t written = fwrite(_memory, 1, sizeof(_memory), file);
+    fclose(file);
+    return written == sizeof(_memory);
+}
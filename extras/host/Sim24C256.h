@@ -0,0 +1,48 @@
+// Sim24C256.h
+#ifndef SIM_24C256_H
+#define SIM_24C256_H
+
+#include "HostI2C.h"
+
+// سعة 24C256 (32 كيلوبايت) وحجم صفحة الكتابة
+#define SIM_24C256_SIZE 32768
+#define SIM_24C256_PAGE_SIZE 64
+// زمن دورة الكتابة الداخلية (tWR) الافتراضي بالميكروثانية: لا يُقَر بالعنوان خلالها
+#define SIM_24C256_WRITE_CYCLE_US 5000
+
+// محاكاة 24C256: عنوان من بايتين ثم بيانات، والكتابة المتتالية تلتف داخل الصفحة
+// (كما في الشريحة، فعبور حدود الصفحة يكتب فوق بدايتها)، والقراءة المتتالية تلتف عند نهاية الذاكرة.
+// بعد كل كتابة لا يستجيب الجهاز لمدة دورة الكتابة على الساعة الافتراضية، فيُختبر إعادة المحاولة في I2CBus.
+class Sim24C256 : public HostI2CDevice {
+public:
+    Sim24C256();
+
+    uint8_t receive(const uint8_t* data, size_t length) override;
+    size_t transmit(uint8_t* buffer, size_t length) override;
+
+    // صورة الذاكرة في ملف (لحفظ الإعدادات بين تشغيلات الخادم على الحاسوب)
+    bool load(const char* path);
+    bool save(const char* path) const;
+    // مسح الذاكرة (0xFF كشريحة جديدة)
+    void erase();
+    uint8_t* data() { return _memory; }
+    // زمن دورة الكتابة (نموذج التوقيت: 5ms في ورقة البيانات، وأقل لشرائح أسرع)
+    void setWriteCycle(uint32_t us) { _writeCycleUs = us; }
+
+    // عدد دورات الكتابة (تآكل الشريحة) والبايتات المكتوبة
+    uint32_t writeCycles() const { return _writeCycles; }
+    uint32_t bytesWritten() const { return _bytesWritten; }
+    void resetCounters() { _writeCycles = 0; _bytesWritten = 0; }
+
+private:
+    uint8_t _memory[SIM_24C256_SIZE];
+    uint16_t _pointer;    // عداد العنوان الداخلي
+    uint64_t _busyUntil;  // نهاية دورة الكتابة الجارية
+    uint32_t _writeCycleUs;
+    uint32_t _writeCycles;
+    uint32_t _bytesWritten;
+
+    bool busy() const;
+};
+
+#endif // SIM_24C256_H
@@ -0,0 +1,315 @@
+// SimDS3231.cpp
+#include "SimDS3231.h"
+#include "RTClib.h"
+
+// السجلات
+#define REG_SECONDS 0x00
+#define REG_HOURS 0x02
+#define REG_ALARM1 0x07
+#define REG_ALARM2 0x0B
+#define REG_CONTROL 0x0E
+#define REG_STATUS 0x0F
+#define REG_AGING 0x10
+#define REG_TEMP_MSB 0x11
+#define REG_TEMP_LSB 0x12
+// بتات التحكم والحالة
+#define CONTROL_INTCN 0x04
+#define CONTROL_RS 0x18
+#define STATUS_OSF 0x80
+#define STATUS_EN32KHZ 0x08
+#define STATUS_FLAGS 0x83 // OSF و A2F و A1F (تُمسح بكتابة صفر فقط)
+
+#define MICROS_PER_SECOND 1000000ULL
+
+static uint8_t bcd2bin(uint8_t value) {
+    return value - 6 * (value >> 4);
+}
+
+static uint8_t bin2bcd(uint8_t value) {
+    return value + 6 * (value / 10);
+}
+
+// سجل الساعة بنظام 24 أو 12 ساعة (البت 6)
+static uint8_t decodeHour(uint8_t value) {
+    if (value & 0x40) {
+        uint8_t hour = bcd2bin(value & 0x1F) % 12;
+        return (value & 0x20) ? hour + 12 : hour;
+    }
+    return bcd2bin(value & 0x3F);
+}
+
+static uint8_t encodeHour(uint8_t hour, bool twelveHour) {
+    if (!twelveHour) {
+        return bin2bcd(hour);
+    }
+    uint8_t hour12 = hour % 12 == 0 ? 12 : hour % 12;
+    return 0x40 | (hour >= 12 ? 0x20 : 0) | bin2bcd(hour12);
+}
+
+// يوم الأسبوع كما يكتبه RTClib (الاثنين = 1 ... الأحد = 7)
+static uint8_t dayOfWeek(const DateTime& time) {
+    uint8_t day = time.dayOfTheWeek();
+    return day == 0 ? 7 : day;
+}
+
+SimDS3231::SimDS3231() : _interruptPin(-1) {
+    reset(HostClock::micros());
+    HostClock::addTimer(this);
+}
+
+SimDS3231::~SimDS3231() {
+    HostClock::removeTimer(this);
+}
+
+void SimDS3231::reset(uint64_t now) {
+    for (uint8_t i = 0; i < SIM_DS3231_REGISTERS; i++) {
+        _regs[i] = 0;
+    }
+    _regs[REG_CONTROL] = 0x1C;
+    _regs[REG_STATUS] = STATUS_OSF | STATUS_EN32KHZ;
+    _regs[REG_TEMP_MSB] = 25;
+    _pointer = 0;
+    _epochSeconds = SECONDS_FROM_1970_TO_2000;
+    _epochMicros = now;
+    schedule(now);
+}
+
+uint32_t SimDS3231::secondsAt(uint64_t now) const {
+    return _epochSeconds + (uint32_t)((now - _epochMicros) / MICROS_PER_SECOND);
+}
+
+uint64_t SimDS3231::microsAt(uint32_t seconds) const {
+    return _epochMicros + (uint64_t)(seconds - _epochSeconds) * MICROS_PER_SECOND;
+}
+
+// --- الناقل ---
+
+uint8_t SimDS3231::receive(const uint8_t* data, size_t length) {
+    std::lock_guard<std::recursive_mutex> lock(HostClock::mutex());
+    uint64_t now = HostClock::micros();
+    if (length == 0) {
+        return 0;
+    }
+    refreshTime(now);
+    _pointer = data[0] % SIM_DS3231_REGISTERS;
+    bool timeWritten = false;
+    for (size_t i = 1; i < length; i++) {
+        timeWritten |= _pointer <= 0x06;
+        writeRegister(_pointer, data[i]);
+        _pointer = (_pointer + 1) % SIM_DS3231_REGISTERS;
+    }
+    if (timeWritten) {
+        // كتابة الوقت تعيد ضبط عداد الثواني، فتبدأ الثانية من لحظة الكتابة
+        _epochSeconds = decodeTime();
+        _epochMicros = now;
+    }
+    if (length > 1) {
+        schedule(now);
+        updatePin(now);
+    }
+    return 0;
+}
+
+size_t SimDS3231::transmit(uint8_t* buffer, size_t length) {
+    std::lock_guard<std::recursive_mutex> lock(HostClock::mutex());
+    refreshTime(HostClock::micros());
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = _regs[_pointer];
+        _pointer = (_pointer + 1) % SIM_DS3231_REGISTERS;
+    }
+    return length;
+}
+
+void SimDS3231::writeRegister(uint8_t index, uint8_t value) {
+    switch (index) {
+        case REG_STATUS:
+            _regs[index] = (_regs[index] & value & STATUS_FLAGS) | (value & STATUS_EN32KHZ);
+            break;
+        case REG_TEMP_MSB:
+        case REG_TEMP_LSB:
+            break; // للقراءة فقط
+        default:
+            _regs[index] = value;
+            break;
+    }
+}
+
+// نسخ الوقت الحالي إلى سجلات الوقت قبل قراءتها أو الكتابة على جزء منها
+void SimDS3231::refreshTime(uint64_t now) {
+    DateTime time(secondsAt(now));
+    _regs[0x00] = bin2bcd(time.second());
+    _regs[0x01] = bin2bcd(time.minute());
+    _regs[REG_HOURS] = encodeHour(time.hour(), (_regs[REG_HOURS] & 0x40) != 0);
+    _regs[0x03] = dayOfWeek(time);
+    _regs[0x04] = bin2bcd(time.day());
+    _regs[0x05] = bin2bcd(time.month());
+    _regs[0x06] = bin2bcd(time.year() - 2000);
+}
+
+uint32_t SimDS3231::decodeTime() const {
+    DateTime time(2000 + bcd2bin(_regs[0x06]), bcd2bin(_regs[0x05] & 0x1F), bcd2bin(_regs[0x04] & 0x3F),
+                  decodeHour(_regs[REG_HOURS]), bcd2bin(_regs[0x01] & 0x7F), bcd2bin(_regs[0x00] & 0x7F));
+    return time.unixtime();
+}
+
+// --- التنبيهات ---
+
+// مطابقة حقل تنبيه (بت القناع 7 يتجاهل الحقل): field = 0 الثواني، 1 الدقائق، 2 الساعات، 3 اليوم/التاريخ
+static bool fieldMatches(const uint8_t* alarm, uint8_t field, const DateTime& time) {
+    uint8_t value = alarm[field];
+    if (value & 0x80) {
+        return true;
+    }
+    switch (field) {
+        case 0: return bcd2bin(value & 0x7F) == time.second();
+        case 1: return bcd2bin(value & 0x7F) == time.minute();
+        case 2: return decodeHour(value) == time.hour();
+        default:
+            if (value & 0x40) {
+                return (value & 0x0F) == dayOfWeek(time);
+            }
+            return bcd2bin(value & 0x3F) == time.day();
+    }
+}
+
+// أول ثانية بعد after يطابقها التنبيه (0 إذا لم توجد خلال مدى البحث)
+uint32_t SimDS3231::findAlarm(uint8_t alarm, uint32_t after) const {
+    // التنبيه الثاني بلا سجل ثوانٍ: يطابق عند الثانية 00
+    uint8_t fields[4];
+    if (alarm == 0) {
+        for (uint8_t i = 0; i < 4; i++) {
+            fields[i] = _regs[REG_ALARM1 + i];
+        }
+    } else {
+        fields[0] = 0x00;
+        for (uint8_t i = 1; i < 4; i++) {
+            fields[i] = _regs[REG_ALARM2 + i - 1];
+        }
+    }
+    uint32_t first = after + 1;
+    uint32_t limit = first + SIM_DS3231_ALARM_SCAN_DAYS * 86400UL;
+    // تخطي يوم أو ساعة كاملة عند عدم المطابقة، ثم البحث داخل الدقيقة
+    uint32_t minute = first - first % 60;
+    while (minute < limit) {
+        DateTime time(minute);
+        if (!fieldMatches(fields, 3, time)) {
+            minute += 86400 - minute % 86400;
+            continue;
+        }
+        if (!fieldMatches(fields, 2, time)) {
+            minute += 3600 - minute % 3600;
+            continue;
+        }
+        if (fieldMatches(fields, 1, time)) {
+            if (fields[0] & 0x80) {
+                uint32_t candidate = minute < first ? first : minute;
+                if (candidate < minute + 60) {
+                    return candidate;
+                }
+            } else {
+                uint32_t candidate = minute + bcd2bin(fields[0] & 0x7F);
+                if (candidate >= first) {
+                    return candidate;
+                }
+            }
+        }
+        minute += 60;
+    }
+    return 0;
+}
+
+void SimDS3231::schedule(uint64_t now) {
+    uint32_t seconds = secondsAt(now);
+    for (uint8_t alarm = 0; alarm < 2; alarm++) {
+        uint32_t next = findAlarm(alarm, seconds);
+        _nextAlarm[alarm] = next != 0 ? microsAt(next) : HOST_NO_EVENT;
+    }
+    uint8_t control = _regs[REG_CONTROL];
+    if (_interruptPin >= 0 && !(control & CONTROL_INTCN) && (control & CONTROL_RS) == 0) {
+        uint64_t phase = (now - _epochMicros) % MICROS_PER_SECOND;
+        _nextSquareWave = now - phase + (phase < MICROS_PER_SECOND / 2 ? MICROS_PER_SECOND / 2 : MICROS_PER_SECOND);
+    } else {
+        _nextSquareWave = HOST_NO_EVENT;
+    }
+}
+
+uint64_t SimDS3231::nextEvent() {
+    uint64_t next = _nextAlarm[0] < _nextAlarm[1] ? _nextAlarm[0] : _nextAlarm[1];
+    return _nextSquareWave < next ? _nextSquareWave : next;
+}
+
+void SimDS3231::onEvent(uint64_t now) {
+    for (uint8_t alarm = 0; alarm < 2; alarm++) {
+        if (_nextAlarm[alarm] <= now) {
+            _regs[REG_STATUS] |= 1 << alarm;
+        }
+    }
+    schedule(now);
+    updatePin(now);
+}
+
+// مخرج مفتوح المصرف: منخفض أو محرر (يرفعه مقاوم السحب)
+void SimDS3231::updatePin(uint64_t now) {
+    if (_interruptPin < 0) {
+        return;
+    }
+    uint8_t control = _regs[REG_CONTROL];
+    bool low;
+    if (control & CONTROL_INTCN) {
+        low = (_regs[REG_STATUS] & control & 0x03) != 0;
+    } else if ((control & CONTROL_RS) == 0) {
+        low = (now - _epochMicros) % MICROS_PER_SECOND < MICROS_PER_SECOND / 2;
+    } else {
+        low = false;
+    }
+    if (low) {
+        HostPins::drive(_interruptPin, LOW);
+    } else {
+        HostPins::release(_interruptPin);
+    }
+}
+
+// --- واجهة الاختبارات ---
+
+void SimDS3231::setTime(uint32_t unixTime) {
+    std::lock_guard<std::recursive_mutex> lock(HostClock::mutex());
+    uint64_t now = HostClock::micros();
+    _epochSeconds = unixTime;
+    _epochMicros = now;
+    _regs[REG_STATUS] &= ~STATUS_OSF;
+    schedule(now);
+    updatePin(now);
+}
+
+uint32_t SimDS3231::time() {
+    std::lock_guard<std::recursive_mutex> lock(HostClock::mutex());
+    return secondsAt(HostClock::micros());
+}
+
+void SimDS3231::powerLoss() {
+    std::lock_guard<std::recursive_mutex> lock(HostClock::mutex());
+    uint64_t now = HostClock::micros();
+    reset(now);
+    updatePin(now);
+}
+
+void SimDS3231::connectInterrupt(uint8_t pin) {
+    std::lock_guard<std::recursive_mutex> lock(HostClock::mutex());
+    uint64_t now = HostClock::micros();
+    _interruptPin = pin;
+    schedule(now);
+    updatePin(now);
+}
+
+void SimDS3231::setTemperature(float celsius) {
+    std::lock_guard<std::recursive_mutex> lock(HostClock::mutex());
+    int16_t quarters = (int16_t)(celsius * 4.0f);
+    _regs[REG_TEMP_MSB] = (uint8_t)(quarters >> 2);
+    _regs[REG_TEMP_LSB] = (uint8_t)((quarters & 0x03) << 6);
+}
+
+uint8_t SimDS3231::reg(uint8_t index) {
+    std::lock_guard<std::recursive_mutex> lock(HostClock::mutex());
+    refreshTime(HostClock::micros());
+    return index < SIM_DS3231_REGISTERS ? _regs[index] : 0;
+}
@@ -0,0 +1,59 @@
+// SimDS3231.h
+#ifndef SIM_DS3231_H
+#define SIM_DS3231_H
+
+#include "HostI2C.h"
+#include "HostClock.h"
+
+// عدد سجلات DS3231 (0x00..0x12)
+#define SIM_DS3231_REGISTERS 0x13
+// أقصى مدى للبحث عن موعد التنبيه القادم (تنبيه بتاريخ 31 قد يبعد شهرين)
+#define SIM_DS3231_ALARM_SCAN_DAYS 400
+
+// محاكاة DS3231 على مستوى السجلات: الوقت يُشتق من الساعة الافتراضية (لا ينجرف ولا يحتاج حدثاً كل ثانية)،
+// وكتابة أي سجل وقت تعيد ضبطه. التنبيهان يطابقان بتات القناع M1..M4 و DY/DT كما في الشريحة،
+// ويُضبط A1F/A2F عند الموعد، ولا تُمسح الأعلام (ولا OSF) إلا بكتابة صفر.
+// مخرج INT/SQW (بعد connectInterrupt) يُقاد على دبوس محاكى:
+// مع INTCN منخفض ما دام علم تنبيه مفعل المقاطعة مضبوطاً، ودون INTCN موجة 1Hz (الحافة الهابطة عند بداية الثانية).
+// الترددات الأعلى لموجة SQW ووضع البطارية غير محاكاة. الوضع عند التشغيل: 2000-01-01 00:00:00 مع OSF.
+class SimDS3231 : public HostI2CDevice, public HostTimer {
+public:
+    SimDS3231();
+    ~SimDS3231();
+
+    uint8_t receive(const uint8_t* data, size_t length) override;
+    size_t transmit(uint8_t* buffer, size_t length) override;
+    uint64_t nextEvent() override;
+    void onEvent(uint64_t now) override;
+
+    // ضبط الساعة مباشرة (كأنها ضُبطت سابقاً ولم تفقد الطاقة) وقراءة وقتها، بثوانٍ Unix
+    void setTime(uint32_t unixTime);
+    uint32_t time();
+    // محاكاة انقطاع البطارية: العودة لوضع التشغيل الأول مع OSF
+    void powerLoss();
+    // ربط مخرج INT/SQW بدبوس محاكى (يُقرأ بـ digitalRead وتُستدعى مقاطعته عند الحافة)
+    void connectInterrupt(uint8_t pin);
+    void setTemperature(float celsius);
+    uint8_t reg(uint8_t index);
+
+private:
+    uint8_t _regs[SIM_DS3231_REGISTERS];
+    uint8_t _pointer;
+    uint32_t _epochSeconds; // الوقت (Unix) عند آخر ضبط
+    uint64_t _epochMicros;  // وقت الساعة الافتراضية عند آخر ضبط (بداية ثانية)
+    uint64_t _nextAlarm[2];
+    uint64_t _nextSquareWave;
+    int16_t _interruptPin;
+
+    uint32_t secondsAt(uint64_t now) const;
+    uint64_t microsAt(uint32_t seconds) const;
+    void reset(uint64_t now);
+    void writeRegister(uint8_t index, uint8_t value);
+    void refreshTime(uint64_t now);
+    uint32_t decodeTime() const;
+    uint32_t findAlarm(uint8_t alarm, uint32_t after) const;
+    void schedule(uint64_t now);
+    void updatePin(uint64_t now);
+};
+
+#endif // SIM_DS3231_H
@@ -0,0 +1,172 @@
+// WString.cpp
+#include "WString.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// تحويل عدد بلا إشارة إلى نص بأي أساس (2-36)
+static std::string toBase(unsigned long long value, unsigned char base) {
+    if (base < 2 || base > 36) {
+        base = 10;
+    }
+    char buffer[66];
+    char* p = buffer + sizeof(buffer);
+    *--p = 0;
+    do {
+        unsigned digit = value % base;
+        *--p = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+        value /= base;
+    } while (value != 0);
+    return p;
+}
+
+// الأعداد السالبة بإشارة في الأساس 10 فقط، وبتمثيلها بلا إشارة في غيره (مثل Arduino)
+static std::string signedToBase(long long value, unsigned char base, unsigned bits) {
+    if (base == 10) {
+        return value < 0 ? "-" + toBase(0ULL - (unsigned long long)value, 10) : toBase(value, 10);
+    }
+    unsigned long long mask = bits >= 64 ? ~0ULL : ((1ULL << bits) - 1);
+    return toBase((unsigned long long)value & mask, base);
+}
+
+static std::string fixed(double value, unsigned int decimalPlaces) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimalPlaces, value);
+    return buffer;
+}
+
+String::String(unsigned char value, unsigned char base) : std::string(toBase(value, base)) {}
+String::String(int value, unsigned char base) : std::string(signedToBase(value, base, 32)) {}
+String::String(unsigned int value, unsigned char base) : std::string(toBase(value, base)) {}
+String::String(long value, unsigned char base) : std::string(signedToBase(value, base, sizeof(long) * 8)) {}
+String::String(unsigned long value, unsigned char base) : std::string(toBase(value, base)) {}
+String::String(long long value, unsigned char base) : std::string(signedToBase(value, base, 64)) {}
+String::String(unsigned long long value, unsigned char base) : std::string(toBase(value, base)) {}
+String::String(float value, unsigned int decimalPlaces) : std::string(fixed(value, decimalPlaces)) {}
+String::String(double value, unsigned int decimalPlaces) : std::string(fixed(value, decimalPlaces)) {}
+
+bool String::equalsIgnoreCase(const String& other) const {
+    return size() == other.size() && strncasecmp(c_str(), other.c_str(), size()) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return size() >= suffix.size() && compare(size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void String::getBytes(unsigned char* buffer, unsigned int bufferSize, unsigned int index) const {
+    if (buffer == nullptr || bufferSize == 0) {
+        return;
+    }
+    if (index >= size()) {
+        buffer[0] = 0;
+        return;
+    }
+    unsigned int n = size() - index;
+    if (n > bufferSize - 1) {
+        n = bufferSize - 1;
+    }
+    memcpy(buffer, data() + index, n);
+    buffer[n] = 0;
+}
+
+// مثل Arduino: الحدود المعكوسة تُبدل، وما بعد النهاية يُقص
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) {
+        unsigned int t = from;
+        from = to;
+        to = t;
+    }
+    if (from >= size()) {
+        return String();
+    }
+    if (to > size()) {
+        to = size();
+    }
+    return String(substr(from, to - from));
+}
+
+void String::replace(char find, char replacement) {
+    for (char& c : *this) {
+        if (c == find) {
+            c = replacement;
+        }
+    }
+}
+
+void String::replace(const String& find, const String& replacement) {
+    if (find.empty()) {
+        return;
+    }
+    size_type at = 0;
+    while ((at = std::string::find(find, at)) != npos) {
+        std::string::replace(at, find.size(), replacement);
+        at += replacement.size();
+    }
+}
+
+void String::toLowerCase() {
+    for (char& c : *this) {
+        c = (char)tolower((unsigned char)c);
+    }
+}
+
+void String::toUpperCase() {
+    for (char& c : *this) {
+        c = (char)toupper((unsigned char)c);
+    }
+}
+
+void String::trim() {
+    size_type first = 0;
+    while (first < size() && isspace((unsigned char)(*this)[first])) {
+        first++;
+    }
+    size_type last = size();
+    while (last > first && isspace((unsigned char)(*this)[last - 1])) {
+        last--;
+    }
+    *this = String(substr(first, last - first));
+}
+
+long String::toInt() const {
+    return atol(c_str());
+}
+
+float String::toFloat() const {
+    return (float)atof(c_str());
+}
+
+double String::toDouble() const {
+    return atof(c_str());
+}
+
+StringSumHelper operator+(const String& left, const String& right) {
+    StringSumHelper result(left);
+    result.concat(right);
+    return result;
+}
+
+StringSumHelper operator+(const String& left, const char* right) {
+    StringSumHelper result(left);
+    result.concat(right);
+    return result;
+}
+
+StringSumHelper operator+(const char* left, const String& right) {
+    StringSumHelper result(left);
+    result.concat(right);
+    return result;
+}
+
+StringSumHelper operator+(const String& left, char right) {
+    StringSumHelper result(left);
+    result.concat(right);
+    return result;
+}
+
+StringSumHelper operator+(const String& left, int right) { return left + String(right); }
+StringSumHelper operator+(const String& left, unsigned int right) { return left + String(right); }
+StringSumHelper operator+(const String& left, long right) { return left + String(right); }
+StringSumHelper operator+(const String& left, unsigned long right) { return left + String(right); }
+StringSumHelper operator+(const String& left, double right) { return left + String(right); }
@@ -0,0 +1,107 @@
+// WString.h
+// String بنفس واجهة Arduino للبناء على الحاسوب (مبني على std::string)
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+class String : public std::string {
+public:
+    String() {}
+    String(const char* text) : std::string(text ? text : "") {}
+    String(const std::string& text) : std::string(text) {}
+    explicit String(char c) : std::string(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimalPlaces = 2);
+    explicit String(double value, unsigned int decimalPlaces = 2);
+
+    unsigned int length() const { return (unsigned int)size(); }
+    bool isEmpty() const { return empty(); }
+    bool reserve(unsigned int size) { std::string::reserve(size); return true; }
+
+    // الإضافة
+    bool concat(const String& text) { append(text); return true; }
+    bool concat(const char* text) { if (text) append(text); return text != nullptr; }
+    bool concat(const char* text, unsigned int length) { append(text, length); return true; }
+    bool concat(char c) { push_back(c); return true; }
+    bool concat(unsigned char value) { return concat(String(value)); }
+    bool concat(int value) { return concat(String(value)); }
+    bool concat(unsigned int value) { return concat(String(value)); }
+    bool concat(long value) { return concat(String(value)); }
+    bool concat(unsigned long value) { return concat(String(value)); }
+    bool concat(long long value) { return concat(String(value)); }
+    bool concat(unsigned long long value) { return concat(String(value)); }
+    bool concat(float value) { return concat(String(value)); }
+    bool concat(double value) { return concat(String(value)); }
+    template<typename T> String& operator+=(const T& value) { concat(value); return *this; }
+
+    // المقارنة
+    bool equals(const String& other) const { return compare(other) == 0; }
+    bool equalsIgnoreCase(const String& other) const;
+    int compareTo(const String& other) const { return compare(other); }
+    bool startsWith(const String& prefix) const { return rfind(prefix, 0) == 0; }
+    bool startsWith(const String& prefix, unsigned int offset) const { return compare(offset, prefix.size(), prefix) == 0; }
+    bool endsWith(const String& suffix) const;
+
+    // الأحرف
+    char charAt(unsigned int index) const { return index < size() ? (*this)[index] : 0; }
+    void setCharAt(unsigned int index, char c) { if (index < size()) (*this)[index] = c; }
+    void getBytes(unsigned char* buffer, unsigned int size, unsigned int index = 0) const;
+    void toCharArray(char* buffer, unsigned int size, unsigned int index = 0) const {
+        getBytes((unsigned char*)buffer, size, index);
+    }
+
+    // البحث
+    int indexOf(char c, unsigned int from = 0) const { return position(find(c, from)); }
+    int indexOf(const String& text, unsigned int from = 0) const { return position(find(text, from)); }
+    int lastIndexOf(char c) const { return position(rfind(c)); }
+    int lastIndexOf(char c, unsigned int from) const { return position(rfind(c, from)); }
+    int lastIndexOf(const String& text) const { return position(rfind(text)); }
+    int lastIndexOf(const String& text, unsigned int from) const { return position(rfind(text, from)); }
+    String substring(unsigned int from) const { return from < size() ? String(substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const;
+
+    // التعديل
+    void replace(char find, char replacement);
+    void replace(const String& find, const String& replacement);
+    void remove(unsigned int index) { if (index < size()) erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < size()) erase(index, count); }
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    // التحويل
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+
+private:
+    static int position(size_type found) { return found == npos ? -1 : (int)found; }
+};
+
+// نوع نتيجة + في Arduino (تحتاجه ArduinoJson عند تفعيل دعم String)
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String& text) : String(text) {}
+    StringSumHelper(const char* text) : String(text) {}
+};
+
+StringSumHelper operator+(const String& left, const String& right);
+StringSumHelper operator+(const String& left, const char* right);
+StringSumHelper operator+(const char* left, const String& right);
+StringSumHelper operator+(const String& left, char right);
+StringSumHelper operator+(const String& left, int right);
+StringSumHelper operator+(const String& left, unsigned int right);
+StringSumHelper operator+(const String& left, long right);
+StringSumHelper operator+(const String& left, unsigned long right);
+StringSumHelper operator+(const String& left, double right);
+
+#endif // HOST_WSTRING_H
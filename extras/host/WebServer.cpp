@@ -0,0 +1,110 @@
+// WebServer.cpp
+#include "WebServer.h"
+
+void WebServer::on(const String& uri, HTTPMethod method, THandlerFunction handler) {
+    _routes.push_back(Route{uri, method, handler});
+}
+
+bool WebServer::hasArg(const String& name) const {
+    for (const Arg& item : _args) {
+        if (item.name == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+String WebServer::arg(const String& name) const {
+    for (const Arg& item : _args) {
+        if (item.name == name) {
+            return item.value;
+        }
+    }
+    return String();
+}
+
+String WebServer::arg(int index) const {
+    return index >= 0 && index < args() ? _args[index].value : String();
+}
+
+String WebServer::argName(int index) const {
+    return index >= 0 && index < args() ? _args[index].name : String();
+}
+
+void WebServer::send(int code, const char* contentType, const String& content) {
+    _response.code = code;
+    _response.contentType = contentType;
+    _response.body = content;
+}
+
+HostHttpResponse WebServer::request(HTTPMethod method, const String& uri, const String& body, const String& contentType) {
+    _method = method;
+    _args.clear();
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    _response = HostHttpResponse{0, String(), String()};
+
+    int query = uri.indexOf('?');
+    _uri = query < 0 ? uri : uri.substring(0, query);
+    if (query >= 0) {
+        parseArgs(uri.substring(query + 1));
+    }
+    if (body.length() > 0) {
+        if (contentType.startsWith("application/x-www-form-urlencoded")) {
+            parseArgs(body);
+        } else {
+            _args.push_back(Arg{"plain", body});
+        }
+    }
+
+    for (const Route& route : _routes) {
+        if (route.uri == _uri && (route.method == HTTP_ANY || route.method == method)) {
+            route.handler();
+            return _response;
+        }
+    }
+    if (_notFound) {
+        _notFound();
+    } else {
+        send(404, "text/plain", String("Not found: ") + _uri);
+    }
+    return _response;
+}
+
+// name=value&name=value مع فك ترميز URL
+void WebServer::parseArgs(const String& data) {
+    int start = 0;
+    while (start < (int)data.length()) {
+        int end = data.indexOf('&', start);
+        if (end < 0) {
+            end = data.length();
+        }
+        String pair = data.substring(start, end);
+        if (pair.length() > 0) {
+            int equals = pair.indexOf('=');
+            if (equals < 0) {
+                _args.push_back(Arg{urlDecode(pair), String()});
+            } else {
+                _args.push_back(Arg{urlDecode(pair.substring(0, equals)), urlDecode(pair.substring(equals + 1))});
+            }
+        }
+        start = end + 1;
+    }
+}
+
+String WebServer::urlDecode(const String& text) {
+    String decoded;
+    decoded.reserve(text.length());
+    for (size_t i = 0; i < text.length(); i++) {
+        char c = text[i];
+        if (c == '+') {
+            decoded += ' ';
+        } else if (c == '%' && i + 2 < text.length() && isxdigit((unsigned char)text[i + 1]) && isxdigit((unsigned char)text[i + 2])) {
+            char hex[3] = {text[i + 1], text[i + 2], 0};
+            decoded += (char)strtol(hex, nullptr, 16);
+            i += 2;
+        } else {
+            decoded += c;
+        }
+    }
+    return decoded;
+}
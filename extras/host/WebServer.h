@@ -0,0 +1,83 @@
+// WebServer.h
+#ifndef HOST_WEBSERVER_H
+#define HOST_WEBSERVER_H
+
+#include "Arduino.h"
+#include <functional>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+// رد طلب في العملية نفسها (code = 0 إذا لم يرسل المعالج رداً)
+struct HostHttpResponse {
+    int code;
+    String contentType;
+    String body;
+};
+
+// WebServer على الحاسوب دون شبكة: المسارات تُسجل كالمعتاد، والطلبات تُنفذ مباشرة بـ request()
+// (معاملات الاستعلام وجسم النموذج تصبح arg، وأي جسم آخر هو arg("plain") كما في WebServer الأصلي).
+// للخادم الحقيقي على منفذ TCP استخدم AsyncHttpServer مع PosixSocketBackend (انظر HostServer.cpp).
+class WebServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    explicit WebServer(int port = 80) : _port(port), _method(HTTP_ANY), _contentLength(CONTENT_LENGTH_NOT_SET) {}
+
+    void on(const String& uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void on(const String& uri, HTTPMethod method, THandlerFunction handler);
+    void onNotFound(THandlerFunction handler) { _notFound = handler; }
+    void begin() {}
+    void close() {}
+    void stop() {}
+    void handleClient() {}
+
+    // --- الطلب الحالي ---
+    bool hasArg(const String& name) const;
+    String arg(const String& name) const;
+    String arg(int index) const;
+    String argName(int index) const;
+    int args() const { return (int)_args.size(); }
+    String uri() const { return _uri; }
+    HTTPMethod method() const { return _method; }
+
+    // --- الرد ---
+    void send(int code, const char* contentType, const String& content);
+    void send(int code, const String& contentType, const String& content) { send(code, contentType.c_str(), content); }
+    void send(int code, const char* contentType = "text/plain", const char* content = "") { send(code, contentType, String(content)); }
+    void setContentLength(size_t length) { _contentLength = length; }
+    void sendHeader(const String&, const String&, bool = false) {}
+    void sendContent(const String& content) { _response.body += content; }
+    void sendContent(const char* content, size_t length) { _response.body.append(content, length); }
+
+    // تنفيذ طلب على المسارات المسجلة وإرجاع رده
+    HostHttpResponse request(HTTPMethod method, const String& uri, const String& body = "",
+                             const String& contentType = "application/json");
+
+private:
+    struct Route {
+        String uri;
+        HTTPMethod method;
+        THandlerFunction handler;
+    };
+    struct Arg {
+        String name;
+        String value;
+    };
+
+    int _port;
+    std::vector<Route> _routes;
+    THandlerFunction _notFound;
+    String _uri;
+    HTTPMethod _method;
+    std::vector<Arg> _args;
+    size_t _contentLength;
+    HostHttpResponse _response;
+
+    void parseArgs(const String& data);
+    static String urlDecode(const String& text);
+};
+
+#endif // HOST_WEBSERVER_H
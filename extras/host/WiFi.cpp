@@ -0,0 +1,19 @@
+// WiFi.cpp
+#include "WiFi.h"
+
+WiFiClass WiFi;
+
+String IPAddress::toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+    return String(text);
+}
+
+// نفس شروط ESP32: SSID غير فارغ، وكلمة المرور فارغة أو 8 أحرف على الأقل
+bool WiFiClass::softAP(const String& ssid, const String& passphrase) {
+    if (ssid.length() == 0 || ssid.length() > 32 || (passphrase.length() > 0 && passphrase.length() < 8)) {
+        return false;
+    }
+    _ssid = ssid;
+    return true;
+}
@@ -0,0 +1,41 @@
+// WiFi.h
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "Arduino.h"
+
+#define WIFI_OFF 0
+#define WIFI_STA 1
+#define WIFI_AP 2
+#define WIFI_AP_STA 3
+
+class IPAddress : public Printable {
+public:
+    IPAddress() : IPAddress(0, 0, 0, 0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+    uint8_t operator[](int index) const { return _bytes[index]; }
+    String toString() const;
+    size_t printTo(Print& p) const override { return p.print(toString()); }
+
+private:
+    uint8_t _bytes[4];
+};
+
+// نقطة الوصول على الحاسوب: تحفظ الإعدادات فقط (الخادم يستمع على واجهات الحاسوب)
+class WiFiClass {
+public:
+    WiFiClass() : _mode(WIFI_OFF) {}
+    bool mode(int mode) { _mode = mode; return true; }
+    int getMode() const { return _mode; }
+    bool softAP(const String& ssid, const String& passphrase = "");
+    IPAddress softAPIP() const { return IPAddress(192, 168, 4, 1); }
+    String softAPSSID() const { return _ssid; }
+
+private:
+    int _mode;
+    String _ssid;
+};
+
+extern WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
@@ -0,0 +1,78 @@
+// Wire.cpp
+#include "Wire.h"
+
+TwoWire Wire;
+
+bool TwoWire::begin(int, int, uint32_t frequency) {
+    if (frequency != 0) {
+        _clock = frequency;
+    }
+    return true;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    _address = address;
+    _txLength = 0;
+    _txOverflow = false;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (_txLength >= HOST_WIRE_BUFFER_SIZE) {
+        _txOverflow = true;
+        return 0;
+    }
+    _txBuffer[_txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (!write(data[i])) {
+            return i;
+        }
+    }
+    return length;
+}
+
+uint8_t TwoWire::endTransmission(bool) {
+    _transactions++;
+    if (_txOverflow) {
+        return 1;
+    }
+    HostI2CDevice* device = HostI2C::device(_address);
+    if (device == nullptr) {
+        busTime(0);
+        return 2;
+    }
+    uint8_t status = device->receive(_txBuffer, _txLength);
+    busTime(status == 2 ? 0 : _txLength);
+    return status;
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity, int) {
+    _transactions++;
+    _rxIndex = 0;
+    _rxLength = 0;
+    if (quantity > HOST_WIRE_BUFFER_SIZE) {
+        quantity = HOST_WIRE_BUFFER_SIZE;
+    }
+    HostI2CDevice* device = HostI2C::device((uint8_t)address);
+    if (device != nullptr && quantity > 0) {
+        _rxLength = device->transmit(_rxBuffer, (size_t)quantity);
+    }
+    busTime(_rxLength);
+    return (uint8_t)_rxLength;
+}
+
+// زمن المعاملة على الناقل: بايت العنوان والبيانات، 9 نبضات لكل منها (مع الإقرار)
+// (بالسرعة المطلوبة، أو بحد نموذج التوقيت في HostI2C إذا كان أقل)
+void TwoWire::busTime(size_t bytes) {
+    uint32_t clock = _clock;
+    if (HostI2C::maxClock() != 0 && HostI2C::maxClock() < clock) {
+        clock = HostI2C::maxClock();
+    }
+    if (HostClock::realTime() || clock == 0) {
+        return;
+    }
+    HostClock::advance((uint64_t)(bytes + 1) * 9 * 1000000ULL / clock);
+}
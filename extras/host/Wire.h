@@ -0,0 +1,54 @@
+// Wire.h
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+#include "HostI2C.h"
+
+// حجم مخزن المعاملة (مثل ESP32 الحديث؛ المكتبة لا تتجاوز 2 + EXTERNAL_EEPROM_PAGE_SIZE)
+#define HOST_WIRE_BUFFER_SIZE 256
+
+// ناقل I2C على الحاسوب: كل معاملة تُسلَّم عند نهايتها للجهاز المسجل على عنوانها في HostI2C،
+// وتُقدَّم الساعة الافتراضية بزمن النقل على سرعة الناقل الحالية (9 بتات لكل بايت مع العنوان)،
+// فتقيس الاختبارات أثر setClock وعدد المعاملات دون عتاد.
+class TwoWire {
+public:
+    TwoWire() : _clock(100000UL), _address(0), _txLength(0), _txOverflow(false), _rxLength(0), _rxIndex(0), _transactions(0) {}
+
+    bool begin() { return true; }
+    bool begin(int sda, int scl, uint32_t frequency = 0);
+    void end() {}
+    void setClock(uint32_t frequency) { _clock = frequency; }
+    uint32_t getClock() const { return _clock; }
+
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t length);
+    // 0 نجاح، 1 المخزن ممتلئ، 2 لا إقرار بالعنوان، 3 لا إقرار بالبيانات
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(int address, int quantity, int sendStop = 1);
+    int available() { return _rxLength - _rxIndex; }
+    int read() { return _rxIndex < _rxLength ? _rxBuffer[_rxIndex++] : -1; }
+    int peek() { return _rxIndex < _rxLength ? _rxBuffer[_rxIndex] : -1; }
+
+    // عدد المعاملات منذ البدء (كتابة وقراءة)
+    uint32_t transactions() const { return _transactions; }
+
+private:
+    uint32_t _clock;
+    uint8_t _address;
+    uint8_t _txBuffer[HOST_WIRE_BUFFER_SIZE];
+    size_t _txLength;
+    bool _txOverflow;
+    uint8_t _rxBuffer[HOST_WIRE_BUFFER_SIZE];
+    size_t _rxLength;
+    size_t _rxIndex;
+    uint32_t _transactions;
+
+    void busTime(size_t bytes);
+};
+
+extern TwoWire Wire;
+
+#endif // HOST_WIRE_H
@@ -0,0 +1,114 @@
+// AsyncHttpServerTest.cpp
+// محرك AsyncHttpServer فوق مقابس وهمية: الرد المجزأ الكبير يُرسل كاملاً لعميل يستلم،
+// ويُلغى دون انتظار داخل المعالج لعميل توقف عن الاستلام.
+#include "HostTest.h"
+#include "AsyncHttpServer.h"
+#include "HttpSocketBackend.h"
+
+// اتصال واحد بطلب جاهز؛ الكتابة تقبل حتى capacity بايت في كل مرور لـ handleClient (وتُرجع 0 بعدها)
+class FakeSocketBackend : public HttpSocketBackend {
+public:
+    FakeSocketBackend(const char* request, size_t capacity)
+        : request(request), capacity(capacity), room(capacity), pending(true), closed(false) {}
+
+    bool listen(uint16_t) override { return true; }
+    int accept() override {
+        if (!pending) {
+            return -1;
+        }
+        pending = false;
+        return 1;
+    }
+    int read(int, uint8_t* buffer, size_t size) override {
+        size_t length = request.length() < size ? request.length() : size;
+        memcpy(buffer, request.c_str(), length);
+        request.remove(0, length);
+        return (int)length;
+    }
+    int write(int, const uint8_t* data, size_t size) override {
+        if (size > room) {
+            size = room;
+        }
+        received.concat((const char*)data, size);
+        room -= size;
+        return (int)size;
+    }
+    void close(int) override { closed = true; }
+    void wait(uint32_t, bool) override {}
+
+    // مرور جديد: العميل استلم ما في مخزن الإرسال
+    void refill() { room = capacity; }
+
+    String request;
+    String received;
+    size_t capacity;
+    size_t room;
+    bool pending;
+    bool closed;
+};
+
+static const char* const STREAM_REQUEST = "GET /stream HTTP/1.1\r\nHost: test\r\n\r\n";
+#define STREAM_CHUNK_SIZE 1024
+
+static uint32_t chunksSent = 0;
+
+// رد مجزأ من chunks جزءاً بحجم STREAM_CHUNK_SIZE
+static void streamRoute(AsyncHttpServer& server, uint32_t chunks) {
+    server.on("/stream", HTTP_GET, [&server, chunks]() {
+        String chunk;
+        for (int i = 0; i < STREAM_CHUNK_SIZE; i++) {
+            chunk += (char)('a' + i % 26);
+        }
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "text/plain", "");
+        for (chunksSent = 0; chunksSent < chunks; chunksSent++) {
+            server.sendContent(chunk);
+        }
+        server.sendContent("");
+    });
+}
+
+// رد أكبر بكثير من HTTP_OUTPUT_MAX_PENDING لعميل يستلم كل ما يُرسل
+HOST_TEST(readingClientGetsWholeResponse) {
+    FakeSocketBackend backend(STREAM_REQUEST, 1u << 30);
+    AsyncHttpServer server(backend);
+    streamRoute(server, 64);
+    server.begin();
+    server.handleClient();
+    CHECK_EQUAL(64u, chunksSent);
+    CHECK(backend.received.startsWith("HTTP/1.1 200"));
+    CHECK(backend.received.endsWith("\r\n0\r\n\r\n"));
+    CHECK((size_t)backend.received.length() > (size_t)64 * STREAM_CHUNK_SIZE);
+    CHECK_EQUAL(0u, server.stats().timeouts);
+    CHECK(!backend.closed);
+}
+
+// عميل يستلم ببطء (HTTP_OUTPUT_HIGH_WATER في كل مرور): ما لم يُرسل أثناء المعالج يبقى في المخزن
+// ويكتمل عبر مرورات handleClient التالية
+HOST_TEST(slowClientFinishesAcrossPasses) {
+    FakeSocketBackend backend(STREAM_REQUEST, HTTP_OUTPUT_HIGH_WATER);
+    AsyncHttpServer server(backend);
+    streamRoute(server, HTTP_OUTPUT_MAX_PENDING / STREAM_CHUNK_SIZE);
+    server.begin();
+    for (int pass = 0; pass < 1000 && !backend.received.endsWith("\r\n0\r\n\r\n"); pass++) {
+        server.handleClient();
+        backend.refill();
+    }
+    CHECK(backend.received.endsWith("\r\n0\r\n\r\n"));
+    CHECK_EQUAL(0u, server.stats().timeouts);
+}
+
+// عميل لا يستلم: المعالج ينتهي فوراً دون delay()، والرد يُلغى والاتصال يُغلق
+HOST_TEST(stalledClientAbortsWithoutBlocking) {
+    FakeSocketBackend backend(STREAM_REQUEST, 0);
+    AsyncHttpServer server(backend);
+    streamRoute(server, 64);
+    server.begin();
+    uint64_t before = HostClock::micros();
+    server.handleClient();
+    CHECK_EQUAL(before, HostClock::micros());
+    CHECK_EQUAL(64u, chunksSent);
+    CHECK_EQUAL(1u, server.stats().timeouts);
+    CHECK(backend.closed);
+    CHECK_EQUAL(0u, (unsigned)server.stats().active);
+}
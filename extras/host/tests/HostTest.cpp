@@ -0,0 +1,120 @@
+// HostTest.cpp
+#include "HostTest.h"
+#include "Sim24C256.h"
+#include "SimDS3231.h"
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// دبوس المحاكاة الموصول بمخرج INT/SQW في DS3231 (نفس الخادم وقياس الأداء على الحاسوب)
+#define HOST_TEST_RTC_INTERRUPT_PIN 4
+// أقصى عدد حالات في برنامج اختبار واحد
+#define HOST_TEST_MAX_CASES 64
+
+struct HostTestCase {
+    const char* name;
+    HostTestFunction function;
+};
+
+static HostTestCase cases[HOST_TEST_MAX_CASES];
+static uint8_t caseCount = 0;
+static uint32_t failures = 0; // في العملية الفرعية للحالة الجارية
+
+HostTest::HostTest(const char* name, HostTestFunction function) {
+    if (caseCount < HOST_TEST_MAX_CASES) {
+        cases[caseCount++] = { name, function };
+    }
+}
+
+void HostTest::fail(const char* file, int line, const String& message) {
+    failures++;
+    fprintf(stderr, "%s:%d: فشل: %s\n", file, line, message.c_str());
+}
+
+static bool selected(const char* name, int argc, char** argv) {
+    if (argc < 2) {
+        return true;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int HostTest::run(int argc, char** argv) {
+    uint32_t failed = 0;
+    uint32_t executed = 0;
+    for (uint8_t i = 0; i < caseCount; i++) {
+        if (!selected(cases[i].name, argc, argv)) {
+            continue;
+        }
+        executed++;
+        fflush(stdout);
+        pid_t child = fork();
+        if (child == 0) {
+            cases[i].function();
+            fflush(stdout);
+            _exit(failures == 0 ? 0 : 1);
+        }
+        int status = 1;
+        if (child < 0 || waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failed++;
+            printf("[FAIL] %s\n", cases[i].name);
+        } else {
+            printf("[ OK ] %s\n", cases[i].name);
+        }
+    }
+    printf("%u/%u passed\n", executed - failed, executed);
+    return failed == 0 && executed > 0 ? 0 : 1;
+}
+
+// --- HostTestDevice ---
+
+HostTestDevice::HostTestDevice() : web(80), users(web, RELAY_PIN), schedules(web, RELAY_PIN), prayers(web, RELAY_PIN) {
+}
+
+HostTestDevice& HostTestDevice::begin(const DateTime& start) {
+    Serial.setOutput(nullptr);
+    // ذاكرة مصفرة كجهاز جديد (الإعدادات الافتراضية في المكتبة تفترض الأصفار، لا 0xFF)
+    memset(HostI2C::eeprom().data(), 0, SIM_24C256_SIZE);
+    // ضبط الساعة قبل المديرات حتى لا يُرى فقدان الطاقة (OSF)
+    HostI2C::rtc().setTime(start.unixtime());
+    HostI2C::rtc().connectInterrupt(HOST_TEST_RTC_INTERRUPT_PIN);
+
+    static HostTestDevice device;
+    device.users.beginAPAndWebServer("Smart Timer", "sM@rt123");
+    device.users.setupUserEndpoints();
+    device.schedules.setupScheduleEndpoints();
+    device.prayers.setupPrayerEndpoints();
+    TimeService::attachInterruptPin(HOST_TEST_RTC_INTERRUPT_PIN);
+    return device;
+}
+
+void HostTestDevice::run(uint32_t ms) {
+    uint64_t end = HostClock::micros() + (uint64_t)ms * 1000;
+    while (HostClock::micros() < end) {
+        users.handleClient();
+        uint64_t remainingMs = (end - HostClock::micros()) / 1000;
+        uint32_t wait = TaskScheduler::nextDeadline();
+        if (wait > 1000) {
+            wait = 1000;
+        }
+        if (wait > remainingMs) {
+            wait = (uint32_t)remainingMs;
+        }
+        delay(wait > 0 ? wait : 1);
+    }
+    users.handleClient();
+}
+
+bool HostTestDevice::relayOn(uint8_t channel) {
+    // حالة القناة نفسها لا حالة أحد الطلبات في "claims"
+    String expected = "\"channel\":" + String(channel) + ",\"state\":\"on\"";
+    return contains(request(HTTP_GET, "/api/relay/get_state?channel=" + String(channel)), expected.c_str());
+}
+
+int main(int argc, char** argv) {
+    return HostTest::run(argc, argv);
+}
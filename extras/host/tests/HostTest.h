@@ -0,0 +1,80 @@
+// HostTest.h
+// إطار اختبار صغير للاختبارات على الحاسوب (ctest): HOST_TEST يسجل حالة، و CHECK/CHECK_EQUAL تسجلان الفشل وتكملان.
+// كل حالة تُشغل في عملية فرعية مستقلة (مثل نماذج smartcontrol_bench)، فتبدأ المديرات وعداداتها
+// والذاكرة والساعة المحاكاة من حالة نظيفة. برنامج الاختبار يُرجع 0 إذا نجحت جميع الحالات.
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include "UserManager.h"
+#include "ScheduleManager.h"
+#include "PrayerTimesManager.h"
+
+typedef void (*HostTestFunction)();
+
+class HostTest {
+public:
+    // تسجيل حالة (من مُنشئ كائن عام يولده HOST_TEST)
+    HostTest(const char* name, HostTestFunction function);
+
+    // تشغيل جميع الحالات، أو الحالات المسماة في سطر الأوامر فقط
+    static int run(int argc, char** argv);
+    static void fail(const char* file, int line, const String& message);
+
+    template <typename Expected, typename Actual>
+    static void checkEqual(const char* file, int line, const char* expression, const Expected& expected, const Actual& actual) {
+        if (!(expected == actual)) {
+            fail(file, line, String(expression) + ": المتوقع " + text(expected) + "، الفعلي " + text(actual));
+        }
+    }
+
+private:
+    static String text(const String& value) { return "\"" + value + "\""; }
+    static String text(const char* value) { return "\"" + String(value) + "\""; }
+    static String text(bool value) { return value ? "true" : "false"; }
+    template <typename T>
+    static String text(const T& value) { return String(value); }
+};
+
+#define HOST_TEST(name)                                          \
+    static void name();                                          \
+    static HostTest name##Registration(#name, name);             \
+    static void name()
+
+#define CHECK(condition)                                         \
+    do {                                                         \
+        if (!(condition)) {                                      \
+            HostTest::fail(__FILE__, __LINE__, #condition);      \
+        }                                                        \
+    } while (0)
+
+#define CHECK_EQUAL(expected, actual) HostTest::checkEqual(__FILE__, __LINE__, #actual, expected, actual)
+
+// جهاز كامل على WebServer داخل العملية: المديرات الثلاثة بنقاط نهايتها، و DS3231 مضبوطة على start
+// ومخرجها INT موصول بدبوس محاكى، والسجل التسلسلي مكتوم. الساعة افتراضية، فـ run() يقدم يوماً كاملاً في أجزاء من الثانية.
+class HostTestDevice {
+public:
+    static HostTestDevice& begin(const DateTime& start = DateTime(2026, 1, 1, 0, 0, 0));
+
+    HostHttpResponse request(HTTPMethod method, const String& uri, const String& body = "") {
+        return web.request(method, uri, body);
+    }
+    // تشغيل حلقة الجهاز ms من الزمن المحاكى (الانتظار حتى أقرب موعد في TaskScheduler كما في loop())
+    void run(uint32_t ms);
+    // حالة قناة المرحل كما يعرضها /api/relay/get_state
+    bool relayOn(uint8_t channel = 0);
+
+    WebServer web;
+    UserManager users;
+    ScheduleManagerClass schedules;
+    PrayerTimesManagementClass prayers;
+
+private:
+    HostTestDevice();
+};
+
+// هل يحتوي جسم الرد على النص (مثل "\"found\":true")
+inline bool contains(const HostHttpResponse& response, const char* text) {
+    return response.body.indexOf(text) >= 0;
+}
+
+#endif // HOST_TEST_H
@@ -0,0 +1,104 @@
+// MainControlTest.cpp
+// حَكَم المرحل عبر WebServer داخل العملية: الأولوية الأعلى تغلب، والأحدث عند التساوي، وانتهاء الطلب اليدوي
+// بمهلته، والكتابة على دبوس المرحل عند تغير الحالة فقط.
+#include "HostTest.h"
+
+static String pointBody(int hour, int minute, bool turnOn) {
+    return "{\"hour\":" + String(hour) + ",\"minute\":" + String(minute) + ",\"turnOn\":" +
+           String(turnOn ? "true" : "false") + ",\"repeatEveryDay\":true}";
+}
+
+static HostHttpResponse setState(HostTestDevice& device, const String& body) {
+    return device.request(HTTP_POST, "/api/relay/set_state", body);
+}
+
+// المصدر الفائز على القناة 0 كما يعرضه /api/relay/get_state
+static bool winnerIs(HostTestDevice& device, const char* source) {
+    return contains(device.request(HTTP_GET, "/api/relay/get_state"), ("\"source\":\"" + String(source) + "\",\"mask\"").c_str());
+}
+
+// طلب يدوي بأولوية أعلى يبقى فائزاً على جدول أحدث منه، وخفض أولويته يعيد القناة للجدول
+HOST_TEST(higherPriorityWins) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/relay/set_arbiter",
+                                    "{\"priority\":{\"manual\":5,\"schedule\":1}}").code);
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 1, true));
+    CHECK_EQUAL(200, setState(device, "{\"state\":\"off\"}").code);
+    device.run(90 * 1000UL);
+    CHECK(!device.relayOn());
+    CHECK(winnerIs(device, "manual"));
+
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/relay/set_arbiter", "{\"priority\":{\"manual\":0}}").code);
+    CHECK(device.relayOn());
+    CHECK(winnerIs(device, "schedule"));
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/relay/set_arbiter", "{\"priority\":{\"manual\":256}}").code);
+}
+
+// بأولويات متساوية (الافتراضي) يفوز آخر طلب أياً كان مصدره
+HOST_TEST(newestClaimWinsOnTie) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 1, true));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 3, false));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 4, true));
+    device.run(90 * 1000UL);  // 00:01:30
+    CHECK(device.relayOn());
+    CHECK(winnerIs(device, "schedule"));
+    device.run(30 * 1000UL);  // 00:02
+    setState(device, "{\"state\":\"off\"}");
+    CHECK(!device.relayOn());
+    CHECK(winnerIs(device, "manual"));
+    device.run(90 * 1000UL);  // 00:03:30: إيقاف الجدول أحدث، والحالة لا تتغير
+    CHECK(!device.relayOn());
+    CHECK(winnerIs(device, "schedule"));
+    device.run(60 * 1000UL);  // 00:04:30
+    CHECK(device.relayOn());
+}
+
+// الطلب اليدوي بمهلة ينتهي ويعيد القناة لما يقرره الجدول (مهلة الطلب أو مهلة المصدر المحفوظة)
+HOST_TEST(manualClaimExpiresAfterTimeout) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 1, true));
+    device.run(90 * 1000UL);
+    CHECK(device.relayOn());
+
+    setState(device, "{\"state\":\"off\",\"seconds\":60}");
+    CHECK(!device.relayOn());
+    CHECK(contains(device.request(HTTP_GET, "/api/relay/get_state"), "\"remaining\":60"));
+    device.run(59 * 1000UL);
+    CHECK(!device.relayOn());
+    device.run(2 * 1000UL);
+    CHECK(device.relayOn());
+    CHECK(winnerIs(device, "schedule"));
+
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/relay/set_arbiter", "{\"timeout\":{\"manual\":30}}").code);
+    setState(device, "{\"state\":\"off\"}");
+    CHECK(!device.relayOn());
+    device.run(31 * 1000UL);
+    CHECK(device.relayOn());
+}
+
+// دبوس المرحل يُكتب عند تغير الحالة الفعلية فقط، لا عند كل طلب
+HOST_TEST(relayPinWrittenOnlyOnChange) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 1, true));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(23, 0, false)); // آخر حدث قبل البدء: إيقاف
+    device.run(1000);
+    CHECK(!device.relayOn());
+    uint32_t writes = HostPins::writes(RELAY_PIN);
+
+    setState(device, "{\"state\":\"on\"}");
+    CHECK_EQUAL(writes + 1, HostPins::writes(RELAY_PIN));
+    CHECK_EQUAL(HIGH, (int)HostPins::output(RELAY_PIN));
+    setState(device, "{\"state\":\"on\"}");
+    device.run(90 * 1000UL); // الجدول يطلب نفس الحالة عند 00:01
+    CHECK(winnerIs(device, "schedule"));
+    device.request(HTTP_POST, "/api/relay/set_arbiter", "{\"priority\":{\"card\":2}}");
+    CHECK_EQUAL(writes + 1, HostPins::writes(RELAY_PIN));
+
+    setState(device, "{\"state\":\"off\"}");
+    CHECK_EQUAL(writes + 2, HostPins::writes(RELAY_PIN));
+    CHECK_EQUAL(LOW, (int)HostPins::output(RELAY_PIN));
+    setState(device, "{\"state\":\"auto\"}"); // الجدول (تشغيل) يعود فائزاً
+    CHECK_EQUAL(writes + 3, HostPins::writes(RELAY_PIN));
+    CHECK(device.relayOn());
+}
@@ -0,0 +1,88 @@
+// PrayerCalcAccuracyTest.cpp
+// دقة محرك PrayerCalc (float) مقارنة بالمرجع PrayerReference (double) على شبكة من خطوط العرض والطول
+// والتواريخ لكل طرق الحساب ومعاملي العصر: كل الفروق ضمن ±1 دقيقة (حدود التقريب لأقرب دقيقة).
+// المرجع يستخدم نفس الصيغ، فيكشف خطأ الدقة المفردة فقط؛ المقارنة مع مكتبة PrayerTimes (التطبيق السابق)
+// في مثال examples/PrayerEngineAccuracy على الجهاز.
+#include "HostTest.h"
+#include "PrayerReference.h"
+#include <stdlib.h>
+
+// أكبر فرق مسموح بالدقائق
+#define ACCURACY_TOLERANCE_MINUTES 1
+
+// فرق دقيقتين من اليوم مع الالتفاف حول منتصف الليل
+static int minuteDifference(int a, int b) {
+    int diff = abs(a - b);
+    return diff > 720 ? 1440 - diff : diff;
+}
+
+// يُرجع أكبر فرق في اليوم ويضيف عدد العينات الخارجة عن الحد
+static int compareDay(const int native[PRAYER_COUNT], const int expected[PRAYER_COUNT], uint32_t& outside) {
+    int worst = 0;
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        int diff = minuteDifference(native[i], expected[i]);
+        if (diff > ACCURACY_TOLERANCE_MINUTES) {
+            outside++;
+        }
+        if (diff > worst) {
+            worst = diff;
+        }
+    }
+    return worst;
+}
+
+// calculateDay لكل طريقة ومعامل عصر، خطوط عرض -48..60 وخطوط طول -150..180، وأربعة أيام من كل شهر
+HOST_TEST(calculateDayMatchesReference) {
+    uint32_t samples = 0;
+    uint32_t outside = 0;
+    int worst = 0;
+    for (uint8_t method = 0; method < PRAYER_METHOD_COUNT; method++) {
+        for (uint8_t asr = PRAYER_ASR_SHAFII; asr <= PRAYER_ASR_HANAFI; asr++) {
+            for (int lat = -48; lat <= 60; lat += 12) {
+                for (int lon = -150; lon <= 180; lon += 30) {
+                    PrayerSettings settings = { (double)lat, (double)lon, (int)lround(lon / 15.0), method, asr };
+                    for (int month = 1; month <= 12; month++) {
+                        for (int day = 1; day <= 28; day += 9) {
+                            DateTime date(2026, month, day);
+                            int native[PRAYER_COUNT], expected[PRAYER_COUNT];
+                            PrayerCalc::calculateDay(settings, date, native);
+                            PrayerReference::calculateDay(settings, date, expected);
+                            int diff = compareDay(native, expected, outside);
+                            worst = diff > worst ? diff : worst;
+                            samples += PRAYER_COUNT;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    printf("calculateDay: %u samples, worst %d min, %u outside ±%d min\n", samples, worst, outside,
+           ACCURACY_TOLERANCE_MINUTES);
+    CHECK_EQUAL(0u, outside);
+}
+
+// PrayerDayIterator (الجدول السنوي والتقويم) يبقى ضمن الحد عبر سنة كاملة في مواقع متفرقة
+HOST_TEST(dayIteratorMatchesReference) {
+    const PrayerSettings locations[] = {
+        { 30.0444, 31.2357, 2, PRAYER_METHOD_EGYPTIAN, PRAYER_ASR_SHAFII },
+        { 21.4225, 39.8262, 3, PRAYER_METHOD_MAKKAH, PRAYER_ASR_SHAFII },
+        { 59.9139, 10.7522, 1, PRAYER_METHOD_MWL, PRAYER_ASR_HANAFI },
+        { -33.8688, 151.2093, 10, PRAYER_METHOD_ISNA, PRAYER_ASR_SHAFII },
+        { 40.7128, -74.0060, -5, PRAYER_METHOD_KARACHI, PRAYER_ASR_HANAFI },
+    };
+    uint32_t outside = 0;
+    int worst = 0;
+    for (const PrayerSettings& settings : locations) {
+        DateTime first(2026, 1, 1);
+        PrayerDayIterator iterator(settings, first);
+        for (int day = 0; day < 365; day++) {
+            int native[PRAYER_COUNT], expected[PRAYER_COUNT];
+            iterator.next(native);
+            PrayerReference::calculateDay(settings, first + TimeSpan(day, 0, 0, 0), expected);
+            int diff = compareDay(native, expected, outside);
+            worst = diff > worst ? diff : worst;
+        }
+    }
+    printf("PrayerDayIterator: worst %d min, %u outside ±%d min\n", worst, outside, ACCURACY_TOLERANCE_MINUTES);
+    CHECK_EQUAL(0u, outside);
+}
@@ -0,0 +1,245 @@
+// PrayerTimesManagerTest.cpp
+// أوقات الصلاة عبر WebServer داخل العملية: أوقات اليوم، والتقويم الشهري والسنوي، والإعدادات، وحواف المرحل التلقائي.
+#include "HostTest.h"
+#include "Sim24C256.h"
+
+// أسماء أوقات اليوم في رد get_times بالترتيب
+static const char* const TIME_NAMES[PRAYER_COUNT] = { "Fajr", "Sunrise", "Dhuhr", "Asr", "Maghrib", "Isha" };
+
+// الدقائق من منتصف الليل لوقت "HH:MM" في رد get_times (أو -1 إذا لم يوجد)
+static int minutesOf(const HostHttpResponse& response, const char* name) {
+    int at = response.body.indexOf("\"" + String(name) + "\"");
+    if (at < 0) {
+        return -1;
+    }
+    int quote = response.body.indexOf('"', response.body.indexOf(':', at) + 1);
+    if (quote < 0) {
+        return -1;
+    }
+    String value = response.body.substring(quote + 1, quote + 6);
+    return value.substring(0, 2).toInt() * 60 + value.substring(3, 5).toInt();
+}
+
+static int occurrences(const String& text, const char* needle) {
+    int count = 0;
+    for (int at = text.indexOf(needle); at >= 0; at = text.indexOf(needle, at + 1)) {
+        count++;
+    }
+    return count;
+}
+
+HOST_TEST(timesAreOrdered) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 3, 21, 8, 0, 0));
+    HostHttpResponse times = device.request(HTTP_GET, "/api/prayer/get_times");
+    CHECK_EQUAL(200, times.code);
+    int previous = -1;
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        int minutes = minutesOf(times, TIME_NAMES[i]);
+        CHECK(minutes > previous);
+        CHECK(minutes < 24 * 60);
+        previous = minutes;
+    }
+}
+
+HOST_TEST(calendarMonthAndYear) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    HostHttpResponse month = device.request(HTTP_GET, "/api/prayer/get_calendar?year=2026&month=2");
+    CHECK_EQUAL(200, month.code);
+    CHECK(contains(month, "\"year\":2026"));
+    CHECK_EQUAL(28, occurrences(month.body, "[2,"));
+
+    HostHttpResponse year = device.request(HTTP_GET, "/api/prayer/get_calendar?year=2028");
+    CHECK_EQUAL(200, year.code);
+    CHECK_EQUAL(29, occurrences(year.body, "[2,"));
+    CHECK_EQUAL(31, occurrences(year.body, "[12,"));
+
+    CHECK_EQUAL(400, device.request(HTTP_GET, "/api/prayer/get_calendar?year=2026&month=13").code);
+    CHECK_EQUAL(400, device.request(HTTP_GET, "/api/prayer/get_calendar?year=1999").code);
+}
+
+HOST_TEST(configRoundTrip) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 6, 1, 8, 0, 0));
+    HostHttpResponse cairo = device.request(HTTP_GET, "/api/prayer/get_times");
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/prayer/set_config",
+                                    "{\"latitude\":21.4225,\"longitude\":39.8262,\"timezone\":3}").code);
+    CHECK(contains(device.request(HTTP_GET, "/api/prayer/get_config"), "21.42"));
+    HostHttpResponse mecca = device.request(HTTP_GET, "/api/prayer/get_times");
+    CHECK_EQUAL(200, mecca.code);
+    CHECK(cairo.body != mecca.body);
+}
+
+// المعالجات لا تولد الجدول السنوي: تحسب أوقات اليوم مباشرة وتطلب التوليد من مهمته
+// (في الدورة التالية، حتى مع تعطيل المرحل التلقائي). StorageWorker::flush() قبل كل قراءة لعداد الكتابة،
+// لأن الكتابات مع عامل التخزين تكتمل بعد الطلب.
+HOST_TEST(tableRegeneratesOutsideHandlers) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 6, 1, 8, 0, 0));
+    device.run(10);
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/prayer/set_config",
+                                    "{\"latitude\":21.4225,\"longitude\":39.8262,\"timezone\":3}").code);
+    StorageWorker::flush();
+    uint32_t cycles = HostI2C::eeprom().writeCycles();
+    HostHttpResponse direct = device.request(HTTP_GET, "/api/prayer/get_times");
+    CHECK_EQUAL(200, direct.code);
+    CHECK_EQUAL(200, device.request(HTTP_GET, "/api/prayer/get_auto_relay_config").code);
+    StorageWorker::flush();
+    CHECK_EQUAL(cycles, HostI2C::eeprom().writeCycles());
+
+    device.run(10);
+    StorageWorker::flush();
+    CHECK(HostI2C::eeprom().writeCycles() > cycles);
+    // الجدول المولد يعطي نفس أوقات الحساب المباشر
+    device.request(HTTP_POST, "/api/prayer/set_config", "{\"latitude\":21.4225,\"longitude\":39.8262,\"timezone\":3}");
+    CHECK(direct.body == device.request(HTTP_GET, "/api/prayer/get_times").body);
+}
+
+HOST_TEST(tableRegeneratesForNewYear) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 12, 31, 23, 59, 0));
+    device.run(10);
+    device.run(120 * 1000UL);
+    StorageWorker::flush();
+    uint32_t cycles = HostI2C::eeprom().writeCycles();
+    CHECK_EQUAL(200, device.request(HTTP_GET, "/api/prayer/get_times").code);
+    StorageWorker::flush();
+    CHECK_EQUAL(cycles, HostI2C::eeprom().writeCycles());
+    device.run(10);
+    StorageWorker::flush();
+    CHECK(HostI2C::eeprom().writeCycles() > cycles);
+}
+
+// --- المرحل التلقائي لأوقات الصلاة ---
+
+// بداية الجهاز وموضعه على الساعة المحاكاة، لتشغيل الحلقة حتى وقت محدد
+static DateTime relayOrigin;
+static uint64_t relayOriginUs = 0;
+
+static HostTestDevice& beginRelayDevice(const DateTime& start) {
+    HostTestDevice& device = HostTestDevice::begin(start);
+    relayOrigin = start;
+    relayOriginUs = HostClock::micros();
+    return device;
+}
+
+// تشغيل حلقة الجهاز حتى الوقت 'target'
+static void runUntil(HostTestDevice& device, const DateTime& target) {
+    uint64_t targetUs = relayOriginUs + (uint64_t)(target - relayOrigin).totalseconds() * 1000000ULL;
+    if (targetUs > HostClock::micros()) {
+        device.run((uint32_t)((targetUs - HostClock::micros()) / 1000));
+    }
+}
+
+// وقت من اليوم الأول بالدقائق من منتصف الليل (مع إزاحة بالثواني)
+static DateTime relayAt(int minutes, int seconds = 0) {
+    return relayOrigin + TimeSpan((int32_t)minutes * 60 + seconds);
+}
+
+// إعدادات بمصفوفات الأوقات الستة ونوافذ الأوقات المسماة فقط
+static String relayConfigBody(const int before[PRAYER_COUNT], const int after[PRAYER_COUNT], const char* prayers) {
+    String body = "{\"enabled\":true,\"minutesBefore\":[";
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        body += (i > 0 ? "," : "") + String(before[i]);
+    }
+    body += "],\"minutesAfter\":[";
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        body += (i > 0 ? "," : "") + String(after[i]);
+    }
+    return body + "],\"prayers\":[" + prayers + "]}";
+}
+
+// المرحل يعمل عند (الوقت - minutesBefore) ويتوقف عند (الوقت + minutesAfter + دقيقة)
+HOST_TEST(relaySwitchesAtWindowEdges) {
+    HostTestDevice& device = beginRelayDevice(DateTime(2026, 1, 1, 0, 0, 0));
+    int maghrib = minutesOf(device.request(HTTP_GET, "/api/prayer/get_times"), "Maghrib");
+    const int before[PRAYER_COUNT] = { 0, 0, 0, 0, 10, 0 };
+    const int after[PRAYER_COUNT] = { 0, 0, 0, 0, 5, 0 };
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/prayer/set_auto_relay_config",
+                                    relayConfigBody(before, after, "\"Maghrib\"")).code);
+    runUntil(device, relayAt(maghrib - 10, -1));
+    CHECK(!device.relayOn());
+    runUntil(device, relayAt(maghrib - 10, 1));
+    CHECK(device.relayOn());
+    runUntil(device, relayAt(maghrib + 6, -1));
+    CHECK(device.relayOn());
+    runUntil(device, relayAt(maghrib + 6, 1));
+    CHECK(!device.relayOn());
+}
+
+// نافذة العشاء الممتدة بعد منتصف الليل تبقى مشغلة في اليوم التالي حتى نهايتها
+HOST_TEST(relayWindowCrossesMidnight) {
+    HostTestDevice& device = beginRelayDevice(DateTime(2026, 1, 1, 0, 0, 0));
+    int isha = minutesOf(device.request(HTTP_GET, "/api/prayer/get_times"), "Isha");
+    int after = 24 * 60 - isha + 60; // حتى نحو 01:00
+    const int beforeMinutes[PRAYER_COUNT] = { 0, 0, 0, 0, 0, 0 };
+    const int afterMinutes[PRAYER_COUNT] = { 0, 0, 0, 0, 0, after };
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/prayer/set_auto_relay_config",
+                                    relayConfigBody(beforeMinutes, afterMinutes, "\"Isha\"")).code);
+    // نافذة الأمس (31 ديسمبر) ما زالت قائمة عند تفعيل الإعدادات، وتنتهي نحو 01:00
+    runUntil(device, relayAt(30));
+    CHECK(device.relayOn());
+    runUntil(device, relayAt(isha + after - 24 * 60 + 3));
+    CHECK(!device.relayOn());
+    runUntil(device, relayAt(isha, 1));
+    CHECK(device.relayOn());
+    runUntil(device, relayAt(24 * 60 + 10));
+    CHECK(device.relayOn());
+    // العشاء يتغير أقل من دقيقتين بين اليومين
+    runUntil(device, relayAt(isha + after - 2));
+    CHECK(device.relayOn());
+    runUntil(device, relayAt(isha + after + 3));
+    CHECK(!device.relayOn());
+}
+
+// نافذتان متداخلتان (المغرب ثم العشاء) تُدمجان: تشغيل واحد وإيقاف واحد دون انقطاع بينهما
+HOST_TEST(overlappingWindowsMerge) {
+    HostTestDevice& device = beginRelayDevice(DateTime(2026, 1, 1, 0, 0, 0));
+    HostHttpResponse times = device.request(HTTP_GET, "/api/prayer/get_times");
+    int maghrib = minutesOf(times, "Maghrib");
+    int isha = minutesOf(times, "Isha");
+    const int before[PRAYER_COUNT] = { 0, 0, 0, 0, 0, 10 };
+    const int after[PRAYER_COUNT] = { 0, 0, 0, 0, isha - maghrib - 5, 5 };
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/prayer/set_auto_relay_config",
+                                    relayConfigBody(before, after, "\"Maghrib\",\"Isha\"")).code);
+    HostHttpResponse config = device.request(HTTP_GET, "/api/prayer/get_auto_relay_config");
+    StaticJsonDocument<1024> doc;
+    CHECK(!deserializeJson(doc, config.body));
+    CHECK_EQUAL((size_t)1, doc["windows"].size());
+    CHECK_EQUAL(maghrib, doc["windows"][0][0].as<int>());
+    CHECK_EQUAL(isha + 6, doc["windows"][0][1].as<int>());
+
+    runUntil(device, relayAt(maghrib - 1));
+    uint32_t writes = HostPins::writes(RELAY_PIN);
+    for (int minute = maghrib; minute < isha + 6; minute++) {
+        runUntil(device, relayAt(minute, 30));
+        CHECK(device.relayOn());
+    }
+    runUntil(device, relayAt(isha + 7));
+    CHECK(!device.relayOn());
+    CHECK_EQUAL(writes + 2, HostPins::writes(RELAY_PIN));
+}
+
+// المصفوفات القديمة بثلاثة عناصر تقابل الفجر والمغرب والعشاء
+HOST_TEST(legacyArraysMapToFajrMaghribIsha) {
+    HostTestDevice& device = beginRelayDevice(DateTime(2026, 1, 1, 0, 0, 0));
+    int fajr = minutesOf(device.request(HTTP_GET, "/api/prayer/get_times"), "Fajr");
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/prayer/set_auto_relay_config",
+                                    "{\"enabled\":true,\"minutesBefore\":[1,2,3],\"minutesAfter\":[4,5,6]}").code);
+    HostHttpResponse config = device.request(HTTP_GET, "/api/prayer/get_auto_relay_config");
+    StaticJsonDocument<1024> doc;
+    CHECK(!deserializeJson(doc, config.body));
+    const int before[PRAYER_COUNT] = { 1, 0, 0, 0, 2, 3 };
+    const int after[PRAYER_COUNT] = { 4, 0, 0, 0, 5, 6 };
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        CHECK_EQUAL(before[i], doc["minutesBefore"][i].as<int>());
+        CHECK_EQUAL(after[i], doc["minutesAfter"][i].as<int>());
+    }
+    CHECK_EQUAL((size_t)3, doc["prayers"].size());
+    CHECK_EQUAL(String("Fajr"), String(doc["prayers"][0].as<const char*>()));
+    CHECK_EQUAL(String("Maghrib"), String(doc["prayers"][1].as<const char*>()));
+    CHECK_EQUAL(String("Isha"), String(doc["prayers"][2].as<const char*>()));
+
+    runUntil(device, relayAt(fajr - 1, -1));
+    CHECK(!device.relayOn());
+    runUntil(device, relayAt(fajr - 1, 1));
+    CHECK(device.relayOn());
+    runUntil(device, relayAt(fajr + 5, 1));
+    CHECK(!device.relayOn());
+}
@@ -0,0 +1,91 @@
+// RelayChannelsTest.cpp
+// قنوات المرحل المتعددة (تُبنى مع RELAY_CHANNEL_COUNT=3 والدبابيس 16 و 17 و 18): الجدول يقود قناته فقط،
+// وقناع القنوات يبقى بعد إعادة التشغيل عبر getRelayStateFromEEPROM، وأرقام القنوات خارج المدى ترجع 400.
+#include "HostTest.h"
+#include "Sim24C256.h"
+
+static const uint8_t CHANNEL_PINS[RELAY_CHANNEL_COUNT] = RELAY_CHANNEL_PINS;
+
+static String pointBody(int hour, int minute, bool turnOn, int channel) {
+    return "{\"hour\":" + String(hour) + ",\"minute\":" + String(minute) + ",\"turnOn\":" +
+           String(turnOn ? "true" : "false") + ",\"repeatEveryDay\":true,\"channel\":" + String(channel) + "}";
+}
+
+// جدول على القناة 1 يشغلها ويطفئها دون أن تتحرك القناتان 0 و 2
+HOST_TEST(scheduleDrivesOnlyItsChannel) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 1, true, 1)).code);
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 2, false, 1)).code);
+    device.run(1000);
+    uint32_t actuations[RELAY_CHANNEL_COUNT];
+    for (uint8_t c = 0; c < RELAY_CHANNEL_COUNT; c++) {
+        actuations[c] = RelayOutput::actuations(c);
+    }
+
+    device.run(90 * 1000UL); // 00:01:30
+    CHECK(device.relayOn(1));
+    CHECK(!device.relayOn(0));
+    CHECK(!device.relayOn(2));
+    CHECK_EQUAL(LOW, (int)HostPins::output(CHANNEL_PINS[0]));
+    CHECK_EQUAL(HIGH, (int)HostPins::output(CHANNEL_PINS[1]));
+    CHECK_EQUAL(LOW, (int)HostPins::output(CHANNEL_PINS[2]));
+    CHECK(contains(device.request(HTTP_GET, "/api/relay/get_state"), "\"mask\":2"));
+
+    device.run(60 * 1000UL); // 00:02:30
+    CHECK(!device.relayOn(1));
+    CHECK_EQUAL(LOW, (int)HostPins::output(CHANNEL_PINS[1]));
+    CHECK_EQUAL(actuations[0], RelayOutput::actuations(0));
+    CHECK_EQUAL(actuations[1] + 2, RelayOutput::actuations(1));
+    CHECK_EQUAL(actuations[2], RelayOutput::actuations(2));
+}
+
+// القناع المحفوظ (بايت واحد في RELAY_STATE_ADDR) يعيد كل قناة إلى حالتها عند الإقلاع التالي
+HOST_TEST(channelMaskSurvivesRestart) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    device.request(HTTP_POST, "/api/relay/set_state", "{\"state\":\"on\",\"channels\":[0,2]}");
+    device.request(HTTP_POST, "/api/relay/set_state", "{\"state\":\"off\",\"channel\":0}");
+    CHECK_EQUAL((uint8_t)0x04, device.users.getRelayStateFromEEPROM());
+    CHECK_EQUAL((uint8_t)0x04, HostI2C::eeprom().data()[RELAY_STATE_ADDR]);
+
+    // انقطاع الطاقة: المخارج تعود منخفضة، ثم جهاز جديد على نفس EEPROM
+    for (uint8_t c = 0; c < RELAY_CHANNEL_COUNT; c++) {
+        digitalWrite(CHANNEL_PINS[c], LOW);
+    }
+    WebServer web(81);
+    UserManager restarted(web, RELAY_PIN);
+    restarted.beginAPAndWebServer("Smart Timer", "sM@rt123");
+    CHECK_EQUAL((uint8_t)0x04, restarted.getRelayStateFromEEPROM());
+    CHECK_EQUAL(LOW, (int)HostPins::output(CHANNEL_PINS[0]));
+    CHECK_EQUAL(LOW, (int)HostPins::output(CHANNEL_PINS[1]));
+    CHECK_EQUAL(HIGH, (int)HostPins::output(CHANNEL_PINS[2]));
+
+    // بتات القنوات غير الموجودة في البايت المحفوظ تُهمل
+    HostI2C::eeprom().data()[RELAY_STATE_ADDR] = 0xF9;
+    CHECK_EQUAL((uint8_t)0x01, restarted.getRelayStateFromEEPROM());
+}
+
+// channel و channels خارج 0..RELAY_CHANNEL_COUNT-1 ترجع 400 دون تغيير أي قناة أو إعداد
+HOST_TEST(outOfRangeChannelsReturn400) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    const char* setStateBodies[] = {
+        "{\"state\":\"on\",\"channel\":3}",
+        "{\"state\":\"on\",\"channel\":-1}",
+        "{\"state\":\"on\",\"channels\":[0,3]}",
+        "{\"state\":\"auto\",\"channels\":[8]}",
+    };
+    for (const char* body : setStateBodies) {
+        HostTest::checkEqual(__FILE__, __LINE__, body, 400, device.request(HTTP_POST, "/api/relay/set_state", body).code);
+    }
+    CHECK_EQUAL(400, device.request(HTTP_GET, "/api/relay/get_state?channel=3").code);
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/relay/set_arbiter", "{\"channels\":{\"card\":[1,3]}}").code);
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 1, true, 3)).code);
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 1, true, -1)).code);
+
+    CHECK(contains(device.request(HTTP_GET, "/api/relay/get_state"), "\"mask\":0"));
+    CHECK(contains(device.request(HTTP_GET, "/api/relay/get_arbiter"), "\"card\":[0]"));
+    CHECK(contains(device.request(HTTP_GET, "/api/schedules/get_all"), "[]"));
+
+    // الحد الأعلى الصالح مقبول
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/relay/set_state", "{\"state\":\"on\",\"channel\":2}").code);
+    CHECK(device.relayOn(2));
+}
@@ -0,0 +1,181 @@
+// ScheduleManagerTest.cpp
+// الجداول الزمنية عبر WebServer داخل العملية: الإضافة والحذف، وتنفيذ المواعيد على الساعة المحاكاة،
+// وفترات الاستثناء، وضبط الوقت.
+#include "HostTest.h"
+
+static String pointBody(int hour, int minute, bool turnOn) {
+    return "{\"hour\":" + String(hour) + ",\"minute\":" + String(minute) + ",\"turnOn\":" +
+           String(turnOn ? "true" : "false") + ",\"repeatEveryDay\":true}";
+}
+
+HOST_TEST(pointSchedulesDriveRelay) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 1, true)).code);
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 3, false)).code);
+    CHECK(!device.relayOn());
+    device.run(90 * 1000UL);
+    CHECK(device.relayOn());
+    device.run(120 * 1000UL);
+    CHECK(!device.relayOn());
+    // المواعيد تتكرر في اليوم التالي
+    device.run(86400UL * 1000UL - 120 * 1000UL);
+    CHECK(device.relayOn());
+}
+
+HOST_TEST(addListAndDelete) {
+    HostTestDevice& device = HostTestDevice::begin();
+    HostHttpResponse first = device.request(HTTP_POST, "/api/schedules/add", pointBody(6, 30, true));
+    HostHttpResponse second = device.request(HTTP_POST, "/api/schedules/add", pointBody(7, 45, false));
+    CHECK_EQUAL(200, first.code);
+    CHECK_EQUAL(200, second.code);
+    CHECK(first.body != second.body); // معرفات مختلفة
+
+    HostHttpResponse all = device.request(HTTP_GET, "/api/schedules/get_all");
+    CHECK_EQUAL(200, all.code);
+    CHECK(contains(all, "\"hour\":6,\"minute\":30"));
+    CHECK(contains(all, "\"hour\":7,\"minute\":45"));
+
+    String id = first.body.substring(first.body.indexOf("\"id\":") + 5);
+    id = id.substring(0, id.indexOf('}'));
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/schedules/delete", "{\"id\":" + id + "}").code);
+    CHECK_EQUAL(404, device.request(HTTP_POST, "/api/schedules/delete", "{\"id\":" + id + "}").code);
+    all = device.request(HTTP_GET, "/api/schedules/get_all");
+    CHECK(!contains(all, "\"hour\":6,\"minute\":30"));
+    CHECK(contains(all, "\"hour\":7,\"minute\":45"));
+    CHECK(contains(device.request(HTTP_GET, "/api/schedules/get_all?offset=0&limit=5"), "\"total\":1"));
+}
+
+HOST_TEST(rejectsInvalidFields) {
+    HostTestDevice& device = HostTestDevice::begin();
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/schedules/add", pointBody(24, 0, true)).code);
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/schedules/add", pointBody(1, 60, true)).code);
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/schedules/add", "{\"hour\":1,\"minute\":0,\"type\":\"weekly\"}").code);
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/schedules/add", "{\"hour\":").code);
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/schedules/add").code);
+    CHECK(contains(device.request(HTTP_GET, "/api/schedules/get_all"), "[]"));
+}
+
+// فترة suppress تمنع مواعيد يومها فقط
+HOST_TEST(exceptionSuppressesDay) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 1, true));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(0, 2, false));
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/schedules/exceptions/add",
+                                    "{\"from\":\"2026-01-01\",\"to\":\"2026-01-01\",\"kind\":\"suppress\"}").code);
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/schedules/exceptions/add",
+                                    "{\"from\":\"2026-01-05\",\"to\":\"2026-01-04\"}").code);
+    CHECK(contains(device.request(HTTP_GET, "/api/schedules/exceptions/get_all"), "2026-01-01"));
+    device.run(90 * 1000UL);
+    CHECK(!device.relayOn());
+    device.run(86400UL * 1000UL);
+    CHECK(device.relayOn());
+}
+
+// حلقة متأخرة (توليد الجدول السنوي أو عميل عالق) حتى بعد حدثين: الحالة النهائية حسب آخرهما
+HOST_TEST(lateWakeAppliesMissedEvents) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 5, 59, 0));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(6, 0, true));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(6, 1, false));
+    device.run(1000);
+    CHECK(!device.relayOn());
+    HostClock::advance(3 * 60 * 1000000ULL); // 06:02:01 دون خدمة المهام
+    device.run(1000);
+    CHECK(!device.relayOn());
+    // التشغيل التالي في موعده
+    device.run(86400UL * 1000UL - 2 * 60 * 1000UL);
+    CHECK(device.relayOn());
+}
+
+// بعد يوم "on" تعود القناة للجداول عند منتصف الليل: آخر انتقال قبل الفترة (إيقاف 18:00)
+HOST_TEST(forcedOnDayReturnsToSchedules) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(8, 0, true));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(18, 0, false));
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/schedules/exceptions/add",
+                                    "{\"from\":\"2026-01-02\",\"kind\":\"on\"}").code);
+    device.run(20 * 3600 * 1000UL); // 2026-01-01 20:00
+    CHECK(!device.relayOn());
+    device.run(24 * 3600 * 1000UL); // 2026-01-02 20:00 (بعد موعد الإيقاف)
+    CHECK(device.relayOn());
+    device.run(5 * 3600 * 1000UL);  // 2026-01-03 01:00
+    CHECK(!device.relayOn());
+    device.run(8 * 3600 * 1000UL);  // 09:00: الجداول تعمل مجدداً
+    CHECK(device.relayOn());
+}
+
+// بعد يوم "off" تعود القناة للتشغيل الذي بدأ قبل الفترة (20:00 حتى 06:00)
+HOST_TEST(forcedOffDayReturnsToSchedules) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(20, 0, true));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(6, 0, false));
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/schedules/exceptions/add",
+                                    "{\"from\":\"2026-01-02\",\"kind\":\"off\"}").code);
+    device.run(21 * 3600 * 1000UL); // 2026-01-01 21:00
+    CHECK(device.relayOn());
+    device.run(12 * 3600 * 1000UL); // 2026-01-02 09:00
+    CHECK(!device.relayOn());
+    device.run(16 * 3600 * 1000UL); // 2026-01-03 01:00
+    CHECK(device.relayOn());
+    device.run(6 * 3600 * 1000UL);  // 07:00
+    CHECK(!device.relayOn());
+}
+
+// الاستعادة بعد ضبط الساعة إلى اليوم التالي للاستثناء لا تعيد حالته المفروضة
+HOST_TEST(setTimeAfterForcedDayUsesSchedules) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 2, 12, 0, 0));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(8, 0, true));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(18, 0, false));
+    device.request(HTTP_POST, "/api/schedules/exceptions/add", "{\"from\":\"2026-01-02\",\"kind\":\"on\"}");
+    device.run(1000);
+    CHECK(device.relayOn());
+    device.request(HTTP_POST, "/api/schedules/time/set",
+                   "{\"year\":2026,\"month\":1,\"day\":3,\"hour\":1,\"minute\":0,\"second\":0}");
+    device.run(1000);
+    CHECK(!device.relayOn());
+}
+
+// حذف فترة مفروضة تشمل اليوم يعيد القناة للجداول فوراً
+HOST_TEST(deletingForcedRangeRestoresRelay) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 2, 12, 0, 0));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(8, 0, true));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(9, 0, false));
+    HostHttpResponse added = device.request(HTTP_POST, "/api/schedules/exceptions/add",
+                                            "{\"from\":\"2026-01-02\",\"kind\":\"on\"}");
+    device.run(1000);
+    CHECK(device.relayOn());
+    String id = added.body.substring(added.body.indexOf("\"id\":") + 5);
+    id = id.substring(0, id.indexOf('}'));
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/schedules/exceptions/delete", "{\"id\":" + id + "}").code);
+    device.run(1000);
+    CHECK(!device.relayOn());
+}
+
+// ضبط الوقت داخل فترة تشغيل يعيد المرحل حسب آخر انتقال في الدورة التالية (بكتابة واحدة)
+HOST_TEST(setTimeRestoresRelay) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(6, 0, true));
+    device.request(HTTP_POST, "/api/schedules/add", pointBody(18, 0, false));
+    device.run(1000);
+    CHECK(!device.relayOn());
+    uint32_t writes = HostPins::writes(RELAY_PIN);
+    device.request(HTTP_POST, "/api/schedules/time/set",
+                   "{\"year\":2026,\"month\":1,\"day\":1,\"hour\":12,\"minute\":0,\"second\":0}");
+    device.run(1000);
+    CHECK(device.relayOn());
+    CHECK_EQUAL(writes + 1, HostPins::writes(RELAY_PIN));
+    device.request(HTTP_POST, "/api/prayer/time/set",
+                   "{\"year\":2026,\"month\":1,\"day\":1,\"hour\":20,\"minute\":0,\"second\":0}");
+    device.run(1000);
+    CHECK(!device.relayOn());
+}
+
+HOST_TEST(setTimeMovesClock) {
+    HostTestDevice& device = HostTestDevice::begin(DateTime(2026, 1, 1, 0, 0, 0));
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/schedules/time/set",
+                                    "{\"year\":2026,\"month\":6,\"day\":15,\"hour\":12,\"minute\":30,\"second\":0}").code);
+    HostHttpResponse time = device.request(HTTP_GET, "/api/schedules/time/get");
+    CHECK(contains(time, "\"year\": 2026"));
+    CHECK(contains(time, "\"month\": 6"));
+    CHECK(contains(time, "\"day\": 15"));
+    CHECK(contains(time, "\"hour\": 12"));
+}
@@ -0,0 +1,97 @@
+// StorageWorkerTest.cpp
+// عامل التخزين تحت الضغط: كتابات وقراءات عشوائية متداخلة عبر EEPROMHelper تُقارن بنموذج في الذاكرة،
+// وتقسيم الكتابات عند حدود الصفحات. مع SMART_CONTROL_STORAGE_WORKER تمر العمليات بطوابير العامل
+// (std::thread)، فتكشف المنظفات سباقات الطوابير؛ وبدونه تختبر نفس الحالات المسار المباشر.
+#include "HostTest.h"
+#include "Sim24C256.h"
+#include <random>
+#include <string.h>
+
+// عدد العمليات في اختبار الضغط، ومدى العناوين (منطقة الاختبار في بداية الذاكرة المحاكاة)
+#define STRESS_OPERATIONS 200000
+#define STRESS_REGION 4096
+// أطول كتابة أو قراءة (تعبر عدة صفحات)
+#define STRESS_MAX_LENGTH 150
+
+static uint32_t completions = 0;
+
+static void startWorker() {
+    Serial.setOutput(nullptr);
+    memset(HostI2C::eeprom().data(), 0, SIM_24C256_SIZE);
+#ifdef USE_STORAGE_WORKER
+    CHECK(StorageWorker::begin());
+#else
+    CHECK(!StorageWorker::begin());
+#endif
+}
+
+// كل قراءة (طلب متزامن خلف الكتابات المنتظرة) ترى آخر ما كُتب، وكل إشعار إكمال يصل مرة واحدة
+HOST_TEST(randomWritesAndReadsMatchModel) {
+    startWorker();
+    static uint8_t model[STRESS_REGION];
+    memset(model, 0, sizeof(model));
+    std::mt19937 random(1);
+    uint32_t expectedCompletions = 0;
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < STRESS_OPERATIONS; i++) {
+        uint16_t address = random() % (STRESS_REGION - STRESS_MAX_LENGTH);
+        int length = 1 + random() % STRESS_MAX_LENGTH;
+        uint8_t buffer[STRESS_MAX_LENGTH];
+        if (random() % 2) {
+            for (int j = 0; j < length; j++) {
+                buffer[j] = (uint8_t)random();
+            }
+            memcpy(model + address, buffer, length);
+            bool notify = random() % 4 == 0;
+            expectedCompletions += notify ? 1 : 0;
+            StorageWorker::write(address, buffer, length,
+                                 notify ? (StorageJob)[](void*) { completions++; } : nullptr, nullptr);
+        } else {
+            EEPROMHelper::readBytes(address, buffer, length);
+            if (memcmp(buffer, model + address, length) != 0) {
+                mismatches++;
+            }
+        }
+        if (random() % 8 == 0) {
+            StorageWorker::poll();
+        }
+    }
+    StorageWorker::end();
+    StorageWorker::poll();
+    CHECK_EQUAL(0u, mismatches);
+    CHECK_EQUAL(expectedCompletions, completions);
+    CHECK(memcmp(HostI2C::eeprom().data(), model, sizeof(model)) == 0);
+}
+
+// طلب لكل صفحة: عدد دورات الكتابة كما في الكتابة المباشرة
+HOST_TEST(writesSplitAtPageBoundaries) {
+    startWorker();
+    uint8_t data[4 * EXTERNAL_EEPROM_PAGE_SIZE];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)i;
+    }
+    uint32_t cycles = HostI2C::eeprom().writeCycles();
+    StorageWorker::write(2 * EXTERNAL_EEPROM_PAGE_SIZE, data, sizeof(data));
+    StorageWorker::flush();
+    CHECK_EQUAL(cycles + 4, HostI2C::eeprom().writeCycles());
+
+    // كتابة غير محاذاة: بقية الصفحة الأولى، صفحة كاملة، ثم بداية الصفحة الثالثة
+    cycles = HostI2C::eeprom().writeCycles();
+    StorageWorker::write(EXTERNAL_EEPROM_PAGE_SIZE - 4, data, 100);
+    StorageWorker::flush();
+    CHECK_EQUAL(cycles + 3, HostI2C::eeprom().writeCycles());
+    CHECK(memcmp(HostI2C::eeprom().data() + EXTERNAL_EEPROM_PAGE_SIZE - 4, data, 100) == 0);
+    StorageWorker::end();
+}
+
+// post ينسخ البيانات عند الاستدعاء (المصدر يتغير بعده دون أثر)
+HOST_TEST(postCopiesPayload) {
+    startWorker();
+    static uint32_t seen = 0;
+    uint32_t value = 42;
+    StorageWorker::post([](void* data) { memcpy(&seen, data, sizeof(seen)); }, value);
+    value = 7;
+    StorageWorker::flush();
+    CHECK_EQUAL(42u, seen);
+    StorageWorker::end();
+}
@@ -0,0 +1,153 @@
+// TaskSchedulerTest.cpp
+// عجلة المهام مباشرة على الساعة المحاكاة (دون مديرات): النقل بين المستويات الأربعة وما بعد مدى العجلة،
+// و trigger لمهمة مجدولة، والمهام الدورية دون انزياح، وميزانية الدورة والتجاوزات، و nextDeadline.
+#include "HostTest.h"
+#include <vector>
+
+// الوقت المحاكى بالمللي ثانية
+static uint64_t nowMs() {
+    return HostClock::micros() / 1000;
+}
+
+// حلقة الجهاز حتى الوقت end: القفز إلى nextDeadline() ثم service() كما في loop()
+static void runUntil(uint64_t end) {
+    while (nowMs() < end) {
+        uint32_t wait = TaskScheduler::nextDeadline();
+        if (wait > end - nowMs()) {
+            wait = (uint32_t)(end - nowMs());
+        }
+        HostClock::advance((uint64_t)wait * 1000);
+        TaskScheduler::service();
+    }
+}
+
+// أوقات تنفيذ مهمة
+struct FireLog {
+    std::vector<uint64_t> times;
+};
+
+static void logFire(void* context) {
+    static_cast<FireLog*>(context)->times.push_back(nowMs());
+}
+
+// مواعيد في كل مستوى (حدود المستويات 64 و 4096 و 262144 نبضة) وبعد مدى العجلة (2^24 نبضة، نحو 4.7 ساعات):
+// كل مهمة تُنفذ في موعدها بالضبط مع القفز بـ nextDeadline() فقط
+HOST_TEST(cascadesAcrossLevelsAndBeyondSpan) {
+    Serial.setOutput(nullptr);
+    const uint32_t delays[] = { 1, 63, 64, 100, 4095, 4096, 5000, 262143, 262144, 300000,
+                                (1UL << 24) - 1, 1UL << 24, 6UL * 3600 * 1000, 30UL * 3600 * 1000 };
+    const size_t count = sizeof(delays) / sizeof(delays[0]);
+    static FireLog logs[count];
+    uint64_t start = nowMs();
+    for (size_t i = 0; i < count; i++) {
+        CHECK(TaskScheduler::add(logFire, &logs[i], delays[i]) != TASK_NONE);
+    }
+    runUntil(start + 31UL * 3600 * 1000);
+    for (size_t i = 0; i < count; i++) {
+        HostTest::checkEqual(__FILE__, __LINE__, (String("fires of ") + String(delays[i])).c_str(), (size_t)1,
+                             logs[i].times.size());
+        if (!logs[i].times.empty()) {
+            HostTest::checkEqual(__FILE__, __LINE__, (String("time of ") + String(delays[i])).c_str(),
+                                 start + delays[i], logs[i].times[0]);
+        }
+    }
+    CHECK_EQUAL(0u, TaskScheduler::maxLatenessMs());
+    CHECK_EQUAL(TASK_NO_DEADLINE, TaskScheduler::nextDeadline());
+}
+
+// nextDeadline: بلا مواعيد TASK_NO_DEADLINE، وحد أدنى للموعد الأقرب (مضبوط في المستوى 0)، و 0 لمهمة مستحقة
+HOST_TEST(nextDeadlineIsLowerBound) {
+    Serial.setOutput(nullptr);
+    FireLog log;
+    uint8_t idle = TaskScheduler::add(logFire, &log);
+    CHECK_EQUAL(TASK_NO_DEADLINE, TaskScheduler::nextDeadline());
+
+    uint8_t near = TaskScheduler::add(logFire, &log, 10);
+    CHECK_EQUAL(10u, TaskScheduler::nextDeadline());
+    TaskScheduler::remove(near);
+    CHECK_EQUAL(TASK_NO_DEADLINE, TaskScheduler::nextDeadline());
+
+    TaskScheduler::schedule(idle, 250);
+    uint32_t wait = TaskScheduler::nextDeadline();
+    CHECK(wait > 0 && wait <= 250);
+    HostClock::advance(100 * 1000);
+    CHECK(TaskScheduler::nextDeadline() <= 150); // الزمن المنقضي قبل service() محسوب
+    TaskScheduler::trigger(idle);
+    CHECK_EQUAL(0u, TaskScheduler::nextDeadline());
+    TaskScheduler::cancel(idle);
+    CHECK_EQUAL(TASK_NO_DEADLINE, TaskScheduler::nextDeadline());
+    TaskScheduler::service();
+    CHECK(log.times.empty());
+}
+
+// trigger لمهمة لها موعد: تُنفذ مرة في الدورة التالية ويُزال موعدها السابق؛ وتكرار trigger لا يكررها
+HOST_TEST(triggerReplacesScheduledDeadline) {
+    Serial.setOutput(nullptr);
+    FireLog log;
+    uint64_t start = nowMs();
+    uint8_t task = TaskScheduler::add(logFire, &log, 1000);
+    TaskScheduler::trigger(task);
+    TaskScheduler::trigger(task);
+    TaskScheduler::service();
+    CHECK_EQUAL((size_t)1, log.times.size());
+    CHECK_EQUAL(start, log.times[0]);
+    runUntil(start + 5000);
+    CHECK_EQUAL((size_t)1, log.times.size());
+}
+
+// المهمة الدورية: المواعيد من الموعد السابق لا من وقت التنفيذ المتأخر، وبعد فوات دورة كاملة من الآن
+HOST_TEST(periodicTaskDoesNotDrift) {
+    Serial.setOutput(nullptr);
+    FireLog log;
+    uint64_t start = nowMs();
+    TaskScheduler::add(logFire, &log, 100, 100);
+    runUntil(start + 1000);
+    CHECK_EQUAL((size_t)10, log.times.size());
+    for (size_t i = 0; i < log.times.size(); i++) {
+        CHECK_EQUAL(start + 100 * (i + 1), log.times[i]);
+    }
+
+    // خدمة كل 130 ms (التأخر 30 ثم 60 ثم 90 ms): المواعيد تبقى على مضاعفات الدورة
+    for (int i = 0; i < 3; i++) {
+        HostClock::advance(130 * 1000);
+        TaskScheduler::service();
+    }
+    CHECK_EQUAL((size_t)13, log.times.size());
+    CHECK_EQUAL(90u, TaskScheduler::maxLatenessMs());
+    runUntil(start + 1400);
+    CHECK_EQUAL((size_t)14, log.times.size());
+    CHECK_EQUAL(start + 1400, log.times.back());
+
+    // انقطاع أطول من دورتين: تنفيذ واحد، ثم الدورة التالية من وقت الخدمة
+    HostClock::advance(350 * 1000);
+    TaskScheduler::service();
+    CHECK_EQUAL((size_t)15, log.times.size());
+    uint64_t resumed = nowMs();
+    runUntil(resumed + 100);
+    CHECK_EQUAL((size_t)16, log.times.size());
+    CHECK_EQUAL(resumed + 100, log.times.back());
+}
+
+// مهمة تستغرق 15 ms من الزمن المحاكى
+static void slowTask(void* context) {
+    (*static_cast<int*>(context))++;
+    HostClock::advance(15 * 1000);
+}
+
+// ميزانية TASK_SERVICE_BUDGET_US: بعد تجاوزها تُؤجل بقية المستحقة للدورة التالية ويُحسب تجاوز واحد
+HOST_TEST(serviceBudgetDefersAndCountsOverruns) {
+    Serial.setOutput(nullptr);
+    static int ran = 0;
+    for (int i = 0; i < 3; i++) {
+        TaskScheduler::add(slowTask, &ran, 0);
+    }
+    TaskScheduler::service();
+    CHECK_EQUAL(2, ran); // 15 ms ثم 30 ms: الثانية تبدأ قبل نفاد الميزانية
+    CHECK_EQUAL(1u, TaskScheduler::overruns());
+    CHECK_EQUAL(0u, TaskScheduler::nextDeadline());
+    CHECK(TaskScheduler::maxServiceMicros() >= 30000u);
+    TaskScheduler::service();
+    CHECK_EQUAL(3, ran);
+    CHECK_EQUAL(1u, TaskScheduler::overruns());
+    CHECK_EQUAL(TASK_NO_DEADLINE, TaskScheduler::nextDeadline());
+}
@@ -0,0 +1,116 @@
+// UserManagerTest.cpp
+// نقاط نهاية علامات المستخدمين عبر WebServer داخل العملية: الإضافة والبحث والحذف مع الإزاحة، ونبضة المرحل عند الاستخدام.
+#include "HostTest.h"
+#include "HostHeap.h"
+
+static String tagBody(const char* tag) {
+    return "{\"tag\":\"" + String(tag) + "\"}";
+}
+
+HOST_TEST(addCheckAndDelete) {
+    HostTestDevice& device = HostTestDevice::begin();
+    HostHttpResponse added = device.request(HTTP_POST, "/api/users/add_tag", tagBody("12345678901"));
+    CHECK_EQUAL(200, added.code);
+    CHECK(contains(device.request(HTTP_GET, "/api/users/get_count"), "\"count\":1"));
+    CHECK(contains(device.request(HTTP_POST, "/api/users/check_tag", tagBody("12345678901")), "\"found\":true"));
+    // العلامة الأقصر تُحشى بالأصفار البادئة
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/users/add_tag", tagBody("42")).code);
+    CHECK(contains(device.request(HTTP_POST, "/api/users/check_tag", tagBody("00000000042")), "\"found\":true"));
+
+    CHECK(contains(device.request(HTTP_POST, "/api/users/delete_tag", tagBody("12345678901")), "\"status\":\"success\""));
+    CHECK(contains(device.request(HTTP_POST, "/api/users/check_tag", tagBody("12345678901")), "\"found\":false"));
+    // الحذف يزيح العلامة التالية إلى مكانها
+    CHECK(contains(device.request(HTTP_GET, "/api/users/get_tags"), "\"tags\":[\"00000000042\"]"));
+}
+
+HOST_TEST(shiftKeepsOrder) {
+    HostTestDevice& device = HostTestDevice::begin();
+    const char* tags[] = { "10000000001", "10000000002", "10000000003", "10000000004" };
+    for (const char* tag : tags) {
+        CHECK_EQUAL(200, device.request(HTTP_POST, "/api/users/add_tag", tagBody(tag)).code);
+    }
+    device.request(HTTP_POST, "/api/users/delete_tag", tagBody("10000000002"));
+    CHECK(contains(device.request(HTTP_GET, "/api/users/get_tags"),
+                   "\"tags\":[\"10000000001\",\"10000000003\",\"10000000004\"]"));
+    for (const char* tag : { "10000000001", "10000000003", "10000000004" }) {
+        CHECK(contains(device.request(HTTP_POST, "/api/users/check_tag", tagBody(tag)), "\"found\":true"));
+    }
+}
+
+HOST_TEST(rejectsInvalidTags) {
+    HostTestDevice& device = HostTestDevice::begin();
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/users/add_tag", tagBody("12345678901")).code);
+    CHECK_EQUAL(409, device.request(HTTP_POST, "/api/users/add_tag", tagBody("12345678901")).code);
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/users/add_tag", tagBody("123456789012")).code);
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/users/check_tag", "{\"tag\":").code);
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/users/use_tag").code);
+    CHECK(contains(device.request(HTTP_GET, "/api/users/get_count"), "\"count\":1"));
+}
+
+HOST_TEST(maxUsersLimitsStore) {
+    HostTestDevice& device = HostTestDevice::begin();
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/users/set_users_max_number", "{\"userNum\":2}").code);
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/users/add_tag", tagBody("1")).code);
+    CHECK_EQUAL(200, device.request(HTTP_POST, "/api/users/add_tag", tagBody("2")).code);
+    CHECK_EQUAL(500, device.request(HTTP_POST, "/api/users/add_tag", tagBody("3")).code);
+    CHECK_EQUAL(400, device.request(HTTP_POST, "/api/users/set_users_max_number",
+                                    "{\"userNum\":" + String(MAX_USER_TAGS + 1) + "}").code);
+}
+
+// use_tag يطلب نبضة من مصدر البطاقة تنتهي بمهلتها دون delay() في المعالج
+HOST_TEST(useTagPulsesRelay) {
+    HostTestDevice& device = HostTestDevice::begin();
+    device.request(HTTP_POST, "/api/users/add_tag", tagBody("12345678901"));
+    CHECK(!device.relayOn());
+    CHECK(contains(device.request(HTTP_POST, "/api/users/use_tag", tagBody("99999999999")), "\"found\":false"));
+    CHECK(!device.relayOn());
+
+    uint64_t before = HostClock::micros();
+    CHECK(contains(device.request(HTTP_POST, "/api/users/use_tag", tagBody("12345678901")), "\"found\":true"));
+    CHECK(HostClock::micros() - before < 1000000ULL);
+    CHECK(device.relayOn());
+    device.run(10000);
+    CHECK(!device.relayOn());
+}
+
+HOST_TEST(unknownRouteIsNotFound) {
+    HostTestDevice& device = HostTestDevice::begin();
+    CHECK_EQUAL(404, device.request(HTTP_GET, "/api/users/nope").code);
+}
+
+// تخصيصات طلب كامل عبر WebServer داخل العملية (HostHeap يعد كل operator new)
+static uint32_t requestAllocations(HostTestDevice& device, const char* uri, const String& body) {
+    uint32_t before = HostHeap::allocations();
+    device.request(HTTP_POST, uri, body);
+    return HostHeap::allocations() - before;
+}
+
+// مسارات قارئ البطاقات لا تخصص شيئاً بعد تحليل JSON وإرسال الرد: تُقارن تخصيصات الطلب بمسار مرجعي
+// يحلل نفس الجسم ويرد بنص بنفس الطول فقط، فتبقى المقارنة صحيحة مع أي إصدار من ArduinoJson.
+HOST_TEST(tagLookupAllocatesNothing) {
+    HostTestDevice& device = HostTestDevice::begin();
+    static String reply;
+    device.web.on("/api/test/parse_and_reply", HTTP_POST, [&device]() {
+        if (device.web.hasArg("plain")) {
+            StaticJsonDocument<200> doc;
+            deserializeJson(doc, device.web.arg("plain"));
+        }
+        device.web.send(200, "application/json", reply.c_str());
+    });
+    for (int i = 1; i <= 20; i++) {
+        device.request(HTTP_POST, "/api/users/add_tag", tagBody(String(10000000000LL + i).c_str()));
+    }
+
+    const char* routes[] = { "/api/users/check_tag", "/api/users/use_tag" };
+    const char* tags[] = { "10000000020", "99999999999", "42", "123456789012" };
+    for (const char* uri : routes) {
+        for (const char* tag : tags) {
+            String body = tagBody(tag);
+            HostHttpResponse response = device.request(HTTP_POST, uri, body);
+            reply = response.body;
+            uint32_t expected = requestAllocations(device, "/api/test/parse_and_reply", body);
+            HostTest::checkEqual(__FILE__, __LINE__, (String(uri) + " " + tag).c_str(), expected,
+                                 requestAllocations(device, uri, body));
+        }
+    }
+}